@@ -0,0 +1,1182 @@
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "CpuKernels.hpp"
+#include "DeviceCapabilities.hpp"
+#include "ShaderReflection.hpp"
+#include "WorkerPool.hpp"
+
+// generated at build time from the optimized SPIR-V in Build/shaders; see the Makefile.
+#include "EmbeddedShaders.hpp"
+
+/**
+ * @brief a shader compiled into the binary by the Makefile's SPIR-V stage, by source file name (e.g. "saxpy.comp").
+ */
+static std::span<const uint32_t> embeddedShader(std::string_view name)
+{
+    for (const auto &shader : embedded_shaders::all)
+    {
+        if (name == shader.name)
+        {
+            return {shader.words, shader.wordCount};
+        }
+    }
+    throw std::runtime_error("no embedded shader named " + std::string(name) + "; was it added to shaders/ and the build rerun?");
+}
+
+/**
+ * @brief command line options; see printUsage() for what each does.
+ */
+struct ComputeConfig
+{
+    // element counts for saxpy, reduce and scan.
+    std::vector<uint32_t> sizes = {1u << 20, 1u << 24};
+    // matrix widths for matmul.
+    std::vector<uint32_t> matrixSizes = {256, 1024};
+    std::set<std::string> kernels = {"saxpy", "reduce", "scan", "matmul"};
+    // timed runs per kernel and size, after one untimed run that is also the one checked against the CPU.
+    uint32_t repeats = 5;
+    // threads per workgroup for the 1D kernels; a power of two, since reduce folds by halves.
+    uint32_t workgroupSize = 256;
+    // matmul tile width; a workgroup is tile x tile threads.
+    uint32_t tileSize = 16;
+    // index among the compute-capable devices, in enumeration order.
+    uint32_t deviceIndex = 0;
+    // threads for the CPU baseline; 0 means one per hardware thread.
+    uint32_t cpuThreads = 0;
+    // run and time the CPU baseline; off skips both it and the result check.
+    bool cpu = true;
+    bool validation = false;
+};
+
+void printUsage(const char *program)
+{
+    std::cout << "usage: " << program << " [options]\n"
+              << "\t--kernels LIST        comma separated saxpy,reduce,scan,matmul (default all)\n"
+              << "\t--sizes LIST          element counts for saxpy, reduce and scan (default 1048576,16777216)\n"
+              << "\t--matrix-sizes LIST   matrix widths for matmul (default 256,1024)\n"
+              << "\t--repeats N           timed runs per kernel and size, best one counts (default 5)\n"
+              << "\t--workgroup N         threads per workgroup for the 1D kernels, a power of two (default 256)\n"
+              << "\t--tile N              matmul tile width (default 16)\n"
+              << "\t--device N            use the Nth compute-capable device (default 0)\n"
+              << "\t--cpu-threads N       threads for the CPU baseline (default one per hardware thread)\n"
+              << "\t--no-cpu              skip the CPU baseline and the result check\n"
+              << "\t--validation          enable the validation layer\n";
+}
+
+/**
+ * @brief "1024,65536" to {1024, 65536}.
+ */
+std::vector<uint32_t> parseSizeList(const std::string &list)
+{
+    std::vector<uint32_t> sizes;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        uint32_t size = static_cast<uint32_t>(std::stoul(item));
+        if (size == 0)
+        {
+            throw std::runtime_error("sizes must be positive: " + list);
+        }
+        sizes.push_back(size);
+    }
+    if (sizes.empty())
+    {
+        throw std::runtime_error("empty size list");
+    }
+    return sizes;
+}
+
+ComputeConfig parseArguments(int argc, char **argv)
+{
+    ComputeConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto nextValue = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--kernels")
+        {
+            config.kernels.clear();
+            std::stringstream stream(nextValue());
+            std::string name;
+            while (std::getline(stream, name, ','))
+            {
+                if (name != "saxpy" && name != "reduce" && name != "scan" && name != "matmul")
+                {
+                    throw std::runtime_error("unknown kernel " + name);
+                }
+                config.kernels.insert(name);
+            }
+        }
+        else if (arg == "--sizes")
+        {
+            config.sizes = parseSizeList(nextValue());
+        }
+        else if (arg == "--matrix-sizes")
+        {
+            config.matrixSizes = parseSizeList(nextValue());
+        }
+        else if (arg == "--repeats")
+        {
+            config.repeats = std::max(1u, static_cast<uint32_t>(std::stoul(nextValue())));
+        }
+        else if (arg == "--workgroup")
+        {
+            config.workgroupSize = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--tile")
+        {
+            config.tileSize = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--device")
+        {
+            config.deviceIndex = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--cpu-threads")
+        {
+            config.cpuThreads = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--no-cpu")
+        {
+            config.cpu = false;
+        }
+        else if (arg == "--validation")
+        {
+            config.validation = true;
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            printUsage(argv[0]);
+            std::exit(EXIT_SUCCESS);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+    if (config.workgroupSize < 2 || (config.workgroupSize & (config.workgroupSize - 1)) != 0)
+    {
+        // and at least 2, or scan's levels of block totals would never get any shorter.
+        throw std::runtime_error("--workgroup must be a power of two, at least 2");
+    }
+    if (config.tileSize == 0)
+    {
+        throw std::runtime_error("--tile must be at least 1");
+    }
+    if (config.kernels.empty())
+    {
+        throw std::runtime_error("--kernels selected nothing to run");
+    }
+    return config;
+}
+
+/**
+ * @brief one line of the report.
+ */
+struct KernelResult
+{
+    std::string kernel;
+    uint64_t size;
+    double gpuSeconds = 0.0;
+    double cpuSeconds = 0.0;
+    // minimum traffic the kernel has to move, for GB/s.
+    double bytes = 0.0;
+    // arithmetic operations, for GFLOP/s; scan counts its integer adds.
+    double flops = 0.0;
+    // largest relative difference from the CPU result; 0 when the CPU baseline didn't run.
+    double maxError = 0.0;
+    bool passed = true;
+};
+
+/**
+ * @brief GPGPU throughput sandbox: a compute-only device with no GLFW, surface or swapchain, running SAXPY, a reduction, a prefix scan and a tiled matrix multiply over configurable sizes, each timed against a SIMD CPU baseline (CpuKernels.hpp) and checked against its result.
+ *
+ * The device gets a single queue from a compute family (a dedicated one if there is one) and no extensions or features, so anything from a discrete GPU to lavapipe on a CPU-only CI box can run it. GPU time comes from timestamp queries around the dispatches, or from submit-to-fence wall time on queues without timestamps. Data moves through a host-visible staging buffer into device-local buffers and transfers aren't timed; only the kernels are. Each kernel and size runs once untimed (the run whose result is checked), then --repeats times, and the fastest run counts, on both sides.
+ */
+class ComputeSandbox
+{
+public:
+    explicit ComputeSandbox(const ComputeConfig &config) : config(config)
+    {
+    }
+
+    ~ComputeSandbox()
+    {
+        cleanup();
+    }
+
+    ComputeSandbox(const ComputeSandbox &) = delete;
+    ComputeSandbox &operator=(const ComputeSandbox &) = delete;
+
+    /**
+     * @return false if any GPU result didn't match the CPU's.
+     */
+    bool run()
+    {
+        createInstance();
+        pickDevice();
+        createDevice();
+        createKernels();
+        uint32_t threads = config.cpuThreads > 0 ? config.cpuThreads : std::max(1u, std::thread::hardware_concurrency());
+        cpuWorkers = std::make_unique<WorkerPool>(threads);
+        std::cout << "GPU: " << caps.properties.deviceName << (timestampsSupported ? " (timestamp queries)" : " (wall clock, no timestamps on this queue)") << "\n"
+                  << "CPU: " << threads << " thread(s), " << simdName() << "\n\n";
+
+        std::vector<KernelResult> results;
+        for (uint32_t size : config.sizes)
+        {
+            if (config.kernels.count("saxpy"))
+            {
+                results.push_back(runSaxpy(size));
+            }
+            if (config.kernels.count("reduce"))
+            {
+                results.push_back(runReduce(size));
+            }
+            if (config.kernels.count("scan"))
+            {
+                results.push_back(runScan(size));
+            }
+        }
+        if (config.kernels.count("matmul"))
+        {
+            for (uint32_t size : config.matrixSizes)
+            {
+                results.push_back(runMatmul(size));
+            }
+        }
+        printReport(results);
+        return std::all_of(results.begin(), results.end(), [](const KernelResult &result)
+                           { return result.passed; });
+    }
+
+private:
+    struct Buffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        // persistently mapped for host-visible buffers, null otherwise.
+        void *mapped = nullptr;
+    };
+
+    /**
+     * @brief one shader and the pipeline variants specialized from it; they all share the layout generated from its reflection.
+     */
+    struct Kernel
+    {
+        VkShaderModule module = VK_NULL_HANDLE;
+        ShaderReflection reflection;
+        ReflectedLayout layout;
+        std::vector<VkPipeline> pipelines;
+    };
+
+    // must match the push constant blocks in shaders/saxpy.comp, reduce.comp, scan.comp and matmul.comp.
+    struct SaxpyParams
+    {
+        float a;
+        uint32_t count;
+    };
+    struct ReduceParams
+    {
+        uint32_t count;
+    };
+    struct ScanParams
+    {
+        uint32_t count;
+    };
+    struct MatmulParams
+    {
+        uint32_t size;
+    };
+
+    // first-pass workgroups for reduce; enough to fill any GPU, and the second pass folds them with one workgroup.
+    static constexpr uint32_t reduceGroups = 1024;
+
+    void createInstance()
+    {
+        VkApplicationInfo appInfo{};
+        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        appInfo.pApplicationName = "Compute Sandbox";
+        appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+        appInfo.pEngineName = "No Engine";
+        appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+        appInfo.apiVersion = VK_API_VERSION_1_0;
+
+        // no window, so no instance extensions at all.
+        VkInstanceCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        createInfo.pApplicationInfo = &appInfo;
+        const char *validationLayer = "VK_LAYER_KHRONOS_validation";
+        if (config.validation)
+        {
+            if (!InstanceCapabilities::query().hasLayer(validationLayer))
+            {
+                throw std::runtime_error("--validation asked for, but VK_LAYER_KHRONOS_validation isn't installed!");
+            }
+            createInfo.enabledLayerCount = 1;
+            createInfo.ppEnabledLayerNames = &validationLayer;
+        }
+        if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute instance!");
+        }
+    }
+
+    void pickDevice()
+    {
+        uint32_t deviceCount = 0;
+        vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+        std::vector<VkPhysicalDevice> devices(deviceCount);
+        vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+        std::vector<DeviceCapabilities> candidates;
+        for (VkPhysicalDevice device : devices)
+        {
+            DeviceCapabilities candidate = DeviceCapabilities::query(device);
+            if (computeFamily(candidate) != UINT32_MAX)
+            {
+                candidates.push_back(std::move(candidate));
+            }
+        }
+        if (config.deviceIndex >= candidates.size())
+        {
+            throw std::runtime_error("no compute-capable device " + std::to_string(config.deviceIndex) + " (found " + std::to_string(candidates.size()) + ")!");
+        }
+        caps = candidates[config.deviceIndex];
+        family = computeFamily(caps);
+
+        const VkPhysicalDeviceLimits &limits = caps.properties.limits;
+        if (config.workgroupSize > limits.maxComputeWorkGroupSize[0] || config.workgroupSize > limits.maxComputeWorkGroupInvocations ||
+            config.workgroupSize * sizeof(uint32_t) > limits.maxComputeSharedMemorySize)
+        {
+            throw std::runtime_error("--workgroup " + std::to_string(config.workgroupSize) + " is bigger than this device allows!");
+        }
+        if (config.tileSize > limits.maxComputeWorkGroupSize[0] || config.tileSize > limits.maxComputeWorkGroupSize[1] ||
+            config.tileSize * config.tileSize > limits.maxComputeWorkGroupInvocations || 2 * config.tileSize * config.tileSize * sizeof(float) > limits.maxComputeSharedMemorySize)
+        {
+            throw std::runtime_error("--tile " + std::to_string(config.tileSize) + " is bigger than this device allows!");
+        }
+    }
+
+    /**
+     * @return a compute family without graphics if there is one (the GPU's async compute queue), else any compute family, else UINT32_MAX.
+     */
+    static uint32_t computeFamily(const DeviceCapabilities &candidate)
+    {
+        uint32_t found = UINT32_MAX;
+        for (uint32_t i = 0; i < candidate.queueFamilies.size(); i++)
+        {
+            VkQueueFlags flags = candidate.queueFamilies[i].queueFlags;
+            if ((flags & VK_QUEUE_COMPUTE_BIT) && (found == UINT32_MAX || !(flags & VK_QUEUE_GRAPHICS_BIT)))
+            {
+                found = i;
+            }
+        }
+        return found;
+    }
+
+    void createDevice()
+    {
+        float priority = 1.0f;
+        VkDeviceQueueCreateInfo queueInfo{};
+        queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueInfo.queueFamilyIndex = family;
+        queueInfo.queueCount = 1;
+        queueInfo.pQueuePriorities = &priority;
+        VkDeviceCreateInfo deviceInfo{};
+        deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        deviceInfo.queueCreateInfoCount = 1;
+        deviceInfo.pQueueCreateInfos = &queueInfo;
+        if (vkCreateDevice(caps.device, &deviceInfo, nullptr, &device) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute device!");
+        }
+        vkGetDeviceQueue(device, family, 0, &queue);
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = family;
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute command pool!");
+        }
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate compute command buffer!");
+        }
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute fence!");
+        }
+
+        timestampsSupported = caps.queueFamilies[family].timestampValidBits > 0 && caps.properties.limits.timestampPeriod > 0.0f;
+        if (timestampsSupported)
+        {
+            VkQueryPoolCreateInfo queryInfo{};
+            queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryInfo.queryCount = 2;
+            if (vkCreateQueryPool(device, &queryInfo, nullptr, &queryPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create compute timestamp pool!");
+            }
+        }
+
+        // sized for the most any one kernel run binds: scan's one set per level.
+        VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 256};
+        VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+        descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolInfo.maxSets = 64;
+        descriptorPoolInfo.poolSizeCount = 1;
+        descriptorPoolInfo.pPoolSizes = &poolSize;
+        if (vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute descriptor pool!");
+        }
+    }
+
+    void createKernels()
+    {
+        uint32_t tile = config.tileSize;
+        createKernel(saxpy, "saxpy.comp", sizeof(SaxpyParams), {SpecializationConstants().set(0, config.workgroupSize)});
+        createKernel(reduce, "reduce.comp", sizeof(ReduceParams), {SpecializationConstants().set(0, config.workgroupSize)});
+        // pipelines[0] scans blocks, pipelines[1] adds the scanned block totals back in.
+        createKernel(scan, "scan.comp", sizeof(ScanParams),
+                     {SpecializationConstants().set(0, config.workgroupSize).setBool(1, false), SpecializationConstants().set(0, config.workgroupSize).setBool(1, true)});
+        createKernel(matmul, "matmul.comp", sizeof(MatmulParams), {SpecializationConstants().set(0, tile).set(1, tile)});
+    }
+
+    void createKernel(Kernel &kernel, const char *name, size_t pushConstantSize, std::vector<SpecializationConstants> variants)
+    {
+        std::span<const uint32_t> code = embeddedShader(name);
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size_bytes();
+        moduleInfo.pCode = code.data();
+        if (vkCreateShaderModule(device, &moduleInfo, nullptr, &kernel.module) != VK_SUCCESS)
+        {
+            throw std::runtime_error(std::string("failed to create shader module for ") + name + "!");
+        }
+        kernel.reflection = ShaderReflection::reflect(code);
+        if (kernel.reflection.pushConstantSize != pushConstantSize)
+        {
+            throw std::runtime_error(std::string(name) + " declares " + std::to_string(kernel.reflection.pushConstantSize) + " bytes of push constants but the sandbox pushes " +
+                                     std::to_string(pushConstantSize) + "!");
+        }
+        kernel.layout.create(device, {&kernel.reflection});
+
+        for (auto &constants : variants)
+        {
+            constants.requireDeclaredBy(kernel.reflection, name);
+            VkComputePipelineCreateInfo pipelineInfo{};
+            pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            pipelineInfo.stage.module = kernel.module;
+            pipelineInfo.stage.pName = "main";
+            pipelineInfo.stage.pSpecializationInfo = constants.info();
+            pipelineInfo.layout = kernel.layout.pipelineLayout();
+            VkPipeline pipeline;
+            if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+            {
+                throw std::runtime_error(std::string("failed to create compute pipeline for ") + name + "!");
+            }
+            kernel.pipelines.push_back(pipeline);
+        }
+    }
+
+    KernelResult runSaxpy(uint32_t count)
+    {
+        vkResetDescriptorPool(device, descriptorPool, 0);
+        std::vector<float> x = randomFloats(count, 1);
+        std::vector<float> y = randomFloats(count, 2);
+        const float a = 1.5f;
+        Buffer xBuffer = createBuffer(sizeof(float) * count, false);
+        Buffer yBuffer = createBuffer(sizeof(float) * count, false);
+        upload(xBuffer, x.data());
+        upload(yBuffer, y.data());
+        VkDescriptorSet set = bindBuffers(saxpy, {xBuffer.buffer, yBuffer.buffer});
+        SaxpyParams params{a, count};
+        uint32_t groups = std::min(ceilDiv(count, config.workgroupSize), caps.properties.limits.maxComputeWorkGroupCount[0]);
+        auto record = [&](VkCommandBuffer cmd)
+        {
+            bind(cmd, saxpy, 0, set, &params, sizeof(params));
+            vkCmdDispatch(cmd, groups, 1, 1);
+        };
+
+        KernelResult result{"saxpy", count};
+        result.bytes = 3.0 * sizeof(float) * count;
+        result.flops = 2.0 * count;
+        submit(record);
+        std::vector<float> gpu(count);
+        download(yBuffer, gpu.data());
+        result.gpuSeconds = timeGpu(record);
+
+        if (config.cpu)
+        {
+            std::vector<float> cpu = y;
+            parallelFor(count, [&](uint32_t begin, uint32_t end)
+                        { cpu_kernels::saxpy(a, x.data() + begin, cpu.data() + begin, end - begin); });
+            check(result, gpu, cpu, 1e-5);
+            result.cpuSeconds = timeCpu([&]()
+                                        { parallelFor(count, [&](uint32_t begin, uint32_t end)
+                                                      { cpu_kernels::saxpy(a, x.data() + begin, cpu.data() + begin, end - begin); }); });
+        }
+        destroyBuffer(xBuffer);
+        destroyBuffer(yBuffer);
+        return result;
+    }
+
+    KernelResult runReduce(uint32_t count)
+    {
+        vkResetDescriptorPool(device, descriptorPool, 0);
+        std::vector<float> values = randomFloats(count, 3);
+        uint32_t groups = std::min({ceilDiv(count, config.workgroupSize), reduceGroups, caps.properties.limits.maxComputeWorkGroupCount[0]});
+        Buffer valueBuffer = createBuffer(sizeof(float) * count, false);
+        Buffer partialBuffer = createBuffer(sizeof(float) * groups, false);
+        Buffer totalBuffer = createBuffer(sizeof(float), false);
+        upload(valueBuffer, values.data());
+        VkDescriptorSet firstPass = bindBuffers(reduce, {valueBuffer.buffer, partialBuffer.buffer});
+        VkDescriptorSet secondPass = bindBuffers(reduce, {partialBuffer.buffer, totalBuffer.buffer});
+        ReduceParams firstParams{count};
+        ReduceParams secondParams{groups};
+        auto record = [&](VkCommandBuffer cmd)
+        {
+            bind(cmd, reduce, 0, firstPass, &firstParams, sizeof(firstParams));
+            vkCmdDispatch(cmd, groups, 1, 1);
+            computeBarrier(cmd);
+            bind(cmd, reduce, 0, secondPass, &secondParams, sizeof(secondParams));
+            vkCmdDispatch(cmd, 1, 1, 1);
+        };
+
+        KernelResult result{"reduce", count};
+        result.bytes = sizeof(float) * static_cast<double>(count);
+        result.flops = count;
+        submit(record);
+        std::vector<float> gpu(1);
+        download(totalBuffer, gpu.data());
+        result.gpuSeconds = timeGpu(record);
+
+        if (config.cpu)
+        {
+            std::vector<float> partials(cpuWorkers->size());
+            auto cpuReduce = [&]()
+            {
+                cpuWorkers->run([&](uint32_t worker)
+                                {
+                    auto [begin, end] = cpuWorkers->slice(count, worker);
+                    partials[worker] = cpu_kernels::sum(values.data() + begin, end - begin); });
+                return cpu_kernels::sum(partials.data(), partials.size());
+            };
+            std::vector<float> cpu = {cpuReduce()};
+            check(result, gpu, cpu, 1e-3);
+            result.cpuSeconds = timeCpu([&]()
+                                        { cpuReduce(); });
+        }
+        destroyBuffer(valueBuffer);
+        destroyBuffer(partialBuffer);
+        destroyBuffer(totalBuffer);
+        return result;
+    }
+
+    KernelResult runScan(uint32_t count)
+    {
+        vkResetDescriptorPool(device, descriptorPool, 0);
+        std::vector<uint32_t> values(count);
+        std::mt19937 random(4);
+        for (auto &value : values)
+        {
+            value = random() & 15u;
+        }
+
+        // level 0 is the data; each level above holds the block totals of the one below, until one block covers a whole level.
+        std::vector<uint32_t> levelCounts = {count};
+        while (levelCounts.back() > config.workgroupSize)
+        {
+            levelCounts.push_back(ceilDiv(levelCounts.back(), config.workgroupSize));
+        }
+        std::vector<Buffer> levels;
+        for (uint32_t levelCount : levelCounts)
+        {
+            levels.push_back(createBuffer(sizeof(uint32_t) * levelCount, false));
+        }
+        // the top level's single block total has nowhere to go but here.
+        Buffer topTotal = createBuffer(sizeof(uint32_t), false);
+        std::vector<VkDescriptorSet> sets;
+        for (size_t level = 0; level < levels.size(); level++)
+        {
+            sets.push_back(bindBuffers(scan, {levels[level].buffer, level + 1 < levels.size() ? levels[level + 1].buffer : topTotal.buffer}));
+        }
+        auto dispatchBlocks = [&](VkCommandBuffer cmd, uint32_t levelCount)
+        {
+            uint32_t blocks = ceilDiv(levelCount, config.workgroupSize);
+            uint32_t width = std::min(blocks, caps.properties.limits.maxComputeWorkGroupCount[0]);
+            vkCmdDispatch(cmd, width, ceilDiv(blocks, width), 1);
+        };
+        auto record = [&](VkCommandBuffer cmd)
+        {
+            for (size_t level = 0; level < levels.size(); level++)
+            {
+                ScanParams params{levelCounts[level]};
+                bind(cmd, scan, 0, sets[level], &params, sizeof(params));
+                dispatchBlocks(cmd, levelCounts[level]);
+                computeBarrier(cmd);
+            }
+            for (size_t level = levels.size() - 1; level-- > 0;)
+            {
+                ScanParams params{levelCounts[level]};
+                bind(cmd, scan, 1, sets[level], &params, sizeof(params));
+                dispatchBlocks(cmd, levelCounts[level]);
+                computeBarrier(cmd);
+            }
+        };
+
+        KernelResult result{"scan", count};
+        result.bytes = 2.0 * sizeof(uint32_t) * count;
+        result.flops = count;
+        upload(levels[0], values.data());
+        submit(record);
+        std::vector<uint32_t> gpu(count);
+        download(levels[0], gpu.data());
+        // the scan is in place, so every timed run starts from the previous run's output; the values wrap, which doesn't change the work.
+        result.gpuSeconds = timeGpu(record);
+
+        if (config.cpu)
+        {
+            std::vector<uint32_t> cpu(count);
+            std::vector<uint32_t> carries(cpuWorkers->size());
+            auto cpuScan = [&]()
+            {
+                // per-slice totals first, then each slice scans from the sum of the slices before it.
+                cpuWorkers->run([&](uint32_t worker)
+                                {
+                    auto [begin, end] = cpuWorkers->slice(count, worker);
+                    carries[worker] = cpu_kernels::sum(values.data() + begin, end - begin); });
+                cpu_kernels::inclusiveScan(carries.data(), carries.data(), carries.size(), 0);
+                cpuWorkers->run([&](uint32_t worker)
+                                {
+                    auto [begin, end] = cpuWorkers->slice(count, worker);
+                    cpu_kernels::inclusiveScan(values.data() + begin, cpu.data() + begin, end - begin, worker > 0 ? carries[worker - 1] : 0); });
+            };
+            cpuScan();
+            result.maxError = 0.0;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (gpu[i] != cpu[i])
+                {
+                    result.maxError = 1.0;
+                    result.passed = false;
+                    break;
+                }
+            }
+            result.cpuSeconds = timeCpu(cpuScan);
+        }
+        for (auto &level : levels)
+        {
+            destroyBuffer(level);
+        }
+        destroyBuffer(topTotal);
+        return result;
+    }
+
+    KernelResult runMatmul(uint32_t size)
+    {
+        vkResetDescriptorPool(device, descriptorPool, 0);
+        size_t elements = static_cast<size_t>(size) * size;
+        std::vector<float> a = randomFloats(elements, 5);
+        std::vector<float> b = randomFloats(elements, 6);
+        Buffer aBuffer = createBuffer(sizeof(float) * elements, false);
+        Buffer bBuffer = createBuffer(sizeof(float) * elements, false);
+        Buffer cBuffer = createBuffer(sizeof(float) * elements, false);
+        upload(aBuffer, a.data());
+        upload(bBuffer, b.data());
+        VkDescriptorSet set = bindBuffers(matmul, {aBuffer.buffer, bBuffer.buffer, cBuffer.buffer});
+        MatmulParams params{size};
+        uint32_t tiles = ceilDiv(size, config.tileSize);
+        if (tiles > caps.properties.limits.maxComputeWorkGroupCount[0] || tiles > caps.properties.limits.maxComputeWorkGroupCount[1])
+        {
+            throw std::runtime_error("matrix size " + std::to_string(size) + " needs more workgroups than this device dispatches; use a bigger --tile");
+        }
+        auto record = [&](VkCommandBuffer cmd)
+        {
+            bind(cmd, matmul, 0, set, &params, sizeof(params));
+            vkCmdDispatch(cmd, tiles, tiles, 1);
+        };
+
+        KernelResult result{"matmul", size};
+        result.bytes = 3.0 * sizeof(float) * elements;
+        result.flops = 2.0 * elements * size;
+        submit(record);
+        std::vector<float> gpu(elements);
+        download(cBuffer, gpu.data());
+        result.gpuSeconds = timeGpu(record);
+
+        if (config.cpu)
+        {
+            std::vector<float> cpu(elements);
+            auto cpuMatmul = [&]()
+            {
+                parallelFor(size, [&](uint32_t begin, uint32_t end)
+                            { cpu_kernels::matmul(a.data(), b.data(), cpu.data(), size, begin, end); });
+            };
+            cpuMatmul();
+            check(result, gpu, cpu, 1e-3);
+            result.cpuSeconds = timeCpu(cpuMatmul);
+        }
+        destroyBuffer(aBuffer);
+        destroyBuffer(bBuffer);
+        destroyBuffer(cBuffer);
+        return result;
+    }
+
+    static uint32_t ceilDiv(uint32_t value, uint32_t divisor)
+    {
+        return (value + divisor - 1) / divisor;
+    }
+
+    static std::vector<float> randomFloats(size_t count, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        std::vector<float> values(count);
+        for (auto &value : values)
+        {
+            value = distribution(random);
+        }
+        return values;
+    }
+
+    static const char *simdName()
+    {
+#if defined(__AVX2__)
+        return "SSE kernels, compiled with AVX2 available";
+#elif defined(__SSE2__)
+        return "SSE kernels";
+#else
+        return "scalar kernels (no SSE on this target)";
+#endif
+    }
+
+    /**
+     * @brief records the largest relative difference, |gpu - cpu| / (1 + |cpu|), and fails the result past tolerance. Float results differ in summation order and FMA contraction, so exact equality isn't expected.
+     */
+    static void check(KernelResult &result, const std::vector<float> &gpu, const std::vector<float> &cpu, double tolerance)
+    {
+        for (size_t i = 0; i < gpu.size(); i++)
+        {
+            double error = std::fabs(static_cast<double>(gpu[i]) - cpu[i]) / (1.0 + std::fabs(cpu[i]));
+            result.maxError = std::max(result.maxError, error);
+        }
+        // NaN compares false, so spell out the pass condition rather than the fail one.
+        result.passed = result.maxError <= tolerance;
+    }
+
+    void parallelFor(uint32_t count, const std::function<void(uint32_t begin, uint32_t end)> &job)
+    {
+        cpuWorkers->run([&](uint32_t worker)
+                        {
+            auto [begin, end] = cpuWorkers->slice(count, worker);
+            if (begin < end)
+            {
+                job(begin, end);
+            } });
+    }
+
+    /**
+     * @return the fastest of config.repeats runs, in seconds.
+     */
+    double timeCpu(const std::function<void()> &job)
+    {
+        double best = 0.0;
+        for (uint32_t run = 0; run < config.repeats; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            job();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (run == 0 || seconds < best)
+            {
+                best = seconds;
+            }
+        }
+        return std::max(best, 1e-9);
+    }
+
+    /**
+     * @return the fastest of config.repeats submissions of record(), in seconds: timestamp to timestamp where the queue has them, submit to fence otherwise.
+     */
+    double timeGpu(const std::function<void(VkCommandBuffer)> &record)
+    {
+        double best = 0.0;
+        for (uint32_t run = 0; run < config.repeats; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            submit([&](VkCommandBuffer cmd)
+                   {
+                if (timestampsSupported)
+                {
+                    vkCmdResetQueryPool(cmd, queryPool, 0, 2);
+                    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+                }
+                record(cmd);
+                if (timestampsSupported)
+                {
+                    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1);
+                } });
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (timestampsSupported)
+            {
+                uint64_t ticks[2];
+                if (vkGetQueryPoolResults(device, queryPool, 0, 2, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) == VK_SUCCESS)
+                {
+                    seconds = static_cast<double>(ticks[1] - ticks[0]) * caps.properties.limits.timestampPeriod * 1e-9;
+                }
+            }
+            if (run == 0 || seconds < best)
+            {
+                best = seconds;
+            }
+        }
+        return std::max(best, 1e-9);
+    }
+
+    /**
+     * @brief records into the one command buffer, submits and waits for the fence.
+     */
+    void submit(const std::function<void(VkCommandBuffer)> &record)
+    {
+        vkResetCommandBuffer(commandBuffer, 0);
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        record(commandBuffer);
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record compute commands!");
+        }
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit compute commands!");
+        }
+        vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(device, 1, &fence);
+    }
+
+    void bind(VkCommandBuffer cmd, const Kernel &kernel, uint32_t variant, VkDescriptorSet set, const void *params, uint32_t paramsSize)
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, kernel.pipelines[variant]);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, kernel.layout.pipelineLayout(), 0, 1, &set, 0, nullptr);
+        vkCmdPushConstants(cmd, kernel.layout.pipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, paramsSize, params);
+    }
+
+    /**
+     * @brief makes one dispatch's storage writes visible to the next dispatch's reads and writes.
+     */
+    static void computeBarrier(VkCommandBuffer cmd)
+    {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    /**
+     * @brief allocates a set from the shared pool and points bindings 0, 1, ... at the given buffers. Sets live until the next kernel run starts and resets the pool.
+     */
+    VkDescriptorSet bindBuffers(const Kernel &kernel, std::initializer_list<VkBuffer> buffers)
+    {
+        VkDescriptorSetLayout setLayout = kernel.layout.setLayout(0);
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &setLayout;
+        VkDescriptorSet set;
+        if (vkAllocateDescriptorSets(device, &allocInfo, &set) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate compute descriptor set!");
+        }
+        std::vector<VkDescriptorBufferInfo> bufferInfos;
+        for (VkBuffer buffer : buffers)
+        {
+            bufferInfos.push_back({buffer, 0, VK_WHOLE_SIZE});
+        }
+        std::vector<VkWriteDescriptorSet> writes(bufferInfos.size());
+        for (uint32_t i = 0; i < writes.size(); i++)
+        {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = set;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        return set;
+    }
+
+    /**
+     * @brief dedicated allocation: device-local for kernel buffers (falling back to whatever the device has), host-visible and coherent for staging. A handful of long-lived buffers don't need DeviceAllocator.
+     */
+    Buffer createBuffer(VkDeviceSize size, bool hostVisible)
+    {
+        Buffer result;
+        result.size = size;
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = hostVisible ? VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                                       : VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &result.buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute buffer!");
+        }
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, result.buffer, &requirements);
+        VkMemoryPropertyFlags wanted = hostVisible ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        uint32_t typeIndex = UINT32_MAX;
+        for (uint32_t i = 0; i < caps.memory.memoryTypeCount; i++)
+        {
+            bool allowed = requirements.memoryTypeBits & (1u << i);
+            bool matches = (caps.memory.memoryTypes[i].propertyFlags & wanted) == wanted;
+            if (allowed && matches)
+            {
+                typeIndex = i;
+                break;
+            }
+            if (allowed && !hostVisible && typeIndex == UINT32_MAX)
+            {
+                typeIndex = i;
+            }
+        }
+        if (typeIndex == UINT32_MAX)
+        {
+            throw std::runtime_error("no memory type for compute buffer!");
+        }
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = requirements.size;
+        allocInfo.memoryTypeIndex = typeIndex;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &result.memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate compute buffer memory (" + std::to_string(size >> 20) + " MiB)!");
+        }
+        vkBindBufferMemory(device, result.buffer, result.memory, 0);
+        if (hostVisible)
+        {
+            vkMapMemory(device, result.memory, 0, VK_WHOLE_SIZE, 0, &result.mapped);
+        }
+        return result;
+    }
+
+    void destroyBuffer(Buffer &buffer)
+    {
+        if (buffer.buffer == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        // submit() waits for every submission, so nothing can still be using it.
+        vkDestroyBuffer(device, buffer.buffer, nullptr);
+        vkFreeMemory(device, buffer.memory, nullptr);
+        buffer = {};
+    }
+
+    Buffer &stagingFor(VkDeviceSize size)
+    {
+        if (staging.size < size)
+        {
+            destroyStaging();
+            staging = createBuffer(size, true);
+        }
+        return staging;
+    }
+
+    void destroyStaging()
+    {
+        if (staging.buffer != VK_NULL_HANDLE)
+        {
+            vkDestroyBuffer(device, staging.buffer, nullptr);
+            vkFreeMemory(device, staging.memory, nullptr);
+            staging = {};
+        }
+    }
+
+    void upload(const Buffer &target, const void *data)
+    {
+        Buffer &source = stagingFor(target.size);
+        std::memcpy(source.mapped, data, target.size);
+        submit([&](VkCommandBuffer cmd)
+               {
+            VkBufferCopy region{0, 0, target.size};
+            vkCmdCopyBuffer(cmd, source.buffer, target.buffer, 1, &region); });
+    }
+
+    void download(const Buffer &source, void *data)
+    {
+        Buffer &target = stagingFor(source.size);
+        submit([&](VkCommandBuffer cmd)
+               {
+            VkBufferCopy region{0, 0, source.size};
+            vkCmdCopyBuffer(cmd, source.buffer, target.buffer, 1, &region);
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr); });
+        std::memcpy(data, target.mapped, source.size);
+    }
+
+    void printReport(const std::vector<KernelResult> &results)
+    {
+        std::cout << std::left << std::setw(8) << "kernel" << std::right << std::setw(10) << "size" << std::setw(11) << "gpu ms" << std::setw(10) << "GB/s" << std::setw(10)
+                  << "GFLOP/s";
+        if (config.cpu)
+        {
+            std::cout << std::setw(11) << "cpu ms" << std::setw(10) << "GB/s" << std::setw(10) << "GFLOP/s" << std::setw(9) << "speedup" << std::setw(11) << "max error";
+        }
+        std::cout << '\n';
+        std::cout << std::fixed;
+        for (const auto &result : results)
+        {
+            std::cout << std::left << std::setw(8) << result.kernel << std::right << std::setw(10) << result.size << std::setprecision(3) << std::setw(11)
+                      << result.gpuSeconds * 1e3 << std::setprecision(1) << std::setw(10) << result.bytes / result.gpuSeconds / 1e9 << std::setw(10)
+                      << result.flops / result.gpuSeconds / 1e9;
+            if (config.cpu)
+            {
+                std::cout << std::setprecision(3) << std::setw(11) << result.cpuSeconds * 1e3 << std::setprecision(1) << std::setw(10) << result.bytes / result.cpuSeconds / 1e9
+                          << std::setw(10) << result.flops / result.cpuSeconds / 1e9 << std::setprecision(2) << std::setw(8) << result.cpuSeconds / result.gpuSeconds << 'x'
+                          << std::scientific << std::setprecision(1) << std::setw(11) << result.maxError << std::fixed << (result.passed ? "" : "  MISMATCH");
+            }
+            std::cout << '\n';
+        }
+        std::cout.unsetf(std::ios::floatfield);
+    }
+
+    void cleanup()
+    {
+        if (device != VK_NULL_HANDLE)
+        {
+            vkDeviceWaitIdle(device);
+            destroyStaging();
+            for (Kernel *kernel : {&saxpy, &reduce, &scan, &matmul})
+            {
+                for (VkPipeline pipeline : kernel->pipelines)
+                {
+                    vkDestroyPipeline(device, pipeline, nullptr);
+                }
+                kernel->pipelines.clear();
+                kernel->layout.destroy();
+                if (kernel->module != VK_NULL_HANDLE)
+                {
+                    vkDestroyShaderModule(device, kernel->module, nullptr);
+                    kernel->module = VK_NULL_HANDLE;
+                }
+            }
+            if (descriptorPool != VK_NULL_HANDLE)
+            {
+                vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+            }
+            if (queryPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(device, queryPool, nullptr);
+            }
+            if (fence != VK_NULL_HANDLE)
+            {
+                vkDestroyFence(device, fence, nullptr);
+            }
+            if (commandPool != VK_NULL_HANDLE)
+            {
+                vkDestroyCommandPool(device, commandPool, nullptr);
+            }
+            vkDestroyDevice(device, nullptr);
+            device = VK_NULL_HANDLE;
+        }
+        if (instance != VK_NULL_HANDLE)
+        {
+            vkDestroyInstance(instance, nullptr);
+            instance = VK_NULL_HANDLE;
+        }
+    }
+
+    ComputeConfig config;
+    VkInstance instance = VK_NULL_HANDLE;
+    DeviceCapabilities caps;
+    uint32_t family = UINT32_MAX;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    bool timestampsSupported = false;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    Buffer staging;
+    Kernel saxpy;
+    Kernel reduce;
+    Kernel scan;
+    Kernel matmul;
+    std::unique_ptr<WorkerPool> cpuWorkers;
+};
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        ComputeConfig config = parseArguments(argc, argv);
+        ComputeSandbox sandbox(config);
+        if (!sandbox.run())
+        {
+            std::cerr << "GPU and CPU results differ" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief the CPU side of ComputeSandbox: the same kernels as shaders/saxpy.comp, reduce.comp, scan.comp and matmul.comp, hand-vectorized with SSE so the comparison is against a CPU doing its best rather than against scalar loops.
+ *
+ * Every function works on a caller-given range so ComputeSandbox can split the work over a WorkerPool. SSE2 is baseline on x86-64; anywhere else the scalar tails do all the work and the compiler's autovectorizer is the baseline. The Makefile builds with -march=native so the compiler is free to widen the scalar parts too.
+ */
+namespace cpu_kernels
+{
+/**
+ * @brief y[i] = a * x[i] + y[i].
+ */
+inline void saxpy(float a, const float *x, float *y, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 va = _mm_set1_ps(a);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_mul_ps(va, _mm_loadu_ps(x + i)), _mm_loadu_ps(y + i)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        y[i] = a * x[i] + y[i];
+    }
+}
+
+inline float sum(const float *values, size_t count)
+{
+    size_t i = 0;
+    float total = 0.0f;
+#if defined(__SSE2__)
+    // four independent accumulators, so the adds pipeline instead of waiting on each other.
+    __m128 acc[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+    for (; i + 16 <= count; i += 16)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            acc[lane] = _mm_add_ps(acc[lane], _mm_loadu_ps(values + i + lane * 4));
+        }
+    }
+    __m128 folded = _mm_add_ps(_mm_add_ps(acc[0], acc[1]), _mm_add_ps(acc[2], acc[3]));
+    float lanes[4];
+    _mm_storeu_ps(lanes, folded);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; i++)
+    {
+        total += values[i];
+    }
+    return total;
+}
+
+/**
+ * @brief wrapping sum, i.e. what the last element of an inclusive scan of the range would be.
+ */
+inline uint32_t sum(const uint32_t *values, size_t count)
+{
+    size_t i = 0;
+    uint32_t total = 0;
+#if defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4)
+    {
+        acc = _mm_add_epi32(acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i)));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    total = static_cast<uint32_t>(_mm_cvtsi128_si32(acc));
+#endif
+    for (; i < count; i++)
+    {
+        total += values[i];
+    }
+    return total;
+}
+
+/**
+ * @brief inclusive prefix sum of values into out (which may be values), starting from carry.
+ * @return the last sum written, i.e. carry for the next range.
+ */
+inline uint32_t inclusiveScan(const uint32_t *values, uint32_t *out, size_t count, uint32_t carry)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i running = _mm_set1_epi32(static_cast<int>(carry));
+    for (; i + 4 <= count; i += 4)
+    {
+        // scan within the register by adding copies shifted up one and two lanes, then add the carry from everything before.
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, running);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), v);
+        running = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    carry = static_cast<uint32_t>(_mm_cvtsi128_si32(running));
+#endif
+    for (; i < count; i++)
+    {
+        carry += values[i];
+        out[i] = carry;
+    }
+    return carry;
+}
+
+/**
+ * @brief rows [rowBegin, rowEnd) of c = a * b for square row-major n x n matrices.
+ *
+ * i-k-j order, so the inner loop streams a row of b and a row of c with a broadcast a[i][k]; blocked over k and j so the slice of b being reused stays in L2.
+ */
+inline void matmul(const float *a, const float *b, float *c, uint32_t n, uint32_t rowBegin, uint32_t rowEnd)
+{
+    constexpr uint32_t kBlock = 128;
+    constexpr uint32_t jBlock = 256;
+    std::fill(c + static_cast<size_t>(rowBegin) * n, c + static_cast<size_t>(rowEnd) * n, 0.0f);
+    for (uint32_t jj = 0; jj < n; jj += jBlock)
+    {
+        uint32_t jEnd = std::min(jj + jBlock, n);
+        for (uint32_t kk = 0; kk < n; kk += kBlock)
+        {
+            uint32_t kEnd = std::min(kk + kBlock, n);
+            for (uint32_t i = rowBegin; i < rowEnd; i++)
+            {
+                float *cRow = c + static_cast<size_t>(i) * n;
+                for (uint32_t k = kk; k < kEnd; k++)
+                {
+                    float aik = a[static_cast<size_t>(i) * n + k];
+                    const float *bRow = b + static_cast<size_t>(k) * n;
+                    uint32_t j = jj;
+#if defined(__SSE2__)
+                    __m128 va = _mm_set1_ps(aik);
+                    for (; j + 4 <= jEnd; j += 4)
+                    {
+                        _mm_storeu_ps(cRow + j, _mm_add_ps(_mm_loadu_ps(cRow + j), _mm_mul_ps(va, _mm_loadu_ps(bRow + j))));
+                    }
+#endif
+                    for (; j < jEnd; j++)
+                    {
+                        cRow[j] += aik * bRow[j];
+                    }
+                }
+            }
+        }
+    }
+}
+} // namespace cpu_kernels
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief what the debug messenger subscribes to and how DebugLog treats what arrives.
+ */
+struct DebugLogSettings
+{
+    VkDebugUtilsMessageSeverityFlagsEXT severities = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    VkDebugUtilsMessageTypeFlagsEXT types = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+    // print straight from the callback with std::endl, no dedup or rate limit; the old behavior, kept for comparison.
+    bool synchronous = false;
+    // print each message ID this many times; later repeats are only counted.
+    uint32_t repeatsPerId = 3;
+    // cap on printed lines per second across all IDs; the rest are counted.
+    uint32_t linesPerSecond = 100;
+};
+
+/**
+ * @brief debug messenger sink that keeps the callback off the frame's critical path.
+ *
+ * The callback runs on whichever thread made the offending Vulkan call, often the render thread in the middle of recording. All it does here is copy the message into a fixed-size slot of a bounded lock-free queue (no allocation, no locks, no I/O) and bump a counter to wake the logger thread. The logger thread does the rest: per message-ID counting, dropping repeats past repeatsPerId, a token bucket capping output at linesPerSecond, and the actual writes to std::cerr. If the queue is full the message is dropped and counted rather than blocking the caller; the summary at stop() says how many.
+ *
+ * The queue is Vyukov's bounded MPMC ring, used with many producers (driver threads) and one consumer.
+ */
+class DebugLog
+{
+public:
+    ~DebugLog()
+    {
+        // normally already stopped by cleanup(); this covers an exception unwinding past it, where a joinable std::thread would terminate().
+        stop();
+    }
+
+    void start(const DebugLogSettings &settings)
+    {
+        this->settings = settings;
+        running = true;
+        if (!settings.synchronous)
+        {
+            slots = std::make_unique<Slot[]>(capacity);
+            for (uint32_t i = 0; i < capacity; i++)
+            {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            logger = std::thread([this]()
+                                 { drain(); });
+        }
+    }
+
+    /**
+     * @brief flushes whatever is still queued, stops the logger thread and prints the per-ID summary. Call after the messenger is gone.
+     */
+    void stop()
+    {
+        if (!running)
+        {
+            return;
+        }
+        running = false;
+        if (logger.joinable())
+        {
+            wake();
+            logger.join();
+        }
+        printSummary(std::cerr);
+    }
+
+    const DebugLogSettings &config() const
+    {
+        return settings;
+    }
+
+    /**
+     * @brief called from the debug messenger callback, on any thread.
+     */
+    void submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT *data)
+    {
+        received.fetch_add(1, std::memory_order_relaxed);
+        if (settings.synchronous)
+        {
+            std::lock_guard<std::mutex> lock(syncMutex);
+            std::cerr << "The validation layer says: " << data->pMessage << std::endl;
+            printed++;
+            return;
+        }
+
+        uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;)
+        {
+            slot = &slots[position % capacity];
+            uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+            if (difference == 0)
+            {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+            {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        Message &message = slot->message;
+        message.severity = severity;
+        message.type = type;
+        message.id = data->messageIdNumber;
+        copyTruncated(message.idName, sizeof(message.idName), data->pMessageIdName);
+        copyTruncated(message.text, sizeof(message.text), data->pMessage);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        wake();
+    }
+
+private:
+    static constexpr uint32_t capacity = 1024;
+
+    struct Message
+    {
+        VkDebugUtilsMessageSeverityFlagBitsEXT severity;
+        VkDebugUtilsMessageTypeFlagsEXT type;
+        int32_t id;
+        char idName[96];
+        // long validation messages get cut here; the ID name still says which VUID it was.
+        char text[1024];
+    };
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        Message message;
+    };
+
+    struct IdStats
+    {
+        uint64_t count = 0;
+    };
+    // messageIdNumber alone isn't unique: loader, general and performance messages mostly leave it at 0, so the name is part of the key.
+    using IdKey = std::pair<int32_t, std::string>;
+
+    static void copyTruncated(char *destination, size_t size, const char *source)
+    {
+        if (source == nullptr)
+        {
+            destination[0] = '\0';
+            return;
+        }
+        size_t length = std::min(std::strlen(source), size - 1);
+        std::memcpy(destination, source, length);
+        destination[length] = '\0';
+    }
+
+    static const char *severityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+    {
+        switch (severity)
+        {
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
+            return "error";
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
+            return "warning";
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
+            return "info";
+        default:
+            return "verbose";
+        }
+    }
+
+    void wake()
+    {
+        wakeups.fetch_add(1, std::memory_order_release);
+        wakeups.notify_one();
+    }
+
+    /**
+     * @brief logger thread: pops messages until stop() and the queue is empty.
+     */
+    void drain()
+    {
+        auto refill = std::chrono::steady_clock::now();
+        double tokens = settings.linesPerSecond;
+        for (;;)
+        {
+            uint32_t seen = wakeups.load(std::memory_order_acquire);
+            bool any = false;
+            for (;;)
+            {
+                Slot &slot = slots[dequeuePosition % capacity];
+                if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+                {
+                    break;
+                }
+                auto now = std::chrono::steady_clock::now();
+                tokens = std::min<double>(settings.linesPerSecond, tokens + std::chrono::duration<double>(now - refill).count() * settings.linesPerSecond);
+                refill = now;
+                handle(slot.message, tokens);
+                slot.sequence.store(dequeuePosition + capacity, std::memory_order_release);
+                dequeuePosition++;
+                any = true;
+            }
+            if (any)
+            {
+                std::cerr.flush();
+            }
+            if (!running && enqueuePosition.load(std::memory_order_acquire) == dequeuePosition)
+            {
+                return;
+            }
+            // sleeps until a producer or stop() bumps the counter past what we saw before draining.
+            wakeups.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    void handle(const Message &message, double &tokens)
+    {
+        IdStats &stats = ids[IdKey(message.id, message.idName)];
+        stats.count++;
+        // no ID and no name: nothing says two of these are the same message, so none of them count as repeats.
+        bool anonymous = message.id == 0 && message.idName[0] == '\0';
+        if (!anonymous && stats.count > settings.repeatsPerId)
+        {
+            suppressedRepeats++;
+            return;
+        }
+        if (tokens < 1.0)
+        {
+            suppressedRate++;
+            return;
+        }
+        tokens -= 1.0;
+        printed++;
+        std::cerr << '[' << severityName(message.severity) << "] " << message.idName << ": " << message.text;
+        if (!anonymous && stats.count == settings.repeatsPerId)
+        {
+            std::cerr << " (further repeats only counted)";
+        }
+        std::cerr << '\n';
+    }
+
+    void printSummary(std::ostream &out)
+    {
+        uint64_t total = received.load();
+        if (total == 0)
+        {
+            return;
+        }
+        out << "debug messenger: " << total << " message(s), " << printed << " printed, " << suppressedRepeats << " repeats and " << suppressedRate
+            << " over the rate limit suppressed, " << dropped.load() << " dropped on a full queue\n";
+        std::vector<std::pair<const IdKey *, const IdStats *>> byCount;
+        for (const auto &[key, stats] : ids)
+        {
+            byCount.emplace_back(&key, &stats);
+        }
+        std::sort(byCount.begin(), byCount.end(), [](const auto &a, const auto &b)
+                  { return a.second->count > b.second->count; });
+        for (size_t i = 0; i < std::min<size_t>(byCount.size(), 5); i++)
+        {
+            const IdKey &key = *byCount[i].first;
+            out << '\t' << byCount[i].second->count << "x " << (key.second.empty() ? "(no message ID)" : key.second) << '\n';
+        }
+    }
+
+    DebugLogSettings settings;
+    std::atomic<bool> running{false};
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> enqueuePosition{0};
+    // only the logger thread touches this.
+    uint64_t dequeuePosition = 0;
+    std::atomic<uint32_t> wakeups{0};
+    std::thread logger;
+    std::mutex syncMutex;
+
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> dropped{0};
+    // logger thread only (or syncMutex in synchronous mode) until stop() has joined it.
+    uint64_t printed = 0;
+    uint64_t suppressedRepeats = 0;
+    uint64_t suppressedRate = 0;
+    std::map<IdKey, IdStats> ids;
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include "DeviceAllocator.hpp"
+#include "Stats.hpp"
+#include "VulkanHandle.hpp"
+
+/**
+ * @brief handles retired mid-frame, kept until every frame that could still be using them has finished on the GPU, then destroyed together; the same deal retired swapchains always got, for anything held in a UniqueHandle, so replacing a resource never needs vkDeviceWaitIdle.
+ *
+ * Handles are grouped into one batch per frame they were retired on. collect() goes right after the frame slot's fence wait, when every frame up to frameIndex - framesInFlight is known to be done, and destroys every batch that old in one go. Entries are type-erased down to two integers and a destroy function, so retiring costs no allocation beyond the batch's vector growing. UniqueAllocations ride along in the same batches and are freed after the batch's handles, so nothing is still bound to memory when it goes back to the allocator.
+ */
+class DeletionQueue
+{
+public:
+    void create(uint32_t framesInFlight)
+    {
+        this->framesInFlight = framesInFlight;
+    }
+
+    /**
+     * @param frameIndex the next frame to be submitted, i.e. the first that can no longer be using the handle.
+     */
+    template <typename Traits>
+    void retire(uint32_t frameIndex, UniqueHandle<Traits> &&handle)
+    {
+        if (handle.get() == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        batchFor(frameIndex).entries.push_back({toBits(handle.owner()), toBits(handle.get()), &destroyErased<Traits>});
+        handle.release();
+        retired++;
+        countPending();
+    }
+
+    /**
+     * @brief same, for memory: the allocation goes back to its allocator along with the batch. Declare the queue after the allocator, so anything still queued at teardown is freed before the allocator goes.
+     */
+    void retire(uint32_t frameIndex, UniqueAllocation &&allocation)
+    {
+        if (!allocation.valid())
+        {
+            return;
+        }
+        batchFor(frameIndex).allocations.push_back(std::move(allocation));
+        retiredAllocations++;
+        countPending();
+    }
+
+    /**
+     * @brief destroys the batches no in-flight frame can reference any more; call once per frame, after the current slot's fence wait.
+     */
+    void collect(uint32_t frameIndex)
+    {
+        while (!batches.empty() && frameIndex >= batches.front().frameIndex + framesInFlight)
+        {
+            destroyFront();
+        }
+    }
+
+    /**
+     * @brief destroys everything still queued; only once the device is idle.
+     */
+    void flush()
+    {
+        while (!batches.empty())
+        {
+            destroyFront();
+        }
+    }
+
+    void printStats(std::ostream &out)
+    {
+        out << "deletion queue: " << retired << " handle(s) and " << retiredAllocations << " allocation(s) retired, " << destroyed << " destroyed in " << batchCount << " batch(es), largest batch "
+            << largestBatch << ", at most " << peakPending << " pending\n";
+        if (batchTime.count() > 0)
+        {
+            batchTime.print(out, "deletion batch");
+        }
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t owner;
+        uint64_t handle;
+        void (*destroy)(uint64_t owner, uint64_t handle);
+    };
+
+    struct Batch
+    {
+        uint32_t frameIndex;
+        std::vector<Entry> entries;
+        std::vector<UniqueAllocation> allocations;
+    };
+
+    Batch &batchFor(uint32_t frameIndex)
+    {
+        if (batches.empty() || batches.back().frameIndex != frameIndex)
+        {
+            batches.push_back({frameIndex, {}, {}});
+        }
+        return batches.back();
+    }
+
+    void countPending()
+    {
+        pending++;
+        peakPending = std::max(peakPending, pending);
+    }
+
+    // dispatchable handles are pointers everywhere, non-dispatchable ones are pointers on 64-bit and uint64_t on 32-bit; all of them fit in 64 bits.
+    template <typename T>
+    static uint64_t toBits(T value)
+    {
+        if constexpr (std::is_same_v<T, NoOwner>)
+        {
+            return 0;
+        }
+        else if constexpr (std::is_pointer_v<T>)
+        {
+            return reinterpret_cast<uintptr_t>(value);
+        }
+        else
+        {
+            return static_cast<uint64_t>(value);
+        }
+    }
+
+    template <typename T>
+    static T fromBits(uint64_t bits)
+    {
+        if constexpr (std::is_same_v<T, NoOwner>)
+        {
+            return NoOwner{};
+        }
+        else if constexpr (std::is_pointer_v<T>)
+        {
+            return reinterpret_cast<T>(static_cast<uintptr_t>(bits));
+        }
+        else
+        {
+            return static_cast<T>(bits);
+        }
+    }
+
+    template <typename Traits>
+    static void destroyErased(uint64_t owner, uint64_t handle)
+    {
+        Traits::destroy(fromBits<typename Traits::Owner>(owner), fromBits<typename Traits::Handle>(handle));
+    }
+
+    void destroyFront()
+    {
+        auto start = std::chrono::steady_clock::now();
+        Batch &batch = batches.front();
+        // newest first, so anything retired after its dependencies goes before them, same as a scope unwinding.
+        for (auto it = batch.entries.rbegin(); it != batch.entries.rend(); ++it)
+        {
+            it->destroy(it->owner, it->handle);
+        }
+        size_t batchSize = batch.entries.size() + batch.allocations.size();
+        batch.allocations.clear();
+        batchTime.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        destroyed += batchSize;
+        pending -= batchSize;
+        largestBatch = std::max<uint64_t>(largestBatch, batchSize);
+        batchCount++;
+        batches.pop_front();
+    }
+
+    uint32_t framesInFlight = 1;
+    std::deque<Batch> batches;
+    uint64_t retired = 0;
+    uint64_t retiredAllocations = 0;
+    uint64_t destroyed = 0;
+    uint64_t batchCount = 0;
+    uint64_t largestBatch = 0;
+    uint64_t pending = 0;
+    uint64_t peakPending = 0;
+    SampleStats batchTime;
+};
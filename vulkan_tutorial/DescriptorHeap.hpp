@@ -0,0 +1,334 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief one global descriptor set holding every texture and storage buffer the app uses, addressed by index from push constants.
+ *
+ * Binding 0 is an array of combined image samplers, binding 1 an array of storage buffers. Draws bind the heap once per command buffer and then only push indices, so there's no per-draw vkAllocateDescriptorSets / vkCmdBindDescriptorSets at all. Index 0 of each array is the default resource (white texture, identity buffer) and every free slot points at it, so a stale or unset index reads something harmless instead of an invalid descriptor.
+ *
+ * Two modes:
+ * - bindless (Vulkan 1.2 descriptor indexing): a single update-after-bind, partially-bound set. New slots can be written while frames that don't use them are still in flight.
+ * - fallback (plain 1.0): writing a set that a pending command buffer uses is illegal, so there's one copy of the set per frame slot, and flush(slot) brings that slot's copy up to date once its fence has signaled.
+ *
+ * Array sizes have to match the shader's, which gets them through specialization constants (see buildGraphicsPipeline()).
+ */
+class DescriptorHeap
+{
+public:
+    static constexpr uint32_t textureBinding = 0;
+    static constexpr uint32_t bufferBinding = 1;
+
+    /**
+     * @param copies how many frames can be in flight; only matters for the fallback path.
+     */
+    void create(VkDevice device, bool bindless, uint32_t copies, uint32_t textureCapacity, uint32_t bufferCapacity)
+    {
+        this->device = device;
+        this->bindless = bindless;
+        textureSlots.assign(std::max(textureCapacity, 1u), VkDescriptorImageInfo{});
+        bufferSlots.assign(std::max(bufferCapacity, 1u), VkDescriptorBufferInfo{});
+        setCount = bindless ? 1 : copies;
+
+        VkDescriptorSetLayoutBinding bindings[2]{};
+        bindings[0].binding = textureBinding;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[0].descriptorCount = this->textureCapacity();
+        bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[1].binding = bufferBinding;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[1].descriptorCount = this->bufferCapacity();
+        bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorBindingFlags bindingFlags[2] = {};
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 2;
+        layoutInfo.pBindings = bindings;
+        if (bindless)
+        {
+            for (auto &flags : bindingFlags)
+            {
+                flags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+            }
+            bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+            bindingFlagsInfo.bindingCount = 2;
+            bindingFlagsInfo.pBindingFlags = bindingFlags;
+            layoutInfo.pNext = &bindingFlagsInfo;
+            layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        }
+        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create descriptor heap layout!");
+        }
+
+        VkDescriptorPoolSize poolSizes[2]{};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[0].descriptorCount = this->textureCapacity() * setCount;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[1].descriptorCount = this->bufferCapacity() * setCount;
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = bindless ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : 0;
+        poolInfo.maxSets = setCount;
+        poolInfo.poolSizeCount = 2;
+        poolInfo.pPoolSizes = poolSizes;
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create descriptor heap pool!");
+        }
+
+        std::vector<VkDescriptorSetLayout> layouts(setCount, setLayout);
+        sets.resize(setCount);
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = pool;
+        allocInfo.descriptorSetCount = setCount;
+        allocInfo.pSetLayouts = layouts.data();
+        if (vkAllocateDescriptorSets(device, &allocInfo, sets.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate descriptor heap sets!");
+        }
+        dirtyTextures.assign(setCount, {});
+        dirtyBuffers.assign(setCount, {});
+    }
+
+    DescriptorHeap() = default;
+    DescriptorHeap(const DescriptorHeap &) = delete;
+    DescriptorHeap &operator=(const DescriptorHeap &) = delete;
+
+    ~DescriptorHeap()
+    {
+        destroy();
+    }
+
+    void destroy()
+    {
+        if (pool != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+            pool = VK_NULL_HANDLE;
+        }
+        if (setLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+            setLayout = VK_NULL_HANDLE;
+        }
+        sets.clear();
+    }
+
+    /**
+     * @brief points slot 0 and every free slot at these. Call once before the first flush().
+     */
+    void setDefaults(VkImageView view, VkSampler sampler, VkBuffer buffer, VkDeviceSize bufferRange)
+    {
+        defaultTexture = {sampler, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        defaultBuffer = {buffer, 0, bufferRange};
+        freeTextures.clear();
+        freeBuffers.clear();
+        for (uint32_t i = textureCapacity(); i-- > 1;)
+        {
+            freeTextures.push_back(i);
+        }
+        for (uint32_t i = bufferCapacity(); i-- > 1;)
+        {
+            freeBuffers.push_back(i);
+        }
+        for (uint32_t i = 0; i < textureCapacity(); i++)
+        {
+            writeTexture(i, defaultTexture);
+        }
+        for (uint32_t i = 0; i < bufferCapacity(); i++)
+        {
+            writeBuffer(i, defaultBuffer);
+        }
+    }
+
+    /**
+     * @return the texture's heap index, or 0 (the default texture) when the heap is full.
+     */
+    uint32_t addTexture(VkImageView view, VkSampler sampler, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        if (freeTextures.empty())
+        {
+            std::cerr << "descriptor heap out of texture slots\n";
+            return 0;
+        }
+        uint32_t index = freeTextures.back();
+        freeTextures.pop_back();
+        writeTexture(index, {sampler, view, layout});
+        return index;
+    }
+
+    /**
+     * @return the buffer's heap index, or 0 (the default buffer) when the heap is full.
+     */
+    uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+    {
+        if (freeBuffers.empty())
+        {
+            std::cerr << "descriptor heap out of buffer slots\n";
+            return 0;
+        }
+        uint32_t index = freeBuffers.back();
+        freeBuffers.pop_back();
+        writeBuffer(index, {buffer, offset, range});
+        return index;
+    }
+
+    /**
+     * @brief points index back at the default texture and recycles it. No frame still in flight may be using index.
+     */
+    void removeTexture(uint32_t index)
+    {
+        if (index != 0)
+        {
+            writeTexture(index, defaultTexture);
+            freeTextures.push_back(index);
+        }
+    }
+
+    /**
+     * @brief points index back at the default buffer and recycles it. No frame still in flight may be using index.
+     */
+    void removeBuffer(uint32_t index)
+    {
+        if (index != 0)
+        {
+            writeBuffer(index, defaultBuffer);
+            freeBuffers.push_back(index);
+        }
+    }
+
+    /**
+     * @brief applies pending slot writes to the set slotIndex will bind, coalescing runs of adjacent slots into one VkWriteDescriptorSet. Call once per frame after the slot's fence has signaled and before recording.
+     */
+    void flush(uint32_t slotIndex)
+    {
+        uint32_t setIndex = bindless ? 0 : slotIndex;
+        std::vector<VkWriteDescriptorSet> writes;
+        appendWrites(writes, setIndex, textureBinding, dirtyTextures[setIndex]);
+        appendWrites(writes, setIndex, bufferBinding, dirtyBuffers[setIndex]);
+        if (!writes.empty())
+        {
+            vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+            descriptorWrites += writes.size();
+        }
+        dirtyTextures[setIndex].clear();
+        dirtyBuffers[setIndex].clear();
+    }
+
+    /**
+     * @brief binds the heap as set 0; once per command buffer (secondaries included, they don't inherit it).
+     */
+    void bind(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t slotIndex) const
+    {
+        VkDescriptorSet set = sets[bindless ? 0 : slotIndex];
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &set, 0, nullptr);
+    }
+
+    VkDescriptorSetLayout layout() const
+    {
+        return setLayout;
+    }
+
+    bool isBindless() const
+    {
+        return bindless;
+    }
+
+    uint32_t textureCapacity() const
+    {
+        return static_cast<uint32_t>(textureSlots.size());
+    }
+
+    uint32_t bufferCapacity() const
+    {
+        return static_cast<uint32_t>(bufferSlots.size());
+    }
+
+    void printStats(std::ostream &out) const
+    {
+        out << "descriptor heap: " << (bindless ? "bindless (update-after-bind)" : "fallback (one set per frame slot)")
+            << ", textures " << textureCapacity() - 1 - freeTextures.size() << '/' << textureCapacity() - 1
+            << ", buffers " << bufferCapacity() - 1 - freeBuffers.size() << '/' << bufferCapacity() - 1
+            << ", " << descriptorWrites << " descriptor writes\n";
+    }
+
+private:
+    void writeTexture(uint32_t index, const VkDescriptorImageInfo &info)
+    {
+        textureSlots[index] = info;
+        for (auto &dirty : dirtyTextures)
+        {
+            dirty.insert(index);
+        }
+    }
+
+    void writeBuffer(uint32_t index, const VkDescriptorBufferInfo &info)
+    {
+        bufferSlots[index] = info;
+        for (auto &dirty : dirtyBuffers)
+        {
+            dirty.insert(index);
+        }
+    }
+
+    void appendWrites(std::vector<VkWriteDescriptorSet> &writes, uint32_t setIndex, uint32_t binding, const std::set<uint32_t> &dirty) const
+    {
+        auto it = dirty.begin();
+        while (it != dirty.end())
+        {
+            uint32_t first = *it;
+            uint32_t count = 1;
+            while (++it != dirty.end() && *it == first + count)
+            {
+                count++;
+            }
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = sets[setIndex];
+            write.dstBinding = binding;
+            write.dstArrayElement = first;
+            write.descriptorCount = count;
+            if (binding == textureBinding)
+            {
+                write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                write.pImageInfo = &textureSlots[first];
+            }
+            else
+            {
+                write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                write.pBufferInfo = &bufferSlots[first];
+            }
+            writes.push_back(write);
+        }
+    }
+
+    VkDevice device = VK_NULL_HANDLE;
+    bool bindless = false;
+    uint32_t setCount = 0;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> sets;
+
+    // what every slot should point at; the sets catch up in flush().
+    std::vector<VkDescriptorImageInfo> textureSlots;
+    std::vector<VkDescriptorBufferInfo> bufferSlots;
+    VkDescriptorImageInfo defaultTexture{};
+    VkDescriptorBufferInfo defaultBuffer{};
+    std::vector<uint32_t> freeTextures;
+    std::vector<uint32_t> freeBuffers;
+    // per set, which slots changed since that set was last flushed.
+    std::vector<std::set<uint32_t>> dirtyTextures;
+    std::vector<std::set<uint32_t>> dirtyBuffers;
+    uint64_t descriptorWrites = 0;
+};
@@ -0,0 +1,660 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief the handful of vk* memory entry points the allocator needs, pulled out into a table so it can be driven by a fake device (e.g. a scripted VkPhysicalDeviceMemoryProperties and malloc-backed "memory") with no GPU around.
+ */
+struct DeviceMemoryBackend
+{
+    std::function<VkResult(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory *memory)> allocate;
+    std::function<void(VkDeviceMemory memory)> free;
+    std::function<VkResult(VkDeviceMemory memory, void **mapped)> map;
+    std::function<void(VkDeviceMemory memory)> unmap;
+
+    static DeviceMemoryBackend forDevice(VkDevice device)
+    {
+        DeviceMemoryBackend backend;
+        backend.allocate = [device](uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory *memory)
+        {
+            VkMemoryAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize = size;
+            allocInfo.memoryTypeIndex = memoryTypeIndex;
+            return vkAllocateMemory(device, &allocInfo, nullptr, memory);
+        };
+        backend.free = [device](VkDeviceMemory memory)
+        { vkFreeMemory(device, memory, nullptr); };
+        backend.map = [device](VkDeviceMemory memory, void **mapped)
+        { return vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped); };
+        backend.unmap = [device](VkDeviceMemory memory)
+        { vkUnmapMemory(device, memory); };
+        return backend;
+    }
+};
+
+/**
+ * Whether a resource is laid out linearly (buffers, linear-tiled images) or opaquely (optimal-tiled images). The two may not share a bufferImageGranularity-sized page of the same VkDeviceMemory, so the allocator needs to know which is which.
+ */
+enum class ResourceKind
+{
+    Linear,
+    Optimal,
+};
+
+/**
+ * @brief one sub-allocation handed out by DeviceAllocator. Bind with memory + offset; mapped is non-null for host-visible memory requested as mapped and already points at offset.
+ */
+struct DeviceAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void *mapped = nullptr;
+    uint32_t memoryTypeIndex = 0;
+
+    // bookkeeping for free(); callers shouldn't need these.
+    uint32_t poolIndex = 0;
+    uint32_t blockIndex = 0;
+    bool dedicated = false;
+
+    bool valid() const
+    {
+        return memory != VK_NULL_HANDLE;
+    }
+};
+
+/**
+ * @brief binary buddy allocator over one VkDeviceMemory block.
+ *
+ * Chunks come in power-of-two multiples of minChunkSize and are aligned to their own size, which gets us any power-of-two alignment for free and makes merging on free a single XOR to find the buddy. The price is internal fragmentation (a 65 KiB request eats a 128 KiB chunk), which we report separately so it doesn't get confused with the external kind.
+ */
+class BuddyBlock
+{
+public:
+    BuddyBlock(VkDeviceSize blockSize, VkDeviceSize minChunkSize)
+        : blockSize(blockSize), minChunkSize(minChunkSize)
+    {
+        maxOrder = 0;
+        while ((minChunkSize << maxOrder) < blockSize)
+        {
+            maxOrder++;
+        }
+        freeLists.resize(maxOrder + 1);
+        freeLists[maxOrder].push_back(0);
+        freeBytes = blockSize;
+    }
+
+    /**
+     * @return the chunk offset, or -1 if no chunk big enough is free.
+     */
+    int64_t allocate(VkDeviceSize size, VkDeviceSize alignment)
+    {
+        uint32_t order = orderFor(std::max(size, alignment));
+        if (order > maxOrder)
+        {
+            return -1;
+        }
+
+        uint32_t found = order;
+        while (found <= maxOrder && freeLists[found].empty())
+        {
+            found++;
+        }
+        if (found > maxOrder)
+        {
+            return -1;
+        }
+
+        VkDeviceSize offset = freeLists[found].back();
+        freeLists[found].pop_back();
+        // split down to the order we actually need, putting the upper halves back on the free lists.
+        while (found > order)
+        {
+            found--;
+            freeLists[found].push_back(offset + (minChunkSize << found));
+        }
+
+        allocatedOrders[offset] = order;
+        freeBytes -= minChunkSize << order;
+        return static_cast<int64_t>(offset);
+    }
+
+    void free(VkDeviceSize offset)
+    {
+        auto it = allocatedOrders.find(offset);
+        if (it == allocatedOrders.end())
+        {
+            throw std::runtime_error("buddy free of an offset that was never allocated!");
+        }
+        uint32_t order = it->second;
+        allocatedOrders.erase(it);
+        freeBytes += minChunkSize << order;
+
+        // keep merging with our buddy for as long as it's free too.
+        while (order < maxOrder)
+        {
+            VkDeviceSize buddy = offset ^ (minChunkSize << order);
+            auto &list = freeLists[order];
+            auto buddyIt = std::find(list.begin(), list.end(), buddy);
+            if (buddyIt == list.end())
+            {
+                break;
+            }
+            list.erase(buddyIt);
+            offset = std::min(offset, buddy);
+            order++;
+        }
+        freeLists[order].push_back(offset);
+    }
+
+    bool empty() const
+    {
+        return allocatedOrders.empty();
+    }
+
+    VkDeviceSize getFreeBytes() const
+    {
+        return freeBytes;
+    }
+
+    VkDeviceSize largestFreeChunk() const
+    {
+        for (int32_t order = static_cast<int32_t>(maxOrder); order >= 0; order--)
+        {
+            if (!freeLists[order].empty())
+            {
+                return minChunkSize << order;
+            }
+        }
+        return 0;
+    }
+
+    VkDeviceSize chunkSizeFor(VkDeviceSize size, VkDeviceSize alignment) const
+    {
+        return minChunkSize << orderFor(std::max(size, alignment));
+    }
+
+private:
+    uint32_t orderFor(VkDeviceSize size) const
+    {
+        uint32_t order = 0;
+        while ((minChunkSize << order) < size)
+        {
+            order++;
+        }
+        return order;
+    }
+
+    VkDeviceSize blockSize;
+    VkDeviceSize minChunkSize;
+    uint32_t maxOrder;
+    VkDeviceSize freeBytes;
+    std::vector<std::vector<VkDeviceSize>> freeLists;
+    std::unordered_map<VkDeviceSize, uint32_t> allocatedOrders;
+};
+
+/**
+ * @brief general purpose device memory allocator: a pool of buddy-managed blocks per (memory type, resource kind), so the app makes a handful of vkAllocateMemory calls instead of one per resource. Drivers cap the number of live allocations (maxMemoryAllocationCount, often just 4096) and each call can take a while, so this matters well before memory itself gets tight.
+ *
+ * Requests bigger than a block get their own dedicated VkDeviceMemory. bufferImageGranularity is handled by rounding every chunk up to the granularity when it's small (chunks are aligned to their size, so neighbours can never share a page), and by keeping linear and optimal resources in separate pools when it's big enough that rounding would waste real memory.
+ */
+class DeviceAllocator
+{
+public:
+    struct Config
+    {
+        // preferred size of each VkDeviceMemory block; shrunk for small heaps so one block can't hog the heap.
+        VkDeviceSize preferredBlockSize = 64ull * 1024 * 1024;
+        VkDeviceSize minChunkSize = 256;
+        // granularities above this get separate linear/optimal pools instead of rounding.
+        VkDeviceSize maxRoundedGranularity = 4096;
+    };
+
+    DeviceAllocator() = default;
+    DeviceAllocator(const DeviceAllocator &) = delete;
+    DeviceAllocator &operator=(const DeviceAllocator &) = delete;
+
+    ~DeviceAllocator()
+    {
+        destroy();
+    }
+
+    void init(DeviceMemoryBackend backend, const VkPhysicalDeviceMemoryProperties &memoryProperties, VkDeviceSize bufferImageGranularity)
+    {
+        init(std::move(backend), memoryProperties, bufferImageGranularity, Config{});
+    }
+
+    void init(DeviceMemoryBackend backend, const VkPhysicalDeviceMemoryProperties &memoryProperties, VkDeviceSize bufferImageGranularity, const Config &config)
+    {
+        this->backend = std::move(backend);
+        this->memoryProperties = memoryProperties;
+        this->config = config;
+        granularity = std::max<VkDeviceSize>(bufferImageGranularity, 1);
+        splitByKind = granularity > config.maxRoundedGranularity;
+        pools.clear();
+        pools.resize(memoryProperties.memoryTypeCount * 2);
+        for (uint32_t typeIndex = 0; typeIndex < memoryProperties.memoryTypeCount; typeIndex++)
+        {
+            for (uint32_t kind = 0; kind < 2; kind++)
+            {
+                Pool &pool = pools[typeIndex * 2 + kind];
+                pool.memoryTypeIndex = typeIndex;
+                pool.blockSize = blockSizeFor(typeIndex);
+                pool.minChunkSize = splitByKind ? config.minChunkSize : std::max(config.minChunkSize, granularity);
+            }
+        }
+    }
+
+    /**
+     * @brief picks a memory type allowed by memoryTypeBits with all of the required flags, favouring the one that also has the most preferred flags.
+     * @return the type index, or -1 if nothing fits.
+     */
+    int32_t findMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+    {
+        int32_t best = -1;
+        int bestScore = -1;
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+            if (!(memoryTypeBits & (1u << i)) || (flags & required) != required)
+            {
+                continue;
+            }
+            int score = __builtin_popcount(flags & preferred);
+            if (score > bestScore)
+            {
+                best = static_cast<int32_t>(i);
+                bestScore = score;
+            }
+        }
+        return best;
+    }
+
+    DeviceAllocation allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, ResourceKind kind, bool mapped)
+    {
+        int32_t typeIndex = findMemoryType(requirements.memoryTypeBits, required, preferred);
+        if (typeIndex < 0)
+        {
+            throw std::runtime_error("failed to find suitable memory type!");
+        }
+
+        uint32_t poolIndex = static_cast<uint32_t>(typeIndex) * 2 + (splitByKind && kind == ResourceKind::Optimal ? 1 : 0);
+        Pool &pool = pools[poolIndex];
+        pool.requestedBytes += requirements.size;
+        pool.allocationCount++;
+
+        if (requirements.size > pool.blockSize / 2)
+        {
+            return allocateDedicated(pool, poolIndex, requirements.size, mapped);
+        }
+
+        for (uint32_t blockIndex = 0; blockIndex < pool.blocks.size(); blockIndex++)
+        {
+            DeviceAllocation allocation = tryAllocateFromBlock(pool, poolIndex, blockIndex, requirements, mapped);
+            if (allocation.valid())
+            {
+                return allocation;
+            }
+        }
+
+        pool.blocks.push_back(createBlock(pool));
+        return tryAllocateFromBlock(pool, poolIndex, static_cast<uint32_t>(pool.blocks.size() - 1), requirements, mapped);
+    }
+
+    void free(DeviceAllocation &allocation)
+    {
+        // after destroy() the memory is already gone with its block.
+        if (!allocation.valid() || pools.empty())
+        {
+            allocation = {};
+            return;
+        }
+        Pool &pool = pools[allocation.poolIndex];
+        pool.requestedBytes -= allocation.size;
+        pool.allocationCount--;
+
+        if (allocation.dedicated)
+        {
+            if (allocation.mapped != nullptr)
+            {
+                backend.unmap(allocation.memory);
+            }
+            backend.free(allocation.memory);
+            pool.dedicated.erase(allocation.memory);
+            pool.dedicatedBytes -= allocation.size;
+            pool.dedicatedCount--;
+            liveDeviceMemoryCount--;
+        }
+        else
+        {
+            Block &block = *pool.blocks[allocation.blockIndex];
+            block.buddy.free(allocation.offset);
+            pool.usedChunkBytes -= block.chunkBytes[allocation.offset];
+            block.chunkBytes.erase(allocation.offset);
+            releaseEmptyBlocks(pool);
+        }
+        allocation = {};
+    }
+
+    /**
+     * @brief convenience: allocate for and bind a buffer in one go.
+     */
+    DeviceAllocation allocateForBuffer(VkDevice device, VkBuffer buffer, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, bool mapped)
+    {
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, buffer, &requirements);
+        DeviceAllocation allocation = allocate(requirements, required, preferred, ResourceKind::Linear, mapped);
+        vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+        return allocation;
+    }
+
+    /**
+     * @brief convenience: allocate for and bind an image in one go.
+     */
+    DeviceAllocation allocateForImage(VkDevice device, VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+    {
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device, image, &requirements);
+        ResourceKind kind = tiling == VK_IMAGE_TILING_LINEAR ? ResourceKind::Linear : ResourceKind::Optimal;
+        DeviceAllocation allocation = allocate(requirements, required, preferred, kind, false);
+        vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+        return allocation;
+    }
+
+    /**
+     * @brief frees every block and dedicated allocation regardless of outstanding allocations; call at shutdown once all resources are gone. Safe to call twice, and the destructor calls it too, so an unwind that never reaches cleanup doesn't leak device memory.
+     */
+    void destroy()
+    {
+        for (auto &pool : pools)
+        {
+            for (auto &block : pool.blocks)
+            {
+                destroyBlock(*block);
+            }
+            pool.blocks.clear();
+            for (auto [memory, mapped] : pool.dedicated)
+            {
+                if (mapped)
+                {
+                    backend.unmap(memory);
+                }
+                backend.free(memory);
+                liveDeviceMemoryCount--;
+            }
+            pool.dedicated.clear();
+        }
+        pools.clear();
+    }
+
+    /**
+     * @brief per-heap utilization and fragmentation. Utilization is requested bytes over bytes we got from vkAllocateMemory; internal fragmentation is what buddy rounding wasted; external fragmentation is 1 - largest free chunk / total free, i.e. how chopped up the free space is.
+     */
+    void printStats(std::ostream &out) const
+    {
+        out << "device allocator: " << liveDeviceMemoryCount << " live vkAllocateMemory allocation(s), " << totalDeviceMemoryCalls << " call(s) total\n";
+        for (uint32_t heap = 0; heap < memoryProperties.memoryHeapCount; heap++)
+        {
+            VkDeviceSize reserved = 0, requested = 0, usedChunks = 0, freeBytes = 0, largestFree = 0;
+            uint32_t allocations = 0, blocks = 0, dedicated = 0;
+            for (const auto &pool : pools)
+            {
+                if (memoryProperties.memoryTypes[pool.memoryTypeIndex].heapIndex != heap)
+                {
+                    continue;
+                }
+                requested += pool.requestedBytes;
+                usedChunks += pool.usedChunkBytes + pool.dedicatedBytes;
+                reserved += pool.dedicatedBytes;
+                allocations += pool.allocationCount;
+                dedicated += pool.dedicatedCount;
+                for (const auto &block : pool.blocks)
+                {
+                    blocks++;
+                    reserved += pool.blockSize;
+                    freeBytes += block->buddy.getFreeBytes();
+                    largestFree = std::max(largestFree, block->buddy.largestFreeChunk());
+                }
+            }
+            if (allocations == 0 && blocks == 0)
+            {
+                continue;
+            }
+
+            double utilization = reserved > 0 ? static_cast<double>(requested) / static_cast<double>(reserved) : 0.0;
+            double internal = usedChunks > 0 ? 1.0 - static_cast<double>(requested) / static_cast<double>(usedChunks) : 0.0;
+            double external = freeBytes > 0 ? 1.0 - static_cast<double>(largestFree) / static_cast<double>(freeBytes) : 0.0;
+            out << std::fixed << std::setprecision(1)
+                << "\theap " << heap << ": " << allocations << " allocation(s) in " << blocks << " block(s) + " << dedicated << " dedicated, "
+                << requested / 1024.0 << " KiB requested of " << reserved / 1024.0 << " KiB reserved, utilization " << utilization * 100.0
+                << "%, internal fragmentation " << internal * 100.0 << "%, external fragmentation " << external * 100.0 << "%\n";
+            out.unsetf(std::ios::floatfield);
+        }
+    }
+
+    uint32_t liveDeviceMemoryAllocations() const
+    {
+        return liveDeviceMemoryCount;
+    }
+
+private:
+    struct Block
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void *mapping = nullptr;
+        BuddyBlock buddy;
+        // chunk size actually handed out per offset, for stats.
+        std::unordered_map<VkDeviceSize, VkDeviceSize> chunkBytes;
+
+        Block(VkDeviceSize size, VkDeviceSize minChunk) : buddy(size, minChunk) {}
+    };
+
+    struct Pool
+    {
+        uint32_t memoryTypeIndex = 0;
+        VkDeviceSize blockSize = 0;
+        VkDeviceSize minChunkSize = 0;
+        std::vector<std::unique_ptr<Block>> blocks;
+        // live dedicated allocations and whether they're mapped, so destroy() can release ones nobody freed.
+        std::unordered_map<VkDeviceMemory, bool> dedicated;
+        VkDeviceSize requestedBytes = 0;
+        VkDeviceSize usedChunkBytes = 0;
+        VkDeviceSize dedicatedBytes = 0;
+        uint32_t allocationCount = 0;
+        uint32_t dedicatedCount = 0;
+    };
+
+    VkDeviceSize blockSizeFor(uint32_t typeIndex) const
+    {
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[typeIndex].heapIndex].size;
+        VkDeviceSize blockSize = config.preferredBlockSize;
+        // small heaps (e.g. the 256 MiB host-visible device-local BAR window) get blocks no bigger than an eighth of the heap.
+        while (blockSize > config.minChunkSize && blockSize > heapSize / 8)
+        {
+            blockSize /= 2;
+        }
+        return blockSize;
+    }
+
+    std::unique_ptr<Block> createBlock(Pool &pool)
+    {
+        auto block = std::make_unique<Block>(pool.blockSize, pool.minChunkSize);
+        if (backend.allocate(pool.memoryTypeIndex, pool.blockSize, &block->memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate device memory block!");
+        }
+        totalDeviceMemoryCalls++;
+        liveDeviceMemoryCount++;
+        return block;
+    }
+
+    void destroyBlock(Block &block)
+    {
+        if (block.mapping != nullptr)
+        {
+            backend.unmap(block.memory);
+        }
+        backend.free(block.memory);
+        liveDeviceMemoryCount--;
+    }
+
+    /**
+     * @brief drops empty blocks but always keeps one around, so a pool that bounces between zero and one allocation doesn't hammer vkAllocateMemory.
+     */
+    void releaseEmptyBlocks(Pool &pool)
+    {
+        size_t emptyBlocks = 0;
+        for (const auto &block : pool.blocks)
+        {
+            emptyBlocks += block->buddy.empty() ? 1 : 0;
+        }
+        // only trailing blocks can go without invalidating the blockIndex of live allocations.
+        while (emptyBlocks > 1 && pool.blocks.back()->buddy.empty())
+        {
+            destroyBlock(*pool.blocks.back());
+            pool.blocks.pop_back();
+            emptyBlocks--;
+        }
+    }
+
+    DeviceAllocation tryAllocateFromBlock(Pool &pool, uint32_t poolIndex, uint32_t blockIndex, const VkMemoryRequirements &requirements, bool mapped)
+    {
+        Block &block = *pool.blocks[blockIndex];
+        int64_t offset = block.buddy.allocate(requirements.size, requirements.alignment);
+        if (offset < 0)
+        {
+            return {};
+        }
+        if (mapped && block.mapping == nullptr && backend.map(block.memory, &block.mapping) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to map device memory block!");
+        }
+
+        VkDeviceSize chunk = block.buddy.chunkSizeFor(requirements.size, requirements.alignment);
+        block.chunkBytes[static_cast<VkDeviceSize>(offset)] = chunk;
+        pool.usedChunkBytes += chunk;
+
+        DeviceAllocation allocation;
+        allocation.memory = block.memory;
+        allocation.offset = static_cast<VkDeviceSize>(offset);
+        allocation.size = requirements.size;
+        allocation.memoryTypeIndex = pool.memoryTypeIndex;
+        allocation.poolIndex = poolIndex;
+        allocation.blockIndex = blockIndex;
+        allocation.mapped = mapped ? static_cast<char *>(block.mapping) + offset : nullptr;
+        return allocation;
+    }
+
+    DeviceAllocation allocateDedicated(Pool &pool, uint32_t poolIndex, VkDeviceSize size, bool mapped)
+    {
+        DeviceAllocation allocation;
+        if (backend.allocate(pool.memoryTypeIndex, size, &allocation.memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate dedicated device memory!");
+        }
+        totalDeviceMemoryCalls++;
+        if (mapped && backend.map(allocation.memory, &allocation.mapped) != VK_SUCCESS)
+        {
+            backend.free(allocation.memory);
+            throw std::runtime_error("failed to map dedicated device memory!");
+        }
+        liveDeviceMemoryCount++;
+        allocation.size = size;
+        allocation.memoryTypeIndex = pool.memoryTypeIndex;
+        allocation.poolIndex = poolIndex;
+        allocation.dedicated = true;
+        pool.dedicated[allocation.memory] = allocation.mapped != nullptr;
+        pool.dedicatedBytes += size;
+        pool.dedicatedCount++;
+        return allocation;
+    }
+
+    DeviceMemoryBackend backend;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    Config config;
+    VkDeviceSize granularity = 1;
+    bool splitByKind = false;
+    std::vector<Pool> pools;
+    uint32_t liveDeviceMemoryCount = 0;
+    uint32_t totalDeviceMemoryCalls = 0;
+};
+
+/**
+ * @brief move-only owner of one DeviceAllocation, freed back to its allocator when it goes out of scope; the UniqueHandle of sub-allocations. Declare it after the allocator it came from, and reach the allocation's fields (memory, offset, mapped) through ->.
+ */
+class UniqueAllocation
+{
+public:
+    UniqueAllocation() = default;
+
+    UniqueAllocation(DeviceAllocator &allocator, const DeviceAllocation &allocation) : allocator(&allocator), allocation(allocation) {}
+
+    ~UniqueAllocation()
+    {
+        reset();
+    }
+
+    UniqueAllocation(const UniqueAllocation &) = delete;
+    UniqueAllocation &operator=(const UniqueAllocation &) = delete;
+
+    UniqueAllocation(UniqueAllocation &&other) noexcept : allocator(other.allocator), allocation(other.allocation)
+    {
+        other.allocator = nullptr;
+        other.allocation = {};
+    }
+
+    UniqueAllocation &operator=(UniqueAllocation &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            allocator = other.allocator;
+            allocation = other.allocation;
+            other.allocator = nullptr;
+            other.allocation = {};
+        }
+        return *this;
+    }
+
+    /**
+     * @brief frees the allocation now, if there is one.
+     */
+    void reset()
+    {
+        if (allocator != nullptr)
+        {
+            allocator->free(allocation);
+            allocator = nullptr;
+        }
+    }
+
+    bool valid() const
+    {
+        return allocation.valid();
+    }
+
+    const DeviceAllocation &get() const
+    {
+        return allocation;
+    }
+
+    const DeviceAllocation *operator->() const
+    {
+        return &allocation;
+    }
+
+private:
+    DeviceAllocator *allocator = nullptr;
+    DeviceAllocation allocation;
+};
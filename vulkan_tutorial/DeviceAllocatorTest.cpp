@@ -0,0 +1,288 @@
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DeviceAllocator.hpp"
+
+/**
+ * @brief a DeviceMemoryBackend over host memory: every "VkDeviceMemory" is a heap buffer, so mapped pointers are real and the test can see exactly which allocations are live.
+ */
+class FakeDeviceMemory
+{
+public:
+    DeviceMemoryBackend backend()
+    {
+        DeviceMemoryBackend backend;
+        backend.allocate = [this](uint32_t, VkDeviceSize size, VkDeviceMemory *memory)
+        {
+            // handles are never dereferenced by the allocator, so any unique non-null value will do.
+            *memory = reinterpret_cast<VkDeviceMemory>(static_cast<uintptr_t>(++nextHandle));
+            live[*memory].resize(static_cast<size_t>(size));
+            allocateCalls++;
+            return VK_SUCCESS;
+        };
+        backend.free = [this](VkDeviceMemory memory)
+        {
+            if (live.erase(memory) == 0)
+            {
+                badFrees++;
+            }
+        };
+        backend.map = [this](VkDeviceMemory memory, void **mapped)
+        {
+            *mapped = live.at(memory).data();
+            mappedCount++;
+            return VK_SUCCESS;
+        };
+        backend.unmap = [this](VkDeviceMemory)
+        { mappedCount--; };
+        return backend;
+    }
+
+    std::unordered_map<VkDeviceMemory, std::vector<char>> live;
+    uint64_t nextHandle = 0;
+    uint32_t allocateCalls = 0;
+    uint32_t badFrees = 0;
+    int32_t mappedCount = 0;
+};
+
+/**
+ * @brief a discrete-GPU-like table: a big device-local heap and a host-visible one.
+ */
+VkPhysicalDeviceMemoryProperties fakeMemoryProperties()
+{
+    VkPhysicalDeviceMemoryProperties properties{};
+    properties.memoryHeapCount = 2;
+    properties.memoryHeaps[0].size = 8ull * 1024 * 1024 * 1024;
+    properties.memoryHeaps[1].size = 8ull * 1024 * 1024 * 1024;
+    properties.memoryTypeCount = 2;
+    properties.memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    properties.memoryTypes[0].heapIndex = 0;
+    properties.memoryTypes[1].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    properties.memoryTypes[1].heapIndex = 1;
+    return properties;
+}
+
+// small blocks so a handful of allocations exercise splitting, new blocks and the dedicated path.
+constexpr VkDeviceSize BLOCK_SIZE = 1024 * 1024;
+
+DeviceAllocator::Config smallBlocks()
+{
+    DeviceAllocator::Config config;
+    config.preferredBlockSize = BLOCK_SIZE;
+    config.minChunkSize = 256;
+    return config;
+}
+
+VkMemoryRequirements requirements(VkDeviceSize size, VkDeviceSize alignment, uint32_t memoryTypeBits = 0x3)
+{
+    return {size, alignment, memoryTypeBits};
+}
+
+using Expect = std::function<void(bool ok, const std::string &what)>;
+
+void testBuddySplitAndMerge(const Expect &expect)
+{
+    BuddyBlock block(1024, 64);
+    int64_t a = block.allocate(64, 1);
+    int64_t b = block.allocate(64, 1);
+    int64_t c = block.allocate(128, 1);
+    expect(a == 0 && b == 64 && c == 128, "buddy splits the block from the bottom up: 0, 64, 128");
+    expect(block.getFreeBytes() == 1024 - 256 && block.largestFreeChunk() == 512, "buddy split leaves the upper halves free");
+    expect(block.allocate(2048, 1) == -1, "buddy refuses a request bigger than the block");
+
+    block.free(static_cast<VkDeviceSize>(b));
+    expect(block.largestFreeChunk() == 512, "freeing one half doesn't merge while its buddy is live");
+    block.free(static_cast<VkDeviceSize>(a));
+    block.free(static_cast<VkDeviceSize>(c));
+    expect(block.empty() && block.getFreeBytes() == 1024 && block.largestFreeChunk() == 1024, "freeing everything merges back into one chunk");
+    expect(block.allocate(1024, 1) == 0, "the merged block can be handed out whole");
+
+    bool threw = false;
+    try
+    {
+        block.free(512);
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    expect(threw, "buddy free of an offset that was never allocated throws");
+}
+
+void testAlignment(const Expect &expect)
+{
+    FakeDeviceMemory fake;
+    DeviceAllocator allocator;
+    allocator.init(fake.backend(), fakeMemoryProperties(), 1, smallBlocks());
+
+    bool aligned = true;
+    std::vector<DeviceAllocation> allocations;
+    // odd sizes against growing power-of-two alignments, interleaved so chunks of different orders share the block.
+    for (VkDeviceSize alignment : {1ull, 256ull, 4096ull, 64ull, 65536ull, 16ull})
+    {
+        DeviceAllocation allocation = allocator.allocate(requirements(1000, alignment), 0, 0, ResourceKind::Linear, false);
+        aligned = aligned && allocation.valid() && allocation.offset % alignment == 0;
+        allocations.push_back(allocation);
+    }
+    expect(aligned, "every sub-allocation honours its alignment");
+
+    bool disjoint = true;
+    for (size_t i = 0; i < allocations.size(); i++)
+    {
+        for (size_t j = i + 1; j < allocations.size(); j++)
+        {
+            const DeviceAllocation &x = allocations[i];
+            const DeviceAllocation &y = allocations[j];
+            disjoint = disjoint && (x.memory != y.memory || x.offset + x.size <= y.offset || y.offset + y.size <= x.offset);
+        }
+    }
+    expect(disjoint, "sub-allocations never overlap");
+    expect(fake.allocateCalls == 1, "small allocations share one block");
+
+    DeviceAllocation mapped = allocator.allocate(requirements(1000, 256, 0x2), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0, ResourceKind::Linear, true);
+    expect(mapped.memoryTypeIndex == 1 && mapped.mapped == fake.live.at(mapped.memory).data() + mapped.offset, "mapped pointer points at the allocation's offset");
+
+    for (auto &allocation : allocations)
+    {
+        allocator.free(allocation);
+    }
+    allocator.free(mapped);
+    expect(!mapped.valid(), "free() resets the allocation");
+}
+
+void testGranularity(const Expect &expect)
+{
+    // small granularity: linear and optimal share blocks, every chunk rounded up to a whole page.
+    {
+        FakeDeviceMemory fake;
+        DeviceAllocator allocator;
+        const VkDeviceSize granularity = 1024;
+        allocator.init(fake.backend(), fakeMemoryProperties(), granularity, smallBlocks());
+        DeviceAllocation buffer = allocator.allocate(requirements(100, 4), 0, 0, ResourceKind::Linear, false);
+        DeviceAllocation image = allocator.allocate(requirements(100, 4), 0, 0, ResourceKind::Optimal, false);
+        expect(buffer.memory == image.memory, "rounded granularity keeps linear and optimal in one block");
+        expect(buffer.offset / granularity != image.offset / granularity, "rounded granularity keeps linear and optimal on different pages");
+    }
+    // large granularity: rounding would waste too much, so the kinds get separate pools.
+    {
+        FakeDeviceMemory fake;
+        DeviceAllocator allocator;
+        const VkDeviceSize granularity = 64 * 1024;
+        allocator.init(fake.backend(), fakeMemoryProperties(), granularity, smallBlocks());
+        DeviceAllocation buffer = allocator.allocate(requirements(100, 4), 0, 0, ResourceKind::Linear, false);
+        DeviceAllocation image = allocator.allocate(requirements(100, 4), 0, 0, ResourceKind::Optimal, false);
+        DeviceAllocation buffer2 = allocator.allocate(requirements(100, 4), 0, 0, ResourceKind::Linear, false);
+        expect(buffer.memory != image.memory, "large granularity puts linear and optimal in separate blocks");
+        expect(buffer.memory == buffer2.memory && buffer2.offset - buffer.offset < granularity, "large granularity doesn't round chunks within one kind");
+    }
+}
+
+void testDedicatedThreshold(const Expect &expect)
+{
+    FakeDeviceMemory fake;
+    DeviceAllocator allocator;
+    allocator.init(fake.backend(), fakeMemoryProperties(), 1, smallBlocks());
+
+    DeviceAllocation half = allocator.allocate(requirements(BLOCK_SIZE / 2, 256), 0, 0, ResourceKind::Linear, false);
+    expect(!half.dedicated, "half a block still comes from a block");
+    DeviceAllocation big = allocator.allocate(requirements(BLOCK_SIZE / 2 + 1, 256), 0, 0, ResourceKind::Linear, false);
+    expect(big.dedicated && big.offset == 0 && big.memory != half.memory, "more than half a block gets its own memory");
+    DeviceAllocation bigMapped = allocator.allocate(requirements(2 * BLOCK_SIZE, 256, 0x2), 0, 0, ResourceKind::Linear, true);
+    expect(bigMapped.dedicated && bigMapped.mapped == fake.live.at(bigMapped.memory).data(), "dedicated allocations map too");
+    expect(allocator.liveDeviceMemoryAllocations() == 3 && fake.live.size() == 3, "one block plus two dedicated allocations are live");
+
+    allocator.free(big);
+    expect(fake.live.size() == 2 && allocator.liveDeviceMemoryAllocations() == 2, "freeing a dedicated allocation releases its memory");
+
+    // bigMapped and half are still live: destroy() must release them anyway.
+    allocator.destroy();
+    expect(fake.live.empty() && fake.mappedCount == 0 && fake.badFrees == 0, "destroy() frees blocks and live dedicated allocations exactly once");
+    allocator.free(half);
+    allocator.destroy();
+    expect(fake.badFrees == 0, "free() and destroy() after destroy() do nothing");
+
+    {
+        DeviceAllocator scoped;
+        scoped.init(fake.backend(), fakeMemoryProperties(), 1, smallBlocks());
+        scoped.allocate(requirements(4 * BLOCK_SIZE, 256), 0, 0, ResourceKind::Linear, false);
+        scoped.allocate(requirements(1024, 256), 0, 0, ResourceKind::Linear, false);
+    }
+    expect(fake.live.empty() && fake.badFrees == 0, "the destructor releases everything still allocated");
+}
+
+void testUniqueAllocation(const Expect &expect)
+{
+    FakeDeviceMemory fake;
+    DeviceAllocator allocator;
+    allocator.init(fake.backend(), fakeMemoryProperties(), 1, smallBlocks());
+
+    {
+        UniqueAllocation dedicated(allocator, allocator.allocate(requirements(BLOCK_SIZE, 256), 0, 0, ResourceKind::Linear, true));
+        expect(dedicated.valid() && dedicated->mapped == fake.live.at(dedicated->memory).data(), "UniqueAllocation exposes the allocation it owns");
+        UniqueAllocation moved = std::move(dedicated);
+        expect(!dedicated.valid() && moved.valid(), "moving a UniqueAllocation leaves the source empty");
+        moved = UniqueAllocation(allocator, allocator.allocate(requirements(1024, 256), 0, 0, ResourceKind::Linear, false));
+        expect(fake.live.size() == 1, "assigning over a UniqueAllocation frees what it held");
+    }
+    std::ostringstream stats;
+    allocator.printStats(stats);
+    expect(stats.str().find("heap 0: 0 allocation(s)") != std::string::npos && fake.badFrees == 0, "UniqueAllocation frees once when it goes out of scope");
+}
+
+void testFragmentationStats(const Expect &expect)
+{
+    FakeDeviceMemory fake;
+    DeviceAllocator allocator;
+    allocator.init(fake.backend(), fakeMemoryProperties(), 1, smallBlocks());
+
+    // 96 KiB rounds up to a 128 KiB chunk: 25% internal fragmentation. The split leaves 128 + 256 + 512 KiB free, so the largest free chunk is 512 of 896 KiB: 42.9% external. 96 of 1024 KiB reserved is 9.4% utilization.
+    DeviceAllocation allocation = allocator.allocate(requirements(96 * 1024, 256), 0, 0, ResourceKind::Linear, false);
+    std::ostringstream stats;
+    allocator.printStats(stats);
+    std::string text = stats.str();
+    expect(text.find("1 live vkAllocateMemory allocation(s), 1 call(s) total") != std::string::npos, "stats count vkAllocateMemory calls");
+    expect(text.find("heap 0: 1 allocation(s) in 1 block(s) + 0 dedicated") != std::string::npos, "stats count allocations per heap");
+    expect(text.find("96.0 KiB requested of 1024.0 KiB reserved, utilization 9.4%") != std::string::npos, "stats report utilization");
+    expect(text.find("internal fragmentation 25.0%") != std::string::npos, "stats report internal fragmentation");
+    expect(text.find("external fragmentation 42.9%") != std::string::npos, "stats report external fragmentation");
+    expect(text.find("heap 1") == std::string::npos, "stats skip untouched heaps");
+
+    allocator.free(allocation);
+    std::ostringstream empty;
+    allocator.printStats(empty);
+    expect(empty.str().find("internal fragmentation 0.0%, external fragmentation 0.0%") != std::string::npos, "freeing everything clears fragmentation");
+}
+
+/**
+ * @brief DeviceAllocator against FakeDeviceMemory and a scripted memory-properties table; no GPU, loader or driver needed.
+ */
+int main()
+{
+    uint32_t failures = 0;
+    Expect expect = [&](bool ok, const std::string &what)
+    {
+        if (!ok)
+        {
+            std::cerr << "check FAILED: " << what << '\n';
+            failures++;
+        }
+    };
+
+    testBuddySplitAndMerge(expect);
+    testAlignment(expect);
+    testGranularity(expect);
+    testDedicatedThreshold(expect);
+    testUniqueAllocation(expect);
+    testFragmentationStats(expect);
+
+    std::cout << "device allocator checks: " << (failures == 0 ? "all passed" : std::to_string(failures) + " FAILED") << '\n';
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
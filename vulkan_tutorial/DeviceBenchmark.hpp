@@ -0,0 +1,420 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "DeviceCapabilities.hpp"
+#include "ShaderReflection.hpp"
+
+/**
+ * @brief a few hundred ms of synthetic work on a candidate device, so selection can go by what it actually does rather than what its device type suggests.
+ *
+ * Each test runs on a throwaway logical device with one queue from a compute-capable family and no extensions or features, so it works on anything from a discrete GPU to lavapipe. Every test is submitted a few times and the fastest run counts; the first submission also pays for lazy driver setup and page faults. Timing is CPU wall time from submit to fence, which includes submission overhead; that's a rounding error next to the workloads here and it works on queues without timestamp support.
+ *
+ * Fill rate is approximated with vkCmdClearColorImage rather than drawing, which would need a render pass, a pipeline and shaders of its own. It tracks ROP/memory throughput closely enough to rank devices.
+ */
+class DeviceBenchmark
+{
+public:
+    /**
+     * @param computeSpirv shaders/bench.comp compiled; empty skips the compute test.
+     */
+    static DeviceBenchmarkResults run(const DeviceCapabilities &caps, std::span<const uint32_t> computeSpirv)
+    {
+        Session session(caps);
+        DeviceBenchmarkResults results;
+        results.copyGBPerSec = session.measureCopy();
+        results.fillGpixelsPerSec = session.measureFill();
+        if (!computeSpirv.empty())
+        {
+            results.computeGflops = session.measureCompute(computeSpirv);
+        }
+        results.measured = true;
+        return results;
+    }
+
+private:
+    static constexpr uint32_t repetitions = 3;
+    static constexpr VkDeviceSize copyBytes = 64ull * 1024 * 1024;
+    static constexpr uint32_t fillExtent = 2048;
+    static constexpr uint32_t fillClears = 8;
+    // specialized into shaders/bench.comp as local_size_x (constant 0) and ITERATIONS (constant 1).
+    static constexpr uint32_t computeGroupSize = 64;
+    static constexpr uint32_t computeIterations = 4096;
+    static constexpr uint32_t computeGroups = 1024;
+
+    /**
+     * @brief the throwaway device plus everything the tests create on it; the destructor tears down whatever got created, so a test that throws halfway doesn't leak into the real device's lifetime.
+     */
+    class Session
+    {
+    public:
+        explicit Session(const DeviceCapabilities &caps) : caps(caps)
+        {
+            uint32_t family = UINT32_MAX;
+            for (uint32_t i = 0; i < caps.queueFamilies.size(); i++)
+            {
+                VkQueueFlags flags = caps.queueFamilies[i].queueFlags;
+                // prefer the family that also does graphics; it's the one real frames will run on.
+                if ((flags & VK_QUEUE_COMPUTE_BIT) && (family == UINT32_MAX || (flags & VK_QUEUE_GRAPHICS_BIT)))
+                {
+                    family = i;
+                }
+            }
+            if (family == UINT32_MAX)
+            {
+                throw std::runtime_error("no compute-capable queue family to benchmark on!");
+            }
+
+            float priority = 1.0f;
+            VkDeviceQueueCreateInfo queueInfo{};
+            queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueInfo.queueFamilyIndex = family;
+            queueInfo.queueCount = 1;
+            queueInfo.pQueuePriorities = &priority;
+            VkDeviceCreateInfo deviceInfo{};
+            deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+            deviceInfo.queueCreateInfoCount = 1;
+            deviceInfo.pQueueCreateInfos = &queueInfo;
+            if (vkCreateDevice(caps.device, &deviceInfo, nullptr, &device) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create benchmark device!");
+            }
+            vkGetDeviceQueue(device, family, 0, &queue);
+
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            poolInfo.queueFamilyIndex = family;
+            if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create benchmark command pool!");
+            }
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate benchmark command buffer!");
+            }
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create benchmark fence!");
+            }
+        }
+
+        ~Session()
+        {
+            if (device == VK_NULL_HANDLE)
+            {
+                return;
+            }
+            vkDeviceWaitIdle(device);
+            for (VkPipeline pipeline : pipelines)
+            {
+                vkDestroyPipeline(device, pipeline, nullptr);
+            }
+            computeLayout.destroy();
+            for (VkShaderModule module : shaderModules)
+            {
+                vkDestroyShaderModule(device, module, nullptr);
+            }
+            for (VkDescriptorPool pool : descriptorPools)
+            {
+                vkDestroyDescriptorPool(device, pool, nullptr);
+            }
+            for (VkBuffer buffer : buffers)
+            {
+                vkDestroyBuffer(device, buffer, nullptr);
+            }
+            for (VkImage image : images)
+            {
+                vkDestroyImage(device, image, nullptr);
+            }
+            for (VkDeviceMemory memory : memories)
+            {
+                vkFreeMemory(device, memory, nullptr);
+            }
+            if (fence != VK_NULL_HANDLE)
+            {
+                vkDestroyFence(device, fence, nullptr);
+            }
+            if (commandPool != VK_NULL_HANDLE)
+            {
+                vkDestroyCommandPool(device, commandPool, nullptr);
+            }
+            vkDestroyDevice(device, nullptr);
+        }
+
+        Session(const Session &) = delete;
+        Session &operator=(const Session &) = delete;
+
+        /**
+         * @return GB/s copying one device-local buffer into another.
+         */
+        double measureCopy()
+        {
+            VkBuffer src = createBuffer(copyBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+            VkBuffer dst = createBuffer(copyBytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+            double seconds = bestOf([&](VkCommandBuffer cmd)
+                                    {
+                VkBufferCopy region{0, 0, copyBytes};
+                vkCmdCopyBuffer(cmd, src, dst, 1, &region); });
+            return static_cast<double>(copyBytes) / seconds / 1e9;
+        }
+
+        /**
+         * @return gigapixels/s cleared into a device-local RGBA8 image.
+         */
+        double measureFill()
+        {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+            imageInfo.extent = {fillExtent, fillExtent, 1};
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkImage image;
+            if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create benchmark image!");
+            }
+            images.push_back(image);
+            VkMemoryRequirements requirements;
+            vkGetImageMemoryRequirements(device, image, &requirements);
+            vkBindImageMemory(device, image, allocate(requirements), 0);
+
+            VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+            double seconds = bestOf([&](VkCommandBuffer cmd)
+                                    {
+                VkImageMemoryBarrier toTransfer{};
+                toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                toTransfer.image = image;
+                toTransfer.subresourceRange = range;
+                vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+                for (uint32_t i = 0; i < fillClears; i++)
+                {
+                    VkClearColorValue color = {{static_cast<float>(i) / fillClears, 0.5f, 0.25f, 1.0f}};
+                    vkCmdClearColorImage(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &range);
+                } });
+            return static_cast<double>(fillExtent) * fillExtent * fillClears / seconds / 1e9;
+        }
+
+        /**
+         * @return GFLOP/s of shaders/bench.comp, counting an FMA as two.
+         */
+        double measureCompute(std::span<const uint32_t> spirv)
+        {
+            VkShaderModuleCreateInfo moduleInfo{};
+            moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            moduleInfo.codeSize = spirv.size_bytes();
+            moduleInfo.pCode = spirv.data();
+            VkShaderModule module;
+            if (vkCreateShaderModule(device, &moduleInfo, nullptr, &module) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create benchmark shader module!");
+            }
+            shaderModules.push_back(module);
+
+            ShaderReflection reflection = ShaderReflection::reflect(spirv);
+            computeLayout.create(device, {&reflection});
+            VkPipelineLayout layout = computeLayout.pipelineLayout();
+            VkDescriptorSetLayout setLayout = computeLayout.setLayout(0);
+
+            SpecializationConstants constants;
+            constants.set(0, computeGroupSize).set(1, computeIterations);
+            constants.requireDeclaredBy(reflection, "bench.comp");
+            VkComputePipelineCreateInfo pipelineInfo{};
+            pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            pipelineInfo.stage.module = module;
+            pipelineInfo.stage.pName = "main";
+            pipelineInfo.stage.pSpecializationInfo = constants.info();
+            pipelineInfo.layout = layout;
+            VkPipeline pipeline;
+            if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create benchmark pipeline!");
+            }
+            pipelines.push_back(pipeline);
+
+            std::vector<VkDescriptorPoolSize> poolSizes = computeLayout.descriptorPoolSizes(1);
+            VkDescriptorPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            poolInfo.maxSets = 1;
+            poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+            poolInfo.pPoolSizes = poolSizes.data();
+            VkDescriptorPool pool;
+            if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create benchmark descriptor pool!");
+            }
+            descriptorPools.push_back(pool);
+            VkDescriptorSetAllocateInfo setInfo{};
+            setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            setInfo.descriptorPool = pool;
+            setInfo.descriptorSetCount = 1;
+            setInfo.pSetLayouts = &setLayout;
+            VkDescriptorSet set;
+            if (vkAllocateDescriptorSets(device, &setInfo, &set) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate benchmark descriptor set!");
+            }
+            // one vec4 per invocation, written once at the end so the FMA chain can't be optimized away.
+            VkDeviceSize outputBytes = static_cast<VkDeviceSize>(computeGroups) * computeGroupSize * 4 * sizeof(float);
+            VkBuffer output = createBuffer(outputBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+            VkDescriptorBufferInfo bufferInfo{output, 0, VK_WHOLE_SIZE};
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = set;
+            write.dstBinding = 0;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.pBufferInfo = &bufferInfo;
+            vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+            double seconds = bestOf([&](VkCommandBuffer cmd)
+                                    {
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+                vkCmdDispatch(cmd, computeGroups, 1, 1); });
+            double flops = static_cast<double>(computeGroups) * computeGroupSize * computeIterations * 4 * 2;
+            return flops / seconds / 1e9;
+        }
+
+    private:
+        /**
+         * @return the fastest of a few submissions of whatever record() puts in the command buffer, in seconds.
+         */
+        double bestOf(const std::function<void(VkCommandBuffer)> &record)
+        {
+            double best = 0.0;
+            // one extra, untimed, to get lazy allocation and shader compilation out of the way.
+            for (uint32_t run = 0; run <= repetitions; run++)
+            {
+                vkResetCommandBuffer(commandBuffer, 0);
+                VkCommandBufferBeginInfo beginInfo{};
+                beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                vkBeginCommandBuffer(commandBuffer, &beginInfo);
+                record(commandBuffer);
+                if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to record benchmark command buffer!");
+                }
+                VkSubmitInfo submitInfo{};
+                submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submitInfo.commandBufferCount = 1;
+                submitInfo.pCommandBuffers = &commandBuffer;
+                auto start = std::chrono::steady_clock::now();
+                if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to submit benchmark!");
+                }
+                vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                vkResetFences(device, 1, &fence);
+                if (run > 0 && (best == 0.0 || seconds < best))
+                {
+                    best = seconds;
+                }
+            }
+            // a timer that didn't tick shouldn't turn into an infinite score.
+            return std::max(best, 1e-6);
+        }
+
+        VkBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage)
+        {
+            VkBufferCreateInfo bufferInfo{};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.size = size;
+            bufferInfo.usage = usage;
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            VkBuffer buffer;
+            if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create benchmark buffer!");
+            }
+            buffers.push_back(buffer);
+            VkMemoryRequirements requirements;
+            vkGetBufferMemoryRequirements(device, buffer, &requirements);
+            vkBindBufferMemory(device, buffer, allocate(requirements), 0);
+            return buffer;
+        }
+
+        /**
+         * @brief dedicated allocation, device-local if the device has any such type; a few allocations for a few hundred ms don't need DeviceAllocator.
+         */
+        VkDeviceMemory allocate(const VkMemoryRequirements &requirements)
+        {
+            uint32_t typeIndex = UINT32_MAX;
+            for (uint32_t i = 0; i < caps.memory.memoryTypeCount; i++)
+            {
+                if ((requirements.memoryTypeBits & (1u << i)) == 0)
+                {
+                    continue;
+                }
+                if (typeIndex == UINT32_MAX || (caps.memory.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+                {
+                    typeIndex = i;
+                    if (caps.memory.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                    {
+                        break;
+                    }
+                }
+            }
+            if (typeIndex == UINT32_MAX)
+            {
+                throw std::runtime_error("no memory type for benchmark resource!");
+            }
+            VkMemoryAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize = requirements.size;
+            allocInfo.memoryTypeIndex = typeIndex;
+            VkDeviceMemory memory;
+            if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate benchmark memory!");
+            }
+            memories.push_back(memory);
+            return memory;
+        }
+
+        const DeviceCapabilities &caps;
+        VkDevice device = VK_NULL_HANDLE;
+        VkQueue queue = VK_NULL_HANDLE;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        std::vector<VkBuffer> buffers;
+        std::vector<VkImage> images;
+        std::vector<VkDeviceMemory> memories;
+        std::vector<VkShaderModule> shaderModules;
+        ReflectedLayout computeLayout;
+        std::vector<VkDescriptorPool> descriptorPools;
+        std::vector<VkPipeline> pipelines;
+    };
+};
@@ -0,0 +1,397 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief what the loader offers before we have an instance: layers and instance extensions, enumerated once and kept in hash sets so every later "is X supported?" is a lookup rather than another enumerate + string-compare scan.
+ */
+struct InstanceCapabilities
+{
+    std::unordered_set<std::string> layers;
+    std::unordered_set<std::string> extensions;
+
+    static InstanceCapabilities query()
+    {
+        InstanceCapabilities caps;
+        uint32_t layerCount = 0;
+        vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+        std::vector<VkLayerProperties> layers(layerCount);
+        vkEnumerateInstanceLayerProperties(&layerCount, layers.data());
+        for (const auto &layer : layers)
+        {
+            caps.layers.insert(layer.layerName);
+        }
+
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+        for (const auto &extension : extensions)
+        {
+            caps.extensions.insert(extension.extensionName);
+        }
+        return caps;
+    }
+
+    bool hasLayer(const std::string &name) const
+    {
+        return layers.count(name) != 0;
+    }
+
+    bool hasExtension(const std::string &name) const
+    {
+        return extensions.count(name) != 0;
+    }
+};
+
+/**
+ * @brief what DeviceBenchmark measured on a device; cached alongside its capabilities so it only runs on the first launch after a driver change.
+ */
+struct DeviceBenchmarkResults
+{
+    bool measured = false;
+    // image clears, as a stand-in for raw fill rate.
+    double fillGpixelsPerSec = 0.0;
+    // vec4 FMAs in a compute shader; 0 when the benchmark shader wasn't available.
+    double computeGflops = 0.0;
+    // device-local to device-local buffer copies.
+    double copyGBPerSec = 0.0;
+};
+
+/**
+ * @brief snapshot of everything we ask a physical device that doesn't depend on a surface: properties, features, memory heaps/types, queue families and extensions.
+ *
+ * Built once per device during selection and then treated as the single source of truth for selection and creation alike. Surface-dependent answers (present support, surface formats, present modes) are deliberately not in here; they change with the window and are cheap to ask for the one device we end up using.
+ */
+struct DeviceCapabilities
+{
+    VkPhysicalDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties properties{};
+    VkPhysicalDeviceFeatures features{};
+    VkPhysicalDeviceMemoryProperties memory{};
+    // indexed by queue family index.
+    std::vector<VkQueueFamilyProperties> queueFamilies;
+    std::unordered_set<std::string> extensions;
+    // not filled by query(); see DeviceBenchmark.hpp.
+    DeviceBenchmarkResults benchmark;
+    // true when everything past properties came out of DeviceCapabilityCache rather than the driver.
+    bool fromCache = false;
+
+    static DeviceCapabilities query(VkPhysicalDevice device)
+    {
+        DeviceCapabilities caps;
+        caps.device = device;
+        vkGetPhysicalDeviceProperties(device, &caps.properties);
+        vkGetPhysicalDeviceFeatures(device, &caps.features);
+        vkGetPhysicalDeviceMemoryProperties(device, &caps.memory);
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+        caps.queueFamilies.resize(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, caps.queueFamilies.data());
+
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+        for (const auto &extension : extensions)
+        {
+            caps.extensions.insert(extension.extensionName);
+        }
+        return caps;
+    }
+
+    bool hasExtension(const std::string &name) const
+    {
+        return extensions.count(name) != 0;
+    }
+};
+
+/**
+ * @brief on-disk DeviceCapabilities database so repeat launches skip the per-device feature/memory/queue/extension queries.
+ *
+ * vkGetPhysicalDeviceProperties is still called live for every device: it's cheap, and its vendorID + deviceID + driverVersion + apiVersion + pipelineCacheUUID make the cache key, so a driver update or a different ICD simply misses and gets re-queried (and re-benchmarked). The file is a flat binary dump of the POD structs and is only valid for the build that wrote it (struct sizes are checked on load); anything that doesn't parse is thrown away whole. Saves are write-temp-then-rename like PipelineCache.
+ */
+class DeviceCapabilityCache
+{
+public:
+    /**
+     * @param path file to load from and save to; empty disables the cache and lookup() always queries.
+     */
+    void load(const std::string &path)
+    {
+        this->path = path;
+        entries.clear();
+        if (path.empty())
+        {
+            return;
+        }
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return;
+        }
+        std::vector<char> blob((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (!parse(blob))
+        {
+            std::cout << "discarding device capability cache " << path << ": unrecognized or truncated\n";
+            entries.clear();
+        }
+    }
+
+    /**
+     * @return the device's capabilities, from the cache when its key matches, otherwise freshly queried (and remembered for save()).
+     */
+    DeviceCapabilities lookup(VkPhysicalDevice device)
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
+        if (!path.empty())
+        {
+            auto it = entries.find(keyFor(properties));
+            if (it != entries.end())
+            {
+                hits++;
+                DeviceCapabilities caps = it->second;
+                caps.device = device;
+                caps.properties = properties;
+                caps.fromCache = true;
+                return caps;
+            }
+        }
+        misses++;
+        DeviceCapabilities caps = DeviceCapabilities::query(device);
+        if (!path.empty())
+        {
+            entries[keyFor(caps.properties)] = caps;
+            dirty = true;
+        }
+        return caps;
+    }
+
+    /**
+     * @brief replaces the device's entry, e.g. once it has benchmark results, so save() writes them out.
+     */
+    void update(const DeviceCapabilities &caps)
+    {
+        if (path.empty())
+        {
+            return;
+        }
+        DeviceCapabilities &entry = entries[keyFor(caps.properties)];
+        entry = caps;
+        entry.fromCache = false;
+        dirty = true;
+    }
+
+    /**
+     * @brief writes the database back out if lookup() or update() learned anything new.
+     */
+    void save()
+    {
+        if (path.empty() || !dirty)
+        {
+            return;
+        }
+        std::vector<char> blob;
+        append(blob, magic);
+        append(blob, formatVersion);
+        appendLayoutSizes(blob);
+        append(blob, static_cast<uint32_t>(entries.size()));
+        for (const auto &[key, caps] : entries)
+        {
+            append(blob, caps.properties);
+            append(blob, caps.features);
+            append(blob, caps.memory);
+            append(blob, static_cast<uint32_t>(caps.queueFamilies.size()));
+            for (const auto &family : caps.queueFamilies)
+            {
+                append(blob, family);
+            }
+            append(blob, static_cast<uint32_t>(caps.extensions.size()));
+            for (const auto &extension : caps.extensions)
+            {
+                append(blob, static_cast<uint32_t>(extension.size()));
+                blob.insert(blob.end(), extension.begin(), extension.end());
+            }
+            append(blob, caps.benchmark);
+        }
+
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+            if (!file)
+            {
+                std::cerr << "failed to write device capability cache to " << tempPath << '\n';
+                return;
+            }
+        }
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            std::cerr << "failed to move device capability cache into place at " << path << '\n';
+            std::remove(tempPath.c_str());
+            return;
+        }
+        dirty = false;
+    }
+
+    uint32_t hitCount() const
+    {
+        return hits;
+    }
+
+    uint32_t missCount() const
+    {
+        return misses;
+    }
+
+private:
+    static constexpr uint32_t magic = 0x43444b56; // "VKDC"
+    static constexpr uint32_t formatVersion = 2;
+
+    static std::string keyFor(const VkPhysicalDeviceProperties &properties)
+    {
+        std::string key;
+        key.append(reinterpret_cast<const char *>(&properties.vendorID), sizeof(properties.vendorID));
+        key.append(reinterpret_cast<const char *>(&properties.deviceID), sizeof(properties.deviceID));
+        key.append(reinterpret_cast<const char *>(&properties.driverVersion), sizeof(properties.driverVersion));
+        key.append(reinterpret_cast<const char *>(&properties.apiVersion), sizeof(properties.apiVersion));
+        key.append(reinterpret_cast<const char *>(properties.pipelineCacheUUID), VK_UUID_SIZE);
+        return key;
+    }
+
+    template <typename T>
+    static void append(std::vector<char> &blob, const T &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        blob.insert(blob.end(), bytes, bytes + sizeof(T));
+    }
+
+    // a file written against different Vulkan headers would have different struct layouts, so record the sizes and refuse to load on mismatch.
+    static void appendLayoutSizes(std::vector<char> &blob)
+    {
+        append(blob, static_cast<uint32_t>(sizeof(VkPhysicalDeviceProperties)));
+        append(blob, static_cast<uint32_t>(sizeof(VkPhysicalDeviceFeatures)));
+        append(blob, static_cast<uint32_t>(sizeof(VkPhysicalDeviceMemoryProperties)));
+        append(blob, static_cast<uint32_t>(sizeof(VkQueueFamilyProperties)));
+        append(blob, static_cast<uint32_t>(sizeof(DeviceBenchmarkResults)));
+    }
+
+    /**
+     * @brief bounds-checked cursor over the loaded blob; every read fails once the blob runs out.
+     */
+    struct Reader
+    {
+        const std::vector<char> &blob;
+        size_t offset = 0;
+
+        template <typename T>
+        bool read(T &value)
+        {
+            if (blob.size() - offset < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&value, blob.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return true;
+        }
+
+        bool readString(std::string &value, uint32_t length)
+        {
+            if (blob.size() - offset < length)
+            {
+                return false;
+            }
+            value.assign(blob.data() + offset, length);
+            offset += length;
+            return true;
+        }
+    };
+
+    bool parse(const std::vector<char> &blob)
+    {
+        Reader reader{blob};
+        uint32_t fileMagic = 0;
+        uint32_t fileVersion = 0;
+        if (!reader.read(fileMagic) || !reader.read(fileVersion) || fileMagic != magic || fileVersion != formatVersion)
+        {
+            return false;
+        }
+        std::vector<char> expectedSizes;
+        appendLayoutSizes(expectedSizes);
+        if (blob.size() < reader.offset + expectedSizes.size() || std::memcmp(blob.data() + reader.offset, expectedSizes.data(), expectedSizes.size()) != 0)
+        {
+            return false;
+        }
+        reader.offset += expectedSizes.size();
+
+        uint32_t entryCount = 0;
+        if (!reader.read(entryCount))
+        {
+            return false;
+        }
+        for (uint32_t entry = 0; entry < entryCount; entry++)
+        {
+            DeviceCapabilities caps;
+            uint32_t queueFamilyCount = 0;
+            if (!reader.read(caps.properties) || !reader.read(caps.features) || !reader.read(caps.memory) || !reader.read(queueFamilyCount))
+            {
+                return false;
+            }
+            // a corrupt count shouldn't get to size an allocation.
+            if (queueFamilyCount > (blob.size() - reader.offset) / sizeof(VkQueueFamilyProperties))
+            {
+                return false;
+            }
+            caps.queueFamilies.resize(queueFamilyCount);
+            for (auto &family : caps.queueFamilies)
+            {
+                if (!reader.read(family))
+                {
+                    return false;
+                }
+            }
+            uint32_t extensionCount = 0;
+            if (!reader.read(extensionCount))
+            {
+                return false;
+            }
+            for (uint32_t i = 0; i < extensionCount; i++)
+            {
+                uint32_t length = 0;
+                std::string name;
+                if (!reader.read(length) || !reader.readString(name, length))
+                {
+                    return false;
+                }
+                caps.extensions.insert(std::move(name));
+            }
+            if (!reader.read(caps.benchmark))
+            {
+                return false;
+            }
+            entries[keyFor(caps.properties)] = std::move(caps);
+        }
+        return reader.offset == blob.size();
+    }
+
+    std::string path;
+    std::unordered_map<std::string, DeviceCapabilities> entries;
+    bool dirty = false;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DeviceCapabilities.hpp"
+
+/**
+ * @brief weights for ranking suitable devices, loadable from a plain "key = value" file (see device_scoring.cfg).
+ *
+ * A score is a weighted sum of what we know about the device: its type, the size of its biggest device-local heap, whether it has dedicated compute/transfer queues and, when DeviceBenchmark has run on it, how fast it actually is. Defaults let measured numbers dominate whenever there are any. The policy can also require VkPhysicalDeviceFeatures by name; a device missing one is unsuitable no matter its score. Nothing is required by default, so lavapipe and integrated/mobile GPUs are all in the running.
+ */
+struct ScoringPolicy
+{
+    double discreteGpu = 1000.0;
+    double integratedGpu = 500.0;
+    double virtualGpu = 250.0;
+    double cpu = 50.0;
+    double otherType = 0.0;
+    // per GiB of the largest DEVICE_LOCAL heap.
+    double perDeviceLocalGiB = 100.0;
+    double dedicatedComputeQueue = 50.0;
+    double dedicatedTransferQueue = 50.0;
+    double perFillGpixelsPerSec = 100.0;
+    double perComputeGflops = 10.0;
+    double perCopyGBPerSec = 20.0;
+    // run DeviceBenchmark on devices that don't have cached results yet.
+    bool benchmark = false;
+    // VkPhysicalDeviceFeatures member names.
+    std::vector<std::string> requiredFeatures;
+
+    /**
+     * @brief reads "key = value" lines over the defaults; blank lines and # comments are skipped and "require" may repeat. Unknown keys and feature names are errors rather than silently ignored typos.
+     */
+    static ScoringPolicy load(const std::string &path)
+    {
+        ScoringPolicy policy;
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open scoring policy " + path);
+        }
+        std::string line;
+        uint32_t lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            lineNumber++;
+            line = line.substr(0, line.find('#'));
+            size_t equals = line.find('=');
+            std::string key = trim(line.substr(0, equals));
+            if (key.empty())
+            {
+                continue;
+            }
+            if (equals == std::string::npos)
+            {
+                throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected key = value");
+            }
+            std::string value = trim(line.substr(equals + 1));
+            if (key == "require")
+            {
+                if (featureOffset(value) == SIZE_MAX)
+                {
+                    throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": unknown feature " + value);
+                }
+                policy.requiredFeatures.push_back(value);
+            }
+            else if (key == "benchmark")
+            {
+                policy.benchmark = value == "true" || value == "1";
+            }
+            else if (double *weight = policy.weight(key))
+            {
+                *weight = std::stod(value);
+            }
+            else
+            {
+                throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": unknown key " + key);
+            }
+        }
+        return policy;
+    }
+
+    /**
+     * @return the first required feature the device lacks, or an empty string if it has them all.
+     */
+    std::string missingFeature(const VkPhysicalDeviceFeatures &features) const
+    {
+        for (const auto &name : requiredFeatures)
+        {
+            const VkBool32 *value = reinterpret_cast<const VkBool32 *>(reinterpret_cast<const char *>(&features) + featureOffset(name));
+            if (*value != VK_TRUE)
+            {
+                return name;
+            }
+        }
+        return {};
+    }
+
+    double score(const DeviceCapabilities &caps) const
+    {
+        double total = 0.0;
+        switch (caps.properties.deviceType)
+        {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            total += discreteGpu;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            total += integratedGpu;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            total += virtualGpu;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            total += cpu;
+            break;
+        default:
+            total += otherType;
+            break;
+        }
+
+        VkDeviceSize largestLocalHeap = 0;
+        for (uint32_t i = 0; i < caps.memory.memoryHeapCount; i++)
+        {
+            if (caps.memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            {
+                largestLocalHeap = std::max(largestLocalHeap, caps.memory.memoryHeaps[i].size);
+            }
+        }
+        total += perDeviceLocalGiB * static_cast<double>(largestLocalHeap) / (1024.0 * 1024.0 * 1024.0);
+
+        bool dedicatedCompute = std::any_of(caps.queueFamilies.begin(), caps.queueFamilies.end(), [](const VkQueueFamilyProperties &family)
+                                            { return (family.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(family.queueFlags & VK_QUEUE_GRAPHICS_BIT); });
+        bool dedicatedTransfer = std::any_of(caps.queueFamilies.begin(), caps.queueFamilies.end(), [](const VkQueueFamilyProperties &family)
+                                             { return (family.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)); });
+        total += dedicatedCompute ? dedicatedComputeQueue : 0.0;
+        total += dedicatedTransfer ? dedicatedTransferQueue : 0.0;
+
+        if (caps.benchmark.measured)
+        {
+            total += perFillGpixelsPerSec * caps.benchmark.fillGpixelsPerSec;
+            total += perComputeGflops * caps.benchmark.computeGflops;
+            total += perCopyGBPerSec * caps.benchmark.copyGBPerSec;
+        }
+        return total;
+    }
+
+private:
+    double *weight(const std::string &key)
+    {
+        const std::pair<const char *, double *> weights[] = {
+            {"discreteGpu", &discreteGpu},
+            {"integratedGpu", &integratedGpu},
+            {"virtualGpu", &virtualGpu},
+            {"cpu", &cpu},
+            {"otherType", &otherType},
+            {"perDeviceLocalGiB", &perDeviceLocalGiB},
+            {"dedicatedComputeQueue", &dedicatedComputeQueue},
+            {"dedicatedTransferQueue", &dedicatedTransferQueue},
+            {"perFillGpixelsPerSec", &perFillGpixelsPerSec},
+            {"perComputeGflops", &perComputeGflops},
+            {"perCopyGBPerSec", &perCopyGBPerSec},
+        };
+        for (const auto &[name, value] : weights)
+        {
+            if (key == name)
+            {
+                return value;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @return byte offset of the named member in VkPhysicalDeviceFeatures, or SIZE_MAX if there's no such feature.
+     */
+    static size_t featureOffset(const std::string &name)
+    {
+#define FEATURE(member) {#member, offsetof(VkPhysicalDeviceFeatures, member)}
+        static const std::pair<const char *, size_t> features[] = {
+            FEATURE(robustBufferAccess), FEATURE(fullDrawIndexUint32), FEATURE(imageCubeArray), FEATURE(independentBlend),
+            FEATURE(geometryShader), FEATURE(tessellationShader), FEATURE(sampleRateShading), FEATURE(dualSrcBlend),
+            FEATURE(logicOp), FEATURE(multiDrawIndirect), FEATURE(drawIndirectFirstInstance), FEATURE(depthClamp),
+            FEATURE(depthBiasClamp), FEATURE(fillModeNonSolid), FEATURE(depthBounds), FEATURE(wideLines),
+            FEATURE(largePoints), FEATURE(alphaToOne), FEATURE(multiViewport), FEATURE(samplerAnisotropy),
+            FEATURE(textureCompressionETC2), FEATURE(textureCompressionASTC_LDR), FEATURE(textureCompressionBC), FEATURE(occlusionQueryPrecise),
+            FEATURE(pipelineStatisticsQuery), FEATURE(vertexPipelineStoresAndAtomics), FEATURE(fragmentStoresAndAtomics), FEATURE(shaderTessellationAndGeometryPointSize),
+            FEATURE(shaderImageGatherExtended), FEATURE(shaderStorageImageExtendedFormats), FEATURE(shaderStorageImageMultisample), FEATURE(shaderStorageImageReadWithoutFormat),
+            FEATURE(shaderStorageImageWriteWithoutFormat), FEATURE(shaderUniformBufferArrayDynamicIndexing), FEATURE(shaderSampledImageArrayDynamicIndexing), FEATURE(shaderStorageBufferArrayDynamicIndexing),
+            FEATURE(shaderStorageImageArrayDynamicIndexing), FEATURE(shaderClipDistance), FEATURE(shaderCullDistance), FEATURE(shaderFloat64),
+            FEATURE(shaderInt64), FEATURE(shaderInt16), FEATURE(shaderResourceResidency), FEATURE(shaderResourceMinLod),
+            FEATURE(sparseBinding), FEATURE(sparseResidencyBuffer), FEATURE(sparseResidencyImage2D), FEATURE(sparseResidencyImage3D),
+            FEATURE(sparseResidency2Samples), FEATURE(sparseResidency4Samples), FEATURE(sparseResidency8Samples), FEATURE(sparseResidency16Samples),
+            FEATURE(sparseResidencyAliased), FEATURE(variableMultisampleRate), FEATURE(inheritedQueries),
+        };
+#undef FEATURE
+        // every member is a VkBool32, so this catches one missing from the table.
+        static_assert(std::size(features) == sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32), "featureOffset() must name every VkPhysicalDeviceFeatures member");
+        for (const auto &[feature, offset] : features)
+        {
+            if (name == feature)
+            {
+                return offset;
+            }
+        }
+        return SIZE_MAX;
+    }
+
+    static std::string trim(const std::string &text)
+    {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos)
+        {
+            return {};
+        }
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+};
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DeviceCapabilities.hpp"
+#include "DeviceScoring.hpp"
+
+struct QueueFamilyIndices
+{
+    std::optional<uint32_t> graphicsFamily;
+    std::optional<uint32_t> presentFamily;
+    // only set when the device has a compute family without graphics (async compute) or a transfer family with neither (usually a DMA engine); otherwise that work shares the graphics queue.
+    std::optional<uint32_t> computeFamily;
+    std::optional<uint32_t> transferFamily;
+    /**
+     * @param requirePresent false in headless mode, where nobody ever presents and a graphics queue is all we need.
+     */
+    bool isComplete(bool requirePresent = true) const
+    {
+        return graphicsFamily.has_value() && (presentFamily.has_value() || !requirePresent);
+    }
+};
+
+struct SwapChainSupportDetails
+{
+    VkSurfaceCapabilitiesKHR capabilities;
+    std::vector<VkSurfaceFormatKHR> formats;
+    std::vector<VkPresentModeKHR> presentModes;
+};
+
+/**
+ * @brief what the app needs from a device before it'll even score it.
+ */
+struct DeviceRequirements
+{
+    // device extensions we can't live without.
+    std::vector<const char *> extensions;
+    // false in headless mode: no present queue, no swapchain checks.
+    bool present = true;
+    // --gpu-cull's features: multiDrawIndirect, drawIndirectFirstInstance and dynamic indexing into storage buffer arrays.
+    bool gpuDrivenDraws = false;
+};
+
+/**
+ * @brief the device selection path on its own: queue family matching, extension and swapchain checks, and ranking under a ScoringPolicy. Everything surface-independent comes from DeviceCapabilities snapshots; the surface (VK_NULL_HANDLE when headless) is only asked about present support, formats and present modes.
+ *
+ * Kept out of the application class so InitBench can drive exactly the same code against MockVulkan's scripted devices.
+ */
+class DeviceSelector
+{
+public:
+    DeviceSelector(const ScoringPolicy &policy, DeviceRequirements requirements, VkSurfaceKHR surface)
+        : policy(policy), requirements(std::move(requirements)), surface(surface)
+    {
+    }
+
+    QueueFamilyIndices findQueueFamilies(const DeviceCapabilities &caps) const
+    {
+        QueueFamilyIndices indices;
+        // Assign index to queue families that could be found. The family list itself comes from the capability snapshot; only present support is asked live, since it depends on the surface.
+        VkPhysicalDevice device = caps.device;
+        const std::vector<VkQueueFamilyProperties> &queueFamilies = caps.queueFamilies;
+        uint32_t queueFamilyCount = static_cast<uint32_t>(queueFamilies.size());
+
+        // families are reported in index order, so the position in the vector *is* the family index. Scan them all rather than bailing at the first hit: we want a graphics family that can also present (so presenting never needs an ownership transfer), plus any dedicated compute/transfer families, and those tend to come after graphics.
+        for (uint32_t i = 0; i < queueFamilyCount; i++)
+        {
+            VkQueueFlags flags = queueFamilies[i].queueFlags;
+            VkBool32 presentSupport = false;
+            // no surface means nothing to present to, so don't bother asking.
+            if (surface != VK_NULL_HANDLE)
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            }
+
+            if (flags & VK_QUEUE_GRAPHICS_BIT)
+            {
+                bool upgradesToPresent = presentSupport && !(indices.presentFamily.has_value() && indices.presentFamily == indices.graphicsFamily);
+                if (!indices.graphicsFamily.has_value() || upgradesToPresent)
+                {
+                    indices.graphicsFamily = i;
+                    if (presentSupport)
+                    {
+                        indices.presentFamily = i;
+                    }
+                }
+            }
+            if (presentSupport && !indices.presentFamily.has_value())
+            {
+                indices.presentFamily = i;
+            }
+            if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT) && !indices.computeFamily.has_value())
+            {
+                indices.computeFamily = i;
+            }
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && !indices.transferFamily.has_value())
+            {
+                indices.transferFamily = i;
+            }
+        }
+
+        return indices;
+    }
+
+    bool checkDeviceExtensionSupport(const DeviceCapabilities &caps) const
+    {
+        return std::all_of(requirements.extensions.begin(), requirements.extensions.end(), [&caps](const char *name)
+                           { return caps.hasExtension(name); });
+    }
+
+    /**
+     * Checks the swapchain properties supported by the input device, e.g. surface capabilities such as min/max number of images, surface formats such as color space, and available presentation modes.
+     * @return a SwapChainSupportDetails struct populated for the given device.
+     */
+    SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) const
+    {
+        SwapChainSupportDetails details;
+
+        // query surface cap
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
+
+        // query surface formats
+        uint32_t formatCount;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
+        if (formatCount != 0)
+        {
+            details.formats.resize(formatCount);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
+        }
+
+        // query present modes
+        uint32_t presentModeCount;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
+
+        if (presentModeCount != 0)
+        {
+            details.presentModes.resize(presentModeCount);
+            vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
+        }
+
+        return details;
+    }
+
+    /**
+     * @param log where the per-device lines go; nullptr for none.
+     * @return the device's score under the policy, or 0 if it can't run us at all: missing queue families, extensions, features the policy or the requirements ask for, or (when presenting) an unusable swapchain.
+     */
+    double rate(const DeviceCapabilities &device, std::ostream *log) const
+    {
+        const VkPhysicalDeviceProperties &deviceProperties = device.properties;
+        const VkPhysicalDeviceFeatures &deviceFeatures = device.features;
+
+        if (log != nullptr)
+        {
+            *log << "Considering gpu device " << deviceProperties.deviceName << '\n';
+        }
+
+        // the guesswork (device type, memory, queues) and the measurements, if any, all come from the policy.
+        double score = policy.score(device);
+
+        // Application can't function without the required Q family(ies) and extensions
+        QueueFamilyIndices indices = findQueueFamilies(device);
+        if (!indices.isComplete(requirements.present) || !checkDeviceExtensionSupport(device))
+        {
+            return 0;
+        }
+        std::string missing = policy.missingFeature(deviceFeatures);
+        if (!missing.empty())
+        {
+            if (log != nullptr)
+            {
+                *log << "\tmissing required feature " << missing << '\n';
+            }
+            return 0;
+        }
+        // --gpu-cull needs many draws per indirect call, firstInstance to carry the object index, and a push-constant index into the heap's buffer array to find the object data; draw_indirect_count itself was checked with the other extensions.
+        else if (requirements.gpuDrivenDraws && (!deviceFeatures.multiDrawIndirect || !deviceFeatures.drawIndirectFirstInstance || !deviceFeatures.shaderStorageBufferArrayDynamicIndexing))
+        {
+            return 0;
+        }
+        else if (requirements.present)
+        {
+            // now that we know we support the required extensions, including swapchain, we can query the swapchain capabilities to see if those meet our minimum requirements.
+            SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device.device);
+            bool swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+            if (!swapChainAdequate)
+            {
+                return 0;
+            }
+
+            // finally, last minute adjustments for optimal nice-to-haves now that we've passed our minimum viability checks and gathered all the details.
+            if (indices.graphicsFamily == indices.presentFamily)
+            {
+                // slight bump for a device whose gfx and present Q are the same guy, for efficiency.
+                score += 100;
+            }
+        }
+
+        if (log != nullptr)
+        {
+            *log << "\tscore " << score << (device.benchmark.measured ? " (measured)" : " (unmeasured)") << '\n';
+        }
+        // a policy with zero or negative weights mustn't make a working device look unsuitable.
+        return std::max(score, 1e-3);
+    }
+
+    /**
+     * @return every suitable device, best first; ties keep enumeration order.
+     */
+    std::vector<const DeviceCapabilities *> rank(const std::vector<DeviceCapabilities> &devices, std::ostream *log) const
+    {
+        // Use an ordered map to automatically sort candidates by decreasing score
+        std::multimap<double, const DeviceCapabilities *, std::greater<double>> candidates;
+        for (const auto &device : devices)
+        {
+            candidates.insert(std::make_pair(rate(device, log), &device));
+        }
+
+        std::vector<const DeviceCapabilities *> suitable;
+        for (auto it = candidates.begin(); it != candidates.end() && it->first > 0; ++it)
+        {
+            suitable.push_back(it->second);
+        }
+        return suitable;
+    }
+
+private:
+    ScoringPolicy policy;
+    DeviceRequirements requirements;
+    VkSurfaceKHR surface;
+};
@@ -0,0 +1,105 @@
+// build-time helper: turns compiled SPIR-V files into a header of constexpr uint32_t arrays, so the app carries its shaders in the binary instead of reading them at startup.
+// usage: EmbedSpirv OUTPUT.hpp SHADER.spv...
+// Build/shaders/cull.comp.opt.spv becomes embedded_shaders::cull_comp, listed in embedded_shaders::all under the name "cull.comp".
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Shader
+{
+    std::string name;
+    std::string identifier;
+    std::vector<uint32_t> words;
+};
+
+static std::string shaderName(const std::string &path)
+{
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    for (const char *suffix : {".opt.spv", ".spv"})
+    {
+        std::string s = suffix;
+        if (name.size() > s.size() && name.compare(name.size() - s.size(), s.size(), s) == 0)
+        {
+            return name.substr(0, name.size() - s.size());
+        }
+    }
+    return name;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " OUTPUT.hpp SHADER.spv...\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Shader> shaders;
+    for (int i = 2; i < argc; i++)
+    {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file.is_open())
+        {
+            std::cerr << "failed to open " << argv[i] << '\n';
+            return EXIT_FAILURE;
+        }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (bytes.size() % 4 != 0 || bytes.size() < 20)
+        {
+            std::cerr << argv[i] << " isn't SPIR-V (size " << bytes.size() << " isn't a whole number of words)\n";
+            return EXIT_FAILURE;
+        }
+        Shader shader;
+        shader.name = shaderName(argv[i]);
+        shader.identifier = shader.name;
+        for (char &c : shader.identifier)
+        {
+            c = (c == '.' || c == '-') ? '_' : c;
+        }
+        shader.words.resize(bytes.size() / 4);
+        for (size_t w = 0; w < shader.words.size(); w++)
+        {
+            // SPIR-V is a stream of little-endian words; assemble them explicitly so the header is right whatever the build host is.
+            const unsigned char *b = reinterpret_cast<const unsigned char *>(&bytes[w * 4]);
+            shader.words[w] = uint32_t(b[0]) | uint32_t(b[1]) << 8 | uint32_t(b[2]) << 16 | uint32_t(b[3]) << 24;
+        }
+        if (shader.words[0] != 0x07230203u)
+        {
+            std::cerr << argv[i] << " isn't SPIR-V (bad magic number)\n";
+            return EXIT_FAILURE;
+        }
+        shaders.push_back(std::move(shader));
+    }
+
+    std::ofstream out(argv[1]);
+    out << "// generated by EmbedSpirv from the optimized SPIR-V in Build/shaders; don't edit, edit shaders/ and rebuild.\n"
+        << "#pragma once\n\n#include <cstddef>\n#include <cstdint>\n\nnamespace embedded_shaders\n{\n";
+    out << std::hex;
+    for (const auto &shader : shaders)
+    {
+        out << "constexpr uint32_t " << shader.identifier << "[] = {";
+        for (size_t w = 0; w < shader.words.size(); w++)
+        {
+            out << (w % 8 == 0 ? "\n    " : " ") << "0x" << shader.words[w] << "u,";
+        }
+        out << "\n};\n";
+    }
+    out << std::dec;
+    out << "\nstruct Entry\n{\n    const char *name;\n    const uint32_t *words;\n    size_t wordCount;\n};\n\n"
+        << "constexpr Entry all[] = {\n";
+    for (const auto &shader : shaders)
+    {
+        out << "    {\"" << shader.name << "\", " << shader.identifier << ", sizeof(" << shader.identifier << ") / sizeof(uint32_t)},\n";
+    }
+    out << "};\n} // namespace embedded_shaders\n";
+    if (!out.good())
+    {
+        std::cerr << "failed to write " << argv[1] << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * @brief writes a tightly packed RGBA8 frame out as a binary PPM (P6), dropping the alpha channel since PPM has no notion of it.
+ * @param path file to (over)write.
+ * @param rgba pointer to width * height * 4 bytes of pixel data, rows top to bottom.
+ */
+inline void writeFramePpm(const std::string &path, const uint8_t *rgba, uint32_t width, uint32_t height)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("failed to open " + path + " for frame dump!");
+    }
+    file << "P6\n"
+         << width << ' ' << height << "\n255\n";
+
+    std::string row(width * 3, '\0');
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t *src = rgba + static_cast<size_t>(y) * width * 4;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            row[x * 3 + 0] = static_cast<char>(src[x * 4 + 0]);
+            row[x * 3 + 1] = static_cast<char>(src[x * 4 + 1]);
+            row[x * 3 + 2] = static_cast<char>(src[x * 4 + 2]);
+        }
+        file.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+}
+
+/**
+ * @brief POSIX shared memory sink for rendered frames so another process (encoder, test harness, whatever) can pick them up without touching the disk.
+ *
+ * Layout of the segment is a SharedFrameHeader followed immediately by one RGBA8 frame. The writer bumps frameIndex after the pixels land, so a reader polling frameIndex sees a complete frame as long as it copies out before the next publish; it's a mailbox, not a queue.
+ */
+class SharedMemoryFrameSink
+{
+public:
+    struct SharedFrameHeader
+    {
+        uint32_t magic;
+        uint32_t width;
+        uint32_t height;
+        uint32_t bytesPerPixel;
+        // 0 until the first frame lands, then the 1-based index of the most recent frame.
+        uint64_t frameIndex;
+    };
+
+    static constexpr uint32_t MAGIC = 0x564B4652; // "VKFR"
+
+    SharedMemoryFrameSink(const std::string &name, uint32_t width, uint32_t height)
+        : name(name), size(sizeof(SharedFrameHeader) + static_cast<size_t>(width) * height * 4)
+    {
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("failed to open shared memory segment " + name);
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            close(fd);
+            throw std::runtime_error("failed to size shared memory segment " + name);
+        }
+        mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("failed to map shared memory segment " + name);
+        }
+
+        auto *header = static_cast<SharedFrameHeader *>(mapping);
+        header->magic = MAGIC;
+        header->width = width;
+        header->height = height;
+        header->bytesPerPixel = 4;
+        header->frameIndex = 0;
+    }
+
+    ~SharedMemoryFrameSink()
+    {
+        munmap(mapping, size);
+        shm_unlink(name.c_str());
+    }
+
+    SharedMemoryFrameSink(const SharedMemoryFrameSink &) = delete;
+    SharedMemoryFrameSink &operator=(const SharedMemoryFrameSink &) = delete;
+
+    void publish(const uint8_t *rgba, uint64_t frameIndex)
+    {
+        auto *header = static_cast<SharedFrameHeader *>(mapping);
+        std::memcpy(header + 1, rgba, size - sizeof(SharedFrameHeader));
+        __atomic_store_n(&header->frameIndex, frameIndex + 1, __ATOMIC_RELEASE);
+    }
+
+private:
+    std::string name;
+    size_t size;
+    void *mapping = nullptr;
+};
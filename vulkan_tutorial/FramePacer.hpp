@@ -0,0 +1,239 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <ostream>
+#include <thread>
+
+#include "Stats.hpp"
+
+/**
+ * @brief what decides when the next frame starts.
+ */
+enum class PacingMode
+{
+    // as fast as acquire lets us; the old behavior, and what the benchmarks want.
+    Uncapped,
+    // FIFO present mode: acquire blocks until vblank frees an image.
+    Vsync,
+    // a fixed rate from the CPU clock, sleep plus spin; works headless too.
+    TargetFps,
+    // VK_KHR_present_wait: each frame starts once the previous one is on screen, so there's never more than one frame queued behind the display.
+    PresentWait,
+};
+
+/**
+ * @brief CPU side of frame pacing: holds frames to a target rate and records how evenly they actually start.
+ *
+ * Sleeping alone is too coarse for a frame deadline (the scheduler wakes us a millisecond or more late, more on a loaded box) and spinning alone burns a core, so it sleeps until just short of the deadline and spins with yield() for the rest. Deadlines advance by exactly one period so small wakeup errors don't accumulate into drift; after a stall of more than a frame the schedule restarts from now rather than bursting to catch up. The Vsync and PresentWait modes are paced by the presentation engine, so waitForNextFrame() only records the interval for them.
+ */
+class FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void configure(PacingMode mode, double targetFps)
+    {
+        pacingMode = mode;
+        if (targetFps > 0.0)
+        {
+            period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+        }
+    }
+
+    PacingMode mode() const
+    {
+        return pacingMode;
+    }
+
+    /**
+     * @brief call once per frame, right before polling input, so the frame samples input as late as possible.
+     */
+    void waitForNextFrame()
+    {
+        if (pacingMode == PacingMode::TargetFps)
+        {
+            auto now = Clock::now();
+            if (!deadline || *deadline + period < now)
+            {
+                deadline = now;
+            }
+            sleepUntil(*deadline);
+            *deadline += period;
+        }
+        auto start = Clock::now();
+        if (lastFrameStart)
+        {
+            intervalStats.add(std::chrono::duration<double, std::milli>(start - *lastFrameStart).count());
+        }
+        lastFrameStart = start;
+    }
+
+    /**
+     * @brief forget the schedule, e.g. after sitting idle in glfwWaitEvents(), so the gap doesn't show up as one huge frame interval.
+     */
+    void reset()
+    {
+        deadline.reset();
+        lastFrameStart.reset();
+    }
+
+    void printStats(std::ostream &out)
+    {
+        if (intervalStats.count() > 0)
+        {
+            intervalStats.print(out, "frame start interval");
+        }
+        if (lateWakeStats.count() > 0)
+        {
+            lateWakeStats.print(out, "pacer late by");
+        }
+    }
+
+private:
+    // how early to stop sleeping and start spinning; covers typical scheduler wakeup latency on desktop Linux and Windows.
+    static constexpr std::chrono::microseconds spinWindow{1500};
+
+    void sleepUntil(Clock::time_point target)
+    {
+        if (target - Clock::now() > spinWindow)
+        {
+            std::this_thread::sleep_until(target - spinWindow);
+        }
+        while (Clock::now() < target)
+        {
+            std::this_thread::yield();
+        }
+        lateWakeStats.add(std::chrono::duration<double, std::milli>(Clock::now() - target).count());
+    }
+
+    PacingMode pacingMode = PacingMode::Uncapped;
+    Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / 60.0));
+    std::optional<Clock::time_point> deadline;
+    std::optional<Clock::time_point> lastFrameStart;
+    SampleStats intervalStats;
+    SampleStats lateWakeStats;
+};
+
+/**
+ * @brief input → submit → present-complete latency per frame.
+ *
+ * Input time is when GLFW handed us the earliest event not yet consumed by a frame, from inside glfwPollEvents(); GLFW doesn't expose OS event timestamps, so time spent in the OS queue before the poll isn't counted. Frames with no new input only count towards submit → present. Present-complete times need VK_KHR_present_id + VK_KHR_present_wait: frames are tagged with a present ID and the caller reports when vkWaitForPresentKHR says it reached the screen. That is exact in PresentWait pacing, which blocks on it anyway; in the other modes it's polled once per frame and so lands up to one frame late.
+ */
+class LatencyTracker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief from the GLFW input callbacks.
+     */
+    void inputArrived()
+    {
+        if (!pendingInput)
+        {
+            pendingInput = Clock::now();
+        }
+    }
+
+    /**
+     * @brief call right after the frame's vkQueueSubmit.
+     * @param presentId the ID the frame will be presented with, or 0 without VK_KHR_present_id.
+     */
+    void submitted(uint64_t presentId)
+    {
+        auto now = Clock::now();
+        if (pendingInput)
+        {
+            inputToSubmit.add(std::chrono::duration<double, std::milli>(now - *pendingInput).count());
+        }
+        if (presentId != 0)
+        {
+            inFlight.push_back({presentId, pendingInput, now});
+            // a present that never completes (the swapchain went away under it) mustn't grow this forever.
+            if (inFlight.size() > maxInFlight)
+            {
+                inFlight.pop_front();
+                lost++;
+            }
+        }
+        pendingInput.reset();
+    }
+
+    /**
+     * @return the oldest present ID not yet known to be on screen.
+     */
+    std::optional<uint64_t> oldestInFlight() const
+    {
+        if (inFlight.empty())
+        {
+            return std::nullopt;
+        }
+        return inFlight.front().presentId;
+    }
+
+    /**
+     * @brief presentId, and everything before it, reached the screen by `when`. Frames a mailbox swapchain replaced before they were shown complete along with the one that replaced them, so their latency reads high; it's what the user saw, though.
+     */
+    void presented(uint64_t presentId, Clock::time_point when)
+    {
+        while (!inFlight.empty() && inFlight.front().presentId <= presentId)
+        {
+            const Frame &frame = inFlight.front();
+            submitToPresent.add(std::chrono::duration<double, std::milli>(when - frame.submit).count());
+            if (frame.input)
+            {
+                inputToPresent.add(std::chrono::duration<double, std::milli>(when - *frame.input).count());
+            }
+            inFlight.pop_front();
+        }
+    }
+
+    /**
+     * @brief drops frames still waiting to be presented, e.g. because their swapchain was just replaced and can't be waited on any more.
+     */
+    void forgetInFlight()
+    {
+        lost += inFlight.size();
+        inFlight.clear();
+    }
+
+    void printStats(std::ostream &out)
+    {
+        if (inputToSubmit.count() > 0)
+        {
+            inputToSubmit.print(out, "latency input to submit");
+        }
+        if (submitToPresent.count() > 0)
+        {
+            submitToPresent.print(out, "latency submit to present");
+        }
+        if (inputToPresent.count() > 0)
+        {
+            inputToPresent.print(out, "latency input to present");
+        }
+        if (lost > 0)
+        {
+            out << "latency: " << lost << " frame(s) never reported as presented\n";
+        }
+    }
+
+private:
+    static constexpr size_t maxInFlight = 64;
+
+    struct Frame
+    {
+        uint64_t presentId;
+        std::optional<Clock::time_point> input;
+        Clock::time_point submit;
+    };
+
+    std::optional<Clock::time_point> pendingInput;
+    std::deque<Frame> inFlight;
+    uint64_t lost = 0;
+    SampleStats inputToSubmit;
+    SampleStats submitToPresent;
+    SampleStats inputToPresent;
+};
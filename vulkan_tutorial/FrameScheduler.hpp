@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief hands out contiguous chunks of an offscreen batch job's frames to several devices, sized by how fast each device has proven to be.
+ *
+ * Workers pull; nothing is assigned up front, so a device that stalls or fails to start simply stops asking and the others soak up its share. Chunk size is guided self-scheduling weighted by measured throughput: a worker gets half of its throughput-proportional share of whatever is left. Early chunks are big (little locking, long runs for the frames-in-flight pipeline to settle into) and they shrink toward the end so every device finishes at about the same time. Until a worker has reported once it's assumed to be as fast as the average of those that have, or all equal when nobody has.
+ */
+class FrameScheduler
+{
+public:
+    /**
+     * @param minChunk floor on chunk size, so the tail doesn't degrade into one frame per lock.
+     */
+    FrameScheduler(uint32_t frameCount, uint32_t workerCount, uint32_t minChunk = 4) : frameCount(frameCount), minChunk(std::max(minChunk, 1u)), workers(workerCount) {}
+
+    void setWorkerName(uint32_t worker, const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        workers[worker].name = name;
+    }
+
+    /**
+     * @brief claims the worker's next chunk, frames [begin, end).
+     * @return false once every frame has been handed out.
+     */
+    bool next(uint32_t worker, uint32_t &begin, uint32_t &end)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (nextFrame >= frameCount)
+        {
+            return false;
+        }
+        uint32_t remaining = frameCount - nextFrame;
+        uint32_t chunk = static_cast<uint32_t>(static_cast<double>(remaining) * throughputShare(worker) / 2.0);
+        chunk = std::min(std::max(chunk, minChunk), remaining);
+        begin = nextFrame;
+        end = begin + chunk;
+        nextFrame = end;
+        workers[worker].chunks++;
+        return true;
+    }
+
+    /**
+     * @brief feeds back how long the worker took over its last chunk.
+     */
+    void report(uint32_t worker, uint32_t frames, double seconds)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Worker &w = workers[worker];
+        w.frames += frames;
+        w.seconds += seconds;
+        if (seconds > 0.0)
+        {
+            // smoothed, so one chunk that caught a hiccup doesn't swing the split too far.
+            double fps = static_cast<double>(frames) / seconds;
+            w.fps = w.fps == 0.0 ? fps : 0.5 * w.fps + 0.5 * fps;
+        }
+    }
+
+    /**
+     * @brief one line per worker: frames rendered, their share of the batch, chunks taken and measured throughput.
+     */
+    void printStats(std::ostream &out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        out << "batch of " << frameCount << " frames across " << workers.size() << " device(s):\n";
+        for (uint32_t i = 0; i < workers.size(); i++)
+        {
+            const Worker &w = workers[i];
+            double share = frameCount == 0 ? 0.0 : 100.0 * static_cast<double>(w.frames) / static_cast<double>(frameCount);
+            out << std::fixed << std::setprecision(1)
+                << "\tworker " << i << " (" << (w.name.empty() ? "never started" : w.name) << "): " << w.frames << " frames (" << share << "%) in "
+                << w.chunks << " chunk(s), " << (w.seconds > 0.0 ? static_cast<double>(w.frames) / w.seconds : 0.0) << " fps\n";
+            out.unsetf(std::ios::floatfield);
+        }
+    }
+
+private:
+    struct Worker
+    {
+        std::string name;
+        uint32_t frames = 0;
+        uint32_t chunks = 0;
+        double seconds = 0.0;
+        // smoothed frames per second over reported chunks; 0 until the first report.
+        double fps = 0.0;
+    };
+
+    double throughputShare(uint32_t worker) const
+    {
+        double measuredTotal = 0.0;
+        uint32_t measured = 0;
+        for (const auto &w : workers)
+        {
+            if (w.fps > 0.0)
+            {
+                measuredTotal += w.fps;
+                measured++;
+            }
+        }
+        if (measured == 0)
+        {
+            return 1.0 / static_cast<double>(workers.size());
+        }
+        double assumed = measuredTotal / measured;
+        double total = measuredTotal + assumed * static_cast<double>(workers.size() - measured);
+        double mine = workers[worker].fps > 0.0 ? workers[worker].fps : assumed;
+        return mine / total;
+    }
+
+    std::mutex mutex;
+    uint32_t frameCount;
+    uint32_t minChunk;
+    uint32_t nextFrame = 0;
+    std::vector<Worker> workers;
+};
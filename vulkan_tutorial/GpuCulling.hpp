@@ -0,0 +1,260 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "DeviceAllocator.hpp"
+#include "ShaderReflection.hpp"
+
+/**
+ * @brief one object as the GPU-driven path sees it; layout must match ObjectData in shaders/cull.comp and shaders/triangle_indirect.vert.
+ */
+struct CullObject
+{
+    float offset[2];
+    float scale;
+    float shade;
+    uint32_t textureIndex;
+    uint32_t paletteIndex;
+    // bounding circle around offset, in clip-space units.
+    float radius;
+    float pad;
+};
+
+/**
+ * @brief GPU-driven draw submission: a compute pass tests every object's bounding circle against the view and appends a VkDrawIndexedIndirectCommand for each survivor, and the graphics pass draws them all with one vkCmdDrawIndexedIndirectCount.
+ *
+ * The CPU cost of a frame no longer scales with object count at all; it's one dispatch and one draw whether there are 10 objects or a million. Each command carries firstInstance = object index so the vertex shader can fetch its placement (hence drawIndirectFirstInstance), and survivors are compacted with an atomic counter, so their order changes from frame to frame. Command and count buffers are per frame slot so a frame never overwrites ones the previous frame is still drawing from. Everything runs on the graphics queue inside the frame's command buffer.
+ *
+ * Only view culling: the sandbox has no depth buffer, so there's nothing to build a Hi-Z pyramid from for occlusion culling.
+ */
+class GpuCuller
+{
+public:
+    /**
+     * @param cullReflection reflection of cullShader; the descriptor and pipeline layouts are generated from it.
+     * @param objectBuffer device-local array of objectCount CullObjects; the caller owns and fills it.
+     * @param indexCount indices per object draw (every object is the same mesh).
+     * @param workgroupSize threads per workgroup, specialized into the shader as local_size_x.
+     * @param viewCull false specializes the view test out of the shader, so every object is drawn.
+     */
+    void create(VkDevice device, DeviceAllocator &allocator, VkShaderModule cullShader, const ShaderReflection &cullReflection, VkPipelineCache cache, VkBuffer objectBuffer,
+                uint32_t objectCount, uint32_t indexCount, uint32_t slotCount, uint32_t workgroupSize, bool viewCull)
+    {
+        this->device = device;
+        this->allocator = &allocator;
+        this->objectCount = objectCount;
+        this->indexCount = indexCount;
+        this->workgroupSize = workgroupSize;
+
+        drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR"));
+        if (drawIndexedIndirectCount == nullptr)
+        {
+            throw std::runtime_error("vkCmdDrawIndexedIndirectCountKHR not available; is VK_KHR_draw_indirect_count enabled?");
+        }
+
+        if (cullReflection.pushConstantSize != sizeof(CullParams) || cullReflection.bindings.size() != 3)
+        {
+            throw std::runtime_error("shaders/cull.comp doesn't match GpuCuller (push constants or bindings changed)!");
+        }
+        layout.create(device, {&cullReflection});
+        setLayout = layout.setLayout(0);
+        pipelineLayout = layout.pipelineLayout();
+
+        SpecializationConstants constants;
+        constants.set(0, workgroupSize).setBool(1, viewCull);
+        constants.requireDeclaredBy(cullReflection, "cull.comp");
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = cullShader;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.stage.pSpecializationInfo = constants.info();
+        pipelineInfo.layout = pipelineLayout;
+        if (vkCreateComputePipelines(device, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create cull pipeline!");
+        }
+
+        std::vector<VkDescriptorPoolSize> poolSizes = layout.descriptorPoolSizes(slotCount);
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = slotCount;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create cull descriptor pool!");
+        }
+
+        slots.resize(slotCount);
+        for (auto &slot : slots)
+        {
+            slot.commands = createBuffer(sizeof(VkDrawIndexedIndirectCommand) * std::max(objectCount, 1u), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, false, slot.commandsMemory);
+            // host-visible so the visible count can be read back for stats once the slot's fence has signaled; it's 4 bytes, where it lives doesn't matter.
+            slot.count = createBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true, slot.countMemory);
+
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = descriptorPool;
+            allocInfo.descriptorSetCount = 1;
+            allocInfo.pSetLayouts = &setLayout;
+            if (vkAllocateDescriptorSets(device, &allocInfo, &slot.set) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate cull descriptor set!");
+            }
+            VkDescriptorBufferInfo bufferInfos[3] = {{objectBuffer, 0, VK_WHOLE_SIZE}, {slot.commands, 0, VK_WHOLE_SIZE}, {slot.count, 0, VK_WHOLE_SIZE}};
+            VkWriteDescriptorSet writes[3]{};
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[i].dstSet = slot.set;
+                writes[i].dstBinding = i;
+                writes[i].descriptorCount = 1;
+                writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[i].pBufferInfo = &bufferInfos[i];
+            }
+            vkUpdateDescriptorSets(device, 3, writes, 0, nullptr);
+        }
+    }
+
+    GpuCuller() = default;
+    GpuCuller(const GpuCuller &) = delete;
+    GpuCuller &operator=(const GpuCuller &) = delete;
+
+    ~GpuCuller()
+    {
+        destroy();
+    }
+
+    void destroy()
+    {
+        for (auto &slot : slots)
+        {
+            vkDestroyBuffer(device, slot.commands, nullptr);
+            allocator->free(slot.commandsMemory);
+            vkDestroyBuffer(device, slot.count, nullptr);
+            allocator->free(slot.countMemory);
+        }
+        slots.clear();
+        if (descriptorPool != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+            vkDestroyPipeline(device, pipeline, nullptr);
+            layout.destroy();
+            descriptorPool = VK_NULL_HANDLE;
+        }
+    }
+
+    bool enabled() const
+    {
+        return !slots.empty();
+    }
+
+    /**
+     * @brief resets the slot's draw count, runs the cull dispatch and makes its output visible to indirect draws. Record outside any render pass.
+     * @param camera view center; objects are tested against [-1, 1]^2 around it.
+     */
+    void recordCull(VkCommandBuffer cmd, uint32_t slotIndex, const float camera[2])
+    {
+        Slot &slot = slots[slotIndex];
+        vkCmdFillBuffer(cmd, slot.count, 0, sizeof(uint32_t), 0);
+        VkMemoryBarrier clearToCull{};
+        clearToCull.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearToCull.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearToCull.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearToCull, 0, nullptr, 0, nullptr);
+
+        CullParams params{{camera[0], camera[1]}, objectCount, indexCount};
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &slot.set, 0, nullptr);
+        vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+        vkCmdDispatch(cmd, (objectCount + workgroupSize - 1) / workgroupSize, 1, 1);
+
+        VkMemoryBarrier cullToDraw{};
+        cullToDraw.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cullToDraw.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        cullToDraw.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cullToDraw, 0, nullptr, 0, nullptr);
+        slot.culled = true;
+    }
+
+    /**
+     * @brief draws whatever recordCull() let through; needs the indirect pipeline, vertex/index buffers and object data already bound.
+     */
+    void recordDraw(VkCommandBuffer cmd, uint32_t slotIndex) const
+    {
+        const Slot &slot = slots[slotIndex];
+        drawIndexedIndirectCount(cmd, slot.commands, 0, slot.count, 0, objectCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
+
+    /**
+     * @return how many objects survived the slot's last cull, or -1 if it hasn't culled since the last call. Only meaningful once the slot's fence has signaled.
+     */
+    int64_t takeVisibleCount(uint32_t slotIndex)
+    {
+        Slot &slot = slots[slotIndex];
+        if (!slot.culled)
+        {
+            return -1;
+        }
+        slot.culled = false;
+        return *static_cast<const uint32_t *>(slot.countMemory.mapped);
+    }
+
+private:
+    // must match CullParams in shaders/cull.comp.
+    struct CullParams
+    {
+        float camera[2];
+        uint32_t objectCount;
+        uint32_t indexCount;
+    };
+
+    struct Slot
+    {
+        VkBuffer commands = VK_NULL_HANDLE;
+        DeviceAllocation commandsMemory;
+        VkBuffer count = VK_NULL_HANDLE;
+        DeviceAllocation countMemory;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        bool culled = false;
+    };
+
+    VkBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, bool mapped, DeviceAllocation &memory)
+    {
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer buffer;
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create cull buffer!");
+        }
+        memory = allocator->allocateForBuffer(device, buffer, required, preferred, mapped);
+        return buffer;
+    }
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceAllocator *allocator = nullptr;
+    uint32_t objectCount = 0;
+    uint32_t indexCount = 0;
+    uint32_t workgroupSize = 64;
+    ReflectedLayout layout;
+    // both owned by layout.
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::vector<Slot> slots;
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+};
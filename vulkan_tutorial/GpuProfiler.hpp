@@ -0,0 +1,330 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Stats.hpp"
+
+/**
+ * @brief GPU timestamp profiler plus a CPU scope recorder, exporting both as one Chrome trace (load it in chrome://tracing or ui.perfetto.dev).
+ *
+ * Every frame slot gets its own VkQueryPool. Scopes are a pair of vkCmdWriteTimestamp calls; the results for a slot are read back the next time that slot comes around, by which point its in-flight fence has signaled and the results are guaranteed available, so reading them never stalls. Timestamps are converted to ms with timestampPeriod and masked to timestampValidBits.
+ *
+ * GPU and CPU clocks aren't in the same domain (that needs VK_EXT_calibrated_timestamps), so GPU scopes are placed on the trace relative to their frame's submit time on the CPU. Good enough to see which pass is slow and how GPU work lines up with CPU frames; not good enough for sub-ms CPU/GPU latency analysis.
+ */
+class GpuProfiler
+{
+public:
+    /**
+     * @param timestampValidBits from the graphics queue family; 0 means no timestamp support, in which case only CPU scopes are recorded.
+     */
+    void create(VkDevice device, float timestampPeriod, uint32_t timestampValidBits, uint32_t slotCount, uint32_t maxScopesPerFrame = 32)
+    {
+        this->device = device;
+        this->timestampPeriod = timestampPeriod;
+        this->maxScopes = maxScopesPerFrame;
+        timestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+        gpuSupported = timestampValidBits > 0;
+        epoch = std::chrono::steady_clock::now();
+        active = true;
+
+        slots.resize(slotCount);
+        if (!gpuSupported)
+        {
+            return;
+        }
+        for (auto &slot : slots)
+        {
+            VkQueryPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            poolInfo.queryCount = maxScopes * 2;
+            if (vkCreateQueryPool(device, &poolInfo, nullptr, &slot.queryPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create timestamp query pool!");
+            }
+        }
+    }
+
+    GpuProfiler() = default;
+    GpuProfiler(const GpuProfiler &) = delete;
+    GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+    ~GpuProfiler()
+    {
+        destroy();
+    }
+
+    void destroy()
+    {
+        for (auto &slot : slots)
+        {
+            if (slot.queryPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(device, slot.queryPool, nullptr);
+            }
+        }
+        slots.clear();
+        active = false;
+    }
+
+    bool enabled() const
+    {
+        return active;
+    }
+
+    /**
+     * @brief harvests the slot's previous frame (its fence must have signaled) and resets its queries. Record at the very start of the frame's command buffer, outside any render pass.
+     */
+    void beginFrame(VkCommandBuffer cmd, uint32_t slotIndex, uint32_t frameIndex)
+    {
+        if (!active)
+        {
+            return;
+        }
+        currentSlot = slotIndex;
+        collect(slots[slotIndex]);
+
+        Slot &slot = slots[slotIndex];
+        slot.frameIndex = frameIndex;
+        slot.scopeNames.clear();
+        slot.submitUs = 0.0;
+        if (gpuSupported)
+        {
+            vkCmdResetQueryPool(cmd, slot.queryPool, 0, maxScopes * 2);
+        }
+    }
+
+    /**
+     * @return scope id to pass to endScope(), or UINT32_MAX when the scope was dropped (profiling off or too many scopes this frame).
+     */
+    uint32_t beginScope(VkCommandBuffer cmd, const char *name)
+    {
+        if (!active || !gpuSupported)
+        {
+            return UINT32_MAX;
+        }
+        Slot &slot = slots[currentSlot];
+        if (slot.scopeNames.size() >= maxScopes)
+        {
+            return UINT32_MAX;
+        }
+        uint32_t scope = static_cast<uint32_t>(slot.scopeNames.size());
+        slot.scopeNames.push_back(name);
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.queryPool, scope * 2);
+        return scope;
+    }
+
+    void endScope(VkCommandBuffer cmd, uint32_t scope)
+    {
+        if (scope == UINT32_MAX)
+        {
+            return;
+        }
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slots[currentSlot].queryPool, scope * 2 + 1);
+    }
+
+    /**
+     * @brief anchors the current frame's GPU scopes on the CPU timeline; call right before vkQueueSubmit.
+     */
+    void markSubmit()
+    {
+        if (active)
+        {
+            slots[currentSlot].submitUs = nowUs();
+        }
+    }
+
+    /**
+     * @brief harvests every slot; call once the device is idle so the last framesInFlight frames aren't lost.
+     */
+    void collectAll()
+    {
+        for (auto &slot : slots)
+        {
+            collect(slot);
+        }
+    }
+
+    /**
+     * @brief RAII CPU scope, e.g. auto scope = profiler.cpuScope("record"); at the top of a block. Safe to use from any thread.
+     */
+    class CpuScope
+    {
+    public:
+        CpuScope(GpuProfiler *profiler, const char *name) : profiler(profiler), name(name), startUs(profiler->active ? profiler->nowUs() : 0.0) {}
+        ~CpuScope()
+        {
+            if (profiler->active)
+            {
+                profiler->recordCpu(name, startUs, profiler->nowUs());
+            }
+        }
+        CpuScope(const CpuScope &) = delete;
+        CpuScope &operator=(const CpuScope &) = delete;
+
+    private:
+        GpuProfiler *profiler;
+        const char *name;
+        double startUs;
+    };
+
+    CpuScope cpuScope(const char *name)
+    {
+        return CpuScope(this, name);
+    }
+
+    /**
+     * @brief one line per scope name, GPU scopes first.
+     */
+    void printStats(std::ostream &out)
+    {
+        for (auto &[name, stats] : gpuStats)
+        {
+            stats.print(out, "gpu " + name);
+        }
+        for (auto &[name, stats] : cpuStats)
+        {
+            stats.print(out, "cpu " + name);
+        }
+    }
+
+    /**
+     * @brief writes every scope recorded so far as Chrome trace "complete" events. GPU scopes go on their own track; each event carries its frame number in args so runs can be diffed frame by frame.
+     */
+    void writeChromeTrace(const std::string &path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("failed to open " + path + " for trace output!");
+        }
+        // trace timestamps are in µs and runs easily go past a million of them, so default ostream precision would round them away.
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU (graphics queue)\"}}";
+        std::map<std::thread::id, uint32_t> threadIds;
+        for (const auto &event : events)
+        {
+            uint32_t tid = 0;
+            if (!event.gpu)
+            {
+                auto it = threadIds.find(event.thread);
+                if (it == threadIds.end())
+                {
+                    it = threadIds.emplace(event.thread, static_cast<uint32_t>(threadIds.size() + 1)).first;
+                    file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << it->second << ",\"args\":{\"name\":\"CPU thread " << it->second << "\"}}";
+                }
+                tid = it->second;
+            }
+            file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                 << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs;
+            if (event.frame != UINT32_MAX)
+            {
+                file << ",\"args\":{\"frame\":" << event.frame << '}';
+            }
+            file << '}';
+        }
+        file << "\n]}\n";
+        std::cout << "wrote " << events.size() << " trace events to " << path << '\n';
+    }
+
+    /**
+     * @brief tags CPU scopes recorded from now on with this frame number.
+     */
+    void setCpuFrame(uint32_t frameIndex)
+    {
+        cpuFrame = frameIndex;
+    }
+
+private:
+    struct Slot
+    {
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        std::vector<const char *> scopeNames;
+        uint32_t frameIndex = 0;
+        // CPU time of the submit that carried these scopes; 0 means never submitted (e.g. recorded but dropped), so there's nothing to read.
+        double submitUs = 0.0;
+    };
+
+    struct Event
+    {
+        std::string name;
+        bool gpu;
+        double startUs;
+        double durationUs;
+        uint32_t frame;
+        std::thread::id thread;
+    };
+
+    double nowUs() const
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void recordCpu(const char *name, double startUs, double endUs)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cpuStats[name].add((endUs - startUs) / 1000.0);
+        events.push_back({name, false, startUs, endUs - startUs, cpuFrame, std::this_thread::get_id()});
+    }
+
+    void collect(Slot &slot)
+    {
+        if (!gpuSupported || slot.scopeNames.empty() || slot.submitUs == 0.0)
+        {
+            slot.scopeNames.clear();
+            return;
+        }
+        uint32_t queryCount = static_cast<uint32_t>(slot.scopeNames.size()) * 2;
+        // value + availability per query.
+        std::vector<uint64_t> results(queryCount * 2);
+        vkGetQueryPoolResults(device, slot.queryPool, 0, queryCount, results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+        uint64_t frameStart = results[0];
+        for (uint32_t scope = 0; scope < slot.scopeNames.size(); scope++)
+        {
+            uint64_t begin = results[scope * 4 + 0];
+            uint64_t end = results[scope * 4 + 2];
+            bool available = results[scope * 4 + 1] != 0 && results[scope * 4 + 3] != 0;
+            if (!available)
+            {
+                continue;
+            }
+            double durationMs = static_cast<double>((end - begin) & timestampMask) * timestampPeriod / 1e6;
+            double offsetUs = static_cast<double>((begin - frameStart) & timestampMask) * timestampPeriod / 1e3;
+            std::lock_guard<std::mutex> lock(mutex);
+            gpuStats[slot.scopeNames[scope]].add(durationMs);
+            events.push_back({slot.scopeNames[scope], true, slot.submitUs + offsetUs, durationMs * 1000.0, slot.frameIndex, {}});
+        }
+        slot.scopeNames.clear();
+    }
+
+    VkDevice device = VK_NULL_HANDLE;
+    bool active = false;
+    bool gpuSupported = false;
+    float timestampPeriod = 1.0f;
+    uint64_t timestampMask = ~0ull;
+    uint32_t maxScopes = 0;
+    std::vector<Slot> slots;
+    uint32_t currentSlot = 0;
+    uint32_t cpuFrame = UINT32_MAX;
+    std::chrono::steady_clock::time_point epoch;
+
+    std::mutex mutex;
+    std::map<std::string, SampleStats> gpuStats;
+    std::map<std::string, SampleStats> cpuStats;
+    std::vector<Event> events;
+};
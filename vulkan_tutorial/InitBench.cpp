@@ -0,0 +1,674 @@
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "DeviceCapabilities.hpp"
+#include "DeviceScoring.hpp"
+#include "DeviceSelection.hpp"
+#include "MockVulkan.hpp"
+
+/**
+ * @brief command line options; see printUsage() for what each does.
+ */
+struct InitBenchConfig
+{
+    // physical device counts for the enumeration and selection benchmarks.
+    std::vector<uint32_t> deviceCounts = {1, 16, 256, 1024};
+    // queue families per device for the findQueueFamilies benchmark.
+    std::vector<uint32_t> queueFamilyCounts = {4, 16, 64};
+    // only benchmarks whose name contains this run.
+    std::string filter;
+    // each benchmark's iteration count grows until one timed run takes at least this long.
+    double minTimeMs = 200.0;
+    bool checks = true;
+    bool list = false;
+};
+
+void printUsage(const char *program)
+{
+    std::cout << "usage: " << program << " [options]\n"
+              << "\t--devices LIST        physical device counts to enumerate and rank (default 1,16,256,1024)\n"
+              << "\t--queue-families LIST queue families per device for findQueueFamilies (default 4,16,64)\n"
+              << "\t--filter TEXT         only run benchmarks whose name contains TEXT\n"
+              << "\t--min-time-ms N       grow iterations until a run takes at least N ms (default 200)\n"
+              << "\t--no-checks           skip the correctness checks\n"
+              << "\t--list                print the benchmark names and exit\n";
+}
+
+/**
+ * @brief "1,16,256" to {1, 16, 256}.
+ */
+std::vector<uint32_t> parseSizeList(const std::string &list)
+{
+    std::vector<uint32_t> sizes;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        uint32_t size = static_cast<uint32_t>(std::stoul(item));
+        if (size == 0)
+        {
+            throw std::runtime_error("sizes must be positive: " + list);
+        }
+        sizes.push_back(size);
+    }
+    if (sizes.empty())
+    {
+        throw std::runtime_error("empty size list");
+    }
+    return sizes;
+}
+
+InitBenchConfig parseArguments(int argc, char **argv)
+{
+    InitBenchConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto nextValue = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--devices")
+        {
+            config.deviceCounts = parseSizeList(nextValue());
+        }
+        else if (arg == "--queue-families")
+        {
+            config.queueFamilyCounts = parseSizeList(nextValue());
+        }
+        else if (arg == "--filter")
+        {
+            config.filter = nextValue();
+        }
+        else if (arg == "--min-time-ms")
+        {
+            config.minTimeMs = std::stod(nextValue());
+        }
+        else if (arg == "--no-checks")
+        {
+            config.checks = false;
+        }
+        else if (arg == "--list")
+        {
+            config.list = true;
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            printUsage(argv[0]);
+            std::exit(EXIT_SUCCESS);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+    if (config.minTimeMs <= 0.0)
+    {
+        throw std::runtime_error("--min-time-ms must be positive");
+    }
+    return config;
+}
+
+// ---------------------------------------------------------------------------
+// scripted drivers
+// ---------------------------------------------------------------------------
+
+const VkDeviceSize GiB = 1024ull * 1024 * 1024;
+
+/**
+ * @brief a device that passes every check: one graphics+compute+transfer family that can present, the swapchain extension, one format and FIFO.
+ * @param id goes into deviceID, so every device gets its own DeviceCapabilityCache key.
+ */
+MockPhysicalDevice basicDevice(uint32_t id, const std::string &name, VkPhysicalDeviceType type, VkDeviceSize localHeapBytes)
+{
+    MockPhysicalDevice device;
+    device.properties.apiVersion = VK_API_VERSION_1_2;
+    device.properties.driverVersion = 1;
+    device.properties.vendorID = 0x10005;
+    device.properties.deviceID = id;
+    device.properties.deviceType = type;
+    name.copy(device.properties.deviceName, VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+    device.memory.memoryHeapCount = 2;
+    device.memory.memoryHeaps[0] = {localHeapBytes, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT};
+    device.memory.memoryHeaps[1] = {8 * GiB, 0};
+    device.memory.memoryTypeCount = 2;
+    device.memory.memoryTypes[0] = {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0};
+    device.memory.memoryTypes[1] = {VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1};
+    device.queueFamilies.push_back({VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT, 1, 64, {1, 1, 1}});
+    device.presentSupport.push_back(VK_TRUE);
+    device.extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    device.surfaceFormats.push_back({VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR});
+    device.presentModes.push_back(VK_PRESENT_MODE_FIFO_KHR);
+    return device;
+}
+
+/**
+ * @brief a plausible loader: the usual Khronos layers and a couple hundred instance extensions, so the hash-set snapshot has something to chew on.
+ */
+MockDriver basicDriver()
+{
+    MockDriver driver;
+    driver.layers = {"VK_LAYER_KHRONOS_validation", "VK_LAYER_KHRONOS_synchronization2", "VK_LAYER_KHRONOS_shader_object", "VK_LAYER_MESA_device_select",
+                     "VK_LAYER_MESA_overlay", "VK_LAYER_LUNARG_api_dump", "VK_LAYER_LUNARG_monitor", "VK_LAYER_LUNARG_screenshot"};
+    driver.instanceExtensions = {VK_KHR_SURFACE_EXTENSION_NAME, "VK_KHR_xcb_surface", "VK_KHR_xlib_surface", "VK_KHR_wayland_surface",
+                                 VK_EXT_DEBUG_UTILS_EXTENSION_NAME, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME};
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        driver.instanceExtensions.push_back("VK_MOCK_instance_extension_" + std::to_string(i));
+    }
+    return driver;
+}
+
+/**
+ * @brief count devices of every type with odd queue family layouts and extension sets: graphics without present, present-only families, dedicated compute/transfer families in random places, missing swapchain or draw_indirect_count, no surface formats. Seeded, so every run gets the same mix.
+ */
+MockDriver mixedDriver(uint32_t count)
+{
+    MockDriver driver = basicDriver();
+    std::mt19937 random(count);
+    auto chance = [&](double p)
+    {
+        return std::uniform_real_distribution<double>(0.0, 1.0)(random) < p;
+    };
+    const VkPhysicalDeviceType types[] = {VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU, VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU,
+                                          VK_PHYSICAL_DEVICE_TYPE_CPU, VK_PHYSICAL_DEVICE_TYPE_OTHER};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        VkPhysicalDeviceType type = types[random() % std::size(types)];
+        VkDeviceSize localHeap = (1 + random() % 24) * GiB;
+        MockPhysicalDevice device = basicDevice(i, "mock device " + std::to_string(i), type, localHeap);
+
+        uint32_t familyCount = 1 + random() % 8;
+        device.queueFamilies.clear();
+        device.presentSupport.clear();
+        for (uint32_t family = 0; family < familyCount; family++)
+        {
+            VkQueueFlags flags = 0;
+            switch (random() % 4)
+            {
+            case 0:
+                flags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+                break;
+            case 1:
+                flags = VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+                break;
+            case 2:
+                flags = VK_QUEUE_TRANSFER_BIT;
+                break;
+            default:
+                flags = VK_QUEUE_GRAPHICS_BIT;
+                break;
+            }
+            device.queueFamilies.push_back({flags, 1 + static_cast<uint32_t>(random() % 16), 64, {1, 1, 1}});
+            device.presentSupport.push_back(chance(0.5) ? VK_TRUE : VK_FALSE);
+        }
+
+        device.extensions.clear();
+        if (chance(0.9))
+        {
+            device.extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
+        if (chance(0.7))
+        {
+            device.extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
+        uint32_t extraExtensions = random() % 160;
+        for (uint32_t extension = 0; extension < extraExtensions; extension++)
+        {
+            device.extensions.push_back("VK_MOCK_device_extension_" + std::to_string(random() % 400));
+        }
+
+        device.features.geometryShader = chance(0.8);
+        device.features.multiDrawIndirect = chance(0.8);
+        device.features.drawIndirectFirstInstance = chance(0.8);
+        device.features.shaderStorageBufferArrayDynamicIndexing = chance(0.8);
+        if (chance(0.1))
+        {
+            device.surfaceFormats.clear();
+        }
+        if (chance(0.5))
+        {
+            device.presentModes.push_back(VK_PRESENT_MODE_MAILBOX_KHR);
+        }
+        driver.devices.push_back(std::move(device));
+    }
+    return driver;
+}
+
+/**
+ * @brief one device with familyCount queue families where the only graphics family that can present is the last one, so findQueueFamilies() has to look at all of them.
+ */
+MockDriver manyQueueFamiliesDriver(uint32_t familyCount)
+{
+    MockDriver driver = basicDriver();
+    MockPhysicalDevice device = basicDevice(0, "many queue families", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 8 * GiB);
+    device.queueFamilies.clear();
+    device.presentSupport.clear();
+    for (uint32_t family = 0; family < familyCount; family++)
+    {
+        bool last = family + 1 == familyCount;
+        VkQueueFlags flags = last || family % 3 == 0 ? VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT : family % 3 == 1 ? VK_QUEUE_COMPUTE_BIT : VK_QUEUE_TRANSFER_BIT;
+        device.queueFamilies.push_back({flags, 1, 64, {1, 1, 1}});
+        device.presentSupport.push_back(last || family % 3 != 0 ? VK_TRUE : VK_FALSE);
+    }
+    driver.devices.push_back(std::move(device));
+    return driver;
+}
+
+VkInstance createInstance(const std::vector<const char *> &layers, const std::vector<const char *> &extensions)
+{
+    VkApplicationInfo appInfo{};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "InitBench";
+    appInfo.apiVersion = VK_API_VERSION_1_2;
+    VkInstanceCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pApplicationInfo = &appInfo;
+    createInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
+    createInfo.ppEnabledLayerNames = layers.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
+    VkInstance instance = VK_NULL_HANDLE;
+    if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+    {
+        return VK_NULL_HANDLE;
+    }
+    return instance;
+}
+
+std::vector<VkPhysicalDevice> enumerateDevices(VkInstance instance)
+{
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+    return devices;
+}
+
+std::vector<DeviceCapabilities> snapshotDevices(VkInstance instance)
+{
+    std::vector<DeviceCapabilities> devices;
+    for (VkPhysicalDevice device : enumerateDevices(instance))
+    {
+        devices.push_back(DeviceCapabilities::query(device));
+    }
+    return devices;
+}
+
+// the windowed app's requirements with and without --gpu-cull, and headless mode's.
+DeviceRequirements windowedRequirements(bool gpuCull)
+{
+    DeviceRequirements requirements;
+    requirements.extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    if (gpuCull)
+    {
+        requirements.extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+    requirements.gpuDrivenDraws = gpuCull;
+    return requirements;
+}
+
+DeviceRequirements headlessRequirements()
+{
+    DeviceRequirements requirements;
+    requirements.present = false;
+    return requirements;
+}
+
+// ---------------------------------------------------------------------------
+// correctness checks
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief expectations for the selection path against drivers where the right answer is known; each failure is printed, and any failure makes the run fail, so this doubles as a GPU-less CI test.
+ * @return the number of failed expectations.
+ */
+uint32_t runChecks()
+{
+    uint32_t failures = 0;
+    auto expect = [&](bool ok, const std::string &what)
+    {
+        if (!ok)
+        {
+            std::cerr << "check FAILED: " << what << '\n';
+            failures++;
+        }
+    };
+
+    // loader behaviour the rest relies on.
+    MockVulkan::install(mixedDriver(5));
+    VkInstance instance = createInstance({"VK_LAYER_KHRONOS_validation"}, {VK_KHR_SURFACE_EXTENSION_NAME});
+    expect(instance != VK_NULL_HANDLE, "instance with a known layer and extension is created");
+    expect(createInstance({"VK_LAYER_not_installed"}, {}) == VK_NULL_HANDLE, "instance with an unknown layer is refused");
+    expect(createInstance({}, {"VK_KHR_not_installed"}) == VK_NULL_HANDLE, "instance with an unknown extension is refused");
+    uint32_t partialCount = 3;
+    VkPhysicalDevice partial[3];
+    expect(vkEnumeratePhysicalDevices(instance, &partialCount, partial) == VK_INCOMPLETE && partialCount == 3, "short device enumeration returns VK_INCOMPLETE");
+    InstanceCapabilities instanceCaps = InstanceCapabilities::query();
+    expect(instanceCaps.layers.size() == MockVulkan::driver().layers.size() && instanceCaps.hasExtension(VK_EXT_DEBUG_UTILS_EXTENSION_NAME),
+           "instance capability snapshot matches the driver");
+    std::vector<DeviceCapabilities> snapshots = snapshotDevices(instance);
+    bool snapshotsMatch = snapshots.size() == MockVulkan::driver().devices.size();
+    for (size_t i = 0; snapshotsMatch && i < snapshots.size(); i++)
+    {
+        const MockPhysicalDevice &scripted = MockVulkan::driver().devices[i];
+        std::unordered_set<std::string> uniqueExtensions(scripted.extensions.begin(), scripted.extensions.end());
+        snapshotsMatch = snapshots[i].queueFamilies.size() == scripted.queueFamilies.size() && snapshots[i].extensions == uniqueExtensions &&
+                         snapshots[i].properties.deviceID == scripted.properties.deviceID;
+    }
+    expect(snapshotsMatch, "device capability snapshots match the scripted devices");
+
+    // every way a device can fall short, plus two that pass with different queue layouts.
+    MockDriver driver = basicDriver();
+    // 0: best hardware, but can't make a swapchain.
+    driver.devices.push_back(basicDevice(0, "no swapchain", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 16 * GiB));
+    driver.devices.back().extensions.clear();
+    // 1: graphics can't present; present comes from a transfer-only family, compute has its own.
+    driver.devices.push_back(basicDevice(1, "split present", VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU, 2 * GiB));
+    driver.devices.back().queueFamilies = {{VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 1, 64, {1, 1, 1}},
+                                           {VK_QUEUE_TRANSFER_BIT, 1, 64, {1, 1, 1}},
+                                           {VK_QUEUE_COMPUTE_BIT, 1, 64, {1, 1, 1}}};
+    driver.devices.back().presentSupport = {VK_FALSE, VK_TRUE, VK_FALSE};
+    // 2: the first graphics family can't present, a later one can; selection should move to it.
+    driver.devices.push_back(basicDevice(2, "late present", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 8 * GiB));
+    driver.devices.back().queueFamilies = {{VK_QUEUE_GRAPHICS_BIT, 1, 64, {1, 1, 1}},
+                                           {VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT, 1, 64, {1, 1, 1}},
+                                           {VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 1, 64, {1, 1, 1}}};
+    driver.devices.back().presentSupport = {VK_FALSE, VK_TRUE, VK_TRUE};
+    // 3: everything but a surface format.
+    driver.devices.push_back(basicDevice(3, "no formats", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 24 * GiB));
+    driver.devices.back().surfaceFormats.clear();
+    // 4: a software rasterizer; suitable, just last.
+    driver.devices.push_back(basicDevice(4, "cpu", VK_PHYSICAL_DEVICE_TYPE_CPU, 1 * GiB));
+    MockVulkan::install(driver);
+    snapshots = snapshotDevices(instance);
+
+    DeviceSelector windowed(ScoringPolicy{}, windowedRequirements(false), MockVulkan::surface());
+    QueueFamilyIndices split = windowed.findQueueFamilies(snapshots[1]);
+    expect(split.graphicsFamily == 0u && split.presentFamily == 1u && split.computeFamily == 2u && split.transferFamily == 1u,
+           "split present: graphics 0, present 1, compute 2, transfer 1");
+    QueueFamilyIndices late = windowed.findQueueFamilies(snapshots[2]);
+    expect(late.graphicsFamily == 2u && late.presentFamily == 2u && late.computeFamily == 1u && !late.transferFamily,
+           "late present: graphics and present both move to family 2, compute 1");
+    expect(windowed.querySwapChainSupport(snapshots[3].device).formats.empty(), "no formats: swapchain query comes back empty");
+
+    auto names = [](const std::vector<const DeviceCapabilities *> &ranked)
+    {
+        std::string joined;
+        for (const DeviceCapabilities *device : ranked)
+        {
+            joined += (joined.empty() ? "" : ", ") + std::string(device->properties.deviceName);
+        }
+        return joined;
+    };
+    std::string windowedOrder = names(windowed.rank(snapshots, nullptr));
+    expect(windowedOrder == "late present, split present, cpu", "windowed ranking, got: " + windowedOrder);
+    DeviceSelector headless(ScoringPolicy{}, headlessRequirements(), VK_NULL_HANDLE);
+    std::string headlessOrder = names(headless.rank(snapshots, nullptr));
+    expect(headlessOrder == "no formats, no swapchain, late present, split present, cpu", "headless ranking, got: " + headlessOrder);
+    ScoringPolicy needsGeometry;
+    needsGeometry.requiredFeatures = {"geometryShader"};
+    expect(DeviceSelector(needsGeometry, headlessRequirements(), VK_NULL_HANDLE).rank(snapshots, nullptr).empty(), "a required feature nobody has leaves no device");
+
+    // hundreds of devices: best first, and nothing suitable left out.
+    MockVulkan::install(mixedDriver(1024));
+    snapshots = snapshotDevices(instance);
+    DeviceSelector culling(ScoringPolicy{}, windowedRequirements(true), MockVulkan::surface());
+    std::vector<const DeviceCapabilities *> ranked = culling.rank(snapshots, nullptr);
+    bool ordered = true;
+    for (size_t i = 1; i < ranked.size(); i++)
+    {
+        ordered = ordered && culling.rate(*ranked[i - 1], nullptr) >= culling.rate(*ranked[i], nullptr);
+    }
+    size_t suitable = std::count_if(snapshots.begin(), snapshots.end(), [&](const DeviceCapabilities &device)
+                                    { return culling.rate(device, nullptr) > 0; });
+    expect(ordered && ranked.size() == suitable && !ranked.empty() && ranked.size() < snapshots.size(), "1024 mixed devices rank best first, " + std::to_string(ranked.size()) + " suitable");
+
+    // the capability cache answers the second round from memory.
+    DeviceCapabilityCache cache;
+    // a path turns the cache on; nothing here calls save(), so it's never written.
+    cache.load("Build/initbench-unsaved.vkdc");
+    std::vector<VkPhysicalDevice> handles = enumerateDevices(instance);
+    for (VkPhysicalDevice device : handles)
+    {
+        cache.lookup(device);
+    }
+    bool cachedMatch = true;
+    for (size_t i = 0; i < handles.size(); i++)
+    {
+        DeviceCapabilities caps = cache.lookup(handles[i]);
+        cachedMatch = cachedMatch && caps.fromCache && caps.extensions == snapshots[i].extensions && caps.queueFamilies.size() == snapshots[i].queueFamilies.size();
+    }
+    expect(cachedMatch && cache.hitCount() == handles.size() && cache.missCount() == handles.size(), "capability cache serves the second lookup round");
+
+    vkDestroyInstance(instance, nullptr);
+    std::cout << "checks: " << (failures == 0 ? "all passed" : std::to_string(failures) + " FAILED") << '\n';
+    return failures;
+}
+
+// ---------------------------------------------------------------------------
+// benchmarks
+// ---------------------------------------------------------------------------
+
+// results land here so the optimizer can't drop the work that produced them.
+volatile uint64_t sink = 0;
+
+struct Benchmark
+{
+    std::string name;
+    // installs the driver and builds whatever the timed part reads; not timed.
+    std::function<void()> setup;
+    // one iteration.
+    std::function<void()> body;
+    // devices (or queue families) one iteration goes through, for the per-item time.
+    uint64_t items = 1;
+};
+
+std::vector<Benchmark> registerBenchmarks(const InitBenchConfig &config)
+{
+    std::vector<Benchmark> benchmarks;
+    auto instance = std::make_shared<VkInstance>(VK_NULL_HANDLE);
+    auto openInstance = [instance]()
+    {
+        if (*instance == VK_NULL_HANDLE)
+        {
+            *instance = createInstance({}, {});
+        }
+    };
+
+    // what the app does before it has an instance: snapshot the loader, check layers and extensions against it, create, destroy.
+    benchmarks.push_back({"instance/create",
+                          [=]()
+                          { MockVulkan::install(basicDriver()); },
+                          []()
+                          {
+                              InstanceCapabilities caps = InstanceCapabilities::query();
+                              std::vector<const char *> layers = {"VK_LAYER_KHRONOS_validation"};
+                              std::vector<const char *> extensions = {VK_KHR_SURFACE_EXTENSION_NAME, "VK_KHR_xcb_surface", VK_EXT_DEBUG_UTILS_EXTENSION_NAME};
+                              bool supported = caps.hasLayer(layers[0]) && std::all_of(extensions.begin(), extensions.end(), [&](const char *name)
+                                                                                       { return caps.hasExtension(name); });
+                              VkInstance created = supported ? createInstance(layers, extensions) : VK_NULL_HANDLE;
+                              sink = sink + (created != VK_NULL_HANDLE);
+                              vkDestroyInstance(created, nullptr);
+                          }});
+
+    for (uint32_t count : config.deviceCounts)
+    {
+        std::string suffix = "/" + std::to_string(count);
+        // enumeration plus a full DeviceCapabilities::query() per device, i.e. a first launch.
+        benchmarks.push_back({"devices/snapshot" + suffix,
+                              [=]()
+                              {
+                                  MockVulkan::install(mixedDriver(count));
+                                  openInstance();
+                              },
+                              [=]()
+                              { sink = sink + snapshotDevices(*instance).size(); },
+                              count});
+
+        // the same through a warm DeviceCapabilityCache, i.e. every launch after the first.
+        auto cache = std::make_shared<DeviceCapabilityCache>();
+        benchmarks.push_back({"devices/snapshot-cached" + suffix,
+                              [=]()
+                              {
+                                  MockVulkan::install(mixedDriver(count));
+                                  openInstance();
+                                  // never saved; the path only switches the cache on.
+                                  cache->load("Build/initbench-unsaved.vkdc");
+                                  for (VkPhysicalDevice device : enumerateDevices(*instance))
+                                  {
+                                      cache->lookup(device);
+                                  }
+                              },
+                              [=]()
+                              {
+                                  for (VkPhysicalDevice device : enumerateDevices(*instance))
+                                  {
+                                      sink = sink + cache->lookup(device).queueFamilies.size();
+                                  }
+                              },
+                              count});
+
+        // scoring and every suitability check over snapshots already taken, windowed (surface queries included) and headless.
+        auto snapshots = std::make_shared<std::vector<DeviceCapabilities>>();
+        auto prepare = [=]()
+        {
+            MockVulkan::install(mixedDriver(count));
+            openInstance();
+            *snapshots = snapshotDevices(*instance);
+        };
+        DeviceSelector windowed(ScoringPolicy{}, windowedRequirements(false), MockVulkan::surface());
+        benchmarks.push_back({"selection/rank" + suffix, prepare, [=]()
+                              { sink = sink + windowed.rank(*snapshots, nullptr).size(); },
+                              count});
+        DeviceSelector headless(ScoringPolicy{}, headlessRequirements(), VK_NULL_HANDLE);
+        benchmarks.push_back({"selection/rank-headless" + suffix, prepare, [=]()
+                              { sink = sink + headless.rank(*snapshots, nullptr).size(); },
+                              count});
+    }
+
+    for (uint32_t families : config.queueFamilyCounts)
+    {
+        auto snapshot = std::make_shared<std::vector<DeviceCapabilities>>();
+        DeviceSelector windowed(ScoringPolicy{}, windowedRequirements(false), MockVulkan::surface());
+        benchmarks.push_back({"queues/findQueueFamilies/" + std::to_string(families),
+                              [=]()
+                              {
+                                  MockVulkan::install(manyQueueFamiliesDriver(families));
+                                  openInstance();
+                                  *snapshot = snapshotDevices(*instance);
+                              },
+                              [=]()
+                              { sink = sink + windowed.findQueueFamilies(snapshot->front()).graphicsFamily.value_or(0); },
+                              families});
+    }
+
+    // what createSwapChain() asks every time the window is resized.
+    auto device = std::make_shared<VkPhysicalDevice>(VK_NULL_HANDLE);
+    DeviceSelector windowed(ScoringPolicy{}, windowedRequirements(false), MockVulkan::surface());
+    benchmarks.push_back({"swapchain/query",
+                          [=]()
+                          {
+                              MockDriver driver = basicDriver();
+                              driver.devices.push_back(basicDevice(0, "swapchain", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 8 * GiB));
+                              driver.devices.back().presentModes = {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+                              MockVulkan::install(driver);
+                              openInstance();
+                              *device = enumerateDevices(*instance).front();
+                          },
+                          [=]()
+                          { sink = sink + windowed.querySwapChainSupport(*device).formats.size(); }});
+    return benchmarks;
+}
+
+/**
+ * @brief runs the benchmark with more and more iterations until one run lasts minTimeMs, then reports that run: per-iteration time, per-item time when an iteration covers several devices or families, and how many Vulkan calls an iteration makes.
+ */
+void runBenchmark(const Benchmark &benchmark, double minTimeMs)
+{
+    benchmark.setup();
+    // once untimed, so first-touch allocations and cold caches don't land in the measurement.
+    benchmark.body();
+    uint64_t iterations = 1;
+    while (true)
+    {
+        MockVulkan::resetCallCount();
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            benchmark.body();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ms >= minTimeMs || iterations >= (1ull << 32))
+        {
+            double nsPerIteration = ms * 1e6 / static_cast<double>(iterations);
+            std::cout << std::left << std::setw(36) << benchmark.name << std::right << std::setw(12) << iterations << std::fixed << std::setprecision(1)
+                      << std::setw(14) << nsPerIteration << " ns" << std::setw(12) << nsPerIteration / static_cast<double>(benchmark.items) << " ns"
+                      << std::setw(12) << static_cast<double>(MockVulkan::callCount()) / static_cast<double>(iterations) << '\n'
+                      << std::defaultfloat << std::setprecision(6);
+            return;
+        }
+        // aim a bit past the minimum next time, but grow by at most 10x a round in case this run was noise.
+        double scale = ms > 0.0 ? std::min(10.0, minTimeMs * 1.4 / ms) : 10.0;
+        iterations = std::max(iterations + 1, static_cast<uint64_t>(static_cast<double>(iterations) * scale));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        InitBenchConfig config = parseArguments(argc, argv);
+        std::vector<Benchmark> benchmarks = registerBenchmarks(config);
+        if (config.list)
+        {
+            for (const auto &benchmark : benchmarks)
+            {
+                std::cout << benchmark.name << '\n';
+            }
+            return EXIT_SUCCESS;
+        }
+
+        if (config.checks && runChecks() != 0)
+        {
+            return EXIT_FAILURE;
+        }
+
+        std::cout << std::left << std::setw(36) << "benchmark" << std::right << std::setw(12) << "iterations" << std::setw(17) << "time/op" << std::setw(15)
+                  << "time/item" << std::setw(12) << "vk calls/op" << '\n';
+        for (const auto &benchmark : benchmarks)
+        {
+            if (benchmark.name.find(config.filter) != std::string::npos)
+            {
+                runBenchmark(benchmark, config.minTimeMs);
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "InstanceTransforms.hpp"
+#include "WorkerPool.hpp"
+
+/**
+ * @brief command line options; see printUsage() for what each does.
+ */
+struct InstanceBenchConfig
+{
+    // instance counts to time every layout at.
+    std::vector<uint32_t> counts = {10000, 100000, 1000000};
+    // workers for the multithreaded layout.
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    // each layout's frame count grows until one timed run takes at least this long.
+    double minTimeMs = 200.0;
+    bool checks = true;
+};
+
+void printUsage(const char *program)
+{
+    std::cout << "usage: " << program << " [options]\n"
+              << "\t--counts LIST    instance counts to time (default 10000,100000,1000000)\n"
+              << "\t--threads N      workers for the multithreaded update (default one per core)\n"
+              << "\t--min-time-ms N  grow frames until a run takes at least N ms (default 200)\n"
+              << "\t--no-checks      skip comparing the SIMD output against the scalar one\n";
+}
+
+/**
+ * @brief "1,16,256" to {1, 16, 256}.
+ */
+std::vector<uint32_t> parseSizeList(const std::string &list)
+{
+    std::vector<uint32_t> sizes;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        uint32_t size = static_cast<uint32_t>(std::stoul(item));
+        if (size == 0)
+        {
+            throw std::runtime_error("sizes must be positive: " + list);
+        }
+        sizes.push_back(size);
+    }
+    if (sizes.empty())
+    {
+        throw std::runtime_error("empty size list");
+    }
+    return sizes;
+}
+
+InstanceBenchConfig parseArguments(int argc, char **argv)
+{
+    InstanceBenchConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto nextValue = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--counts")
+        {
+            config.counts = parseSizeList(nextValue());
+        }
+        else if (arg == "--threads")
+        {
+            config.threads = static_cast<uint32_t>(std::stoul(nextValue()));
+            if (config.threads == 0)
+            {
+                throw std::runtime_error("--threads needs at least one worker");
+            }
+        }
+        else if (arg == "--min-time-ms")
+        {
+            config.minTimeMs = std::stod(nextValue());
+        }
+        else if (arg == "--no-checks")
+        {
+            config.checks = false;
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            printUsage(argv[0]);
+            std::exit(EXIT_SUCCESS);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+    return config;
+}
+
+// same step the app uses.
+constexpr float FRAME_DT = 1.0f / 60.0f;
+constexpr float EXTENT = 1.0f;
+constexpr uint32_t SEED = 1234;
+
+/**
+ * @brief the layout most code starts with: one struct per instance, libm trig, a matrix built and stored one instance at a time. Same motion as InstanceTransforms, so the outputs are comparable.
+ */
+class AosTransforms
+{
+public:
+    explicit AosTransforms(const InstanceTransforms &source)
+    {
+        instances.reserve(source.size());
+        for (uint32_t i = 0; i < source.size(); i++)
+        {
+            instances.push_back(source.instance(i));
+        }
+    }
+
+    void update(float dt, float *out)
+    {
+        for (size_t i = 0; i < instances.size(); i++)
+        {
+            InstanceTransforms::Instance &instance = instances[i];
+            instance.x = wrap(instance.x + instance.vx * dt, EXTENT);
+            instance.y = wrap(instance.y + instance.vy * dt, EXTENT);
+            instance.angle = wrap(instance.angle + instance.spin * dt, InstanceTransforms::PI);
+            float c = std::cos(instance.angle) * instance.scale;
+            float s = std::sin(instance.angle) * instance.scale;
+            float *matrix = out + i * InstanceTransforms::MATRIX_FLOATS;
+            matrix[0] = c;
+            matrix[1] = s;
+            matrix[2] = 0.0f;
+            matrix[3] = 0.0f;
+            matrix[4] = -s;
+            matrix[5] = c;
+            matrix[6] = 0.0f;
+            matrix[7] = 0.0f;
+            matrix[8] = 0.0f;
+            matrix[9] = 0.0f;
+            matrix[10] = instance.scale;
+            matrix[11] = 0.0f;
+            matrix[12] = instance.x;
+            matrix[13] = instance.y;
+            matrix[14] = 0.0f;
+            matrix[15] = 1.0f;
+        }
+    }
+
+private:
+    static float wrap(float value, float limit)
+    {
+        if (value >= limit)
+        {
+            value -= 2.0f * limit;
+        }
+        if (value < -limit)
+        {
+            value += 2.0f * limit;
+        }
+        return value;
+    }
+
+    std::vector<InstanceTransforms::Instance> instances;
+};
+
+/**
+ * @return the largest absolute difference between two sets of matrices.
+ */
+float maxDifference(const AlignedFloats &a, const AlignedFloats &b)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        worst = std::max(worst, std::abs(a[i] - b[i]));
+    }
+    return worst;
+}
+
+/**
+ * @brief steps the same population a few frames through every path and compares the matrices: libm against the polynomial, and the SIMD and threaded paths against the scalar lanes they must match almost bit for bit.
+ * @return 0 when everything agrees, 1 otherwise.
+ */
+int runChecks(uint32_t threads)
+{
+    const uint32_t count = 10007; // not a multiple of any width or block, so the scalar tails get exercised.
+    const uint32_t frames = 3;
+    InstanceTransforms scalar, simd, threaded;
+    for (InstanceTransforms *transforms : {&scalar, &simd, &threaded})
+    {
+        transforms->create(count, EXTENT, 0.02f, SEED);
+    }
+    AosTransforms aos(scalar);
+    WorkerPool workers(threads);
+
+    size_t floats = static_cast<size_t>(count) * InstanceTransforms::MATRIX_FLOATS;
+    AlignedFloats aosOut(floats), scalarOut(floats), simdOut(floats), threadedOut(floats);
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        aos.update(FRAME_DT, aosOut.data());
+        scalar.updateScalar(FRAME_DT, scalarOut.data());
+        simd.update(FRAME_DT, simdOut.data(), nullptr);
+        threaded.update(FRAME_DT, threadedOut.data(), &workers);
+    }
+
+    struct Check
+    {
+        const char *name;
+        float difference;
+        float tolerance;
+    };
+    // the polynomial is good to ~4e-6 in sin/cos, scaled by at most 0.03 here; everything else only differs by rounding (e.g. FMA contraction).
+    Check checks[] = {{"soa scalar vs aos libm", maxDifference(aosOut, scalarOut), 1e-5f},
+                      {"soa simd vs soa scalar", maxDifference(scalarOut, simdOut), 1e-5f},
+                      {"soa simd threaded vs soa simd", maxDifference(simdOut, threadedOut), 1e-5f}};
+    int failures = 0;
+    for (const Check &check : checks)
+    {
+        bool passed = check.difference <= check.tolerance;
+        std::cout << (passed ? "ok     " : "FAILED ") << check.name << ": max difference " << check.difference << '\n';
+        failures += passed ? 0 : 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief grows the frame count until a run takes minTimeMs, then prints the per-frame update time for count instances.
+ * @return ms per frame, for the speedup column.
+ */
+double runLayout(const std::string &name, uint32_t count, double minTimeMs, double baselineMs, const std::function<void()> &frame)
+{
+    frame(); // warm-up: faults in the output pages and the state.
+    uint64_t frames = 1;
+    double elapsedMs = 0.0;
+    while (true)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < frames; i++)
+        {
+            frame();
+        }
+        elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsedMs >= minTimeMs || frames >= (1ull << 30))
+        {
+            break;
+        }
+        // aim a little past the target rather than doubling blindly.
+        frames = std::max(frames * 2, static_cast<uint64_t>(frames * minTimeMs * 1.2 / std::max(elapsedMs, 1e-3)));
+    }
+
+    double msPerFrame = elapsedMs / frames;
+    double gbPerSecond = static_cast<double>(count) * InstanceTransforms::MATRIX_FLOATS * sizeof(float) / (msPerFrame * 1e6);
+    std::cout << std::left << std::setw(24) << name << std::right << std::setw(10) << count << std::setw(10) << frames << std::fixed << std::setprecision(3)
+              << std::setw(12) << msPerFrame << " ms" << std::setw(10) << msPerFrame * 1e6 / count << " ns" << std::setw(10) << gbPerSecond << " GB/s"
+              << std::setw(9) << std::setprecision(2) << (baselineMs > 0.0 ? baselineMs / msPerFrame : 1.0) << "x\n";
+    return msPerFrame;
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        InstanceBenchConfig config = parseArguments(argc, argv);
+        std::cout << "simd: " << instance_lanes::Widest::name << " (" << instance_lanes::Widest::width << " lanes), " << config.threads << " worker(s)\n";
+        if (config.checks && runChecks(config.threads) != 0)
+        {
+            return EXIT_FAILURE;
+        }
+
+        WorkerPool workers(config.threads);
+        std::cout << std::left << std::setw(24) << "layout" << std::right << std::setw(10) << "instances" << std::setw(10) << "frames" << std::setw(15) << "time/frame"
+                  << std::setw(13) << "time/inst" << std::setw(15) << "written" << std::setw(10) << "speedup" << '\n';
+        for (uint32_t count : config.counts)
+        {
+            InstanceTransforms transforms;
+            transforms.create(count, EXTENT, 0.01f, SEED);
+            AosTransforms aos(transforms);
+            AlignedFloats out(static_cast<size_t>(count) * InstanceTransforms::MATRIX_FLOATS);
+
+            double baselineMs = runLayout("aos scalar", count, config.minTimeMs, 0.0, [&]()
+                                          { aos.update(FRAME_DT, out.data()); });
+            runLayout("soa simd", count, config.minTimeMs, baselineMs, [&]()
+                      { transforms.update(FRAME_DT, out.data(), nullptr); });
+            runLayout("soa simd x" + std::to_string(workers.size()) + " threads", count, config.minTimeMs, baselineMs, [&]()
+                      { transforms.update(FRAME_DT, out.data(), &workers); });
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
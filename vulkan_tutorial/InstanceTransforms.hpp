@@ -0,0 +1,384 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "WorkerPool.hpp"
+
+/**
+ * @brief std::allocator, but every allocation starts on a cache line.
+ */
+template <typename T>
+struct CacheLineAllocator
+{
+    using value_type = T;
+    static constexpr size_t alignment = 64;
+
+    CacheLineAllocator() = default;
+    template <typename U>
+    CacheLineAllocator(const CacheLineAllocator<U> &)
+    {
+    }
+
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t{alignment}));
+    }
+
+    void deallocate(T *pointer, size_t)
+    {
+        ::operator delete(pointer, std::align_val_t{alignment});
+    }
+
+    bool operator==(const CacheLineAllocator &) const
+    {
+        return true;
+    }
+};
+
+using AlignedFloats = std::vector<float, CacheLineAllocator<float>>;
+
+/**
+ * @brief the arithmetic InstanceTransforms needs, once per instruction set, so the update itself is written once. Each backend processes width instances per call; masks come out of the comparisons and go into select().
+ */
+namespace instance_lanes
+{
+struct Scalar
+{
+    using V = float;
+    using Mask = bool;
+    static constexpr const char *name = "scalar";
+    static constexpr uint32_t width = 1;
+
+    static V load(const float *p) { return *p; }
+    static void store(float *p, V v) { *p = v; }
+    static V splat(float v) { return v; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static Mask greaterEqual(V a, V b) { return a >= b; }
+    static Mask less(V a, V b) { return a < b; }
+    static V select(Mask mask, V a, V b) { return mask ? a : b; }
+
+    static void storeMatrices(float *out, V c, V s, V scale, V x, V y)
+    {
+        const float matrix[16] = {c, s, 0.0f, 0.0f, -s, c, 0.0f, 0.0f, 0.0f, 0.0f, scale, 0.0f, x, y, 0.0f, 1.0f};
+        for (int i = 0; i < 16; i++)
+        {
+            out[i] = matrix[i];
+        }
+    }
+
+    static void fence() {}
+};
+
+#if defined(__SSE2__)
+struct Sse
+{
+    using V = __m128;
+    using Mask = __m128;
+    static constexpr const char *name = "sse";
+    static constexpr uint32_t width = 4;
+
+    static V load(const float *p) { return _mm_load_ps(p); }
+    static void store(float *p, V v) { _mm_store_ps(p, v); }
+    static V splat(float v) { return _mm_set1_ps(v); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static Mask greaterEqual(V a, V b) { return _mm_cmpge_ps(a, b); }
+    static Mask less(V a, V b) { return _mm_cmplt_ps(a, b); }
+    static V select(Mask mask, V a, V b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+    /**
+     * @brief four instances' lanes to four column-major matrices: each column is a 4x4 transpose of the lanes that feed it. Non-temporal stores, since the output is written once and read by the GPU, not by us; the instance buffer is often write-combined memory, where anything else is slow.
+     */
+    static void storeMatrices(float *out, V c, V s, V scale, V x, V y)
+    {
+        V zero = _mm_setzero_ps();
+        V columns[4][4] = {{c, s, zero, zero}, {_mm_sub_ps(zero, s), c, zero, zero}, {zero, zero, scale, zero}, {x, y, zero, _mm_set1_ps(1.0f)}};
+        for (int column = 0; column < 4; column++)
+        {
+            V *rows = columns[column];
+            _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+            for (int instance = 0; instance < 4; instance++)
+            {
+                _mm_stream_ps(out + instance * 16 + column * 4, rows[instance]);
+            }
+        }
+    }
+
+    // non-temporal stores aren't ordered with anything else until this.
+    static void fence() { _mm_sfence(); }
+};
+#endif
+
+#if defined(__AVX__)
+struct Avx
+{
+    using V = __m256;
+    using Mask = __m256;
+    static constexpr const char *name = "avx";
+    static constexpr uint32_t width = 8;
+
+    static V load(const float *p) { return _mm256_load_ps(p); }
+    static void store(float *p, V v) { _mm256_store_ps(p, v); }
+    static V splat(float v) { return _mm256_set1_ps(v); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static Mask greaterEqual(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Mask less(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static V select(Mask mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); }
+
+    // the math is 8 wide; the transposes are cheaper done as two 4x4 halves than across 256-bit lanes.
+    static void storeMatrices(float *out, V c, V s, V scale, V x, V y)
+    {
+        Sse::storeMatrices(out, _mm256_castps256_ps128(c), _mm256_castps256_ps128(s), _mm256_castps256_ps128(scale), _mm256_castps256_ps128(x),
+                           _mm256_castps256_ps128(y));
+        Sse::storeMatrices(out + 64, _mm256_extractf128_ps(c, 1), _mm256_extractf128_ps(s, 1), _mm256_extractf128_ps(scale, 1), _mm256_extractf128_ps(x, 1),
+                           _mm256_extractf128_ps(y, 1));
+    }
+
+    static void fence() { _mm_sfence(); }
+};
+#endif
+
+#if defined(__ARM_NEON)
+struct Neon
+{
+    using V = float32x4_t;
+    using Mask = uint32x4_t;
+    static constexpr const char *name = "neon";
+    static constexpr uint32_t width = 4;
+
+    static V load(const float *p) { return vld1q_f32(p); }
+    static void store(float *p, V v) { vst1q_f32(p, v); }
+    static V splat(float v) { return vdupq_n_f32(v); }
+    static V add(V a, V b) { return vaddq_f32(a, b); }
+    static V sub(V a, V b) { return vsubq_f32(a, b); }
+    static V mul(V a, V b) { return vmulq_f32(a, b); }
+    static Mask greaterEqual(V a, V b) { return vcgeq_f32(a, b); }
+    static Mask less(V a, V b) { return vcltq_f32(a, b); }
+    static V select(Mask mask, V a, V b) { return vbslq_f32(mask, a, b); }
+
+    static void storeMatrices(float *out, V c, V s, V scale, V x, V y)
+    {
+        V zero = vdupq_n_f32(0.0f);
+        V columns[4][4] = {{c, s, zero, zero}, {vnegq_f32(s), c, zero, zero}, {zero, zero, scale, zero}, {x, y, zero, vdupq_n_f32(1.0f)}};
+        for (int column = 0; column < 4; column++)
+        {
+            // 4x4 transpose: zip rows 0/1 and 2/3, then pair up the halves.
+            float32x4x2_t low = vzipq_f32(columns[column][0], columns[column][1]);
+            float32x4x2_t high = vzipq_f32(columns[column][2], columns[column][3]);
+            vst1q_f32(out + 0 * 16 + column * 4, vcombine_f32(vget_low_f32(low.val[0]), vget_low_f32(high.val[0])));
+            vst1q_f32(out + 1 * 16 + column * 4, vcombine_f32(vget_high_f32(low.val[0]), vget_high_f32(high.val[0])));
+            vst1q_f32(out + 2 * 16 + column * 4, vcombine_f32(vget_low_f32(low.val[1]), vget_low_f32(high.val[1])));
+            vst1q_f32(out + 3 * 16 + column * 4, vcombine_f32(vget_high_f32(low.val[1]), vget_high_f32(high.val[1])));
+        }
+    }
+
+    static void fence() {}
+};
+#endif
+
+#if defined(__AVX__)
+using Widest = Avx;
+#elif defined(__SSE2__)
+using Widest = Sse;
+#elif defined(__ARM_NEON)
+using Widest = Neon;
+#else
+using Widest = Scalar;
+#endif
+} // namespace instance_lanes
+
+/**
+ * @brief per-instance 2D transforms for --instances, kept as structure of arrays and turned into one column-major mat4 per instance every frame, straight into the instance buffer the vertex shader reads.
+ *
+ * Each field (position, velocity, angle, spin, scale) is its own cache-line-aligned array, so an update streams through memory at unit stride and a SIMD register holds the same field for width neighbouring instances; AVX, SSE or NEON is whatever the build targets: the app stays on the portable baseline (SSE2 on x86-64), InstanceBench gets SIMD_FLAGS. sin/cos come from a polynomial on the folded angle rather than libm, so they vectorize too. Every matrix is 16 floats, exactly a cache line, written with non-temporal stores where the instruction set has them.
+ *
+ * Worker slices are whole blocks of BLOCK instances, a cache line of every array, so two workers never write the same line of state or of the output.
+ */
+class InstanceTransforms
+{
+public:
+    // floats per instance in the output: one column-major mat4.
+    static constexpr uint32_t MATRIX_FLOATS = 16;
+    // instances per cache line of a float array; arrays are padded to it and worker slices start on it.
+    static constexpr uint32_t BLOCK = 16;
+    static constexpr float PI = 3.14159265358979f;
+
+    /**
+     * @brief one instance's state; the layout an array-of-structures version would use.
+     */
+    struct Instance
+    {
+        float x, y;
+        float vx, vy;
+        float angle;
+        float spin;
+        float scale;
+    };
+
+    /**
+     * @brief scatters count instances over [-extent, extent]^2 with random drift, rotation, spin and a size around scale.
+     */
+    void create(uint32_t count, float extent, float scale, uint32_t seed)
+    {
+        this->count = count;
+        this->extent = extent;
+        uint32_t padded = (count + BLOCK - 1) / BLOCK * BLOCK;
+        for (AlignedFloats *column : {&x, &y, &vx, &vy, &angle, &spin, &scales})
+        {
+            // padding lanes are zero: still, unrotated and never written out.
+            column->assign(padded, 0.0f);
+        }
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> position(-extent, extent);
+        std::uniform_real_distribution<float> drift(-0.1f * extent, 0.1f * extent);
+        std::uniform_real_distribution<float> rotation(-PI, PI);
+        std::uniform_real_distribution<float> size(0.5f * scale, 1.5f * scale);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            x[i] = position(random);
+            y[i] = position(random);
+            vx[i] = drift(random);
+            vy[i] = drift(random);
+            angle[i] = rotation(random);
+            spin[i] = rotation(random);
+            scales[i] = size(random);
+        }
+    }
+
+    uint32_t size() const
+    {
+        return count;
+    }
+
+    Instance instance(uint32_t i) const
+    {
+        return {x[i], y[i], vx[i], vy[i], angle[i], spin[i], scales[i]};
+    }
+
+    /**
+     * @brief advances every instance by dt seconds and writes all the matrices to out, split over workers when given.
+     * @param out size() * MATRIX_FLOATS floats, 16-byte aligned.
+     */
+    void update(float dt, float *out, WorkerPool *workers)
+    {
+        if (reinterpret_cast<uintptr_t>(out) % 16 != 0)
+        {
+            throw std::runtime_error("instance transform output must be 16-byte aligned!");
+        }
+        if (workers == nullptr)
+        {
+            updateRange<instance_lanes::Widest>(dt, 0, count, out);
+            return;
+        }
+        uint32_t blocks = (count + BLOCK - 1) / BLOCK;
+        workers->run([&](uint32_t workerIndex)
+                     {
+            auto [begin, end] = workers->slice(blocks, workerIndex);
+            updateRange<instance_lanes::Widest>(dt, begin * BLOCK, std::min(end * BLOCK, count), out); });
+    }
+
+    /**
+     * @brief the same update one instance at a time, without intrinsics; the reference the SIMD paths are checked against.
+     */
+    void updateScalar(float dt, float *out)
+    {
+        updateRange<instance_lanes::Scalar>(dt, 0, count, out);
+    }
+
+    /**
+     * @return sin and cos of angle in [-pi, pi), to within about 4e-6; exposed so other layouts can share the exact same math.
+     */
+    template <typename L>
+    static void sinCos(typename L::V angle, typename L::V &s, typename L::V &c)
+    {
+        s = foldedSin<L>(angle);
+        // cos(a) = sin(a + pi/2), wrapped back into [-pi, pi).
+        typename L::V shifted = L::add(angle, L::splat(0.5f * PI));
+        shifted = L::select(L::greaterEqual(shifted, L::splat(PI)), L::sub(shifted, L::splat(2.0f * PI)), shifted);
+        c = foldedSin<L>(shifted);
+    }
+
+    /**
+     * @return value wrapped into [-limit, limit), assuming it's at most one period out, which a frame's worth of motion always is.
+     */
+    template <typename L>
+    static typename L::V wrap(typename L::V value, float limit)
+    {
+        value = L::select(L::greaterEqual(value, L::splat(limit)), L::sub(value, L::splat(2.0f * limit)), value);
+        return L::select(L::less(value, L::splat(-limit)), L::add(value, L::splat(2.0f * limit)), value);
+    }
+
+private:
+    /**
+     * @brief sin on [-pi, pi): reflect into [-pi/2, pi/2], where a degree 9 Taylor polynomial is off by at most about 4e-6, far below anything visible on screen.
+     */
+    template <typename L>
+    static typename L::V foldedSin(typename L::V a)
+    {
+        typename L::V halfPi = L::splat(0.5f * PI);
+        a = L::select(L::greaterEqual(a, halfPi), L::sub(L::splat(PI), a), a);
+        a = L::select(L::less(a, L::sub(L::splat(0.0f), halfPi)), L::sub(L::splat(-PI), a), a);
+        typename L::V a2 = L::mul(a, a);
+        typename L::V poly = L::add(L::splat(-1.0f / 5040.0f), L::mul(a2, L::splat(1.0f / 362880.0f)));
+        poly = L::add(L::splat(1.0f / 120.0f), L::mul(a2, poly));
+        poly = L::add(L::splat(-1.0f / 6.0f), L::mul(a2, poly));
+        poly = L::add(L::splat(1.0f), L::mul(a2, poly));
+        return L::mul(a, poly);
+    }
+
+    /**
+     * @param begin a multiple of BLOCK, so every full-width load is aligned; whatever doesn't fill a last register goes through the scalar lanes.
+     */
+    template <typename L>
+    void updateRange(float dt, uint32_t begin, uint32_t end, float *out)
+    {
+        uint32_t i = begin;
+        for (; i + L::width <= end; i += L::width)
+        {
+            advance<L>(dt, i, out);
+        }
+        for (; i < end; i++)
+        {
+            advance<instance_lanes::Scalar>(dt, i, out);
+        }
+        L::fence();
+    }
+
+    template <typename L>
+    void advance(float dt, uint32_t i, float *out)
+    {
+        typename L::V step = L::splat(dt);
+        typename L::V px = wrap<L>(L::add(L::load(&x[i]), L::mul(L::load(&vx[i]), step)), extent);
+        typename L::V py = wrap<L>(L::add(L::load(&y[i]), L::mul(L::load(&vy[i]), step)), extent);
+        typename L::V a = wrap<L>(L::add(L::load(&angle[i]), L::mul(L::load(&spin[i]), step)), PI);
+        L::store(&x[i], px);
+        L::store(&y[i], py);
+        L::store(&angle[i], a);
+
+        typename L::V s, c;
+        sinCos<L>(a, s, c);
+        typename L::V scale = L::load(&scales[i]);
+        L::storeMatrices(out + static_cast<size_t>(i) * MATRIX_FLOATS, L::mul(c, scale), L::mul(s, scale), scale, px, py);
+    }
+
+    uint32_t count = 0;
+    float extent = 1.0f;
+    AlignedFloats x, y, vx, vy, angle, spin, scales;
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief one vertex as stored in a .vkmesh file; byte for byte the app's Vertex, so chunks go from the file to the GPU untouched.
+ */
+struct MeshVertex
+{
+    float position[2];
+    float color[3];
+};
+
+/**
+ * @brief .vkmesh layout, written by MeshConverter and read in place by MeshAsset.
+ *
+ * A MeshFileHeader, the MeshChunkRecord table right behind it, then one payload per chunk. A payload is the chunk's vertices followed by its uint16 indices, exactly what ends up in the chunk's GPU buffer, and starts on a MESH_PAYLOAD_ALIGNMENT boundary so a chunk never shares a page with its neighbours: paging one in reads only that chunk, and it can be copied straight out of the mapping into staging. Everything is little-endian, native struct layout; the converter and the app are expected to run on the same kind of host.
+ */
+struct MeshFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t chunkCount;
+    // sizeof(MeshVertex) when written; checked so a stale file fails loudly instead of rendering garbage.
+    uint32_t vertexStride;
+    uint64_t chunkTableOffset;
+    uint64_t fileSize;
+    // xy bounds of the whole mesh: min x, min y, max x, max y.
+    float bounds[4];
+};
+
+struct MeshChunkRecord
+{
+    // from the start of the file; a multiple of MESH_PAYLOAD_ALIGNMENT.
+    uint64_t payloadOffset;
+    uint64_t payloadSize;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    // where the indices start within the payload, after the vertices and padding.
+    uint32_t indexOffset;
+    // bounding circle, same test the draw list uses for culling.
+    float center[2];
+    float radius;
+};
+
+constexpr uint32_t MESH_FILE_MAGIC = 0x4853454D; // "MESH"
+constexpr uint32_t MESH_FILE_VERSION = 1;
+// a whole page on everything we run on, and VkPhysicalDeviceLimits::optimalBufferCopyOffsetAlignment is never bigger.
+constexpr uint64_t MESH_PAYLOAD_ALIGNMENT = 4096;
+// 16-bit indices, so a chunk addresses at most this many vertices.
+constexpr uint32_t MESH_CHUNK_MAX_VERTICES = 65535;
+
+/**
+ * @brief a .vkmesh file mapped read-only. Nothing is read at open beyond the header and the chunk table; chunk payloads are paged in by whoever touches them, normally the upload ring's memcpy into staging.
+ *
+ * The mapping is MADV_RANDOM, since chunks are visited in whatever order the camera finds them and the kernel's sequential readahead would only drag in neighbours nobody asked for; prefetch() asks for the pages of one chunk ahead of time instead.
+ */
+class MeshAsset
+{
+public:
+    MeshAsset() = default;
+    MeshAsset(const MeshAsset &) = delete;
+    MeshAsset &operator=(const MeshAsset &) = delete;
+
+    ~MeshAsset()
+    {
+        close();
+    }
+
+    void open(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("failed to open mesh " + path + "!");
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < sizeof(MeshFileHeader))
+        {
+            ::close(fd);
+            throw std::runtime_error(path + " is too small to be a mesh!");
+        }
+        size = static_cast<size_t>(info.st_size);
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps the file alive on its own.
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            mapping = nullptr;
+            throw std::runtime_error("failed to map mesh " + path + "!");
+        }
+        madvise(mapping, size, MADV_RANDOM);
+        pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+        try
+        {
+            validate(path);
+        }
+        catch (...)
+        {
+            close();
+            throw;
+        }
+    }
+
+    void close()
+    {
+        if (mapping != nullptr)
+        {
+            munmap(mapping, size);
+            mapping = nullptr;
+        }
+    }
+
+    bool isOpen() const
+    {
+        return mapping != nullptr;
+    }
+
+    const MeshFileHeader &header() const
+    {
+        return *static_cast<const MeshFileHeader *>(mapping);
+    }
+
+    uint32_t chunkCount() const
+    {
+        return header().chunkCount;
+    }
+
+    const MeshChunkRecord &chunk(uint32_t index) const
+    {
+        return chunkTable()[index];
+    }
+
+    /**
+     * @brief the chunk's payload, straight out of the mapping; stays valid until close().
+     */
+    const void *payload(uint32_t index) const
+    {
+        return static_cast<const uint8_t *>(mapping) + chunk(index).payloadOffset;
+    }
+
+    /**
+     * @brief starts reading a chunk's pages in the background (MADV_WILLNEED), so the copy into staging a frame or so later doesn't block on the disk.
+     */
+    void prefetch(uint32_t index) const
+    {
+        uint8_t *begin;
+        size_t length;
+        pageRange(index, begin, length);
+        madvise(begin, length, MADV_WILLNEED);
+    }
+
+    /**
+     * @return how many of the chunk's bytes aren't in the page cache yet, i.e. roughly what touching it will read from disk. Page granular.
+     */
+    uint64_t nonResidentBytes(uint32_t index) const
+    {
+        uint8_t *begin;
+        size_t length;
+        pageRange(index, begin, length);
+        std::string resident((length + pageSize - 1) / pageSize, '\0');
+        if (mincore(begin, length, reinterpret_cast<unsigned char *>(resident.data())) != 0)
+        {
+            // can't tell, so assume the worst.
+            return chunk(index).payloadSize;
+        }
+        uint64_t missing = 0;
+        for (char page : resident)
+        {
+            missing += (page & 1) ? 0 : pageSize;
+        }
+        return missing;
+    }
+
+private:
+    const MeshChunkRecord *chunkTable() const
+    {
+        return reinterpret_cast<const MeshChunkRecord *>(static_cast<const uint8_t *>(mapping) + header().chunkTableOffset);
+    }
+
+    /**
+     * @brief the chunk's payload widened to whole pages; mincore() and madvise() want a page aligned start, and MESH_PAYLOAD_ALIGNMENT may be smaller than the host's pages.
+     */
+    void pageRange(uint32_t index, uint8_t *&begin, size_t &length) const
+    {
+        const MeshChunkRecord &record = chunk(index);
+        uint64_t first = record.payloadOffset / pageSize * pageSize;
+        begin = static_cast<uint8_t *>(mapping) + first;
+        length = static_cast<size_t>(record.payloadOffset + record.payloadSize - first);
+    }
+
+    /**
+     * @brief bounds checks on the header and every chunk record. Indices themselves aren't checked; that would mean reading every payload up front, which is what the format exists to avoid, so files are trusted to come from MeshConverter.
+     */
+    void validate(const std::string &path) const
+    {
+        const MeshFileHeader &h = header();
+        if (h.magic != MESH_FILE_MAGIC)
+        {
+            throw std::runtime_error(path + " isn't a mesh file!");
+        }
+        if (h.version != MESH_FILE_VERSION || h.vertexStride != sizeof(MeshVertex))
+        {
+            throw std::runtime_error(path + " was written by a different version of MeshConverter; convert it again!");
+        }
+        if (h.fileSize != size || h.chunkTableOffset % alignof(MeshChunkRecord) != 0 || h.chunkTableOffset > size ||
+            (size - h.chunkTableOffset) / sizeof(MeshChunkRecord) < h.chunkCount)
+        {
+            throw std::runtime_error(path + " is truncated or corrupt!");
+        }
+        for (uint32_t i = 0; i < h.chunkCount; i++)
+        {
+            const MeshChunkRecord &record = chunk(i);
+            bool inFile = record.payloadOffset <= size && record.payloadSize <= size - record.payloadOffset;
+            bool layoutOk = record.payloadOffset % MESH_PAYLOAD_ALIGNMENT == 0 && record.vertexCount <= MESH_CHUNK_MAX_VERTICES &&
+                            static_cast<uint64_t>(record.vertexCount) * sizeof(MeshVertex) <= record.indexOffset && record.indexOffset % 4 == 0 &&
+                            record.indexOffset + static_cast<uint64_t>(record.indexCount) * sizeof(uint16_t) <= record.payloadSize;
+            if (!inFile || !layoutOk)
+            {
+                throw std::runtime_error(path + " chunk " + std::to_string(i) + " is corrupt!");
+            }
+        }
+    }
+
+    void *mapping = nullptr;
+    size_t size = 0;
+    size_t pageSize = 4096;
+};
@@ -0,0 +1,850 @@
+// build-time helper: converts an OBJ or glTF 2.0 (.gltf/.glb) mesh into the .vkmesh format MeshAsset maps and MeshStreamer streams.
+// usage: MeshConverter [--grid N] [--extent E] INPUT.{obj,gltf,glb} OUTPUT.vkmesh
+// The app draws in 2D, so the mesh is viewed down -z: z is dropped after shading by it, and x/y are recentered and scaled to fit [-E, E] (default 4, the --scene-objects world). Triangles are then binned by centroid into an N x N grid (default 16) and each cell split further wherever it would pass 65535 vertices, so a chunk is a compact patch of the world with its own bounding circle.
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MeshAsset.hpp"
+
+/**
+ * @brief whatever the importers found, before projection and chunking.
+ */
+struct SourceMesh
+{
+    std::vector<std::array<float, 3>> positions;
+    // same length as positions, or empty if the file had no vertex colors.
+    std::vector<std::array<float, 3>> colors;
+    std::vector<uint32_t> indices;
+};
+
+static std::vector<char> readBytes(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open " + path);
+    }
+    return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static bool endsWith(const std::string &text, const std::string &suffix)
+{
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// ---- OBJ ----
+
+/**
+ * @brief v and f lines only; polygons are fan triangulated. Accepts the common "v x y z r g b" vertex color extension.
+ */
+static SourceMesh loadObj(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open " + path);
+    }
+    SourceMesh mesh;
+    bool anyColor = false;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream in(line);
+        std::string keyword;
+        in >> keyword;
+        if (keyword == "v")
+        {
+            std::array<float, 3> position{};
+            std::array<float, 3> color{1.0f, 1.0f, 1.0f};
+            in >> position[0] >> position[1] >> position[2];
+            if (in >> color[0] >> color[1] >> color[2])
+            {
+                anyColor = true;
+            }
+            mesh.positions.push_back(position);
+            mesh.colors.push_back(color);
+        }
+        else if (keyword == "f")
+        {
+            std::vector<uint32_t> polygon;
+            std::string corner;
+            while (in >> corner)
+            {
+                // "7", "7/2", "7//3" or "7/2/3"; only the position index matters. Negative indices count back from the latest vertex.
+                long index = std::stol(corner.substr(0, corner.find('/')));
+                long resolved = index < 0 ? static_cast<long>(mesh.positions.size()) + index : index - 1;
+                if (resolved < 0 || resolved >= static_cast<long>(mesh.positions.size()))
+                {
+                    throw std::runtime_error(path + ": face refers to vertex " + std::to_string(index) + " that doesn't exist");
+                }
+                polygon.push_back(static_cast<uint32_t>(resolved));
+            }
+            for (size_t i = 2; i < polygon.size(); i++)
+            {
+                mesh.indices.insert(mesh.indices.end(), {polygon[0], polygon[i - 1], polygon[i]});
+            }
+        }
+    }
+    if (!anyColor)
+    {
+        mesh.colors.clear();
+    }
+    return mesh;
+}
+
+// ---- glTF ----
+
+/**
+ * @brief just enough JSON for a glTF document.
+ */
+struct Json
+{
+    enum class Type
+    {
+        Null,
+        Boolean,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    const Json *find(const std::string &key) const
+    {
+        for (const auto &[name, value] : object)
+        {
+            if (name == key)
+            {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    const Json &at(const std::string &key) const
+    {
+        const Json *value = find(key);
+        if (value == nullptr)
+        {
+            throw std::runtime_error("glTF: missing \"" + key + "\"");
+        }
+        return *value;
+    }
+
+    const Json &at(size_t index) const
+    {
+        if (type != Type::Array || index >= array.size())
+        {
+            throw std::runtime_error("glTF: index " + std::to_string(index) + " out of range");
+        }
+        return array[index];
+    }
+
+    size_t asIndex() const
+    {
+        if (type != Type::Number || number < 0.0)
+        {
+            throw std::runtime_error("glTF: expected an index");
+        }
+        return static_cast<size_t>(number);
+    }
+
+    size_t indexOr(const std::string &key, size_t fallback) const
+    {
+        const Json *value = find(key);
+        return value == nullptr ? fallback : value->asIndex();
+    }
+};
+
+class JsonParser
+{
+public:
+    explicit JsonParser(const std::string &text) : text(text) {}
+
+    Json parse()
+    {
+        Json value = parseValue();
+        skipSpace();
+        if (pos != text.size())
+        {
+            fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string &what)
+    {
+        throw std::runtime_error("glTF JSON: " + what + " at offset " + std::to_string(pos));
+    }
+
+    void skipSpace()
+    {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+        {
+            pos++;
+        }
+    }
+
+    void expect(char c)
+    {
+        skipSpace();
+        if (pos >= text.size() || text[pos] != c)
+        {
+            fail(std::string("expected '") + c + "'");
+        }
+        pos++;
+    }
+
+    bool consume(const char *word)
+    {
+        size_t length = std::strlen(word);
+        if (text.compare(pos, length, word) == 0)
+        {
+            pos += length;
+            return true;
+        }
+        return false;
+    }
+
+    Json parseValue()
+    {
+        skipSpace();
+        if (pos >= text.size())
+        {
+            fail("unexpected end");
+        }
+        Json value;
+        char c = text[pos];
+        if (c == '{')
+        {
+            value.type = Json::Type::Object;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == '}')
+            {
+                pos++;
+                return value;
+            }
+            do
+            {
+                skipSpace();
+                std::string key = parseString();
+                expect(':');
+                value.object.emplace_back(std::move(key), parseValue());
+                skipSpace();
+            } while (pos < text.size() && text[pos++] == ',');
+            if (text[pos - 1] != '}')
+            {
+                fail("expected '}'");
+            }
+        }
+        else if (c == '[')
+        {
+            value.type = Json::Type::Array;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == ']')
+            {
+                pos++;
+                return value;
+            }
+            do
+            {
+                value.array.push_back(parseValue());
+                skipSpace();
+            } while (pos < text.size() && text[pos++] == ',');
+            if (text[pos - 1] != ']')
+            {
+                fail("expected ']'");
+            }
+        }
+        else if (c == '"')
+        {
+            value.type = Json::Type::String;
+            value.string = parseString();
+        }
+        else if (consume("true"))
+        {
+            value.type = Json::Type::Boolean;
+            value.boolean = true;
+        }
+        else if (consume("false"))
+        {
+            value.type = Json::Type::Boolean;
+        }
+        else if (consume("null"))
+        {
+            value.type = Json::Type::Null;
+        }
+        else
+        {
+            const char *start = text.c_str() + pos;
+            char *end = nullptr;
+            value.type = Json::Type::Number;
+            value.number = std::strtod(start, &end);
+            if (end == start)
+            {
+                fail("unexpected character");
+            }
+            pos += static_cast<size_t>(end - start);
+        }
+        return value;
+    }
+
+    /**
+     * @brief escapes other than \uXXXX come through as the escaped character; glTF keys and URIs are ASCII in practice.
+     */
+    std::string parseString()
+    {
+        if (pos >= text.size() || text[pos] != '"')
+        {
+            fail("expected a string");
+        }
+        pos++;
+        std::string out;
+        while (pos < text.size() && text[pos] != '"')
+        {
+            if (text[pos] == '\\' && pos + 1 < text.size())
+            {
+                pos++;
+                switch (text[pos])
+                {
+                case 'n':
+                    out += '\n';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u':
+                    // non-ASCII never shows up in anything we read; keep a placeholder and move on.
+                    out += '?';
+                    pos += 4;
+                    break;
+                default:
+                    out += text[pos];
+                }
+                pos++;
+                continue;
+            }
+            out += text[pos++];
+        }
+        if (pos >= text.size())
+        {
+            fail("unterminated string");
+        }
+        pos++;
+        return out;
+    }
+
+    const std::string &text;
+    size_t pos = 0;
+};
+
+static std::vector<char> decodeBase64(const std::string &data)
+{
+    static const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::vector<char> out;
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : data)
+    {
+        size_t value = alphabet.find(c);
+        if (value == std::string::npos)
+        {
+            // padding, line breaks.
+            continue;
+        }
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        count += 6;
+        if (count >= 8)
+        {
+            count -= 8;
+            out.push_back(static_cast<char>((bits >> count) & 0xFF));
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief a glTF document plus its buffers, resolved from the GLB binary chunk, data: URIs or files next to the .gltf.
+ */
+struct GltfDocument
+{
+    Json json;
+    std::vector<std::vector<char>> buffers;
+
+    /**
+     * @brief an accessor's elements as floats (or integers, for indices), with normalized integer types mapped to [0, 1].
+     */
+    std::vector<float> readAccessor(size_t index, size_t &components) const
+    {
+        const Json &accessor = json.at("accessors").at(index);
+        static const std::map<std::string, size_t> componentsPerType = {{"SCALAR", 1}, {"VEC2", 2}, {"VEC3", 3}, {"VEC4", 4}};
+        auto type = componentsPerType.find(accessor.at("type").string);
+        if (type == componentsPerType.end())
+        {
+            throw std::runtime_error("glTF: unsupported accessor type " + accessor.at("type").string);
+        }
+        components = type->second;
+        size_t count = accessor.at("count").asIndex();
+        uint32_t componentType = static_cast<uint32_t>(accessor.at("componentType").number);
+        size_t componentSize = componentType == 5126 || componentType == 5125 ? 4 : componentType == 5123 || componentType == 5122 ? 2 : 1;
+        bool normalized = accessor.find("normalized") != nullptr && accessor.at("normalized").boolean;
+
+        std::vector<float> values(count * components, 0.0f);
+        if (accessor.find("bufferView") == nullptr)
+        {
+            // no view means all zeros (sparse accessors aren't supported).
+            return values;
+        }
+        const Json &view = json.at("bufferViews").at(accessor.at("bufferView").asIndex());
+        const std::vector<char> &buffer = buffers.at(view.at("buffer").asIndex());
+        size_t stride = view.indexOr("byteStride", components * componentSize);
+        size_t base = view.indexOr("byteOffset", 0) + accessor.indexOr("byteOffset", 0);
+        if (count > 0 && base + (count - 1) * stride + components * componentSize > buffer.size())
+        {
+            throw std::runtime_error("glTF: accessor " + std::to_string(index) + " runs past the end of its buffer");
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            for (size_t c = 0; c < components; c++)
+            {
+                const char *src = buffer.data() + base + i * stride + c * componentSize;
+                float value;
+                switch (componentType)
+                {
+                case 5126:
+                {
+                    std::memcpy(&value, src, 4);
+                    break;
+                }
+                case 5125:
+                {
+                    uint32_t v;
+                    std::memcpy(&v, src, 4);
+                    value = static_cast<float>(v);
+                    break;
+                }
+                case 5123:
+                {
+                    uint16_t v;
+                    std::memcpy(&v, src, 2);
+                    value = normalized ? v / 65535.0f : static_cast<float>(v);
+                    break;
+                }
+                case 5121:
+                {
+                    uint8_t v = static_cast<uint8_t>(*src);
+                    value = normalized ? v / 255.0f : static_cast<float>(v);
+                    break;
+                }
+                default:
+                    throw std::runtime_error("glTF: unsupported component type " + std::to_string(componentType));
+                }
+                values[i * components + c] = value;
+            }
+        }
+        return values;
+    }
+
+    /**
+     * @brief uint32 indices need to round-trip exactly, which floats can't do past 2^24.
+     */
+    std::vector<uint32_t> readIndices(size_t index) const
+    {
+        const Json &accessor = json.at("accessors").at(index);
+        if (static_cast<uint32_t>(accessor.at("componentType").number) != 5125)
+        {
+            size_t components;
+            std::vector<float> values = readAccessor(index, components);
+            return std::vector<uint32_t>(values.begin(), values.end());
+        }
+        const Json &view = json.at("bufferViews").at(accessor.at("bufferView").asIndex());
+        const std::vector<char> &buffer = buffers.at(view.at("buffer").asIndex());
+        size_t count = accessor.at("count").asIndex();
+        size_t base = view.indexOr("byteOffset", 0) + accessor.indexOr("byteOffset", 0);
+        if (base + count * 4 > buffer.size())
+        {
+            throw std::runtime_error("glTF: index accessor runs past the end of its buffer");
+        }
+        std::vector<uint32_t> indices(count);
+        std::memcpy(indices.data(), buffer.data() + base, count * 4);
+        return indices;
+    }
+};
+
+static GltfDocument openGltf(const std::string &path)
+{
+    GltfDocument document;
+    std::vector<char> bytes = readBytes(path);
+    std::string jsonText;
+    std::vector<char> binChunk;
+    if (endsWith(path, ".glb"))
+    {
+        // 12 byte header, then chunks of (length, type, data): JSON first, optionally BIN second.
+        auto word = [&](size_t offset)
+        {
+            uint32_t value;
+            if (offset + 4 > bytes.size())
+            {
+                throw std::runtime_error(path + " is truncated");
+            }
+            std::memcpy(&value, bytes.data() + offset, 4);
+            return value;
+        };
+        if (word(0) != 0x46546C67)
+        {
+            throw std::runtime_error(path + " isn't a GLB file");
+        }
+        size_t offset = 12;
+        while (offset + 8 <= bytes.size())
+        {
+            uint32_t length = word(offset);
+            uint32_t type = word(offset + 4);
+            if (offset + 8 + length > bytes.size())
+            {
+                throw std::runtime_error(path + " is truncated");
+            }
+            const char *data = bytes.data() + offset + 8;
+            if (type == 0x4E4F534A)
+            {
+                jsonText.assign(data, length);
+            }
+            else if (type == 0x004E4942)
+            {
+                binChunk.assign(data, data + length);
+            }
+            offset += 8 + length;
+        }
+    }
+    else
+    {
+        jsonText.assign(bytes.begin(), bytes.end());
+    }
+    document.json = JsonParser(jsonText).parse();
+
+    std::string directory = path.find('/') == std::string::npos ? "" : path.substr(0, path.find_last_of('/') + 1);
+    if (const Json *buffers = document.json.find("buffers"))
+    {
+        for (const Json &buffer : buffers->array)
+        {
+            const Json *uri = buffer.find("uri");
+            if (uri == nullptr)
+            {
+                document.buffers.push_back(binChunk);
+            }
+            else if (uri->string.rfind("data:", 0) == 0)
+            {
+                document.buffers.push_back(decodeBase64(uri->string.substr(uri->string.find(',') + 1)));
+            }
+            else
+            {
+                document.buffers.push_back(readBytes(directory + uri->string));
+            }
+        }
+    }
+    return document;
+}
+
+/**
+ * @brief every triangle primitive of every mesh, POSITION and COLOR_0 only. Node transforms aren't applied; each mesh is taken in its own space, which is what single-mesh exports look like anyway.
+ */
+static SourceMesh loadGltf(const std::string &path)
+{
+    GltfDocument document = openGltf(path);
+    SourceMesh mesh;
+    bool anyColor = false;
+    const Json *meshes = document.json.find("meshes");
+    if (meshes == nullptr)
+    {
+        throw std::runtime_error(path + " has no meshes");
+    }
+    for (const Json &gltfMesh : meshes->array)
+    {
+        for (const Json &primitive : gltfMesh.at("primitives").array)
+        {
+            if (primitive.indexOr("mode", 4) != 4)
+            {
+                std::cerr << "skipping a non-triangle-list primitive\n";
+                continue;
+            }
+            const Json &attributes = primitive.at("attributes");
+            size_t components;
+            std::vector<float> positions = document.readAccessor(attributes.at("POSITION").asIndex(), components);
+            if (components != 3)
+            {
+                throw std::runtime_error("glTF: POSITION must be VEC3");
+            }
+            size_t vertexCount = positions.size() / 3;
+            std::vector<float> colors;
+            size_t colorComponents = 0;
+            if (const Json *color = attributes.find("COLOR_0"))
+            {
+                colors = document.readAccessor(color->asIndex(), colorComponents);
+                anyColor = true;
+            }
+
+            uint32_t base = static_cast<uint32_t>(mesh.positions.size());
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                mesh.positions.push_back({positions[v * 3], positions[v * 3 + 1], positions[v * 3 + 2]});
+                if (colorComponents >= 3)
+                {
+                    mesh.colors.push_back({colors[v * colorComponents], colors[v * colorComponents + 1], colors[v * colorComponents + 2]});
+                }
+                else
+                {
+                    mesh.colors.push_back({1.0f, 1.0f, 1.0f});
+                }
+            }
+            if (const Json *indices = primitive.find("indices"))
+            {
+                for (uint32_t index : document.readIndices(indices->asIndex()))
+                {
+                    if (index >= vertexCount)
+                    {
+                        throw std::runtime_error("glTF: index out of range");
+                    }
+                    mesh.indices.push_back(base + index);
+                }
+            }
+            else
+            {
+                for (uint32_t v = 0; v + 2 < vertexCount; v += 3)
+                {
+                    mesh.indices.insert(mesh.indices.end(), {base + v, base + v + 1, base + v + 2});
+                }
+            }
+        }
+    }
+    if (!anyColor)
+    {
+        mesh.colors.clear();
+    }
+    return mesh;
+}
+
+// ---- projection, chunking, output ----
+
+struct Chunk
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<uint16_t> indices;
+};
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t grid = 16;
+    float extent = 4.0f;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--grid" && i + 1 < argc)
+        {
+            grid = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--extent" && i + 1 < argc)
+        {
+            extent = std::stof(argv[++i]);
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != 2 || grid == 0 || extent <= 0.0f)
+    {
+        std::cerr << "usage: " << argv[0] << " [--grid N] [--extent E] INPUT.{obj,gltf,glb} OUTPUT.vkmesh\n";
+        return EXIT_FAILURE;
+    }
+
+    SourceMesh source;
+    try
+    {
+        source = endsWith(paths[0], ".obj") ? loadObj(paths[0]) : loadGltf(paths[0]);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    if (source.indices.empty())
+    {
+        std::cerr << paths[0] << " has no triangles\n";
+        return EXIT_FAILURE;
+    }
+
+    // recenter and scale x/y into [-extent, extent]; without vertex colors, shade by depth so there's something to look at.
+    float low[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float high[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+    for (const auto &p : source.positions)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            low[axis] = std::min(low[axis], p[axis]);
+            high[axis] = std::max(high[axis], p[axis]);
+        }
+    }
+    float halfSize = std::max({(high[0] - low[0]) * 0.5f, (high[1] - low[1]) * 0.5f, 1e-6f});
+    float scale = extent / halfSize;
+    float center[2] = {(low[0] + high[0]) * 0.5f, (low[1] + high[1]) * 0.5f};
+    float depthRange = std::max(high[2] - low[2], 1e-6f);
+    std::vector<MeshVertex> vertices(source.positions.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const auto &p = source.positions[i];
+        vertices[i].position[0] = (p[0] - center[0]) * scale;
+        vertices[i].position[1] = (p[1] - center[1]) * scale;
+        std::array<float, 3> color;
+        if (source.colors.empty())
+        {
+            float shade = 0.3f + 0.7f * (p[2] - low[2]) / depthRange;
+            color = {shade, shade, shade};
+        }
+        else
+        {
+            color = source.colors[i];
+        }
+        std::copy(color.begin(), color.end(), vertices[i].color);
+    }
+
+    // bin triangles by centroid.
+    std::vector<std::vector<uint32_t>> cells(static_cast<size_t>(grid) * grid);
+    for (uint32_t t = 0; t + 2 < source.indices.size(); t += 3)
+    {
+        float cx = 0.0f, cy = 0.0f;
+        for (int corner = 0; corner < 3; corner++)
+        {
+            cx += vertices[source.indices[t + corner]].position[0] / 3.0f;
+            cy += vertices[source.indices[t + corner]].position[1] / 3.0f;
+        }
+        uint32_t gx = std::min(grid - 1, static_cast<uint32_t>(std::max(0.0f, (cx + extent) / (2.0f * extent) * grid)));
+        uint32_t gy = std::min(grid - 1, static_cast<uint32_t>(std::max(0.0f, (cy + extent) / (2.0f * extent) * grid)));
+        cells[gy * grid + gx].push_back(t);
+    }
+
+    std::vector<Chunk> chunks;
+    for (const auto &cell : cells)
+    {
+        if (cell.empty())
+        {
+            continue;
+        }
+        chunks.emplace_back();
+        std::unordered_map<uint32_t, uint16_t> remap;
+        for (uint32_t t : cell)
+        {
+            if (chunks.back().vertices.size() + 3 > MESH_CHUNK_MAX_VERTICES)
+            {
+                chunks.emplace_back();
+                remap.clear();
+            }
+            Chunk &chunk = chunks.back();
+            for (int corner = 0; corner < 3; corner++)
+            {
+                uint32_t global = source.indices[t + corner];
+                auto [it, inserted] = remap.emplace(global, static_cast<uint16_t>(chunk.vertices.size()));
+                if (inserted)
+                {
+                    chunk.vertices.push_back(vertices[global]);
+                }
+                chunk.indices.push_back(it->second);
+            }
+        }
+    }
+
+    MeshFileHeader header{};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.chunkCount = static_cast<uint32_t>(chunks.size());
+    header.vertexStride = sizeof(MeshVertex);
+    header.chunkTableOffset = alignUp(sizeof(MeshFileHeader), alignof(MeshChunkRecord));
+    header.bounds[0] = header.bounds[1] = std::numeric_limits<float>::max();
+    header.bounds[2] = header.bounds[3] = std::numeric_limits<float>::lowest();
+
+    std::vector<MeshChunkRecord> records(chunks.size());
+    uint64_t offset = alignUp(header.chunkTableOffset + sizeof(MeshChunkRecord) * records.size(), MESH_PAYLOAD_ALIGNMENT);
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        const Chunk &chunk = chunks[i];
+        MeshChunkRecord &record = records[i];
+        float chunkLow[2] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        float chunkHigh[2] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+        for (const MeshVertex &v : chunk.vertices)
+        {
+            for (int axis = 0; axis < 2; axis++)
+            {
+                chunkLow[axis] = std::min(chunkLow[axis], v.position[axis]);
+                chunkHigh[axis] = std::max(chunkHigh[axis], v.position[axis]);
+            }
+        }
+        record.center[0] = (chunkLow[0] + chunkHigh[0]) * 0.5f;
+        record.center[1] = (chunkLow[1] + chunkHigh[1]) * 0.5f;
+        for (const MeshVertex &v : chunk.vertices)
+        {
+            record.radius = std::max(record.radius, std::hypot(v.position[0] - record.center[0], v.position[1] - record.center[1]));
+        }
+        for (int axis = 0; axis < 2; axis++)
+        {
+            header.bounds[axis] = std::min(header.bounds[axis], chunkLow[axis]);
+            header.bounds[axis + 2] = std::max(header.bounds[axis + 2], chunkHigh[axis]);
+        }
+        record.vertexCount = static_cast<uint32_t>(chunk.vertices.size());
+        record.indexCount = static_cast<uint32_t>(chunk.indices.size());
+        record.indexOffset = static_cast<uint32_t>(alignUp(sizeof(MeshVertex) * chunk.vertices.size(), 4));
+        record.payloadOffset = offset;
+        record.payloadSize = record.indexOffset + sizeof(uint16_t) * chunk.indices.size();
+        offset = alignUp(offset + record.payloadSize, MESH_PAYLOAD_ALIGNMENT);
+    }
+    // the last payload isn't padded out; nothing reads past it.
+    header.fileSize = records.empty() ? offset : records.back().payloadOffset + records.back().payloadSize;
+
+    std::ofstream out(paths[1], std::ios::binary);
+    auto writeAt = [&](uint64_t position, const void *data, size_t size)
+    {
+        out.seekp(static_cast<std::streamoff>(position));
+        out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    };
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.chunkTableOffset, records.data(), sizeof(MeshChunkRecord) * records.size());
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        writeAt(records[i].payloadOffset, chunks[i].vertices.data(), sizeof(MeshVertex) * chunks[i].vertices.size());
+        writeAt(records[i].payloadOffset + records[i].indexOffset, chunks[i].indices.data(), sizeof(uint16_t) * chunks[i].indices.size());
+    }
+    if (!out.good())
+    {
+        std::cerr << "failed to write " << paths[1] << '\n';
+        return EXIT_FAILURE;
+    }
+    std::cout << paths[1] << ": " << source.indices.size() / 3 << " triangles, " << chunks.size() << " chunk(s), " << header.fileSize / 1024 << " KiB\n";
+    return EXIT_SUCCESS;
+}
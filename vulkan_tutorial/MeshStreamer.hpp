@@ -0,0 +1,269 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "DeletionQueue.hpp"
+#include "DeviceAllocator.hpp"
+#include "MeshAsset.hpp"
+#include "Stats.hpp"
+#include "UploadRing.hpp"
+#include "VulkanHandle.hpp"
+
+/**
+ * @brief keeps the chunks of a MeshAsset the camera can see resident on the GPU, streaming them in through the upload ring as they come into range and dropping ones it hasn't needed in a while once over budget.
+ *
+ * Each chunk gets one device-local buffer holding its payload as-is: vertices at 0, indices at the record's indexOffset. The upload ring reads straight out of the file mapping, so a chunk costs one memcpy from the page cache into staging and one GPU copy, with no parsing anywhere. Chunks are requested when their bounding circle comes within prefetchMargin of the view, nearest first, so they've usually landed by the time they're actually on screen; only ones inside the view proper are drawn.
+ *
+ * Eviction is least recently used. An evicted chunk's buffer and memory go to the app's DeletionQueue like a retired swapchain, so they're only destroyed once every frame that could have drawn it has retired, and eviction never needs a device wait. Visible chunks and chunks still in the ring's queue are never evicted, so the budget is a target rather than a hard cap when the view alone needs more.
+ */
+class MeshStreamer
+{
+public:
+    struct Drawable
+    {
+        VkBuffer buffer;
+        VkDeviceSize indexOffset;
+        uint32_t indexCount;
+    };
+
+    void create(VkDevice device, DeviceAllocator &allocator, UploadRing &uploadRing, DeletionQueue &deletionQueue, const MeshAsset &asset, VkDeviceSize budgetBytes)
+    {
+        this->device = device;
+        this->allocator = &allocator;
+        this->uploadRing = &uploadRing;
+        this->deletionQueue = &deletionQueue;
+        this->asset = &asset;
+        this->budgetBytes = budgetBytes;
+        chunks.clear();
+        chunks.resize(asset.chunkCount());
+    }
+
+    bool enabled() const
+    {
+        return asset != nullptr;
+    }
+
+    /**
+     * @brief once per frame, after the frame slot's fence wait and before the upload ring's submitFrame(), so new requests go out this frame.
+     * @param camera view center; the view is camera ± 1 in both axes, as in the draw list.
+     * @param prefetchMargin how far outside the view to start streaming a chunk in.
+     */
+    void update(uint32_t frameIndex, const float camera[2], float prefetchMargin)
+    {
+        auto now = std::chrono::steady_clock::now();
+        drawables.clear();
+        std::vector<uint32_t> wanted;
+        for (uint32_t i = 0; i < chunks.size(); i++)
+        {
+            Chunk &chunk = chunks[i];
+            if (chunk.state == State::Loading && uploadRing->isReady(chunk.ticket))
+            {
+                chunk.state = State::Resident;
+                loadLatency.add(std::chrono::duration<double, std::milli>(now - chunk.requested).count());
+            }
+            const MeshChunkRecord &record = asset->chunk(i);
+            float dx = std::abs(record.center[0] - camera[0]);
+            float dy = std::abs(record.center[1] - camera[1]);
+            float reach = 1.0f + record.radius;
+            if (dx > reach + prefetchMargin || dy > reach + prefetchMargin)
+            {
+                continue;
+            }
+            bool visible = dx <= reach && dy <= reach;
+            chunk.lastWantedFrame = frameIndex;
+            if (chunk.state == State::Absent)
+            {
+                wanted.push_back(i);
+            }
+            if (visible && chunk.state == State::Resident)
+            {
+                drawables.push_back({chunk.buffer, record.indexOffset, record.indexCount});
+            }
+            else if (visible)
+            {
+                visibleButLoading++;
+            }
+        }
+
+        std::sort(wanted.begin(), wanted.end(), [&](uint32_t a, uint32_t b)
+                  { return distanceSquared(a, camera) < distanceSquared(b, camera); });
+        for (uint32_t index : wanted)
+        {
+            VkDeviceSize size = asset->chunk(index).payloadSize;
+            if (residentBytes + size > budgetBytes && !evictFor(size, frameIndex))
+            {
+                budgetDeferrals++;
+                break;
+            }
+            request(index, frameIndex, now);
+        }
+        peakResidentBytes = std::max(peakResidentBytes, residentBytes);
+    }
+
+    /**
+     * @brief resident chunks inside the view as of the last update().
+     */
+    const std::vector<Drawable> &visibleChunks() const
+    {
+        return drawables;
+    }
+
+    MeshStreamer() = default;
+    MeshStreamer(const MeshStreamer &) = delete;
+    MeshStreamer &operator=(const MeshStreamer &) = delete;
+
+    ~MeshStreamer()
+    {
+        destroy();
+    }
+
+    /**
+     * @brief only once the device is idle.
+     */
+    void destroy()
+    {
+        chunks.clear();
+        residentBytes = 0;
+        asset = nullptr;
+    }
+
+    void printStats(std::ostream &out)
+    {
+        out << "mesh streaming: " << asset->chunkCount() << " chunk(s), " << loads << " load(s), " << evictions << " eviction(s), "
+            << bytesRead / (1024 * 1024) << " MiB read (" << bytesFromDisk / (1024 * 1024) << " MiB not in the page cache when requested), peak resident "
+            << peakResidentBytes / (1024 * 1024) << " MiB of a " << budgetBytes / (1024 * 1024) << " MiB budget\n";
+        out << "mesh streaming: " << visibleButLoading << " chunk-frame(s) visible but still loading, " << budgetDeferrals << " frame(s) with requests held back by the budget\n";
+        if (loadLatency.count() > 0)
+        {
+            loadLatency.print(out, "mesh chunk load latency");
+        }
+    }
+
+private:
+    enum class State
+    {
+        Absent,
+        // queued on the upload ring; its buffer is spoken for but not usable yet.
+        Loading,
+        Resident,
+    };
+
+    struct Chunk
+    {
+        State state = State::Absent;
+        UniqueBuffer buffer;
+        UniqueAllocation memory;
+        uint64_t ticket = 0;
+        // last frame it was in range, visible or in the prefetch margin; eviction order.
+        uint32_t lastWantedFrame = 0;
+        std::chrono::steady_clock::time_point requested;
+    };
+
+    float distanceSquared(uint32_t index, const float camera[2]) const
+    {
+        const MeshChunkRecord &record = asset->chunk(index);
+        float dx = record.center[0] - camera[0];
+        float dy = record.center[1] - camera[1];
+        return dx * dx + dy * dy;
+    }
+
+    void request(uint32_t index, uint32_t frameIndex, std::chrono::steady_clock::time_point now)
+    {
+        const MeshChunkRecord &record = asset->chunk(index);
+        Chunk &chunk = chunks[index];
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = record.payloadSize;
+        bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer buffer;
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create mesh chunk buffer!");
+        }
+        chunk.buffer = UniqueBuffer(device, buffer);
+        chunk.memory = UniqueAllocation(*allocator, allocator->allocateForBuffer(device, buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, false));
+
+        bytesFromDisk += asset->nonResidentBytes(index);
+        asset->prefetch(index);
+        chunk.ticket = uploadRing->uploadBuffer(buffer, 0, asset->payload(index), record.payloadSize, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                                                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+        chunk.state = State::Loading;
+        chunk.lastWantedFrame = frameIndex;
+        chunk.requested = now;
+        residentBytes += record.payloadSize;
+        bytesRead += record.payloadSize;
+        loads++;
+    }
+
+    /**
+     * @brief evicts out of range chunks, least recently wanted first, until size more bytes fit. The budget counts them as gone straight away; the deletion queue holds on to them until the frames that may still draw them have finished.
+     * @return false if it couldn't make enough room.
+     */
+    bool evictFor(VkDeviceSize size, uint32_t frameIndex)
+    {
+        std::vector<uint32_t> candidates;
+        for (uint32_t i = 0; i < chunks.size(); i++)
+        {
+            // not wanted this frame means not drawn this frame, so retiring it as of frameIndex is safe.
+            const Chunk &chunk = chunks[i];
+            if (chunk.state == State::Resident && chunk.lastWantedFrame < frameIndex)
+            {
+                candidates.push_back(i);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b)
+                  { return chunks[a].lastWantedFrame < chunks[b].lastWantedFrame; });
+        for (uint32_t index : candidates)
+        {
+            if (residentBytes + size <= budgetBytes)
+            {
+                break;
+            }
+            release(index, frameIndex);
+            evictions++;
+        }
+        return residentBytes + size <= budgetBytes;
+    }
+
+    void release(uint32_t index, uint32_t frameIndex)
+    {
+        Chunk &chunk = chunks[index];
+        // buffer first: the queue frees a batch's allocations after its handles.
+        deletionQueue->retire(frameIndex, std::move(chunk.buffer));
+        deletionQueue->retire(frameIndex, std::move(chunk.memory));
+        residentBytes -= asset->chunk(index).payloadSize;
+        chunk = Chunk{};
+    }
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceAllocator *allocator = nullptr;
+    UploadRing *uploadRing = nullptr;
+    DeletionQueue *deletionQueue = nullptr;
+    const MeshAsset *asset = nullptr;
+    VkDeviceSize budgetBytes = 0;
+    std::vector<Chunk> chunks;
+    std::vector<Drawable> drawables;
+
+    // resident or loading, i.e. what's allocated on the device.
+    VkDeviceSize residentBytes = 0;
+    VkDeviceSize peakResidentBytes = 0;
+    // payload bytes handed to the upload ring, all of which get read out of the mapping.
+    uint64_t bytesRead = 0;
+    uint64_t bytesFromDisk = 0;
+    uint64_t loads = 0;
+    uint64_t evictions = 0;
+    uint64_t visibleButLoading = 0;
+    uint64_t budgetDeferrals = 0;
+    // request to usable on the graphics queue: page-in, staging copy, GPU copy and ownership transfer.
+    SampleStats loadLatency;
+};
@@ -0,0 +1,318 @@
+#include "MockVulkan.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+MockDriver installed;
+uint64_t calls = 0;
+// the instance and surface are never dereferenced, so any non-null bits will do.
+const uint64_t instanceBits = 0x1000;
+const uint64_t surfaceBits = 0x2000;
+
+// dispatchable handles are pointers; non-dispatchable ones are pointers on 64-bit and uint64_t on 32-bit.
+template <typename Handle>
+Handle fromBits(uint64_t bits)
+{
+    if constexpr (std::is_pointer_v<Handle>)
+    {
+        return reinterpret_cast<Handle>(static_cast<uintptr_t>(bits));
+    }
+    else
+    {
+        return static_cast<Handle>(bits);
+    }
+}
+
+template <typename Handle>
+uint64_t toBits(Handle handle)
+{
+    if constexpr (std::is_pointer_v<Handle>)
+    {
+        return reinterpret_cast<uintptr_t>(handle);
+    }
+    else
+    {
+        return static_cast<uint64_t>(handle);
+    }
+}
+
+// physical devices are their index + 1, so VK_NULL_HANDLE stays invalid.
+VkPhysicalDevice deviceHandle(size_t index)
+{
+    return fromBits<VkPhysicalDevice>(index + 1);
+}
+
+const MockPhysicalDevice &deviceFor(VkPhysicalDevice device)
+{
+    return installed.devices[toBits(device) - 1];
+}
+
+/**
+ * @brief the second half of the two-call idiom: a count query with nullptr, otherwise copy as many as fit and say VK_INCOMPLETE if that wasn't all of them.
+ */
+template <typename Source, typename Out, typename Convert>
+VkResult enumerate(const std::vector<Source> &source, uint32_t *count, Out *out, Convert convert)
+{
+    if (out == nullptr)
+    {
+        *count = static_cast<uint32_t>(source.size());
+        return VK_SUCCESS;
+    }
+    uint32_t written = std::min(*count, static_cast<uint32_t>(source.size()));
+    for (uint32_t i = 0; i < written; i++)
+    {
+        out[i] = convert(source[i]);
+    }
+    *count = written;
+    return written < source.size() ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+template <typename T>
+VkResult enumerate(const std::vector<T> &source, uint32_t *count, T *out)
+{
+    return enumerate(source, count, out, [](const T &value)
+                     { return value; });
+}
+
+VkExtensionProperties extensionProperties(const std::string &name)
+{
+    VkExtensionProperties properties{};
+    std::strncpy(properties.extensionName, name.c_str(), VK_MAX_EXTENSION_NAME_SIZE - 1);
+    properties.specVersion = 1;
+    return properties;
+}
+
+VkLayerProperties layerProperties(const std::string &name)
+{
+    VkLayerProperties properties{};
+    std::strncpy(properties.layerName, name.c_str(), VK_MAX_EXTENSION_NAME_SIZE - 1);
+    properties.specVersion = VK_API_VERSION_1_2;
+    properties.implementationVersion = 1;
+    return properties;
+}
+
+bool contains(const std::vector<std::string> &names, const char *name)
+{
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+} // namespace
+
+void MockVulkan::install(MockDriver driver)
+{
+    installed = std::move(driver);
+}
+
+const MockDriver &MockVulkan::driver()
+{
+    return installed;
+}
+
+VkSurfaceKHR MockVulkan::surface()
+{
+    return fromBits<VkSurfaceKHR>(surfaceBits);
+}
+
+uint64_t MockVulkan::callCount()
+{
+    return calls;
+}
+
+void MockVulkan::resetCallCount()
+{
+    calls = 0;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceVersion(uint32_t *pApiVersion)
+{
+    calls++;
+    *pApiVersion = VK_API_VERSION_1_2;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceLayerProperties(uint32_t *pPropertyCount, VkLayerProperties *pProperties)
+{
+    calls++;
+    return enumerate(installed.layers, pPropertyCount, pProperties, layerProperties);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceExtensionProperties(const char *pLayerName, uint32_t *pPropertyCount, VkExtensionProperties *pProperties)
+{
+    calls++;
+    if (pLayerName != nullptr)
+    {
+        // the mock's layers don't bring extensions of their own.
+        static const std::vector<std::string> none;
+        return contains(installed.layers, pLayerName) ? enumerate(none, pPropertyCount, pProperties, extensionProperties) : VK_ERROR_LAYER_NOT_PRESENT;
+    }
+    return enumerate(installed.instanceExtensions, pPropertyCount, pProperties, extensionProperties);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance(const VkInstanceCreateInfo *pCreateInfo, const VkAllocationCallbacks *, VkInstance *pInstance)
+{
+    calls++;
+    for (uint32_t i = 0; i < pCreateInfo->enabledLayerCount; i++)
+    {
+        if (!contains(installed.layers, pCreateInfo->ppEnabledLayerNames[i]))
+        {
+            return VK_ERROR_LAYER_NOT_PRESENT;
+        }
+    }
+    for (uint32_t i = 0; i < pCreateInfo->enabledExtensionCount; i++)
+    {
+        if (!contains(installed.instanceExtensions, pCreateInfo->ppEnabledExtensionNames[i]))
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+    }
+    *pInstance = fromBits<VkInstance>(instanceBits);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyInstance(VkInstance, const VkAllocationCallbacks *)
+{
+    calls++;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumeratePhysicalDevices(VkInstance, uint32_t *pPhysicalDeviceCount, VkPhysicalDevice *pPhysicalDevices)
+{
+    calls++;
+    if (pPhysicalDevices == nullptr)
+    {
+        *pPhysicalDeviceCount = static_cast<uint32_t>(installed.devices.size());
+        return VK_SUCCESS;
+    }
+    uint32_t written = std::min(*pPhysicalDeviceCount, static_cast<uint32_t>(installed.devices.size()));
+    for (uint32_t i = 0; i < written; i++)
+    {
+        pPhysicalDevices[i] = deviceHandle(i);
+    }
+    *pPhysicalDeviceCount = written;
+    return written < installed.devices.size() ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties *pProperties)
+{
+    calls++;
+    *pProperties = deviceFor(physicalDevice).properties;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures *pFeatures)
+{
+    calls++;
+    *pFeatures = deviceFor(physicalDevice).features;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties *pMemoryProperties)
+{
+    calls++;
+    *pMemoryProperties = deviceFor(physicalDevice).memory;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties *pQueueFamilyProperties)
+{
+    calls++;
+    enumerate(deviceFor(physicalDevice).queueFamilies, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateDeviceExtensionProperties(VkPhysicalDevice physicalDevice, const char *pLayerName, uint32_t *pPropertyCount, VkExtensionProperties *pProperties)
+{
+    calls++;
+    if (pLayerName != nullptr)
+    {
+        static const std::vector<std::string> none;
+        return contains(installed.layers, pLayerName) ? enumerate(none, pPropertyCount, pProperties, extensionProperties) : VK_ERROR_LAYER_NOT_PRESENT;
+    }
+    return enumerate(deviceFor(physicalDevice).extensions, pPropertyCount, pProperties, extensionProperties);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, VkSurfaceKHR surface, VkBool32 *pSupported)
+{
+    calls++;
+    const MockPhysicalDevice &device = deviceFor(physicalDevice);
+    if (toBits(surface) != surfaceBits || queueFamilyIndex >= device.queueFamilies.size())
+    {
+        return VK_ERROR_SURFACE_LOST_KHR;
+    }
+    *pSupported = queueFamilyIndex < device.presentSupport.size() ? device.presentSupport[queueFamilyIndex] : VK_FALSE;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice, VkSurfaceKHR surface, VkSurfaceCapabilitiesKHR *pSurfaceCapabilities)
+{
+    calls++;
+    if (toBits(surface) != surfaceBits)
+    {
+        return VK_ERROR_SURFACE_LOST_KHR;
+    }
+    // an 800x600 window that takes whatever extent it's given.
+    *pSurfaceCapabilities = {};
+    pSurfaceCapabilities->minImageCount = 2;
+    pSurfaceCapabilities->maxImageCount = 8;
+    pSurfaceCapabilities->currentExtent = {800, 600};
+    pSurfaceCapabilities->minImageExtent = {1, 1};
+    pSurfaceCapabilities->maxImageExtent = {16384, 16384};
+    pSurfaceCapabilities->maxImageArrayLayers = 1;
+    pSurfaceCapabilities->supportedTransforms = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    pSurfaceCapabilities->currentTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    pSurfaceCapabilities->supportedCompositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    pSurfaceCapabilities->supportedUsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t *pSurfaceFormatCount, VkSurfaceFormatKHR *pSurfaceFormats)
+{
+    calls++;
+    if (toBits(surface) != surfaceBits)
+    {
+        return VK_ERROR_SURFACE_LOST_KHR;
+    }
+    return enumerate(deviceFor(physicalDevice).surfaceFormats, pSurfaceFormatCount, pSurfaceFormats);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t *pPresentModeCount, VkPresentModeKHR *pPresentModes)
+{
+    calls++;
+    if (toBits(surface) != surfaceBits)
+    {
+        return VK_ERROR_SURFACE_LOST_KHR;
+    }
+    return enumerate(deviceFor(physicalDevice).presentModes, pPresentModeCount, pPresentModes);
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance, const char *pName)
+{
+    calls++;
+    static const std::pair<const char *, PFN_vkVoidFunction> entryPoints[] = {
+        {"vkGetInstanceProcAddr", reinterpret_cast<PFN_vkVoidFunction>(vkGetInstanceProcAddr)},
+        {"vkEnumerateInstanceVersion", reinterpret_cast<PFN_vkVoidFunction>(vkEnumerateInstanceVersion)},
+        {"vkEnumerateInstanceLayerProperties", reinterpret_cast<PFN_vkVoidFunction>(vkEnumerateInstanceLayerProperties)},
+        {"vkEnumerateInstanceExtensionProperties", reinterpret_cast<PFN_vkVoidFunction>(vkEnumerateInstanceExtensionProperties)},
+        {"vkCreateInstance", reinterpret_cast<PFN_vkVoidFunction>(vkCreateInstance)},
+        {"vkDestroyInstance", reinterpret_cast<PFN_vkVoidFunction>(vkDestroyInstance)},
+        {"vkEnumeratePhysicalDevices", reinterpret_cast<PFN_vkVoidFunction>(vkEnumeratePhysicalDevices)},
+        {"vkGetPhysicalDeviceProperties", reinterpret_cast<PFN_vkVoidFunction>(vkGetPhysicalDeviceProperties)},
+        {"vkGetPhysicalDeviceFeatures", reinterpret_cast<PFN_vkVoidFunction>(vkGetPhysicalDeviceFeatures)},
+        {"vkGetPhysicalDeviceMemoryProperties", reinterpret_cast<PFN_vkVoidFunction>(vkGetPhysicalDeviceMemoryProperties)},
+        {"vkGetPhysicalDeviceQueueFamilyProperties", reinterpret_cast<PFN_vkVoidFunction>(vkGetPhysicalDeviceQueueFamilyProperties)},
+        {"vkEnumerateDeviceExtensionProperties", reinterpret_cast<PFN_vkVoidFunction>(vkEnumerateDeviceExtensionProperties)},
+        {"vkGetPhysicalDeviceSurfaceSupportKHR", reinterpret_cast<PFN_vkVoidFunction>(vkGetPhysicalDeviceSurfaceSupportKHR)},
+        {"vkGetPhysicalDeviceSurfaceCapabilitiesKHR", reinterpret_cast<PFN_vkVoidFunction>(vkGetPhysicalDeviceSurfaceCapabilitiesKHR)},
+        {"vkGetPhysicalDeviceSurfaceFormatsKHR", reinterpret_cast<PFN_vkVoidFunction>(vkGetPhysicalDeviceSurfaceFormatsKHR)},
+        {"vkGetPhysicalDeviceSurfacePresentModesKHR", reinterpret_cast<PFN_vkVoidFunction>(vkGetPhysicalDeviceSurfacePresentModesKHR)},
+    };
+    for (const auto &entryPoint : entryPoints)
+    {
+        if (std::strcmp(entryPoint.first, pName) == 0)
+        {
+            return entryPoint.second;
+        }
+    }
+    return nullptr;
+}
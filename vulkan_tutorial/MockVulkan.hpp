@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief one scripted physical device: everything the selection path asks about, surface answers included.
+ */
+struct MockPhysicalDevice
+{
+    VkPhysicalDeviceProperties properties{};
+    VkPhysicalDeviceFeatures features{};
+    VkPhysicalDeviceMemoryProperties memory{};
+    std::vector<VkQueueFamilyProperties> queueFamilies;
+    // one per queue family: what vkGetPhysicalDeviceSurfaceSupportKHR answers.
+    std::vector<VkBool32> presentSupport;
+    std::vector<std::string> extensions;
+    // empty lists make the swapchain inadequate, like a surface the device can't drive.
+    std::vector<VkSurfaceFormatKHR> surfaceFormats;
+    std::vector<VkPresentModeKHR> presentModes;
+};
+
+/**
+ * @brief what the fake loader reports: instance layers and extensions, and the devices every instance enumerates.
+ */
+struct MockDriver
+{
+    std::vector<std::string> layers;
+    std::vector<std::string> instanceExtensions;
+    std::vector<MockPhysicalDevice> devices;
+};
+
+/**
+ * @brief an in-process stand-in for the Vulkan loader and one ICD, covering the entry points instance creation and device selection use. Link MockVulkan.cpp instead of -lvulkan and every call lands here, answered from whatever MockDriver was installed last, so the init path can be benchmarked and checked on a box with no GPU, no driver and no loader.
+ *
+ * The answers follow the spec where the selection path could notice: the two-call enumerate idiom including VK_INCOMPLETE, vkCreateInstance failing on unknown layers/extensions, and vkGetInstanceProcAddr resolving only what's implemented. Everything else (allocators, pNext chains, API versions) is ignored. Not thread-safe: install() while nothing else is calling in.
+ */
+class MockVulkan
+{
+public:
+    /**
+     * @brief replaces the scripted driver; physical device handles from before are only valid for the same device count.
+     */
+    static void install(MockDriver driver);
+
+    /**
+     * @return the installed driver, for building expectations against.
+     */
+    static const MockDriver &driver();
+
+    /**
+     * @return the one surface the mock knows; pass it where the app would pass its window surface.
+     */
+    static VkSurfaceKHR surface();
+
+    /**
+     * @return Vulkan calls made since the last resetCallCount(), i.e. what a real loader would have had to dispatch.
+     */
+    static uint64_t callCount();
+    static void resetCallCount();
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief VkPipelineCache that survives between runs.
+ *
+ * The blob the driver hands back from vkGetPipelineCacheData() is only meaningful to the exact driver + device that produced it, so on load we check the header (vendor, device and pipelineCacheUUID) against the device we picked and quietly start from an empty cache on any mismatch; feeding a stale blob to a driver is allowed by the spec but a good way to find driver bugs. Saves go to a temp file that's renamed over the real one, so a crash mid-write can't leave a truncated cache behind.
+ */
+class PipelineCache
+{
+public:
+    /**
+     * Per-pipeline outcome tallies. Hits and misses come from VK_EXT_pipeline_creation_feedback, which is the only way to learn whether the driver actually found a pipeline in our cache; without it everything lands in unknown.
+     */
+    struct Stats
+    {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t unknown = 0;
+        double totalCreationMs = 0.0;
+    };
+
+    void create(VkDevice device, const VkPhysicalDeviceProperties &deviceProperties, const std::string &path)
+    {
+        this->device = device;
+        this->path = path;
+
+        std::vector<char> blob = readBlob(path);
+        std::string rejection;
+        if (!blob.empty() && !validateHeader(blob, deviceProperties, rejection))
+        {
+            std::cout << "discarding pipeline cache " + path + ": " + rejection + '\n';
+            blob.clear();
+        }
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = blob.size();
+        createInfo.pInitialData = blob.empty() ? nullptr : blob.data();
+        if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+
+        loadedFromDisk = !blob.empty();
+        loadedBytes = blob.size();
+        // built up front and written in one go; startup creates the cache while other tasks may be printing.
+        std::cout << "pipeline cache: " + (loadedFromDisk ? "warm, " + std::to_string(loadedBytes) + " bytes from " + path : "cold") + '\n';
+    }
+
+    /**
+     * @brief writes the current cache contents to path atomically (write temp file, then rename over the original).
+     */
+    void save()
+    {
+        if (cache == VK_NULL_HANDLE || path.empty())
+        {
+            return;
+        }
+
+        size_t size = 0;
+        vkGetPipelineCacheData(device, cache, &size, nullptr);
+        std::vector<char> blob(size);
+        if (size == 0 || vkGetPipelineCacheData(device, cache, &size, blob.data()) != VK_SUCCESS)
+        {
+            return;
+        }
+        blob.resize(size);
+
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+            if (!file)
+            {
+                std::cerr << "failed to write pipeline cache to " << tempPath << '\n';
+                return;
+            }
+        }
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            std::cerr << "failed to move pipeline cache into place at " << path << '\n';
+            std::remove(tempPath.c_str());
+            return;
+        }
+        std::cout << "saved " << blob.size() << " byte pipeline cache to " << path << '\n';
+    }
+
+    PipelineCache() = default;
+    PipelineCache(const PipelineCache &) = delete;
+    PipelineCache &operator=(const PipelineCache &) = delete;
+
+    ~PipelineCache()
+    {
+        destroy();
+    }
+
+    void destroy()
+    {
+        if (cache != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineCache(device, cache, nullptr);
+            cache = VK_NULL_HANDLE;
+        }
+    }
+
+    /**
+     * @brief tallies one pipeline creation.
+     * @param feedback whole-pipeline feedback filled in by the driver, or nullptr if creation feedback isn't enabled.
+     */
+    void recordCreation(const VkPipelineCreationFeedbackEXT *feedback, double creationMs)
+    {
+        stats.totalCreationMs += creationMs;
+        if (feedback == nullptr || !(feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT))
+        {
+            stats.unknown++;
+        }
+        else if (feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT)
+        {
+            stats.hits++;
+        }
+        else
+        {
+            stats.misses++;
+        }
+    }
+
+    void printStats(std::ostream &out) const
+    {
+        out << "pipeline cache (" << (loadedFromDisk ? "warm" : "cold") << "): " << stats.hits << " hit(s), " << stats.misses << " miss(es), "
+            << stats.unknown << " unknown, " << stats.totalCreationMs << " ms total pipeline creation\n";
+    }
+
+    VkPipelineCache handle() const
+    {
+        return cache;
+    }
+
+    bool isWarm() const
+    {
+        return loadedFromDisk;
+    }
+
+private:
+    static std::vector<char> readBlob(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return {};
+        }
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    /**
+     * @brief checks a cache blob's VkPipelineCacheHeaderVersionOne against the device we're about to hand it to.
+     * @param reason set to a human readable explanation when validation fails.
+     */
+    static bool validateHeader(const std::vector<char> &blob, const VkPhysicalDeviceProperties &deviceProperties, std::string &reason)
+    {
+        // the header is defined as tightly packed 32-bit fields followed by the UUID bytes, so pick it apart field by field rather than trusting struct layout.
+        constexpr size_t headerBytes = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+        if (blob.size() < headerBytes)
+        {
+            reason = "file too small for a cache header";
+            return false;
+        }
+
+        uint32_t headerSize, headerVersion, vendorID, deviceID;
+        std::memcpy(&headerSize, blob.data() + 0, sizeof(uint32_t));
+        std::memcpy(&headerVersion, blob.data() + 4, sizeof(uint32_t));
+        std::memcpy(&vendorID, blob.data() + 8, sizeof(uint32_t));
+        std::memcpy(&deviceID, blob.data() + 12, sizeof(uint32_t));
+        const char *uuid = blob.data() + 16;
+
+        if (headerSize < headerBytes || headerSize > blob.size())
+        {
+            reason = "bad header size";
+            return false;
+        }
+        if (headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+        {
+            reason = "unknown header version " + std::to_string(headerVersion);
+            return false;
+        }
+        if (vendorID != deviceProperties.vendorID || deviceID != deviceProperties.deviceID)
+        {
+            reason = "written for a different device";
+            return false;
+        }
+        if (std::memcmp(uuid, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        {
+            reason = "pipelineCacheUUID mismatch (driver changed?)";
+            return false;
+        }
+        return true;
+    }
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    std::string path;
+    bool loadedFromDisk = false;
+    size_t loadedBytes = 0;
+    Stats stats;
+};
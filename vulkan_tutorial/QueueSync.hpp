@@ -0,0 +1,225 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+/**
+ * @brief describes handing a resource from one queue to another: which family gives it up, which family picks it up, and what the two sides do with it.
+ *
+ * With VK_SHARING_MODE_EXCLUSIVE resources (which is what we want, concurrent sharing can cost real bandwidth on some GPUs) a resource written on e.g. the transfer queue has to be explicitly released there and acquired on the graphics queue. Both halves need the same family indices and, for images, the same layouts; the semaphore between the two submissions provides the execution dependency.
+ */
+struct QueueHandoff
+{
+    uint32_t srcFamily;
+    uint32_t dstFamily;
+    // what the releasing queue did to the resource.
+    VkPipelineStageFlags srcStage;
+    VkAccessFlags srcAccess;
+    // what the acquiring queue is about to do with it.
+    VkPipelineStageFlags dstStage;
+    VkAccessFlags dstAccess;
+
+    /**
+     * @return false when both queues come from the same family, in which case no ownership changes hands and the semaphore alone orders things.
+     */
+    bool crossesFamilies() const
+    {
+        return srcFamily != dstFamily;
+    }
+};
+
+/**
+ * @brief release half of a buffer ownership transfer; record on the source queue after the last write. No-op within one family.
+ */
+inline void recordBufferRelease(VkCommandBuffer cmd, const QueueHandoff &handoff, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE)
+{
+    if (!handoff.crossesFamilies())
+    {
+        return;
+    }
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = handoff.srcAccess;
+    // dst access is ignored on a release; visibility happens on the acquiring queue.
+    barrier.dstAccessMask = 0;
+    barrier.srcQueueFamilyIndex = handoff.srcFamily;
+    barrier.dstQueueFamilyIndex = handoff.dstFamily;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    vkCmdPipelineBarrier(cmd, handoff.srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+/**
+ * @brief acquire half of a buffer ownership transfer; record on the destination queue before the first use, in a submission that waits on the source queue's semaphore.
+ */
+inline void recordBufferAcquire(VkCommandBuffer cmd, const QueueHandoff &handoff, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE)
+{
+    if (!handoff.crossesFamilies())
+    {
+        return;
+    }
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = handoff.dstAccess;
+    barrier.srcQueueFamilyIndex = handoff.srcFamily;
+    barrier.dstQueueFamilyIndex = handoff.dstFamily;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, handoff.dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+/**
+ * @brief release half of an image ownership transfer. oldLayout/newLayout must match the acquire exactly; the transition itself happens once, between the two halves.
+ */
+inline void recordImageRelease(VkCommandBuffer cmd, const QueueHandoff &handoff, VkImage image, VkImageSubresourceRange range, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    if (!handoff.crossesFamilies())
+    {
+        return;
+    }
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = handoff.srcAccess;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = handoff.srcFamily;
+    barrier.dstQueueFamilyIndex = handoff.dstFamily;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+    vkCmdPipelineBarrier(cmd, handoff.srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+/**
+ * @brief acquire half of an image ownership transfer. Within one family there's no ownership to move but the layout still has to change, so this degrades to a plain layout transition that relies on the semaphore wait for ordering (make sure that wait's stage mask covers handoff.dstStage).
+ */
+inline void recordImageAcquire(VkCommandBuffer cmd, const QueueHandoff &handoff, VkImage image, VkImageSubresourceRange range, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    if (!handoff.crossesFamilies() && oldLayout == newLayout)
+    {
+        return;
+    }
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = handoff.dstAccess;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = handoff.crossesFamilies() ? handoff.srcFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = handoff.crossesFamilies() ? handoff.dstFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+    vkCmdPipelineBarrier(cmd, handoff.crossesFamilies() ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : handoff.dstStage, handoff.dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+/**
+ * @brief timeline semaphore wrapper (core in 1.2, VK_KHR_timeline_semaphore before that): one monotonically increasing 64-bit counter that any queue can wait on or signal at a given value, and that the host can poll or block on.
+ *
+ * One of these per queue replaces the usual pile of binary semaphores + fences for cross-queue work: the transfer queue signals "upload N done" by bumping its counter to N, the graphics queue waits for >= N, and the host can ask how far along either queue is without a fence per submission. The app asks for a 1.2 instance and device but still runs on older ones, so the entry points are loaded through vkGetDeviceProcAddr: the core names on a 1.2 device, the KHR ones otherwise.
+ */
+class TimelineSemaphore
+{
+public:
+    /**
+     * @param core the device was created with 1.2 and its timelineSemaphore feature; otherwise VK_KHR_timeline_semaphore must be enabled.
+     */
+    void create(VkDevice device, bool core, uint64_t initialValue = 0)
+    {
+        this->device = device;
+        waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphores>(vkGetDeviceProcAddr(device, core ? "vkWaitSemaphores" : "vkWaitSemaphoresKHR"));
+        signalSemaphore = reinterpret_cast<PFN_vkSignalSemaphore>(vkGetDeviceProcAddr(device, core ? "vkSignalSemaphore" : "vkSignalSemaphoreKHR"));
+        getCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValue>(vkGetDeviceProcAddr(device, core ? "vkGetSemaphoreCounterValue" : "vkGetSemaphoreCounterValueKHR"));
+        if (waitSemaphores == nullptr || signalSemaphore == nullptr || getCounterValue == nullptr)
+        {
+            throw std::runtime_error(core ? "timeline semaphore entry points not available on a 1.2 device!"
+                                          : "timeline semaphore entry points not available; is VK_KHR_timeline_semaphore enabled?");
+        }
+
+        VkSemaphoreTypeCreateInfoKHR typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = initialValue;
+        VkSemaphoreCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        createInfo.pNext = &typeInfo;
+        if (vkCreateSemaphore(device, &createInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timeline semaphore!");
+        }
+        lastIssued = initialValue;
+    }
+
+    void destroy()
+    {
+        if (semaphore != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(device, semaphore, nullptr);
+            semaphore = VK_NULL_HANDLE;
+        }
+    }
+
+    VkSemaphore handle() const
+    {
+        return semaphore;
+    }
+
+    /**
+     * @brief reserves the next value for a submission to signal.
+     */
+    uint64_t next()
+    {
+        return ++lastIssued;
+    }
+
+    uint64_t lastIssuedValue() const
+    {
+        return lastIssued;
+    }
+
+    /**
+     * @return how far the GPU (or host) has actually signaled.
+     */
+    uint64_t completedValue() const
+    {
+        uint64_t value = 0;
+        getCounterValue(device, semaphore, &value);
+        return value;
+    }
+
+    /**
+     * @return false on timeout.
+     */
+    bool wait(uint64_t value, uint64_t timeoutNs = UINT64_MAX) const
+    {
+        VkSemaphoreWaitInfoKHR waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+        return waitSemaphores(device, &waitInfo, timeoutNs) == VK_SUCCESS;
+    }
+
+    void signalFromHost(uint64_t value)
+    {
+        VkSemaphoreSignalInfoKHR signalInfo{};
+        signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR;
+        signalInfo.semaphore = semaphore;
+        signalInfo.value = value;
+        signalSemaphore(device, &signalInfo);
+        lastIssued = std::max(lastIssued, value);
+    }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    uint64_t lastIssued = 0;
+    PFN_vkWaitSemaphores waitSemaphores = nullptr;
+    PFN_vkSignalSemaphore signalSemaphore = nullptr;
+    PFN_vkGetSemaphoreCounterValue getCounterValue = nullptr;
+};
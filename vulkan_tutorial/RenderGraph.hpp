@@ -0,0 +1,840 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DeviceAllocator.hpp"
+#include "GpuProfiler.hpp"
+
+/**
+ * @brief how a pass touches an image; each maps onto a fixed stage/access/layout triple in RenderGraph::stateFor().
+ */
+enum class GraphUsage
+{
+    ColorAttachment,
+    DepthAttachment,
+    TransferSrc,
+    TransferDst,
+    SampledFragment,
+    SampledCompute,
+    StorageCompute,
+};
+
+/**
+ * @brief a small render graph over images: passes declare what they read and write up front, and the graph works out everything that's usually hand-written around them.
+ *
+ * compile() walks the passes in declaration order (which is also execution order; there's no reordering or culling) and
+ *  - derives each transient image's lifetime, i.e. the first and last pass touching it,
+ *  - places transients whose lifetimes don't overlap at the same offset of one shared allocation (greedy, biggest first), so peak memory is the widest cut through the frame rather than the sum of every attachment,
+ *  - puts attachment-only transients nobody reads back (depth buffers, typically) into LAZILY_ALLOCATED memory where the device has it, which tile-based GPUs may never back with real pages,
+ *  - precomputes every image barrier and merges all of a pass's barriers into a single vkCmdPipelineBarrier with OR'd stage masks,
+ *  - creates a VkRenderPass for each pass with attachments, picking load/store ops from what came before and what comes after.
+ *
+ * Imported images (e.g. the swapchain or readback image) belong to the caller; they can be swapped each frame with setImportedImage(). Their contents are discarded on first use and they end the frame in the layout/stage/access they were imported with.
+ *
+ * Aliased transients are handed over through barriers from UNDEFINED whose source scope covers every earlier use of the memory, including the previous frame's, so the whole graph can be shared by all frames in flight on one queue.
+ */
+class RenderGraph
+{
+public:
+    using ResourceId = uint32_t;
+
+    struct ImageDesc
+    {
+        VkFormat format;
+        VkExtent2D extent;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    };
+
+    /**
+     * @brief how an imported image is used outside the graph: where its previous frame's use left it, and what it's handed back for.
+     */
+    struct ExternalUse
+    {
+        VkImageLayout layout;
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+    };
+
+    struct Access
+    {
+        ResourceId resource;
+        GraphUsage usage;
+        // attachments only: clear on load (see setClearValue()) instead of loading or discarding.
+        bool clear = false;
+    };
+
+    struct PassContext
+    {
+        VkExtent2D extent;
+        uint32_t slotIndex;
+    };
+
+    using RecordFunction = std::function<void(VkCommandBuffer, const PassContext &)>;
+
+    struct Settings
+    {
+        // false gives every transient its own range of memory, for comparing against.
+        bool aliasing = true;
+        // false keeps attachment-only transients in ordinary device-local memory.
+        bool lazyAllocation = true;
+    };
+
+    ResourceId createImage(const std::string &name, const ImageDesc &desc)
+    {
+        Resource resource;
+        resource.name = name;
+        resource.desc = desc;
+        resources.push_back(resource);
+        return static_cast<ResourceId>(resources.size() - 1);
+    }
+
+    ResourceId importImage(const std::string &name, const ImageDesc &desc, const ExternalUse &use)
+    {
+        Resource resource;
+        resource.name = name;
+        resource.desc = desc;
+        resource.imported = true;
+        resource.external = use;
+        resources.push_back(resource);
+        return static_cast<ResourceId>(resources.size() - 1);
+    }
+
+    void setImportedImage(ResourceId id, VkImage image, VkImageView view)
+    {
+        resources[id].image = image;
+        resources[id].view = view;
+    }
+
+    void setClearValue(ResourceId id, VkClearValue value)
+    {
+        resources[id].clearValue = value;
+    }
+
+    void addPass(const std::string &name, std::vector<Access> accesses, RecordFunction record)
+    {
+        Pass pass;
+        pass.name = name;
+        pass.accesses = std::move(accesses);
+        pass.record = std::move(record);
+        passes.push_back(std::move(pass));
+    }
+
+    VkImage image(ResourceId id) const
+    {
+        return resources[id].image;
+    }
+
+    VkExtent2D extent(ResourceId id) const
+    {
+        return resources[id].desc.extent;
+    }
+
+    /**
+     * @return the render pass compile() made for the named pass, for building pipelines against it.
+     */
+    VkRenderPass renderPass(const std::string &passName) const
+    {
+        for (const auto &pass : passes)
+        {
+            if (pass.name == passName && pass.renderPass != VK_NULL_HANDLE)
+            {
+                return pass.renderPass;
+            }
+        }
+        throw std::runtime_error("render graph has no attachment pass named " + passName);
+    }
+
+    bool compiled() const
+    {
+        return device != VK_NULL_HANDLE;
+    }
+
+    void compile(VkDevice device, DeviceAllocator &allocator, const Settings &settings)
+    {
+        this->device = device;
+        this->allocator = &allocator;
+        this->settings = settings;
+        computeLifetimes();
+        createTransientImages();
+        placeAndBindMemory();
+        createViews();
+        createRenderPasses();
+        planBarriers();
+    }
+
+    /**
+     * @brief records every pass with its batched barriers in front of it, then hands imported images back in their external layout.
+     */
+    void execute(VkCommandBuffer cmd, uint32_t slotIndex, GpuProfiler *profiler)
+    {
+        for (uint32_t p = 0; p < passes.size(); p++)
+        {
+            Pass &pass = passes[p];
+            recordBarriers(cmd, pass.barriers);
+            uint32_t scope = profiler != nullptr ? profiler->beginScope(cmd, pass.name.c_str()) : UINT32_MAX;
+            PassContext context{pass.extent, slotIndex};
+            if (pass.renderPass != VK_NULL_HANDLE)
+            {
+                std::vector<VkClearValue> clearValues;
+                for (ResourceId id : pass.attachments)
+                {
+                    clearValues.push_back(resources[id].clearValue);
+                }
+                VkRenderPassBeginInfo beginInfo{};
+                beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                beginInfo.renderPass = pass.renderPass;
+                beginInfo.framebuffer = framebufferFor(pass);
+                beginInfo.renderArea.extent = pass.extent;
+                beginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+                beginInfo.pClearValues = clearValues.data();
+                vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+                pass.record(cmd, context);
+                vkCmdEndRenderPass(cmd);
+            }
+            else
+            {
+                pass.record(cmd, context);
+            }
+            if (profiler != nullptr)
+            {
+                profiler->endScope(cmd, scope);
+            }
+        }
+        recordBarriers(cmd, finalBarriers);
+    }
+
+    /**
+     * @brief lifetimes, placement and what aliasing saved, plus how many barriers a frame records and in how many calls.
+     */
+    void printSummary(std::ostream &out) const
+    {
+        out << std::fixed << std::setprecision(2) << "render graph: " << passes.size() << " passes, " << barrierCount << " image barriers in " << barrierCallCount << " vkCmdPipelineBarrier calls per frame\n";
+        for (const auto &resource : resources)
+        {
+            out << "\t" << resource.name << ": passes " << resource.firstPass << "-" << resource.lastPass;
+            if (resource.imported)
+            {
+                out << ", imported\n";
+                continue;
+            }
+            out << ", " << mib(resource.size) << " MiB at " << (resource.lazy ? "lazy" : "device") << " offset " << resource.offset << '\n';
+        }
+        VkDeviceSize unaliased = 0;
+        for (const auto &resource : resources)
+        {
+            unaliased += resource.imported ? 0 : resource.size;
+        }
+        out << "\tpeak transient memory " << mib(heaps[0].size + heaps[1].size) << " MiB " << (settings.aliasing ? "aliased" : "(aliasing off)") << " vs " << mib(unaliased)
+            << " MiB one-image-per-allocation; " << mib(heaps[1].size) << " MiB of it lazily allocated\n";
+        out.unsetf(std::ios::floatfield);
+    }
+
+    RenderGraph() = default;
+    RenderGraph(const RenderGraph &) = delete;
+    RenderGraph &operator=(const RenderGraph &) = delete;
+
+    ~RenderGraph()
+    {
+        destroy();
+    }
+
+    void destroy()
+    {
+        if (device == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        for (auto &pass : passes)
+        {
+            for (auto &[views, framebuffer] : pass.framebuffers)
+            {
+                vkDestroyFramebuffer(device, framebuffer, nullptr);
+            }
+            pass.framebuffers.clear();
+            vkDestroyRenderPass(device, pass.renderPass, nullptr);
+            pass.renderPass = VK_NULL_HANDLE;
+        }
+        for (auto &resource : resources)
+        {
+            if (!resource.imported)
+            {
+                vkDestroyImageView(device, resource.view, nullptr);
+                vkDestroyImage(device, resource.image, nullptr);
+            }
+        }
+        for (auto &heap : heaps)
+        {
+            allocator->free(heap.allocation);
+        }
+        device = VK_NULL_HANDLE;
+    }
+
+private:
+    struct UsageState
+    {
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+        VkImageLayout layout;
+        bool write;
+    };
+
+    struct Resource
+    {
+        std::string name;
+        ImageDesc desc;
+        bool imported = false;
+        ExternalUse external{};
+        VkClearValue clearValue{};
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        uint32_t firstPass = UINT32_MAX;
+        uint32_t lastPass = 0;
+        VkImageUsageFlags usage = 0;
+        // every stage and write access the resource sees over a frame; what a later user of the same memory has to wait for.
+        VkPipelineStageFlags stages = 0;
+        VkAccessFlags writes = 0;
+        bool lazy = false;
+        VkMemoryRequirements requirements{};
+        VkDeviceSize size = 0;
+        VkDeviceSize offset = 0;
+    };
+
+    /**
+     * @brief an image barrier minus the image, which for imported resources is only known at execute().
+     */
+    struct PlannedBarrier
+    {
+        ResourceId resource;
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+        VkAccessFlags srcAccess;
+        VkAccessFlags dstAccess;
+    };
+
+    struct BarrierBatch
+    {
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        std::vector<PlannedBarrier> barriers;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        std::vector<Access> accesses;
+        RecordFunction record;
+        std::vector<ResourceId> attachments;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkExtent2D extent{};
+        // keyed by attachment views, so imported attachments that change every frame get a framebuffer each and transient ones just the one.
+        std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;
+        BarrierBatch barriers;
+    };
+
+    struct Heap
+    {
+        VkDeviceSize size = 0;
+        DeviceAllocation allocation;
+    };
+
+    static constexpr VkAccessFlags writeAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    static UsageState stateFor(GraphUsage usage)
+    {
+        switch (usage)
+        {
+        case GraphUsage::ColorAttachment:
+            return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true};
+        case GraphUsage::DepthAttachment:
+            return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true};
+        case GraphUsage::TransferSrc:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false};
+        case GraphUsage::TransferDst:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true};
+        case GraphUsage::SampledFragment:
+            return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+        case GraphUsage::SampledCompute:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+        case GraphUsage::StorageCompute:
+        default:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true};
+        }
+    }
+
+    static VkImageUsageFlags imageUsageFor(GraphUsage usage)
+    {
+        switch (usage)
+        {
+        case GraphUsage::ColorAttachment:
+            return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        case GraphUsage::DepthAttachment:
+            return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        case GraphUsage::TransferSrc:
+            return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        case GraphUsage::TransferDst:
+            return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        case GraphUsage::SampledFragment:
+        case GraphUsage::SampledCompute:
+            return VK_IMAGE_USAGE_SAMPLED_BIT;
+        case GraphUsage::StorageCompute:
+        default:
+            return VK_IMAGE_USAGE_STORAGE_BIT;
+        }
+    }
+
+    static bool isAttachment(GraphUsage usage)
+    {
+        return usage == GraphUsage::ColorAttachment || usage == GraphUsage::DepthAttachment;
+    }
+
+    static double mib(VkDeviceSize bytes)
+    {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+
+    void computeLifetimes()
+    {
+        for (uint32_t p = 0; p < passes.size(); p++)
+        {
+            for (const auto &access : passes[p].accesses)
+            {
+                Resource &resource = resources[access.resource];
+                UsageState state = stateFor(access.usage);
+                resource.firstPass = std::min(resource.firstPass, p);
+                resource.lastPass = std::max(resource.lastPass, p);
+                resource.usage |= imageUsageFor(access.usage);
+                resource.stages |= state.stage;
+                resource.writes |= state.access & writeAccessMask;
+            }
+        }
+        for (const auto &resource : resources)
+        {
+            if (resource.firstPass == UINT32_MAX)
+            {
+                throw std::runtime_error("render graph resource " + resource.name + " is never used!");
+            }
+        }
+    }
+
+    void createTransientImages()
+    {
+        for (auto &resource : resources)
+        {
+            if (resource.imported)
+            {
+                continue;
+            }
+            // only ever an attachment and never read back by a later pass: its contents live and die inside one render pass, which is exactly what lazily allocated memory is for.
+            bool attachmentOnly = (resource.usage & ~(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) == 0;
+            bool transientAttachment = settings.lazyAllocation && attachmentOnly && resource.firstPass == resource.lastPass;
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = resource.desc.format;
+            imageInfo.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = resource.usage | (transientAttachment ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            if (vkCreateImage(device, &imageInfo, nullptr, &resource.image) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create render graph image " + resource.name + "!");
+            }
+            vkGetImageMemoryRequirements(device, resource.image, &resource.requirements);
+            resource.lazy = transientAttachment && allocator->findMemoryType(resource.requirements.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, 0) >= 0;
+            resource.size = resource.requirements.size;
+        }
+    }
+
+    bool lifetimesOverlap(const Resource &a, const Resource &b) const
+    {
+        if (!settings.aliasing)
+        {
+            return true;
+        }
+        return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+    }
+
+    static bool rangesOverlap(const Resource &a, const Resource &b)
+    {
+        return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+    }
+
+    /**
+     * @brief greedy interval packing per heap: biggest first, each at the lowest aligned offset that doesn't collide with anything already placed whose lifetime overlaps its own.
+     */
+    void placeAndBindMemory()
+    {
+        for (uint32_t heapIndex = 0; heapIndex < 2; heapIndex++)
+        {
+            bool lazyHeap = heapIndex == 1;
+            std::vector<Resource *> members;
+            for (auto &resource : resources)
+            {
+                if (!resource.imported && resource.lazy == lazyHeap)
+                {
+                    members.push_back(&resource);
+                }
+            }
+            if (members.empty())
+            {
+                continue;
+            }
+            std::stable_sort(members.begin(), members.end(), [](const Resource *a, const Resource *b)
+                             { return a->size > b->size; });
+
+            std::vector<Resource *> placed;
+            VkMemoryRequirements heapRequirements{0, 1, ~0u};
+            for (Resource *resource : members)
+            {
+                VkDeviceSize alignment = resource->requirements.alignment;
+                VkDeviceSize offset = 0;
+                // every collision pushes the candidate past the colliding range; a pass with no collision means it fits.
+                for (bool moved = true; moved;)
+                {
+                    moved = false;
+                    resource->offset = offset;
+                    for (const Resource *other : placed)
+                    {
+                        if (lifetimesOverlap(*resource, *other) && rangesOverlap(*resource, *other))
+                        {
+                            offset = (other->offset + other->size + alignment - 1) / alignment * alignment;
+                            moved = true;
+                            break;
+                        }
+                    }
+                }
+                placed.push_back(resource);
+                heapRequirements.size = std::max(heapRequirements.size, resource->offset + resource->size);
+                heapRequirements.alignment = std::max(heapRequirements.alignment, alignment);
+                heapRequirements.memoryTypeBits &= resource->requirements.memoryTypeBits;
+            }
+            if (heapRequirements.memoryTypeBits == 0)
+            {
+                throw std::runtime_error("render graph transients have no memory type in common!");
+            }
+
+            Heap &heap = heaps[heapIndex];
+            heap.size = heapRequirements.size;
+            VkMemoryPropertyFlags required = lazyHeap ? VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            heap.allocation = allocator->allocate(heapRequirements, required, 0, ResourceKind::Optimal, false);
+            for (Resource *resource : members)
+            {
+                vkBindImageMemory(device, resource->image, heap.allocation.memory, heap.allocation.offset + resource->offset);
+            }
+        }
+    }
+
+    void createViews()
+    {
+        for (auto &resource : resources)
+        {
+            if (resource.imported)
+            {
+                continue;
+            }
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = resource.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = resource.desc.format;
+            viewInfo.subresourceRange.aspectMask = resource.desc.aspect;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.layerCount = 1;
+            if (vkCreateImageView(device, &viewInfo, nullptr, &resource.view) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create render graph image view " + resource.name + "!");
+            }
+        }
+    }
+
+    /**
+     * @brief one single-subpass VkRenderPass per pass with attachments. Layouts don't change inside the pass (the barriers in front of it already did that), so there are no subpass dependencies either; load/store ops are what saves bandwidth here: anything not cleared or read back is DONT_CARE.
+     */
+    void createRenderPasses()
+    {
+        for (uint32_t p = 0; p < passes.size(); p++)
+        {
+            Pass &pass = passes[p];
+            std::vector<VkAttachmentDescription> descriptions;
+            std::vector<VkAttachmentReference> colorRefs;
+            VkAttachmentReference depthRef{};
+            bool hasDepth = false;
+            for (const auto &access : pass.accesses)
+            {
+                if (!isAttachment(access.usage))
+                {
+                    continue;
+                }
+                const Resource &resource = resources[access.resource];
+                UsageState state = stateFor(access.usage);
+                bool writtenBefore = false;
+                bool readLater = resource.imported;
+                for (uint32_t q = 0; q < passes.size(); q++)
+                {
+                    for (const auto &other : passes[q].accesses)
+                    {
+                        if (other.resource == access.resource)
+                        {
+                            writtenBefore |= q < p && stateFor(other.usage).write;
+                            readLater |= q > p;
+                        }
+                    }
+                }
+
+                VkAttachmentDescription description{};
+                description.format = resource.desc.format;
+                description.samples = VK_SAMPLE_COUNT_1_BIT;
+                description.loadOp = access.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : (writtenBefore ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+                description.storeOp = readLater ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                description.initialLayout = state.layout;
+                description.finalLayout = state.layout;
+                VkAttachmentReference reference{static_cast<uint32_t>(descriptions.size()), state.layout};
+                if (access.usage == GraphUsage::DepthAttachment)
+                {
+                    depthRef = reference;
+                    hasDepth = true;
+                }
+                else
+                {
+                    colorRefs.push_back(reference);
+                }
+                descriptions.push_back(description);
+                pass.attachments.push_back(access.resource);
+                pass.extent = resource.desc.extent;
+            }
+            if (descriptions.empty())
+            {
+                continue;
+            }
+
+            VkSubpassDescription subpass{};
+            subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+            subpass.pColorAttachments = colorRefs.data();
+            subpass.pDepthStencilAttachment = hasDepth ? &depthRef : nullptr;
+
+            VkRenderPassCreateInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+            renderPassInfo.pAttachments = descriptions.data();
+            renderPassInfo.subpassCount = 1;
+            renderPassInfo.pSubpasses = &subpass;
+            if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &pass.renderPass) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create render pass for graph pass " + pass.name + "!");
+            }
+        }
+    }
+
+    /**
+     * @brief simulates a frame's worth of accesses and records the barriers each pass needs. Per resource it tracks the layout, the last write's stage/access, the stages that have read since and the stages that write has been made visible to; reads that are already covered cost nothing.
+     */
+    void planBarriers()
+    {
+        struct Tracked
+        {
+            bool touched = false;
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkPipelineStageFlags writeStages = 0;
+            VkAccessFlags writeAccess = 0;
+            VkPipelineStageFlags readStages = 0;
+            VkPipelineStageFlags visibleStages = 0;
+        };
+        std::vector<Tracked> tracked(resources.size());
+
+        for (auto &pass : passes)
+        {
+            for (const auto &access : pass.accesses)
+            {
+                Tracked &t = tracked[access.resource];
+                UsageState state = stateFor(access.usage);
+                VkPipelineStageFlags srcStages;
+                VkAccessFlags srcAccess;
+                if (!t.touched)
+                {
+                    // contents are discarded, so this is a transition from UNDEFINED; what it has to wait for is whoever last used the memory.
+                    firstUseSource(access.resource, srcStages, srcAccess);
+                }
+                else if (t.layout != state.layout || state.write)
+                {
+                    srcStages = t.writeStages | t.readStages;
+                    srcAccess = t.writeAccess;
+                }
+                else if ((state.stage & ~t.visibleStages) != 0)
+                {
+                    srcStages = t.writeStages;
+                    srcAccess = t.writeAccess;
+                }
+                else
+                {
+                    t.readStages |= state.stage;
+                    continue;
+                }
+
+                VkImageLayout oldLayout = t.touched ? t.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+                addBarrier(pass.barriers, {access.resource, oldLayout, state.layout, srcAccess, state.access}, srcStages, state.stage);
+                bool transitioned = oldLayout != state.layout;
+                t.touched = true;
+                t.layout = state.layout;
+                if (state.write)
+                {
+                    t.writeStages = state.stage;
+                    t.writeAccess = state.access & writeAccessMask;
+                    t.readStages = 0;
+                    t.visibleStages = 0;
+                }
+                else if (transitioned)
+                {
+                    // a layout transition is a write of its own, ordered before this stage; later readers chain off it.
+                    t.writeStages = state.stage;
+                    t.writeAccess = 0;
+                    t.readStages = state.stage;
+                    t.visibleStages = state.stage;
+                }
+                else
+                {
+                    t.readStages |= state.stage;
+                    t.visibleStages |= state.stage;
+                }
+            }
+        }
+
+        for (ResourceId id = 0; id < resources.size(); id++)
+        {
+            const Resource &resource = resources[id];
+            if (!resource.imported)
+            {
+                continue;
+            }
+            const Tracked &t = tracked[id];
+            addBarrier(finalBarriers, {id, t.layout, resource.external.layout, t.writeAccess, resource.external.access}, t.writeStages | t.readStages, resource.external.stage);
+        }
+
+        barrierCount = 0;
+        barrierCallCount = 0;
+        for (const auto &pass : passes)
+        {
+            barrierCount += static_cast<uint32_t>(pass.barriers.barriers.size());
+            barrierCallCount += pass.barriers.barriers.empty() ? 0 : 1;
+        }
+        barrierCount += static_cast<uint32_t>(finalBarriers.barriers.size());
+        barrierCallCount += finalBarriers.barriers.empty() ? 0 : 1;
+    }
+
+    /**
+     * @brief source scope for a resource's first barrier of the frame: every stage and write that touches the same memory, i.e. its own uses in the previous frame and those of everything aliased with it. Imported images wait on their external use instead.
+     */
+    void firstUseSource(ResourceId id, VkPipelineStageFlags &stages, VkAccessFlags &access) const
+    {
+        const Resource &resource = resources[id];
+        if (resource.imported)
+        {
+            stages = resource.external.stage;
+            access = resource.external.access & writeAccessMask;
+            return;
+        }
+        stages = 0;
+        access = 0;
+        for (const auto &other : resources)
+        {
+            if (!other.imported && other.lazy == resource.lazy && rangesOverlap(resource, other))
+            {
+                stages |= other.stages;
+                access |= other.writes;
+            }
+        }
+    }
+
+    static void addBarrier(BarrierBatch &batch, const PlannedBarrier &barrier, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages)
+    {
+        batch.srcStages |= srcStages;
+        batch.dstStages |= dstStages;
+        batch.barriers.push_back(barrier);
+    }
+
+    void recordBarriers(VkCommandBuffer cmd, const BarrierBatch &batch)
+    {
+        if (batch.barriers.empty())
+        {
+            return;
+        }
+        std::vector<VkImageMemoryBarrier> barriers;
+        for (const auto &planned : batch.barriers)
+        {
+            const Resource &resource = resources[planned.resource];
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = planned.srcAccess;
+            barrier.dstAccessMask = planned.dstAccess;
+            barrier.oldLayout = planned.oldLayout;
+            barrier.newLayout = planned.newLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = resource.image;
+            barrier.subresourceRange.aspectMask = resource.desc.aspect;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.layerCount = 1;
+            barriers.push_back(barrier);
+        }
+        VkPipelineStageFlags srcStages = batch.srcStages != 0 ? batch.srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        vkCmdPipelineBarrier(cmd, srcStages, batch.dstStages, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+    }
+
+    VkFramebuffer framebufferFor(Pass &pass)
+    {
+        std::vector<VkImageView> views;
+        for (ResourceId id : pass.attachments)
+        {
+            views.push_back(resources[id].view);
+        }
+        auto found = pass.framebuffers.find(views);
+        if (found != pass.framebuffers.end())
+        {
+            return found->second;
+        }
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = pass.renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+        framebufferInfo.pAttachments = views.data();
+        framebufferInfo.width = pass.extent.width;
+        framebufferInfo.height = pass.extent.height;
+        framebufferInfo.layers = 1;
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create framebuffer for graph pass " + pass.name + "!");
+        }
+        pass.framebuffers.emplace(views, framebuffer);
+        return framebuffer;
+    }
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceAllocator *allocator = nullptr;
+    Settings settings;
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    // hands imported images back in their external layout after the last pass.
+    BarrierBatch finalBarriers;
+    // [0] ordinary device-local, [1] lazily allocated.
+    Heap heaps[2];
+    uint32_t barrierCount = 0;
+    uint32_t barrierCallCount = 0;
+};
@@ -0,0 +1,584 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief what a SPIR-V module needs from a pipeline layout, read straight out of the binary: its stage, descriptor bindings, push constant block size, specialization constants and compute workgroup size.
+ *
+ * It's a single pass over the instruction stream that only understands the handful of opcodes that matter for layouts, so there's no dependency on SPIRV-Reflect or SPIRV-Cross. The embedded shaders are tiny and this runs once per shader at startup, in microseconds.
+ */
+struct ShaderReflection
+{
+    struct Binding
+    {
+        uint32_t set;
+        uint32_t binding;
+        VkDescriptorType type;
+        // array length; 0 for a runtime-sized array.
+        uint32_t count;
+        // the length comes from a specialization constant, so count is only its default.
+        bool specializedCount;
+    };
+
+    struct SpecConstant
+    {
+        uint32_t id;
+        bool isBool;
+        // default value from the SPIR-V, as 32 bits.
+        uint32_t defaultValue;
+    };
+
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+    std::vector<Binding> bindings;
+    uint32_t pushConstantSize = 0;
+    std::vector<SpecConstant> specConstants;
+    uint32_t localSize[3] = {1, 1, 1};
+    // SpecId of each workgroup dimension set with local_size_*_id, or UINT32_MAX when it's a literal.
+    uint32_t localSizeSpecIds[3] = {UINT32_MAX, UINT32_MAX, UINT32_MAX};
+
+    bool declaresSpecConstant(uint32_t id) const
+    {
+        return std::any_of(specConstants.begin(), specConstants.end(), [id](const SpecConstant &constant)
+                           { return constant.id == id; });
+    }
+
+    static ShaderReflection reflect(std::span<const uint32_t> words);
+
+private:
+    // the slice of the SPIR-V spec this needs.
+    enum Op : uint32_t
+    {
+        OpEntryPoint = 15,
+        OpExecutionMode = 16,
+        OpTypeBool = 20,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpSpecConstantTrue = 48,
+        OpSpecConstantFalse = 49,
+        OpSpecConstant = 50,
+        OpSpecConstantComposite = 51,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+        OpExecutionModeId = 331,
+    };
+    enum Decoration : uint32_t
+    {
+        DecorationSpecId = 1,
+        DecorationBlock = 2,
+        DecorationBufferBlock = 3,
+        DecorationArrayStride = 6,
+        DecorationMatrixStride = 7,
+        DecorationBuiltIn = 11,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34,
+        DecorationOffset = 35,
+    };
+    enum StorageClass : uint32_t
+    {
+        StorageClassUniformConstant = 0,
+        StorageClassUniform = 2,
+        StorageClassPushConstant = 9,
+        StorageClassStorageBuffer = 12,
+    };
+    static constexpr uint32_t ExecutionModeLocalSize = 17;
+    static constexpr uint32_t ExecutionModeLocalSizeId = 38;
+    static constexpr uint32_t BuiltInWorkgroupSize = 25;
+
+    struct Type
+    {
+        uint32_t op = 0;
+        std::vector<uint32_t> operands;
+    };
+
+    struct Decorations
+    {
+        uint32_t set = UINT32_MAX;
+        uint32_t binding = UINT32_MAX;
+        uint32_t specId = UINT32_MAX;
+        uint32_t arrayStride = 0;
+        uint32_t matrixStride = 0;
+        bool block = false;
+        bool bufferBlock = false;
+        bool workgroupSize = false;
+        std::map<uint32_t, uint32_t> memberOffsets;
+    };
+
+    struct Variable
+    {
+        uint32_t pointerType;
+        uint32_t storageClass;
+        uint32_t id;
+    };
+
+    // holds a ShaderReflection by value, so it can only be defined once the struct is complete.
+    struct Parser;
+};
+
+struct ShaderReflection::Parser
+{
+    ShaderReflection result;
+    std::unordered_map<uint32_t, Type> types;
+    std::unordered_map<uint32_t, Decorations> decorations;
+    // OpConstant and OpSpecConstant values (32-bit only), for array lengths and workgroup sizes.
+    std::unordered_map<uint32_t, uint32_t> constants;
+    std::unordered_map<uint32_t, bool> specConstantIds;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> composites;
+    std::vector<Variable> variables;
+    std::vector<uint32_t> localSizeIds;
+
+    void instruction(std::span<const uint32_t> in)
+    {
+        uint32_t op = in[0] & 0xffffu;
+        switch (op)
+        {
+        case OpEntryPoint:
+            result.stage = stageFor(in[1]);
+            break;
+        case OpExecutionMode:
+            if (in[2] == ExecutionModeLocalSize)
+            {
+                std::copy(in.begin() + 3, in.begin() + 6, result.localSize);
+            }
+            break;
+        case OpExecutionModeId:
+            if (in[2] == ExecutionModeLocalSizeId)
+            {
+                localSizeIds.assign(in.begin() + 3, in.begin() + 6);
+            }
+            break;
+        case OpTypeBool:
+        case OpTypeInt:
+        case OpTypeFloat:
+        case OpTypeVector:
+        case OpTypeMatrix:
+        case OpTypeImage:
+        case OpTypeSampler:
+        case OpTypeSampledImage:
+        case OpTypeArray:
+        case OpTypeRuntimeArray:
+        case OpTypeStruct:
+        case OpTypePointer:
+            types[in[1]] = {op, std::vector<uint32_t>(in.begin() + 2, in.end())};
+            break;
+        case OpConstant:
+        case OpSpecConstant:
+            constants[in[2]] = in[3];
+            if (op == OpSpecConstant)
+            {
+                specConstantIds[in[2]] = false;
+            }
+            break;
+        case OpSpecConstantTrue:
+        case OpSpecConstantFalse:
+            constants[in[2]] = op == OpSpecConstantTrue ? 1 : 0;
+            specConstantIds[in[2]] = true;
+            break;
+        case OpSpecConstantComposite:
+            composites[in[2]] = std::vector<uint32_t>(in.begin() + 3, in.end());
+            break;
+        case OpVariable:
+            variables.push_back({in[1], in[3], in[2]});
+            break;
+        case OpDecorate:
+            decorate(decorations[in[1]], in[2], in.size() > 3 ? in[3] : 0);
+            break;
+        case OpMemberDecorate:
+            if (in[3] == DecorationOffset)
+            {
+                decorations[in[1]].memberOffsets[in[2]] = in[4];
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    static void decorate(Decorations &target, uint32_t decoration, uint32_t value)
+    {
+        switch (decoration)
+        {
+        case DecorationSpecId:
+            target.specId = value;
+            break;
+        case DecorationBlock:
+            target.block = true;
+            break;
+        case DecorationBufferBlock:
+            target.bufferBlock = true;
+            break;
+        case DecorationArrayStride:
+            target.arrayStride = value;
+            break;
+        case DecorationMatrixStride:
+            target.matrixStride = value;
+            break;
+        case DecorationBuiltIn:
+            target.workgroupSize = value == BuiltInWorkgroupSize;
+            break;
+        case DecorationBinding:
+            target.binding = value;
+            break;
+        case DecorationDescriptorSet:
+            target.set = value;
+            break;
+        default:
+            break;
+        }
+    }
+
+    static VkShaderStageFlagBits stageFor(uint32_t executionModel)
+    {
+        switch (executionModel)
+        {
+        case 0:
+            return VK_SHADER_STAGE_VERTEX_BIT;
+        case 4:
+            return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5:
+            return VK_SHADER_STAGE_COMPUTE_BIT;
+        default:
+            throw std::runtime_error("unsupported SPIR-V execution model " + std::to_string(executionModel));
+        }
+    }
+
+    ShaderReflection finish()
+    {
+        for (const auto &[id, isBool] : specConstantIds)
+        {
+            const Decorations &decoration = decorations[id];
+            if (decoration.specId != UINT32_MAX)
+            {
+                result.specConstants.push_back({decoration.specId, isBool, constants[id]});
+            }
+        }
+        std::sort(result.specConstants.begin(), result.specConstants.end(), [](const SpecConstant &a, const SpecConstant &b)
+                  { return a.id < b.id; });
+
+        // local_size_x_id shows up either as LocalSizeId or, from glslang, as a WorkgroupSize builtin composite of spec constants.
+        for (const auto &[id, members] : composites)
+        {
+            if (decorations[id].workgroupSize && members.size() == 3)
+            {
+                localSizeIds = members;
+            }
+        }
+        for (uint32_t i = 0; i < localSizeIds.size() && i < 3; i++)
+        {
+            result.localSize[i] = constants[localSizeIds[i]];
+            result.localSizeSpecIds[i] = decorations[localSizeIds[i]].specId;
+        }
+
+        for (const auto &variable : variables)
+        {
+            const Type &pointer = types[variable.pointerType];
+            uint32_t pointee = pointer.operands.at(1);
+            if (variable.storageClass == StorageClassPushConstant)
+            {
+                result.pushConstantSize = std::max(result.pushConstantSize, sizeOf(pointee, 0));
+                continue;
+            }
+            if (variable.storageClass != StorageClassUniformConstant && variable.storageClass != StorageClassUniform && variable.storageClass != StorageClassStorageBuffer)
+            {
+                continue;
+            }
+            const Decorations &decoration = decorations[variable.id];
+            if (decoration.binding == UINT32_MAX)
+            {
+                continue;
+            }
+            ShaderReflection::Binding binding{decoration.set == UINT32_MAX ? 0 : decoration.set, decoration.binding, VK_DESCRIPTOR_TYPE_MAX_ENUM, 1, false};
+            uint32_t element = pointee;
+            const Type &outer = types[pointee];
+            if (outer.op == OpTypeArray)
+            {
+                element = outer.operands[0];
+                binding.count = constants[outer.operands[1]];
+                binding.specializedCount = specConstantIds.count(outer.operands[1]) > 0;
+            }
+            else if (outer.op == OpTypeRuntimeArray)
+            {
+                element = outer.operands[0];
+                binding.count = 0;
+            }
+            binding.type = descriptorType(element, variable.storageClass);
+            result.bindings.push_back(binding);
+        }
+        std::sort(result.bindings.begin(), result.bindings.end(), [](const ShaderReflection::Binding &a, const ShaderReflection::Binding &b)
+                  { return a.set != b.set ? a.set < b.set : a.binding < b.binding; });
+        return result;
+    }
+
+    VkDescriptorType descriptorType(uint32_t typeId, uint32_t storageClass)
+    {
+        const Type &type = types[typeId];
+        if (storageClass == StorageClassStorageBuffer)
+        {
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        }
+        if (storageClass == StorageClassUniform)
+        {
+            return decorations[typeId].bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+        switch (type.op)
+        {
+        case OpTypeSampledImage:
+            return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case OpTypeSampler:
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case OpTypeImage:
+            // operands: sampled type, dim, depth, arrayed, ms, sampled (1 = with a sampler, 2 = storage), format.
+            return type.operands[5] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        default:
+            throw std::runtime_error("unsupported descriptor type in SPIR-V (opcode " + std::to_string(type.op) + ")");
+        }
+    }
+
+    /**
+     * @brief bytes a push constant member of this type spans, going by the explicit Offset/ArrayStride/MatrixStride decorations the std430/std140 layouts require.
+     */
+    uint32_t sizeOf(uint32_t typeId, uint32_t matrixStride)
+    {
+        const Type &type = types[typeId];
+        switch (type.op)
+        {
+        case OpTypeBool:
+            return 4;
+        case OpTypeInt:
+        case OpTypeFloat:
+            return type.operands[0] / 8;
+        case OpTypeVector:
+            return sizeOf(type.operands[0], 0) * type.operands[1];
+        case OpTypeMatrix:
+            return (matrixStride != 0 ? matrixStride : sizeOf(type.operands[0], 0)) * type.operands[1];
+        case OpTypeArray:
+            return decorations[typeId].arrayStride * constants[type.operands[1]];
+        case OpTypeStruct:
+        {
+            uint32_t size = 0;
+            const Decorations &decoration = decorations[typeId];
+            for (uint32_t member = 0; member < type.operands.size(); member++)
+            {
+                auto offset = decoration.memberOffsets.find(member);
+                uint32_t start = offset == decoration.memberOffsets.end() ? size : offset->second;
+                size = std::max(size, start + sizeOf(type.operands[member], decoration.matrixStride));
+            }
+            return size;
+        }
+        default:
+            throw std::runtime_error("unsupported push constant member type in SPIR-V (opcode " + std::to_string(type.op) + ")");
+        }
+    }
+};
+
+inline ShaderReflection ShaderReflection::reflect(std::span<const uint32_t> words)
+{
+    if (words.size() < 5 || words[0] != 0x07230203u)
+    {
+        throw std::runtime_error("not a SPIR-V module (bad magic number)!");
+    }
+    Parser parser;
+    for (size_t i = 5; i < words.size();)
+    {
+        uint32_t wordCount = words[i] >> 16;
+        if (wordCount == 0 || i + wordCount > words.size())
+        {
+            throw std::runtime_error("truncated SPIR-V instruction!");
+        }
+        parser.instruction(words.subspan(i, wordCount));
+        i += wordCount;
+    }
+    return parser.finish();
+}
+
+/**
+ * @brief builds a VkSpecializationInfo one 32-bit constant at a time. Keep it alive until the pipeline has been created; the info points into it.
+ */
+class SpecializationConstants
+{
+public:
+    SpecializationConstants &set(uint32_t id, uint32_t value)
+    {
+        entries.push_back({id, static_cast<uint32_t>(data.size() * sizeof(uint32_t)), sizeof(uint32_t)});
+        data.push_back(value);
+        return *this;
+    }
+
+    /**
+     * @brief SPIR-V booleans are specialized as 32-bit VkBool32s.
+     */
+    SpecializationConstants &setBool(uint32_t id, bool value)
+    {
+        return set(id, value ? VK_TRUE : VK_FALSE);
+    }
+
+    /**
+     * @brief throws if the shader doesn't declare one of the constants; Vulkan would silently ignore it, which is how a renamed constant_id goes unnoticed.
+     */
+    void requireDeclaredBy(const ShaderReflection &reflection, const char *shaderName) const
+    {
+        for (const auto &entry : entries)
+        {
+            if (!reflection.declaresSpecConstant(entry.constantID))
+            {
+                throw std::runtime_error(std::string(shaderName) + " has no specialization constant " + std::to_string(entry.constantID) + "!");
+            }
+        }
+    }
+
+    const VkSpecializationInfo *info()
+    {
+        specializationInfo = {static_cast<uint32_t>(entries.size()), entries.data(), data.size() * sizeof(uint32_t), data.data()};
+        return &specializationInfo;
+    }
+
+private:
+    std::vector<VkSpecializationMapEntry> entries;
+    std::vector<uint32_t> data;
+    VkSpecializationInfo specializationInfo{};
+};
+
+/**
+ * @brief descriptor set layouts and a pipeline layout generated from the reflection of every stage of one pipeline: bindings are merged by (set, binding) with their stage flags OR'd together, and a single push constant range covers the largest block any stage declares.
+ *
+ * Only for plain layouts; anything needing binding flags (update-after-bind, variable counts, i.e. the DescriptorHeap) or runtime-sized descriptor arrays is built by hand.
+ */
+class ReflectedLayout
+{
+public:
+    void create(VkDevice device, std::initializer_list<const ShaderReflection *> stages)
+    {
+        this->device = device;
+        std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;
+        VkPushConstantRange pushConstants{0, 0, 0};
+        for (const ShaderReflection *stage : stages)
+        {
+            for (const auto &binding : stage->bindings)
+            {
+                if (binding.count == 0)
+                {
+                    throw std::runtime_error("runtime-sized descriptor arrays need a hand-built layout!");
+                }
+                auto [it, inserted] = sets[binding.set].try_emplace(binding.binding, VkDescriptorSetLayoutBinding{binding.binding, binding.type, binding.count, 0, nullptr});
+                if (!inserted && (it->second.descriptorType != binding.type || it->second.descriptorCount != binding.count))
+                {
+                    throw std::runtime_error("stages disagree about set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding) + "!");
+                }
+                it->second.stageFlags |= stage->stage;
+            }
+            if (stage->pushConstantSize > 0)
+            {
+                pushConstants.stageFlags |= stage->stage;
+                pushConstants.size = std::max(pushConstants.size, stage->pushConstantSize);
+            }
+        }
+        pushConstantRange = pushConstants;
+
+        // sets are indexed by number, so any gaps get empty layouts.
+        uint32_t setCount = sets.empty() ? 0 : sets.rbegin()->first + 1;
+        for (uint32_t set = 0; set < setCount; set++)
+        {
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+            for (const auto &[number, binding] : sets[set])
+            {
+                bindings.push_back(binding);
+            }
+            VkDescriptorSetLayoutCreateInfo layoutInfo{};
+            layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+            layoutInfo.pBindings = bindings.data();
+            VkDescriptorSetLayout setLayout;
+            if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create reflected descriptor set layout!");
+            }
+            setLayouts.push_back(setLayout);
+            for (const auto &binding : bindings)
+            {
+                poolSizes[binding.descriptorType] += binding.descriptorCount;
+            }
+        }
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = pushConstantRange.size > 0 ? 1 : 0;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create reflected pipeline layout!");
+        }
+    }
+
+    void destroy()
+    {
+        if (layout == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        vkDestroyPipelineLayout(device, layout, nullptr);
+        for (auto setLayout : setLayouts)
+        {
+            vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+        }
+        setLayouts.clear();
+        poolSizes.clear();
+        layout = VK_NULL_HANDLE;
+    }
+
+    VkPipelineLayout pipelineLayout() const
+    {
+        return layout;
+    }
+
+    VkDescriptorSetLayout setLayout(uint32_t set) const
+    {
+        return setLayouts.at(set);
+    }
+
+    const VkPushConstantRange &pushConstants() const
+    {
+        return pushConstantRange;
+    }
+
+    /**
+     * @return pool sizes for `copies` allocations of every set in the layout.
+     */
+    std::vector<VkDescriptorPoolSize> descriptorPoolSizes(uint32_t copies) const
+    {
+        std::vector<VkDescriptorPoolSize> sizes;
+        for (const auto &[type, count] : poolSizes)
+        {
+            sizes.push_back({type, count * copies});
+        }
+        return sizes;
+    }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPushConstantRange pushConstantRange{};
+    std::map<VkDescriptorType, uint32_t> poolSizes;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief bag of timing samples (milliseconds by convention) with the handful of summaries we actually look at: mean, percentiles and max.
+ *
+ * Samples are kept raw rather than binned so percentiles are exact; at one sample per frame even a long benchmark run is only a few MB.
+ */
+class SampleStats
+{
+public:
+    void add(double sample)
+    {
+        samples.push_back(sample);
+        sorted = false;
+    }
+
+    void clear()
+    {
+        samples.clear();
+        sorted = true;
+    }
+
+    size_t count() const
+    {
+        return samples.size();
+    }
+
+    double mean() const
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+        return total() / static_cast<double>(samples.size());
+    }
+
+    double total() const
+    {
+        double sum = 0.0;
+        for (double sample : samples)
+        {
+            sum += sample;
+        }
+        return sum;
+    }
+
+    /**
+     * @param p percentile in [0, 100], nearest-rank.
+     */
+    double percentile(double p)
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+        sortIfNeeded();
+        double rank = (p / 100.0) * static_cast<double>(samples.size() - 1);
+        return samples[static_cast<size_t>(rank + 0.5)];
+    }
+
+    double max()
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+        sortIfNeeded();
+        return samples.back();
+    }
+
+    /**
+     * @brief one-line summary: "label: mean X p50 X p95 X p99 X max X unit (n samples)".
+     */
+    void print(std::ostream &out, const std::string &label, const std::string &unit = "ms")
+    {
+        out << std::fixed << std::setprecision(3)
+            << label << ": mean " << mean() << " p50 " << percentile(50) << " p95 " << percentile(95)
+            << " p99 " << percentile(99) << " max " << max() << ' ' << unit
+            << " (" << count() << " samples)\n";
+        out.unsetf(std::ios::floatfield);
+    }
+
+private:
+    void sortIfNeeded()
+    {
+        if (!sorted)
+        {
+            std::sort(samples.begin(), samples.end());
+            sorted = true;
+        }
+    }
+
+    std::vector<double> samples;
+    bool sorted = true;
+};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief a one-shot dependency graph of tasks, run once over a handful of threads; startup uses it to overlap the slow bits of init (the loader, the window system, the driver's compiler, the disk) wherever Vulkan doesn't force an order.
+ *
+ * Unlike WorkerPool this is a real task queue: each task runs exactly once, on whichever thread gets to it first, as soon as everything it depends on has finished. A task can be pinned to the thread that calls run() instead, for APIs like GLFW's window creation that have to stay on the main thread; that thread also picks up unpinned work while it waits. Dependencies have to exist before the task that names them, so the graph can't have cycles. Finishing a dependency happens-before its dependents start, so tasks hand results to each other through plain members without any further locking; tasks that aren't ordered against each other must not touch the same state.
+ *
+ * Every task's start and end time and thread are recorded for printTimings().
+ */
+class TaskGraph
+{
+public:
+    using TaskId = uint32_t;
+    using Clock = std::chrono::steady_clock;
+
+    enum class Affinity
+    {
+        Any,
+        // only ever runs on the thread that called run().
+        Main,
+    };
+
+    /**
+     * @param dependencies tasks that must finish first; all already added.
+     */
+    TaskId add(std::string name, std::vector<TaskId> dependencies, std::function<void()> work, Affinity affinity = Affinity::Any)
+    {
+        TaskId id = static_cast<TaskId>(tasks.size());
+        for (TaskId dependency : dependencies)
+        {
+            if (dependency >= id)
+            {
+                throw std::runtime_error("task " + name + " depends on a task that doesn't exist yet!");
+            }
+            tasks[dependency].dependents.push_back(id);
+        }
+        Task task;
+        task.name = std::move(name);
+        task.dependencies = std::move(dependencies);
+        task.work = std::move(work);
+        task.affinity = affinity;
+        tasks.push_back(std::move(task));
+        return id;
+    }
+
+    /**
+     * @brief runs every task and returns once they've all finished. If one throws, tasks that haven't started yet are skipped, the ones already running are waited for, and the first exception is rethrown here.
+     * @param workerCount threads to start besides the calling one; 0 runs everything on the calling thread, in the order tasks became ready.
+     */
+    void run(uint32_t workerCount)
+    {
+        begin = Clock::now();
+        threadCount = workerCount + 1;
+        finished = 0;
+        failure = nullptr;
+        for (TaskId id = 0; id < tasks.size(); id++)
+        {
+            tasks[id].remaining = static_cast<uint32_t>(tasks[id].dependencies.size());
+            if (tasks[id].remaining == 0)
+            {
+                queueFor(tasks[id]).push_back(id);
+            }
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back([this, i]()
+                                 { workerLoop(i + 1); });
+        }
+        workerLoop(0);
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        end = Clock::now();
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    /**
+     * @brief the overall wall time against the summed task time and the critical path: the chain of dependencies that finished last, which is what has to get shorter for the whole graph to finish sooner.
+     * @param perTask also one line per task in start order, with when it ran and on which thread.
+     */
+    void printTimings(std::ostream &out, const std::string &label, bool perTask) const
+    {
+        std::vector<TaskId> order;
+        double busyMs = 0.0;
+        for (TaskId id = 0; id < tasks.size(); id++)
+        {
+            if (tasks[id].ran)
+            {
+                order.push_back(id);
+                busyMs += tasks[id].endMs - tasks[id].startMs;
+            }
+        }
+        std::sort(order.begin(), order.end(), [&](TaskId a, TaskId b)
+                  { return tasks[a].startMs < tasks[b].startMs; });
+        size_t width = 0;
+        for (const Task &task : tasks)
+        {
+            width = std::max(width, task.name.size());
+        }
+
+        double wallMs = std::chrono::duration<double, std::milli>(end - begin).count();
+        out << std::fixed << std::setprecision(1);
+        out << label << ": " << order.size() << " task(s) on " << threadCount << " thread(s) in " << wallMs << " ms, " << busyMs << " ms of work ("
+            << (wallMs > 0.0 ? busyMs / wallMs : 0.0) << "x overlap)\n";
+        for (size_t i = 0; perTask && i < order.size(); i++)
+        {
+            const Task &task = tasks[order[i]];
+            out << label << ":   " << std::left << std::setw(static_cast<int>(width)) << task.name << std::right << "  " << std::setw(7) << task.startMs << " .. "
+                << std::setw(7) << task.endMs << " ms  (" << std::setw(6) << task.endMs - task.startMs << " ms, " << (task.thread == 0 ? std::string("main") : "worker " + std::to_string(task.thread)) << ")\n";
+        }
+
+        if (!order.empty())
+        {
+            // walk back from whatever finished last, always through the dependency that finished last.
+            TaskId last = *std::max_element(order.begin(), order.end(), [&](TaskId a, TaskId b)
+                                            { return tasks[a].endMs < tasks[b].endMs; });
+            std::vector<TaskId> path{last};
+            while (!tasks[path.back()].dependencies.empty())
+            {
+                const auto &dependencies = tasks[path.back()].dependencies;
+                path.push_back(*std::max_element(dependencies.begin(), dependencies.end(), [&](TaskId a, TaskId b)
+                                                 { return tasks[a].endMs < tasks[b].endMs; }));
+            }
+            out << label << ": critical path";
+            for (auto it = path.rbegin(); it != path.rend(); ++it)
+            {
+                out << (it == path.rbegin() ? " " : " > ") << tasks[*it].name;
+            }
+            out << '\n';
+        }
+        out << std::defaultfloat << std::setprecision(6);
+    }
+
+private:
+    struct Task
+    {
+        std::string name;
+        std::vector<TaskId> dependencies;
+        std::vector<TaskId> dependents;
+        std::function<void()> work;
+        Affinity affinity = Affinity::Any;
+        // dependencies still to finish.
+        uint32_t remaining = 0;
+        bool ran = false;
+        // from the start of run().
+        double startMs = 0.0;
+        double endMs = 0.0;
+        // 0 is the calling thread.
+        uint32_t thread = 0;
+    };
+
+    std::deque<TaskId> &queueFor(const Task &task)
+    {
+        return task.affinity == Affinity::Main ? mainReady : anyReady;
+    }
+
+    /**
+     * @param thread 0 for the calling thread, which takes pinned tasks first and then anything else; workers only take unpinned ones.
+     */
+    void workerLoop(uint32_t thread)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [&]()
+                      { return finished == tasks.size() || !anyReady.empty() || (thread == 0 && !mainReady.empty()); });
+            if (finished == tasks.size())
+            {
+                return;
+            }
+            std::deque<TaskId> &queue = thread == 0 && !mainReady.empty() ? mainReady : anyReady;
+            TaskId id = queue.front();
+            queue.pop_front();
+            Task &task = tasks[id];
+
+            // after a failure the rest of the graph drains without running, so everyone gets to the end and run() can rethrow.
+            if (!failure)
+            {
+                lock.unlock();
+                auto start = Clock::now();
+                std::exception_ptr error;
+                try
+                {
+                    task.work();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                auto stop = Clock::now();
+                lock.lock();
+                task.ran = true;
+                task.thread = thread;
+                task.startMs = std::chrono::duration<double, std::milli>(start - begin).count();
+                task.endMs = std::chrono::duration<double, std::milli>(stop - begin).count();
+                if (error && !failure)
+                {
+                    failure = error;
+                }
+            }
+
+            finished++;
+            for (TaskId dependent : task.dependents)
+            {
+                if (--tasks[dependent].remaining == 0)
+                {
+                    queueFor(tasks[dependent]).push_back(dependent);
+                }
+            }
+            wake.notify_all();
+        }
+    }
+
+    std::vector<Task> tasks;
+    std::deque<TaskId> anyReady;
+    std::deque<TaskId> mainReady;
+    size_t finished = 0;
+    std::exception_ptr failure;
+    uint32_t threadCount = 1;
+    Clock::time_point begin;
+    Clock::time_point end;
+    std::mutex mutex;
+    std::condition_variable wake;
+};
@@ -5,412 +5,3423 @@
 #include <stdexcept>
 #include <cstdlib>
 #include <vector>
+#include <array>
 #include <algorithm>
 #include <map>
 #include <optional>
 #include <set>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <memory>
+#include <limits>
+#include <fstream>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <random>
+#include <sstream>
+#include <exception>
+#include <atomic>
+#include <csignal>
+#include <span>
+#include <string_view>
+
+#include "DebugLog.hpp"
+#include "DeletionQueue.hpp"
+#include "DeviceAllocator.hpp"
+#include "DescriptorHeap.hpp"
+#include "DeviceBenchmark.hpp"
+#include "DeviceCapabilities.hpp"
+#include "DeviceScoring.hpp"
+#include "DeviceSelection.hpp"
+#include "FrameDump.hpp"
+#include "FramePacer.hpp"
+#include "FrameScheduler.hpp"
+#include "GpuCulling.hpp"
+#include "GpuProfiler.hpp"
+#include "InstanceTransforms.hpp"
+#include "MeshAsset.hpp"
+#include "MeshStreamer.hpp"
+#include "PipelineCache.hpp"
+#include "QueueSync.hpp"
+#include "RenderGraph.hpp"
+#include "ShaderReflection.hpp"
+#include "Stats.hpp"
+#include "TaskGraph.hpp"
+#include "UploadRing.hpp"
+#include "VulkanHandle.hpp"
+#include "WorkerPool.hpp"
+
+// generated at build time from the optimized SPIR-V in Build/shaders; see the Makefile.
+#include "EmbeddedShaders.hpp"
 
 const uint32_t WINDOW_WIDTH = 800;
 const uint32_t WINDOW_HEIGHT = 600;
+// descriptor heap sizes we ask for; createLogicalDevice() clamps them to what the device can bind.
+const uint32_t DESCRIPTOR_HEAP_TEXTURES = 1024;
+const uint32_t DESCRIPTOR_HEAP_BUFFERS = 1024;
 const std::vector<const char *> validationLayers = {
     "VK_LAYER_KHRONOS_validation"};
 const std::vector<const char *> deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+// nice-to-haves that get enabled when the device has them and quietly skipped when it doesn't.
+const std::vector<const char *> optionalDeviceExtensions = {
+    // tells us whether a pipeline came out of the pipeline cache.
+    VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME,
+    // cross-queue (graphics/compute/transfer) sync without a binary semaphore + fence per submission; see QueueSync.hpp.
+    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME};
+
+/**
+ * @brief a shader compiled into the binary by the Makefile's SPIR-V stage, by source file name (e.g. "cull.comp").
+ */
+static std::span<const uint32_t> embeddedShader(std::string_view name)
+{
+    for (const auto &shader : embedded_shaders::all)
+    {
+        if (name == shader.name)
+        {
+            return {shader.words, shader.wordCount};
+        }
+    }
+    throw std::runtime_error("no embedded shader named " + std::string(name) + "; was it added to shaders/ and the build rerun?");
+}
+
+/**
+ * Layout of one vertex in the vertex buffer; must match the inputs of shaders/triangle.vert.
+ */
+struct Vertex
+{
+    float position[2];
+    float color[3];
+};
+// --mesh chunks go from the file to the vertex buffer untouched.
+static_assert(sizeof(Vertex) == sizeof(MeshVertex), "Vertex and MeshVertex must stay the same layout");
+
+// the triangle that used to be hardcoded in the vertex shader, now streamed through the upload ring.
+const std::vector<Vertex> triangleVertices = {
+    {{0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}},
+    {{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}},
+    {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}}};
+const std::vector<uint16_t> triangleIndices = {0, 1, 2};
+// radius of a circle around the origin that contains triangleVertices, i.e. a draw's bounding circle at scale 1; used by both the CPU and GPU cull.
+const float TRIANGLE_BOUNDING_RADIUS = 0.5f * std::sqrt(2.0f);
+// --scene-objects scatters objects over [-SCENE_WORLD_EXTENT, SCENE_WORLD_EXTENT]^2; the view only ever covers [-1, 1]^2 around the camera.
+const float SCENE_WORLD_EXTENT = 4.0f;
+// --mesh chunks start streaming in once their bounding circle is this close to the view, so they've usually landed before they show up.
+const float MESH_PREFETCH_MARGIN = 0.5f;
+
+// default for --validation / --no-validation.
+#ifdef NDEBUG
+const bool enableValidationLayers = false;
+#else
+const bool enableValidationLayers = true;
+#endif
+
+// longest --pacing present-wait blocks on one present before giving up on it (e.g. the window is occluded and the compositor stopped showing it).
+const uint64_t PRESENT_WAIT_TIMEOUT_NS = 100'000'000;
+
+// bumped by SIGUSR1 to ask for another --validation-frames window; each app compares it against the last value it saw at the top of drawFrame().
+std::atomic<uint32_t> validationRequests{0};
+
+/**
+ * What we want out of the presentation engine; mapped onto an actual VkPresentModeKHR based on what the surface supports.
+ */
+enum class PresentPolicy
+{
+    // MAILBOX: lowest latency without tearing.
+    LowLatency,
+    // FIFO: vsync-locked, GPU and CPU idle between vblanks.
+    PowerSaving,
+    // IMMEDIATE: uncapped, tearing allowed, for throughput measurements.
+    Benchmark,
+};
+
+/**
+ * Runtime knobs for the sandbox, filled in from the command line by parseArguments().
+ */
+struct AppConfig
+{
+    // render into an offscreen image instead of a GLFW window; no display server or present-capable queue required.
+    bool headless = false;
+    // number of frames to render before exiting; 0 means run until the window is closed (headless mode needs a finite count and defaults to 300).
+    uint32_t frameCount = 0;
+    // when non-empty, headless frames are written here as frame_NNNNN.ppm.
+    std::string dumpDirectory;
+    // when non-empty, headless frames are published to this POSIX shared memory segment (e.g. /vk_frames).
+    std::string dumpSharedMemory;
+    // how many frames the CPU may queue ahead of the GPU before blocking on a fence.
+    uint32_t framesInFlight = 2;
+    // which latency/power trade-off drives the swapchain present mode, see chooseSwapPresentMode().
+    PresentPolicy presentPolicy = PresentPolicy::LowLatency;
+    // what paces frame starts, see FramePacer; Vsync overrides presentPolicy with FIFO.
+    PacingMode pacing = PacingMode::Uncapped;
+    // with PacingMode::TargetFps, the rate to hold.
+    double targetFps = 0.0;
+    // stop rendering while the window is minimized (always) or unfocused (with pauseUnfocused), blocking in glfwWaitEvents() instead of spinning.
+    bool idleWait = true;
+    // treat losing focus like being minimized.
+    bool pauseUnfocused = false;
+    // on-disk VkPipelineCache blob; empty disables persistence.
+    std::string pipelineCachePath = "pipeline_cache.bin";
+    // when non-zero, time this many cold vs warm pipeline creations at startup.
+    uint32_t pipelineCacheBenchIterations = 0;
+    // on-disk device capability snapshots keyed by device + driver; empty re-queries every device on every launch.
+    std::string deviceCachePath = "device_caps.bin";
+    // ScoringPolicy file ranking suitable devices; empty uses the built-in weights.
+    std::string scoringPolicyPath;
+    // micro-benchmark devices without cached results and rank by what they measure (same as benchmark = true in the policy).
+    bool benchmarkDevices = false;
+    // which of the suitable devices to use, best score first.
+    uint32_t deviceRank = 0;
+    // headless batch mode: split the frames across every suitable device, each driven by its own instance + logical device on its own thread.
+    bool multiGpu = false;
+    // with multiGpu, how many independent logical devices to open per suitable physical device; lets one software ICD stand in for several GPUs.
+    uint32_t deviceReplicas = 1;
+    // number of triangles in the draw list, laid out on a grid.
+    uint32_t drawCount = 1;
+    // when non-zero, replace the grid with this many small triangles scattered over a world bigger than the view, with the camera panning across it; a benchmark scene for culling.
+    uint32_t sceneObjects = 0;
+    // when non-empty, draw this .vkmesh (see MeshConverter) instead of the triangle draw list, streaming its chunks in as the panning camera reaches them.
+    std::string meshPath;
+    // with meshPath, how much device memory streamed chunks may hold before the least recently needed get evicted.
+    uint32_t meshBudgetMiB = 256;
+    // when non-zero, replace the draw list with this many instances of the triangle, each moving and spinning on its own, drawn with one instanced draw; see InstanceTransforms.
+    uint32_t instances = 0;
+    // with instances, worker threads splitting the per-frame transform update; 0 updates on the main thread.
+    uint32_t instanceThreads = std::max(1u, std::thread::hardware_concurrency());
+    // cull and emit draws on the GPU (compute + vkCmdDrawIndexedIndirectCount) instead of culling and recording one draw per object on the CPU.
+    bool gpuCull = false;
+    // with gpuCull, threads per cull workgroup; specialized into shaders/cull.comp, so no recompile to try another.
+    uint32_t cullWorkgroupSize = 64;
+    // with gpuCull, run the view test; off specializes it out and every object is drawn.
+    bool viewCull = true;
+    // worker threads recording secondary command buffers; 0 records everything inline on the main thread.
+    uint32_t recordThreads = 0;
+    // when non-zero, time this many frame recordings per worker count (1 to hardware_concurrency) at startup.
+    uint32_t recordBenchFrames = 0;
+    // total size of the staging ring, split evenly between frames in flight.
+    uint32_t uploadRingMiB = 8;
+    // when non-zero, stream a synthetic asset of this size into a device-local buffer to exercise chunked uploads.
+    uint32_t streamTestMiB = 0;
+    // headless only: render through the RenderGraph sample (scene with depth, a downsample/upsample chain and a composite) instead of the single hand-built render pass.
+    bool renderGraph = false;
+    // with renderGraph, let transients with disjoint lifetimes share memory.
+    bool graphAliasing = true;
+    // use the Vulkan 1.2 update-after-bind descriptor heap when the device supports it; false forces the 1.0 one-set-per-frame-slot fallback.
+    bool bindless = true;
+    // collect GPU timestamp and CPU scope timings and print per-pass summaries at exit.
+    bool profile = false;
+    // when non-empty, also write those timings here as a Chrome trace (implies profile).
+    std::string tracePath;
+    // load the Khronos validation layer and hook up the debug messenger.
+    bool validation = enableValidationLayers;
+    // which severities/types the messenger subscribes to and how DebugLog prints, dedups and rate-limits them.
+    DebugLogSettings debugLog;
+    // when non-zero, mute the messenger after this many frames; SIGUSR1 turns it back on for another window.
+    uint32_t validationFrames = 0;
+    // threads besides the main one running the startup TaskGraph (and device benchmarks); 0 runs startup serially for comparison.
+    uint32_t startupThreads = 3;
+    // list every instance layer and extension, and print the per-task startup timings.
+    bool verboseStartup = false;
+};
+
+void printUsage(const char *program)
+{
+    std::cout << "usage: " << program << " [options]\n"
+              << "\t--headless            render offscreen without a window or surface\n"
+              << "\t--frames N            render N frames and exit\n"
+              << "\t--dump-dir DIR        write headless frames to DIR as PPM files\n"
+              << "\t--dump-shm NAME       publish headless frames to POSIX shared memory NAME\n"
+              << "\t--frames-in-flight N  frames the CPU may run ahead of the GPU (default 2)\n"
+              << "\t--present-mode MODE   mailbox (lowest latency, default), fifo (power) or immediate (benchmark)\n"
+              << "\t--pacing MODE        uncapped (default), vsync, fps (with --target-fps) or present-wait (VK_KHR_present_wait)\n"
+              << "\t--target-fps N       with --pacing fps, frames per second to hold\n"
+              << "\t--no-idle-wait       keep rendering while minimized instead of blocking on window events\n"
+              << "\t--pause-unfocused    also stop rendering while the window doesn't have focus\n"
+              << "\t--pipeline-cache PATH pipeline cache file (default pipeline_cache.bin, \"\" to disable)\n"
+              << "\t--bench-pipeline-cache N  time N cold vs warm pipeline creations at startup\n"
+              << "\t--device-cache PATH   device capability cache file (default device_caps.bin, \"\" to disable)\n"
+              << "\t--scoring FILE        device scoring policy (see device_scoring.cfg)\n"
+              << "\t--bench-devices       benchmark uncached devices at startup and rank by the results\n"
+              << "\t--device N            use the Nth best suitable device (default 0)\n"
+              << "\t--multi-gpu           headless only: shard the frames across every suitable device\n"
+              << "\t--device-replicas N   with --multi-gpu, open N logical devices per physical device (default 1)\n"
+              << "\t--draws N             number of triangles to draw per frame (default 1)\n"
+              << "\t--scene-objects N    scatter N triangles over a panning world instead of the --draws grid\n"
+              << "\t--mesh FILE          draw a .vkmesh asset from MeshConverter, streaming chunks in as they come into view\n"
+              << "\t--mesh-budget-mb N   with --mesh, device memory for resident chunks before eviction (default 256)\n"
+              << "\t--instances N        draw N moving instances with one instanced draw, transforms updated on the CPU each frame\n"
+              << "\t--instance-threads N with --instances, worker threads for the transform update (default one per core, 0 inline)\n"
+              << "\t--gpu-cull           cull and issue draws from a compute shader via vkCmdDrawIndexedIndirectCount\n"
+              << "\t--cull-workgroup N    with --gpu-cull, threads per cull workgroup (default 64)\n"
+              << "\t--no-view-cull        with --gpu-cull, specialize the view test out and draw every object\n"
+              << "\t--record-threads N    record secondary command buffers on N worker threads (default 0, inline)\n"
+              << "\t--bench-record N      time N frame recordings for each worker count at startup\n"
+              << "\t--upload-ring-mb N    staging ring size in MiB, split across frames in flight (default 8)\n"
+              << "\t--stream-test-mb N    stream a synthetic N MiB asset through the upload ring\n"
+              << "\t--render-graph        headless only: render a multi-pass sample through the render graph\n"
+              << "\t--no-aliasing         with --render-graph, give every transient image its own memory\n"
+              << "\t--no-bindless         use the Vulkan 1.0 descriptor heap fallback even where 1.2 descriptor indexing is available\n"
+              << "\t--profile             print per-pass GPU and CPU timings at exit\n"
+              << "\t--trace FILE          write GPU and CPU timings as a Chrome trace JSON (implies --profile)\n"
+              << "\t--validation          enable the validation layer (default in debug builds)\n"
+              << "\t--no-validation       disable the validation layer (default in release builds)\n"
+              << "\t--debug-severity LIST comma separated verbose,info,warning,error (default warning,error)\n"
+              << "\t--debug-types LIST    comma separated general,validation,performance (default all)\n"
+              << "\t--debug-log-sync      print messages straight from the callback, no dedup or rate limit\n"
+              << "\t--debug-repeats N     print each message ID at most N times (default 3)\n"
+              << "\t--debug-rate N        print at most N messages per second (default 100)\n"
+              << "\t--validation-frames N mute the messenger after N frames; SIGUSR1 re-enables it for another N\n"
+              << "\t--startup-threads N   worker threads for parallel startup (default 3, 0 for serial)\n"
+              << "\t--verbose-startup     list instance layers/extensions and time every startup task\n";
+}
+
+/**
+ * @brief ORs together the bits named in a comma separated list, e.g. "warning,error".
+ */
+uint32_t parseFlagList(const std::string &list, const std::map<std::string, uint32_t> &names)
+{
+    uint32_t flags = 0;
+    std::stringstream stream(list);
+    std::string name;
+    while (std::getline(stream, name, ','))
+    {
+        auto found = names.find(name);
+        if (found == names.end())
+        {
+            throw std::runtime_error("unknown flag " + name + " in " + list);
+        }
+        flags |= found->second;
+    }
+    if (flags == 0)
+    {
+        throw std::runtime_error("empty flag list");
+    }
+    return flags;
+}
+
+AppConfig parseArguments(int argc, char **argv)
+{
+    AppConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        // every option past the flags takes exactly one value, so grab it up front and complain if it's missing.
+        auto nextValue = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--headless")
+        {
+            config.headless = true;
+        }
+        else if (arg == "--frames")
+        {
+            config.frameCount = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--dump-dir")
+        {
+            config.dumpDirectory = nextValue();
+        }
+        else if (arg == "--dump-shm")
+        {
+            config.dumpSharedMemory = nextValue();
+        }
+        else if (arg == "--frames-in-flight")
+        {
+            config.framesInFlight = static_cast<uint32_t>(std::stoul(nextValue()));
+            if (config.framesInFlight == 0)
+            {
+                throw std::runtime_error("--frames-in-flight must be at least 1");
+            }
+        }
+        else if (arg == "--present-mode")
+        {
+            std::string mode = nextValue();
+            if (mode == "mailbox")
+            {
+                config.presentPolicy = PresentPolicy::LowLatency;
+            }
+            else if (mode == "fifo")
+            {
+                config.presentPolicy = PresentPolicy::PowerSaving;
+            }
+            else if (mode == "immediate")
+            {
+                config.presentPolicy = PresentPolicy::Benchmark;
+            }
+            else
+            {
+                throw std::runtime_error("unknown present mode " + mode);
+            }
+        }
+        else if (arg == "--pacing")
+        {
+            std::string mode = nextValue();
+            if (mode == "uncapped")
+            {
+                config.pacing = PacingMode::Uncapped;
+            }
+            else if (mode == "vsync")
+            {
+                config.pacing = PacingMode::Vsync;
+            }
+            else if (mode == "fps")
+            {
+                config.pacing = PacingMode::TargetFps;
+            }
+            else if (mode == "present-wait")
+            {
+                config.pacing = PacingMode::PresentWait;
+            }
+            else
+            {
+                throw std::runtime_error("unknown pacing mode " + mode);
+            }
+        }
+        else if (arg == "--target-fps")
+        {
+            config.targetFps = std::stod(nextValue());
+        }
+        else if (arg == "--no-idle-wait")
+        {
+            config.idleWait = false;
+        }
+        else if (arg == "--pause-unfocused")
+        {
+            config.pauseUnfocused = true;
+        }
+        else if (arg == "--pipeline-cache")
+        {
+            config.pipelineCachePath = nextValue();
+        }
+        else if (arg == "--bench-pipeline-cache")
+        {
+            config.pipelineCacheBenchIterations = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--device-cache")
+        {
+            config.deviceCachePath = nextValue();
+        }
+        else if (arg == "--scoring")
+        {
+            config.scoringPolicyPath = nextValue();
+        }
+        else if (arg == "--bench-devices")
+        {
+            config.benchmarkDevices = true;
+        }
+        else if (arg == "--device")
+        {
+            config.deviceRank = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--multi-gpu")
+        {
+            config.multiGpu = true;
+        }
+        else if (arg == "--device-replicas")
+        {
+            config.deviceReplicas = static_cast<uint32_t>(std::stoul(nextValue()));
+            if (config.deviceReplicas == 0)
+            {
+                throw std::runtime_error("--device-replicas must be at least 1");
+            }
+        }
+        else if (arg == "--draws")
+        {
+            config.drawCount = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--scene-objects")
+        {
+            config.sceneObjects = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--mesh")
+        {
+            config.meshPath = nextValue();
+        }
+        else if (arg == "--mesh-budget-mb")
+        {
+            config.meshBudgetMiB = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--instances")
+        {
+            config.instances = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--instance-threads")
+        {
+            config.instanceThreads = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--gpu-cull")
+        {
+            config.gpuCull = true;
+        }
+        else if (arg == "--cull-workgroup")
+        {
+            config.cullWorkgroupSize = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--no-view-cull")
+        {
+            config.viewCull = false;
+        }
+        else if (arg == "--record-threads")
+        {
+            config.recordThreads = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--bench-record")
+        {
+            config.recordBenchFrames = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--upload-ring-mb")
+        {
+            config.uploadRingMiB = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--stream-test-mb")
+        {
+            config.streamTestMiB = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--render-graph")
+        {
+            config.renderGraph = true;
+        }
+        else if (arg == "--no-aliasing")
+        {
+            config.graphAliasing = false;
+        }
+        else if (arg == "--no-bindless")
+        {
+            config.bindless = false;
+        }
+        else if (arg == "--profile")
+        {
+            config.profile = true;
+        }
+        else if (arg == "--trace")
+        {
+            config.tracePath = nextValue();
+            config.profile = true;
+        }
+        else if (arg == "--validation")
+        {
+            config.validation = true;
+        }
+        else if (arg == "--no-validation")
+        {
+            config.validation = false;
+        }
+        else if (arg == "--debug-severity")
+        {
+            config.debugLog.severities = parseFlagList(nextValue(), {{"verbose", VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT},
+                                                                     {"info", VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT},
+                                                                     {"warning", VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT},
+                                                                     {"error", VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT}});
+        }
+        else if (arg == "--debug-types")
+        {
+            config.debugLog.types = parseFlagList(nextValue(), {{"general", VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT},
+                                                                {"validation", VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT},
+                                                                {"performance", VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT}});
+        }
+        else if (arg == "--debug-log-sync")
+        {
+            config.debugLog.synchronous = true;
+        }
+        else if (arg == "--debug-repeats")
+        {
+            config.debugLog.repeatsPerId = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--debug-rate")
+        {
+            config.debugLog.linesPerSecond = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--validation-frames")
+        {
+            config.validationFrames = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--startup-threads")
+        {
+            config.startupThreads = static_cast<uint32_t>(std::stoul(nextValue()));
+        }
+        else if (arg == "--verbose-startup")
+        {
+            config.verboseStartup = true;
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            printUsage(argv[0]);
+            std::exit(EXIT_SUCCESS);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+
+    if (config.headless && config.frameCount == 0)
+    {
+        config.frameCount = 300;
+    }
+    if (config.multiGpu && !config.headless)
+    {
+        throw std::runtime_error("--multi-gpu renders offscreen batches and needs --headless");
+    }
+    if (config.renderGraph && !config.headless)
+    {
+        throw std::runtime_error("--render-graph composites into the offscreen image and needs --headless");
+    }
+    if (config.renderGraph && (config.gpuCull || config.recordThreads > 0 || config.recordBenchFrames > 0))
+    {
+        // those record against the single-attachment createRenderPass() pass, which the graph's scene pass (color + depth) isn't compatible with.
+        throw std::runtime_error("--render-graph records its scene pass inline; it can't be combined with --gpu-cull, --record-threads or --bench-record");
+    }
+    if (!config.meshPath.empty() && (config.sceneObjects > 0 || config.gpuCull || config.renderGraph || config.recordThreads > 0 || config.recordBenchFrames > 0))
+    {
+        // the mesh has its own draw list, built every frame from whatever chunks are resident; none of those know about it.
+        throw std::runtime_error("--mesh can't be combined with --scene-objects, --gpu-cull, --render-graph, --record-threads or --bench-record");
+    }
+    if (config.instances > 0 && (config.sceneObjects > 0 || !config.meshPath.empty() || config.gpuCull || config.renderGraph || config.recordThreads > 0 || config.recordBenchFrames > 0))
+    {
+        // the instanced draw replaces the draw list outright, and records inline with its own pipeline.
+        throw std::runtime_error("--instances can't be combined with --scene-objects, --mesh, --gpu-cull, --render-graph, --record-threads or --bench-record");
+    }
+    if (config.cullWorkgroupSize == 0)
+    {
+        throw std::runtime_error("--cull-workgroup needs at least one thread");
+    }
+    if (config.pacing == PacingMode::TargetFps && config.targetFps <= 0.0)
+    {
+        throw std::runtime_error("--pacing fps needs a positive --target-fps");
+    }
+    if (config.targetFps > 0.0 && config.pacing != PacingMode::TargetFps)
+    {
+        throw std::runtime_error("--target-fps only applies to --pacing fps");
+    }
+    if (config.headless && (config.pacing == PacingMode::Vsync || config.pacing == PacingMode::PresentWait))
+    {
+        // nothing is presented headless, so there's no display to lock to; --pacing fps still works.
+        throw std::runtime_error("--pacing vsync and present-wait need a swapchain; use --pacing fps with --headless");
+    }
+    if (config.pauseUnfocused && !config.idleWait)
+    {
+        throw std::runtime_error("--pause-unfocused waits on window events and can't be combined with --no-idle-wait");
+    }
+    if (config.multiGpu && !config.dumpSharedMemory.empty())
+    {
+        // one segment, several unsynchronized publishers.
+        throw std::runtime_error("--multi-gpu can't publish to --dump-shm; use --dump-dir");
+    }
+    return config;
+}
+
+static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
+    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+    VkDebugUtilsMessageTypeFlagsEXT messageType,
+    const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData,
+    void *pUserData)
+{
+    // pUserData is the app's DebugLog; all the callback does is hand the message over so the thread that hit it gets back to work.
+    static_cast<DebugLog *>(pUserData)->submit(messageSeverity, messageType, pCallbackData);
+    return VK_FALSE;
+}
+
+VkResult createDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDebugUtilsMessengerEXT *pDebugMessenger)
+{
+    auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+    if (func != nullptr)
+    {
+        return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
+    }
+    else
+    {
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+    }
+}
+
+// the matching destroy lives in DebugMessengerHandleTraits, see VulkanHandle.hpp.
+
+class HelloTriangleApplication
+{
+public:
+    explicit HelloTriangleApplication(const AppConfig &config) : config(config) {}
+
+    /**
+     * @brief after cleanup() there's nothing left to do. If something threw instead, the device is still up and may have work in flight, so wait for it and drain the deletion queue before the UniqueHandle, UniqueAllocation and helper members start destroying things.
+     */
+    ~HelloTriangleApplication()
+    {
+        if (logicalDevice != VK_NULL_HANDLE)
+        {
+            vkDeviceWaitIdle(logicalDevice);
+            deletionQueue.flush();
+        }
+    }
+
+    void run()
+    {
+        initialize();
+        mainLoop();
+        cleanup();
+    }
+
+    /**
+     * @brief first half of run() for --multi-gpu workers, so the caller can learn how many devices there are before starting the rest.
+     */
+    void init()
+    {
+        initialize();
+    }
+
+    /**
+     * @brief second half of run() for --multi-gpu workers: renders whatever chunks of the batch the scheduler hands this worker, then tears down.
+     */
+    void renderShard(FrameScheduler &scheduler, uint32_t worker)
+    {
+        scheduler.setWorkerName(worker, physicalDeviceProperties.deviceName);
+        shardLoop(scheduler, worker);
+        cleanup();
+    }
+
+    /**
+     * @return how many devices passed DeviceSelector::rate() during init().
+     */
+    uint32_t suitableDeviceCount() const
+    {
+        return suitableDevices;
+    }
+
+private:
+    AppConfig config;
+    GLFWwindow *window = nullptr;
+    // where debugCallback() sends messages; started before the instance exists so instance creation messages land in it too. Declared before the instance and messenger so it also outlives them when unwinding: they can still call back into it while being destroyed.
+    DebugLog debugLog;
+    // Vulkan objects are held in UniqueHandles declared parents first, so if init throws they're torn down child to parent as the app unwinds; cleanup() does the same thing explicitly.
+    UniqueInstance instance;
+    // VK_NULL_HANDLE whenever the messenger is muted (see updateValidationWindow()).
+    UniqueDebugMessenger debugMessenger;
+    // frame at which --validation-frames mutes the messenger again.
+    uint32_t validationUntilFrame = 0;
+    // last validationRequests value this app acted on.
+    uint32_t seenValidationRequests = 0;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties physicalDeviceProperties;
+    // weights DeviceSelector::rate() ranks devices by.
+    ScoringPolicy scoringPolicy;
+    // devices that scored above 0 in pickPhysicalDevice(); config.deviceRank indexes into them.
+    uint32_t suitableDevices = 0;
+    // added to local frame numbers to get the batch frame a --multi-gpu shard is rendering; always 0 otherwise.
+    uint32_t outputFrameOffset = 0;
+    // layers and instance extensions, enumerated once at the top of createInstance().
+    InstanceCapabilities instanceCapabilities;
+    /**
+     * Snapshot of the chosen device's properties, features, memory, queue families and extensions; see DeviceCapabilities.hpp. Selection and creation both read from this instead of asking the driver again.
+     */
+    DeviceCapabilities deviceCapabilities;
+    DeviceCapabilityCache deviceCapabilityCache;
+    UniqueDevice logicalDevice;
+    /**
+     * Sub-allocates buffers and images out of a few big VkDeviceMemory blocks; see DeviceAllocator.hpp. Everything except the swapchain (which owns its own memory) should go through this rather than vkAllocateMemory.
+     */
+    DeviceAllocator deviceAllocator;
+    // child handles and allocations retired mid-run, destroyed once the frames that might use them have finished; see DeletionQueue.hpp. After the allocator, since it can hold allocations.
+    DeletionQueue deletionQueue;
+    // required + whichever optional device extensions the chosen device actually supports.
+    std::set<std::string> enabledDeviceExtensions;
+    /**
+     * A queue in Vulkan is a literal queue of commands; we send command buffers to them, and each queue in each queue family is ordered. The queue family we're interested in is just graphics, so the idea is to have command queues per GPU hardware capability e.g. graphics, compute, codec ops etc. See https://registry.khronos.org/vulkan/specs/latest/man/html/VkQueueFlagBits.html for the full list of queue family cap bits.
+     */
+    VkQueue graphicsQueue;
+    /**
+     * The present Q accepts surface presentation commands. For some reason it must be searched for with a dedicated function vkGetPhysicalDeviceSurfaceSupportKHR() instead of just looking for a Q id bit like we did above. Something something abstracting the Vulkan graphics api so it can serve any purpose for some reason, the api to end all apis, even for non-graphics utility? smdh, Khronos.
+     */
+    VkQueue presentQueue = VK_NULL_HANDLE;
+    /**
+     * Async compute and streaming transfer queues. When the device has no dedicated family for them these alias graphicsQueue, so callers can always submit to them; check queueFamilies before paying for ownership transfers that aren't needed.
+     */
+    VkQueue computeQueue = VK_NULL_HANDLE;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    // VK_KHR_timeline_semaphore extension present *and* its feature turned on.
+    bool timelineSemaphoresEnabled = false;
+    // instance has VK_KHR_get_physical_device_properties2, which we need to ask a 1.0 device about extension features.
+    bool physicalDeviceProperties2Enabled = false;
+    // VK_KHR_present_id + VK_KHR_present_wait, extensions and features; presents are tagged with IDs we can wait on.
+    bool presentWaitEnabled = false;
+    PFN_vkWaitForPresentKHR waitForPresent = nullptr;
+    // ID for the next present; IDs only have to increase per swapchain, so this just keeps counting across recreations.
+    uint64_t nextPresentId = 1;
+    // ID of the last present to the current swapchain, 0 when there hasn't been one yet.
+    uint64_t lastPresentId = 0;
+    /**
+     * Stays VK_NULL_HANDLE in headless mode; everything that talks to the surface has to check for that.
+     */
+    UniqueSurface surface;
+
+    /**
+     * Everything one in-flight frame owns. With N slots the CPU can be recording frame N+1 while the GPU still works on frames N, N-1, ...; a slot only gets reused after its fence says the GPU is done with it.
+     */
+    struct FrameSlot
+    {
+        // everything a slot owns is held in UniqueHandles/UniqueAllocations, so a slot destroys itself; members are declared parents first, since they're destroyed in reverse.
+        UniqueCommandPool commandPool;
+        // freed with the pool.
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        // signaled when the presentation engine hands us an image to render into. The matching render-finished semaphore lives with the swapchain image instead (see swapChainRenderFinishedSemaphores), since present doesn't signal anything we could use to know when it's safe to reuse a per-slot one.
+        UniqueSemaphore imageAvailableSemaphore;
+        UniqueFence inFlightFence;
+        /**
+         * Headless render target: a plain device-local color image we render into, plus a host-visible buffer we copy it to so frames can be dumped. Stand-in for the swapchain when there's no window to present to. One per slot so frames in flight never fight over the same image.
+         */
+        UniqueImage offscreenImage;
+        UniqueAllocation offscreenImageMemory;
+        UniqueBuffer readbackBuffer;
+        // persistently mapped; readbackMemory->mapped is where the frame lands.
+        UniqueAllocation readbackMemory;
+        UniqueImageView offscreenImageView;
+        UniqueFramebuffer offscreenFramebuffer;
+        // frame number submitted from this slot whose output hasn't been consumed yet.
+        std::optional<uint32_t> pendingFrame;
+        // --instances: one mat4 per instance, persistently mapped and rewritten by InstanceTransforms every frame this slot records; per slot so the update never races the GPU reading a frame in flight.
+        UniqueBuffer instanceBuffer;
+        UniqueAllocation instanceMemory;
+        /**
+         * One pool + secondary command buffer per recording worker. Command pools are externally synchronized, so giving each worker its own is what lets them record in parallel without locking; and one per slot means a worker never resets a pool the GPU may still be reading from.
+         */
+        struct WorkerCommands
+        {
+            UniqueCommandPool commandPool;
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        };
+        std::vector<WorkerCommands> workerCommands;
+    };
+    std::vector<FrameSlot> frameSlots;
+    uint32_t currentFrameSlot = 0;
+
+    /**
+     * Push constants for one draw; layout must match DrawParams in shaders/triangle.vert.
+     */
+    struct DrawPushConstants
+    {
+        float offset[2];
+        float scale;
+        float shade;
+        // descriptor heap indices; 0 is the default white texture / identity tint.
+        uint32_t textureIndex;
+        uint32_t paletteIndex;
+    };
+    // what every frame draws; stands in for a real scene's draw list.
+    std::vector<DrawPushConstants> drawList;
+    // view center in world units; only moves for --scene-objects and --mesh, where it pans across a world bigger than the view.
+    float camera[2] = {0.0f, 0.0f};
+    // --mesh: the mapped file, and which of its chunks are on the GPU.
+    MeshAsset meshAsset;
+    MeshStreamer meshStreamer;
+
+    /**
+     * --gpu-cull: drawList mirrored into a device-local CullObject array, which the cull pass reads and triangle_indirect.vert fetches placement from. The vertex shader reaches it through the descriptor heap.
+     */
+    GpuCuller gpuCuller;
+    std::vector<CullObject> cullObjects;
+    UniqueBuffer objectBuffer;
+    UniqueAllocation objectBufferMemory;
+    uint32_t objectBufferIndex = 0;
+    uint64_t objectTicket = 0;
+    UniqueShaderModule cullShaderModule;
+    ShaderReflection cullReflection;
+    UniqueShaderModule indirectVertShaderModule;
+    UniquePipeline indirectPipeline;
+    // objects that survived the GPU cull, read back per frame.
+    SampleStats visibleObjectStats;
+
+    /**
+     * Push constants for the indirect pipeline; layout must match IndirectParams in shaders/triangle_indirect.vert. Shares the pipeline layout (and its push constant range) with DrawPushConstants.
+     */
+    struct IndirectPushConstants
+    {
+        float camera[2];
+        uint32_t objectBufferIndex;
+    };
+    // null when recording inline (config.recordThreads == 0).
+    std::unique_ptr<WorkerPool> recordWorkers;
+
+    /**
+     * --instances: SoA transform state, stepped every frame straight into the frame slot's instance buffer, and the pipeline reading that buffer as a per-instance vertex binding.
+     */
+    InstanceTransforms instanceTransforms;
+    // null when updating inline (config.instanceThreads == 0).
+    std::unique_ptr<WorkerPool> instanceWorkers;
+    UniqueShaderModule instancedVertShaderModule;
+    UniquePipeline instancedPipeline;
+    // wall time of each frame's transform update.
+    SampleStats instanceUpdateStats;
+
+    /**
+     * Push constants for the instanced pipeline; layout must match InstancedParams in shaders/triangle_instanced.vert.
+     */
+    struct InstancedPushConstants
+    {
+        float camera[2];
+    };
+
+    // --render-graph: the multi-pass sample built in createRenderGraph(). graphOutput is the frame slot's offscreen image, re-imported every frame.
+    RenderGraph renderGraph;
+    RenderGraph::ResourceId graphOutput = 0;
+    RenderGraph::ResourceId graphSceneColor = 0;
+
+    // timestamp queries + CPU scopes; a no-op unless --profile/--trace.
+    GpuProfiler profiler;
+
+    // staging ring feeding the transfer queue; see UploadRing.hpp.
+    UploadRing uploadRing;
+    UniqueBuffer vertexBuffer;
+    UniqueAllocation vertexBufferMemory;
+    UniqueBuffer indexBuffer;
+    UniqueAllocation indexBufferMemory;
+    // draws are skipped until the upload ring says the geometry has arrived.
+    uint64_t geometryTicket = 0;
+
+    // every texture and storage buffer the shaders read, addressed by index; see DescriptorHeap.hpp.
+    DescriptorHeap descriptorHeap;
+    uint32_t instanceApiVersion = VK_API_VERSION_1_0;
+    // instance and device are both 1.2+, so 1.2 features are chained through VkPhysicalDeviceVulkan12Features.
+    bool vulkan12Enabled = false;
+    // descriptor heap runs in update-after-bind mode; otherwise it's the 1.0 fallback.
+    bool bindlessEnabled = false;
+    // heap array sizes after clamping to device limits; also fed to the fragment shader as specialization constants.
+    uint32_t heapTextureCapacity = 1;
+    uint32_t heapBufferCapacity = 1;
+    /**
+     * What the draw list samples through the heap: a white 1x1 texture and identity tint in slot 0, plus a checkerboard and a warm tint for draws to alternate between.
+     */
+    struct MaterialTexture
+    {
+        UniqueImage image;
+        UniqueAllocation memory;
+        UniqueImageView view;
+    };
+    struct MaterialPalette
+    {
+        UniqueBuffer buffer;
+        UniqueAllocation memory;
+    };
+    std::vector<MaterialTexture> materialTextures;
+    std::vector<MaterialPalette> materialPalettes;
+    // source bytes for material uploads, kept until shutdown since the ring reads them whenever it gets around to it.
+    std::vector<std::vector<uint8_t>> materialUploadData;
+    UniqueSampler materialSampler;
+    uint32_t checkerTextureIndex = 0;
+    uint32_t warmPaletteIndex = 0;
+    uint64_t materialTicket = 0;
+    /**
+     * --stream-test-mb: a big blob of junk streamed into a device-local buffer nobody reads, purely to see how the ring copes with assets larger than a region.
+     */
+    std::vector<uint8_t> streamTestData;
+    UniqueBuffer streamTestBuffer;
+    UniqueAllocation streamTestMemory;
+    uint64_t streamTestTicket = 0;
+
+    UniqueSwapchain swapChain;
+    std::vector<VkImage> swapChainImages;
+    std::vector<UniqueImageView> swapChainImageViews;
+    std::vector<UniqueFramebuffer> swapChainFramebuffers;
+    // indexed by swapchain image; a semaphore is only reused once its image has been acquired again, which implies the previous present's wait on it is done.
+    std::vector<UniqueSemaphore> swapChainRenderFinishedSemaphores;
+    VkFormat swapChainImageFormat;
+    VkExtent2D swapChainExtent;
+    bool framebufferResized = false;
+    uint32_t swapChainRecreations = 0;
+
+    UniqueRenderPass renderPass;
+    UniqueShaderModule vertShaderModule;
+    UniqueShaderModule fragShaderModule;
+    UniquePipelineLayout pipelineLayout;
+    // largest push constant block of the vertex shaders in use, from reflectShaders().
+    uint32_t pushConstantSize = 0;
+    UniquePipeline graphicsPipeline;
+    PipelineCache pipelineCache;
+    const VkFormat offscreenFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    std::unique_ptr<SharedMemoryFrameSink> sharedMemorySink;
+    // time the CPU spent blocked on a slot's fence at the top of each frame; near zero means we never lapped the GPU.
+    SampleStats fenceWaitStats;
+    // time blocked in vkAcquireNextImageKHR; this is where FIFO throttles us to the display rate.
+    SampleStats acquireWaitStats;
+    // total CPU time per drawFrame(), wait included.
+    SampleStats cpuFrameStats;
+    // --pacing: decides when mainLoop() starts the next frame.
+    FramePacer pacer;
+    // input → submit → on screen, fed by the GLFW input callbacks and present IDs.
+    LatencyTracker latency;
+    // when initialize() started, for time to first frame.
+    std::chrono::steady_clock::time_point launchTime;
+
+private:
+    // what createLogicalDevice() settled on for the chosen device.
+    QueueFamilyIndices queueFamilies;
+
+    /**
+     * @brief the part of window setup the instance waits on, for glfwGetRequiredInstanceExtensions(). Main thread only, like createWindow(). Never called in headless mode, which has no GLFW at all so we don't need an X server (or anything else) lying around.
+     */
+    void initGlfw()
+    {
+        if (glfwInit() != GLFW_TRUE)
+        {
+            throw std::runtime_error("failed to initialize GLFW!");
+        }
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    }
+
+    void createWindow()
+    {
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Vulkan Triangle", nullptr, nullptr);
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+        // input only feeds the latency numbers; nothing reacts to it yet.
+        glfwSetKeyCallback(window, keyCallback);
+        glfwSetMouseButtonCallback(window, mouseButtonCallback);
+        glfwSetCursorPosCallback(window, cursorPositionCallback);
+        glfwSetScrollCallback(window, scrollCallback);
+    }
+
+    void createInstance()
+    {
+        if (config.validation)
+        {
+            debugLog.start(config.debugLog);
+        }
+        // one trip to the loader for everything the layer/extension checks below (and getRequiredExtensions()) need to know.
+        instanceCapabilities = InstanceCapabilities::query();
+
+        // I'm having a disagreement with the tutorial on how best to handle the C/C++ interop since Vulkan is a C API but our program is C++... well anyway, it's easier to build up wrappers around pure data than to decompose wrappers into the appropriate data, so let's go with cstring constant and then build a wrapper of wrappers from that why not. Technically we're creating an opportunity for a disconnect between what layers we check for and what we actually request, but I don't wanna use strcmp and friends in the analysis. I don't wanna!
+        std::vector<std::string> validationLayerStrings;
+        for (auto cstring : validationLayers)
+        {
+            validationLayerStrings.emplace_back(std::string(cstring));
+        }
+
+        if (config.validation && !checkValidationLayerSupport(validationLayerStrings))
+        {
+            throw std::runtime_error("some desired validation layers are not available!");
+        }
+
+        VkApplicationInfo appInfo{};
+        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        appInfo.pApplicationName = "Triangular Sandboxing";
+        appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+        appInfo.pEngineName = "No Engine";
+        appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+        instanceApiVersion = chooseInstanceApiVersion();
+        appInfo.apiVersion = instanceApiVersion;
+
+        VkInstanceCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        createInfo.pApplicationInfo = &appInfo;
+
+        // figure out how many and which vk extensions GLFW requires.
+        auto extensions = getRequiredExtensions();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
+
+        // debug message struct fella has to live outside the val condition because it will be referenced by creatinfo and that will be used by the call to vkCreateInstance()
+        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
+        if (config.validation)
+        {
+            createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+            createInfo.ppEnabledLayerNames = validationLayers.data();
+            populateDebugMessengerCreateInfo(debugCreateInfo);
+            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT *)&debugCreateInfo;
+        }
+        else
+        {
+            createInfo.enabledLayerCount = 0;
+            createInfo.pNext = nullptr;
+        }
+
+        if (!checkInstanceExtensions(std::vector<std::string>(extensions.data(), extensions.data() + extensions.size())))
+        {
+            throw std::runtime_error("failed to create triangly vkinstance due to unsupported extensions");
+        }
+
+        VkInstance createdInstance;
+        if (vkCreateInstance(&createInfo, nullptr, &createdInstance) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create triangly vkinstance");
+        }
+        instance = UniqueInstance(createdInstance);
+    }
+
+    /**
+     * @return 1.2 when the loader knows it, otherwise the newest version it does know. A 1.0 loader has no vkEnumerateInstanceVersion and rejects any other apiVersion outright.
+     */
+    uint32_t chooseInstanceApiVersion()
+    {
+        auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+        uint32_t loaderVersion = VK_API_VERSION_1_0;
+        if (enumerateInstanceVersion != nullptr)
+        {
+            enumerateInstanceVersion(&loaderVersion);
+        }
+        return std::min(loaderVersion, static_cast<uint32_t>(VK_API_VERSION_1_2));
+    }
+
+    /**
+     * @return the set of extension names we need to support GLFW and optionally debugging in debug builds.
+     */
+    std::vector<const char *> getRequiredExtensions()
+    {
+        std::vector<const char *> extensions;
+        if (!config.headless)
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char **glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
+
+        if (config.validation)
+        {
+            extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+        // optional: lets us query extension feature structs (e.g. timeline semaphores) on a 1.0 instance.
+        physicalDeviceProperties2Enabled = instanceSupportsExtension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        if (physicalDeviceProperties2Enabled)
+        {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        }
+
+        return extensions;
+    }
+
+    bool instanceSupportsExtension(const char *name)
+    {
+        return instanceCapabilities.hasExtension(name);
+    }
+
+    /**
+     * @brief checks if the input validation layers are supported by the driver. Only missing layers are reported unless --verbose-startup asks for the full listing.
+     * @input reference to a string vector of desired validation layers.
+     * @return true if all desired layers are supported; false otherwise.
+     */
+    bool checkValidationLayerSupport(const std::vector<std::string> &desiredValidationLayers)
+    {
+        if (config.verboseStartup)
+        {
+            std::cout << "available val layers:\n";
+            for (const auto &layer : instanceCapabilities.layers)
+            {
+                std::cout << '\t' << layer << '\n';
+            }
+        }
+
+        bool allDesiredLayersAreSupported = true;
+        for (const auto &desiredLayer : desiredValidationLayers)
+        {
+            allDesiredLayersAreSupported = allDesiredLayersAreSupported && instanceCapabilities.hasLayer(desiredLayer);
+            if (allDesiredLayersAreSupported)
+            {
+                if (config.verboseStartup)
+                {
+                    std::cout << "layer " << desiredLayer << " is supported." << '\n';
+                }
+            }
+            else
+            {
+                std::cerr << "layer " << desiredLayer << " is NOT supported." << '\n';
+            }
+        }
+        return allDesiredLayersAreSupported;
+    }
+
+    /**
+     * @brief Enumerates the supported vkinstance extensions on stdout (with --verbose-startup) and checks them against the input required extension set for the top level driver/vulkan implementation interface; we'll have to check for device specific extensions separately in checkDeviceExtensions().
+     * @param reference to a vector of strings identifying the required extension names.
+     * @return true if all the required extensions are also found in the supported extensions set; false otherwise.
+     */
+    bool checkInstanceExtensions(const std::vector<std::string> &requiredExtensions)
+    {
+        // check which vk extensions the driver supports against our requirements; the enumeration already happened once in InstanceCapabilities::query().
+        if (config.verboseStartup)
+        {
+            std::cout << "available extensions:\n";
+            for (const auto &extension : instanceCapabilities.extensions)
+            {
+                std::cout << '\t' << extension << '\n';
+            }
+        }
+
+        bool allRequiredExtensionsAreSupported = true;
+        for (const auto &requiredExtension : requiredExtensions)
+        {
+            allRequiredExtensionsAreSupported = allRequiredExtensionsAreSupported && instanceCapabilities.hasExtension(requiredExtension);
+            if (allRequiredExtensionsAreSupported)
+            {
+                if (config.verboseStartup)
+                {
+                    std::cout << "extension " << requiredExtension << " is supported." << '\n';
+                }
+            }
+            else
+            {
+                std::cerr << "extension " << requiredExtension << " is NOT supported." << '\n';
+            }
+        }
+        return allRequiredExtensionsAreSupported;
+    }
+
+    /**
+     * @return the device extensions we can't live without; swapchain drops off the list in headless mode since we never present, and --gpu-cull adds draw_indirect_count.
+     */
+    std::vector<const char *> getRequiredDeviceExtensions()
+    {
+        std::vector<const char *> required;
+        if (!config.headless)
+        {
+            required = deviceExtensions;
+        }
+        if (config.gpuCull)
+        {
+            // core in 1.2, but the extension exists on 1.0/1.1 drivers too and asking for it by name keeps one code path.
+            required.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
+        return required;
+    }
+
+    /**
+     * @brief the selection rules for our flags and surface; cheap to make, so callers build one whenever they need it rather than keeping it in sync with the surface.
+     */
+    DeviceSelector deviceSelector()
+    {
+        DeviceRequirements requirements;
+        requirements.extensions = getRequiredDeviceExtensions();
+        requirements.present = !config.headless;
+        requirements.gpuDrivenDraws = config.gpuCull;
+        return DeviceSelector(scoringPolicy, std::move(requirements), surface);
+    }
+
+    /**
+     * @brief window and Vulkan setup as a TaskGraph, so the slow steps that don't depend on each other overlap: the instance (loader and ICD loading) comes up while GLFW makes the window, shaders get reflected, the caches and the mesh get read off disk, and the graphics pipeline (the driver's compiler) builds while frame slots and buffers get allocated. Joins are only where Vulkan or our own state needs them.
+     *
+     * Everything that allocates through deviceAllocator, the upload ring or the descriptor heap stays on one chain of tasks, since none of those are thread safe. --startup-threads 0 runs the same graph on the calling thread alone for comparison. The per-task timings print at the end; the critical path is the place to look when time to first frame regresses.
+     */
+    void initialize()
+    {
+        using TaskId = TaskGraph::TaskId;
+        launchTime = std::chrono::steady_clock::now();
+        deletionQueue.create(config.framesInFlight);
+        TaskGraph startup;
+
+        // no Vulkan needed for these, so they start right away.
+        TaskId caches = startup.add("load caches", {}, [this]()
+                                    { loadStartupCaches(); });
+        TaskId shaders = startup.add("reflect shaders", {}, [this]()
+                                     { reflectShaders(); });
+        TaskId mesh = startup.add("open mesh", {}, [this]()
+                                  { openMesh(); });
+        TaskId instances = startup.add("instances", {}, [this]()
+                                       { createInstances(); });
+
+        // GLFW wants glfwInit() and window creation on the main thread; the instance only needs glfwInit() for glfwGetRequiredInstanceExtensions(), and surface creation may happen on any thread.
+        std::vector<TaskId> instanceDependencies;
+        std::vector<TaskId> surfaceDependencies;
+        if (!config.headless)
+        {
+            TaskId glfw = startup.add("glfw init", {}, [this]()
+                                      { initGlfw(); }, TaskGraph::Affinity::Main);
+            instanceDependencies.push_back(glfw);
+            surfaceDependencies.push_back(startup.add("window", {glfw}, [this]()
+                                                      { createWindow(); }, TaskGraph::Affinity::Main));
+        }
+        TaskId instanceTask = startup.add("instance", instanceDependencies, [this]()
+                                          {
+            createInstance();
+            setupDebugMessenger();
+            // the first --validation-frames window starts now; only signals from here on count as requests for another.
+            validationUntilFrame = config.validationFrames;
+            seenValidationRequests = validationRequests.load(); });
+        surfaceDependencies.push_back(instanceTask);
+        TaskId surfaceTask = startup.add("surface", surfaceDependencies, [this]()
+                                         { createSurface(); });
+        // Physical device represents the actual hardware capabilities available for Vulkan
+        TaskId pick = startup.add("pick device", {surfaceTask, caches}, [this]()
+                                  { pickPhysicalDevice(); });
+        // Logical device is how we interace with the physical device; there can be many logical devices interfacing with one physical device and they maintain independent states
+        TaskId device = startup.add("logical device", {pick}, [this]()
+                                    { createLogicalDevice(); });
+        TaskId cache = startup.add("pipeline cache", {device}, [this]()
+                                   { pipelineCache.create(logicalDevice, physicalDeviceProperties, config.pipelineCachePath); });
+        TaskId heap = startup.add("descriptor heap", {device}, [this]()
+                                  { descriptorHeap.create(logicalDevice, bindlessEnabled, config.framesInFlight, heapTextureCapacity, heapBufferCapacity); });
+        TaskId pass = startup.add("swapchain + render pass", {device}, [this]()
+                                  {
+            if (!config.headless)
+            {
+                createSwapChain(VK_NULL_HANDLE);
+            }
+            createRenderPass(); });
+        TaskId layout = startup.add("pipeline layout", {heap, shaders}, [this]()
+                                    { createPipelineLayout(); });
+
+        // the allocation chain: every task from here to the draw list allocates, so each one waits for the last.
+        TaskId allocations = pass;
+        std::vector<TaskId> pipelineDependencies{pass, layout, cache};
+        if (config.renderGraph)
+        {
+            // before the pipeline, which is built against the graph's scene pass.
+            allocations = startup.add("render graph", {allocations}, [this]()
+                                      { createRenderGraph(); });
+            pipelineDependencies.push_back(allocations);
+        }
+        TaskId pipeline = startup.add("graphics pipeline", pipelineDependencies, [this]()
+                                      {
+            createGraphicsPipeline();
+            if (config.pipelineCacheBenchIterations > 0)
+            {
+                benchmarkPipelineCache(config.pipelineCacheBenchIterations);
+            } });
+        allocations = startup.add("frame slots", {allocations, heap}, [this]()
+                                  {
+            if (!config.headless)
+            {
+                createSwapChainFramebuffers();
+            }
+            createFrameSlots(); });
+        allocations = startup.add("geometry", {allocations, mesh}, [this]()
+                                  {
+            uploadRing.create(logicalDevice, deviceAllocator, transferQueueFamily(), transferQueue, queueFamilies.graphicsFamily.value(),
+                              static_cast<VkDeviceSize>(config.uploadRingMiB) * 1024 * 1024, config.framesInFlight, timelineSemaphoresEnabled, vulkan12Enabled,
+                              physicalDeviceProperties.limits.optimalBufferCopyOffsetAlignment);
+            createGeometryBuffers();
+            if (meshAsset.isOpen())
+            {
+                meshStreamer.create(logicalDevice, deviceAllocator, uploadRing, deletionQueue, meshAsset, static_cast<VkDeviceSize>(config.meshBudgetMiB) * 1024 * 1024);
+            } });
+        allocations = startup.add("materials + draw list", {allocations}, [this]()
+                                  {
+            createMaterials();
+            // after createMaterials(), which hands out the heap indices draws refer to.
+            buildDrawList(); });
+        if (config.gpuCull)
+        {
+            allocations = startup.add("cull objects", {allocations, pipeline}, [this]()
+                                      { createCullObjects(); });
+        }
+
+        // everything else has to be in place to record a frame.
+        startup.add("recording", {allocations, pipeline, instances}, [this]()
+                    {
+            if (config.recordThreads > 0)
+            {
+                recordWorkers = std::make_unique<WorkerPool>(config.recordThreads);
+            }
+            if (config.recordBenchFrames > 0)
+            {
+                benchmarkRecording(config.recordBenchFrames);
+            }
+            // after the recording benchmark, whose never-submitted frames would otherwise leave queries that never get results.
+            if (config.profile)
+            {
+                profiler.create(logicalDevice, physicalDeviceProperties.limits.timestampPeriod, graphicsTimestampValidBits(), config.framesInFlight);
+            } });
+
+        startup.run(config.startupThreads);
+        startup.printTimings(std::cout, "startup", config.verboseStartup);
+    }
+
+    /**
+     * @brief the on-disk inputs to device selection, read before there's an instance to select with.
+     */
+    void loadStartupCaches()
+    {
+        deviceCapabilityCache.load(config.deviceCachePath);
+        scoringPolicy = config.scoringPolicyPath.empty() ? ScoringPolicy{} : ScoringPolicy::load(config.scoringPolicyPath);
+        scoringPolicy.benchmark = scoringPolicy.benchmark || config.benchmarkDevices;
+    }
+
+    /**
+     * @brief maps --mesh and starts reading the chunks around the starting camera, so the first frames' uploads mostly hit the page cache.
+     */
+    void openMesh()
+    {
+        if (config.meshPath.empty())
+        {
+            return;
+        }
+        meshAsset.open(config.meshPath);
+        float camera[2];
+        cameraAt(0, camera);
+        for (uint32_t i = 0; i < meshAsset.chunkCount(); i++)
+        {
+            const MeshChunkRecord &record = meshAsset.chunk(i);
+            float reach = 1.0f + record.radius + MESH_PREFETCH_MARGIN;
+            if (std::abs(record.center[0] - camera[0]) <= reach && std::abs(record.center[1] - camera[1]) <= reach)
+            {
+                meshAsset.prefetch(i);
+            }
+        }
+        // one insertion, so it stays a whole line while startup has other tasks printing.
+        std::cout << "mesh: " + config.meshPath + ", " + std::to_string(meshAsset.chunkCount()) + " chunk(s)\n";
+    }
+
+    /**
+     * @brief seeds --instances over the view, sized so the population roughly tiles it whatever the count, and starts the workers that update them.
+     */
+    void createInstances()
+    {
+        if (config.instances == 0)
+        {
+            return;
+        }
+        float scale = std::clamp(1.5f / std::sqrt(static_cast<float>(config.instances)), 0.002f, 0.25f);
+        instanceTransforms.create(config.instances, 1.0f, scale, 1234);
+        if (config.instanceThreads > 0)
+        {
+            instanceWorkers = std::make_unique<WorkerPool>(config.instanceThreads);
+        }
+    }
+
+    /**
+     * @return how many bits of a timestamp written on the graphics queue are meaningful; 0 means the queue can't do timestamps at all.
+     */
+    uint32_t graphicsTimestampValidBits()
+    {
+        return deviceCapabilities.queueFamilies[queueFamilies.graphicsFamily.value()].timestampValidBits;
+    }
+
+    void createSurface()
+    {
+        if (config.headless)
+        {
+            // offscreen image stands in for the surface + swapchain, see createOffscreenTarget().
+            return;
+        }
+        VkSurfaceKHR createdSurface;
+        if (glfwCreateWindowSurface(instance, window, nullptr, &createdSurface) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create window surface!");
+        }
+        surface = UniqueSurface(instance, createdSurface);
+    }
+
+    void createLogicalDevice()
+    {
+        QueueFamilyIndices indices = deviceSelector().findQueueFamilies(deviceCapabilities);
+        queueFamilies = indices;
+
+        // one queue per distinct family. Priorities are only a hint, and only between queues of the same device, but where they're honored we want frames first, async compute next and streaming uploads to soak up whatever's left.
+        std::map<uint32_t, float> familyPriorities;
+        auto requestQueue = [&](std::optional<uint32_t> family, float priority)
+        {
+            if (family.has_value())
+            {
+                float &existing = familyPriorities.emplace(family.value(), priority).first->second;
+                existing = std::max(existing, priority);
+            }
+        };
+        requestQueue(indices.graphicsFamily, 1.0f);
+        requestQueue(indices.presentFamily, 1.0f);
+        requestQueue(indices.computeFamily, 0.5f);
+        requestQueue(indices.transferFamily, 0.25f);
+
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+        for (auto &[queueFamily, priority] : familyPriorities)
+        {
+            VkDeviceQueueCreateInfo queueCreateInfo{};
+            queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueCreateInfo.queueFamilyIndex = queueFamily;
+            queueCreateInfo.queueCount = 1;
+            // points into the map, which outlives vkCreateDevice.
+            queueCreateInfo.pQueuePriorities = &priority;
+            queueCreateInfos.push_back(queueCreateInfo);
+        }
+
+        // indexing the descriptor heap's arrays with a push constant is "dynamic indexing" as far as 1.0 is concerned, which is core but still opt-in.
+        VkPhysicalDeviceFeatures deviceFeatures{};
+        deviceFeatures.shaderSampledImageArrayDynamicIndexing = deviceCapabilities.features.shaderSampledImageArrayDynamicIndexing;
+        deviceFeatures.shaderStorageBufferArrayDynamicIndexing = deviceCapabilities.features.shaderStorageBufferArrayDynamicIndexing;
+        // the GPU-driven path issues many draws per indirect call, and each one's firstInstance is how the vertex shader finds its object. DeviceSelector::rate() already turned away devices without them.
+        deviceFeatures.multiDrawIndirect = config.gpuCull;
+        deviceFeatures.drawIndirectFirstInstance = config.gpuCull;
+
+        VkDeviceCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pQueueCreateInfos = queueCreateInfos.data();
+        createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
+        createInfo.pEnabledFeatures = &deviceFeatures;
+        auto enabledExtensions = getRequiredDeviceExtensions();
+        for (const char *optional : optionalDeviceExtensions)
+        {
+            if (deviceCapabilities.hasExtension(optional))
+            {
+                enabledExtensions.push_back(optional);
+            }
+        }
+        enabledDeviceExtensions = std::set<std::string>(enabledExtensions.begin(), enabledExtensions.end());
+
+        // the extension alone isn't enough, the feature bit has to be switched on too. On 1.2 everything we want lives in VkPhysicalDeviceVulkan12Features (and chaining the old per-extension structs next to it is invalid); on a 1.0 instance the only way to even ask is through properties2.
+        vulkan12Enabled = instanceApiVersion >= VK_API_VERSION_1_2 && physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2;
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+        vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures{};
+        timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+        if (vulkan12Enabled)
+        {
+            auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2"));
+            auto getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2"));
+            VkPhysicalDeviceVulkan12Features supported{};
+            supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+            VkPhysicalDeviceFeatures2 features2{};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &supported;
+            getFeatures2(physicalDevice, &features2);
+            VkPhysicalDeviceProperties2 properties2{};
+            properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            properties2.pNext = &vulkan12Properties;
+            getProperties2(physicalDevice, &properties2);
+
+            bindlessEnabled = config.bindless && supported.descriptorBindingSampledImageUpdateAfterBind && supported.descriptorBindingStorageBufferUpdateAfterBind &&
+                              supported.descriptorBindingUpdateUnusedWhilePending && supported.descriptorBindingPartiallyBound;
+            // only switch on what the heap actually uses.
+            vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = bindlessEnabled;
+            vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = bindlessEnabled;
+            vulkan12Features.descriptorBindingUpdateUnusedWhilePending = bindlessEnabled;
+            vulkan12Features.descriptorBindingPartiallyBound = bindlessEnabled;
+            // core in 1.2, so the feature bit is all it takes; the extension isn't needed.
+            timelineSemaphoresEnabled = supported.timelineSemaphore == VK_TRUE;
+            vulkan12Features.timelineSemaphore = timelineSemaphoresEnabled;
+            // with the 1.2 struct in the chain, enabling VK_KHR_draw_indirect_count also requires its feature bit.
+            vulkan12Features.drawIndirectCount = config.gpuCull && supported.drawIndirectCount;
+            createInfo.pNext = &vulkan12Features;
+        }
+        else if (isDeviceExtensionEnabled(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) && physicalDeviceProperties2Enabled)
+        {
+            auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+            VkPhysicalDeviceFeatures2KHR features2{};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+            features2.pNext = &timelineFeatures;
+            getFeatures2(physicalDevice, &features2);
+            timelineSemaphoresEnabled = timelineFeatures.timelineSemaphore == VK_TRUE;
+        }
+        if (timelineSemaphoresEnabled && !vulkan12Enabled)
+        {
+            timelineFeatures.pNext = nullptr;
+            createInfo.pNext = &timelineFeatures;
+        }
+
+        // VK_KHR_present_id tags each present, VK_KHR_present_wait blocks until a tagged present is on screen; --pacing present-wait and the present latency numbers need both.
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        if (!config.headless && (vulkan12Enabled || physicalDeviceProperties2Enabled) &&
+            deviceCapabilities.hasExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME) && deviceCapabilities.hasExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+        {
+            auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2>(vkGetInstanceProcAddr(instance, vulkan12Enabled ? "vkGetPhysicalDeviceFeatures2" : "vkGetPhysicalDeviceFeatures2KHR"));
+            presentIdFeatures.pNext = &presentWaitFeatures;
+            VkPhysicalDeviceFeatures2 features2{};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &presentIdFeatures;
+            getFeatures2(physicalDevice, &features2);
+            presentWaitEnabled = presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+            if (presentWaitEnabled)
+            {
+                enabledExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+                enabledExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+                enabledDeviceExtensions.insert(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+                enabledDeviceExtensions.insert(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+                // in front of whatever 1.2 or timeline struct is already chained; the query left both feature bits set.
+                presentWaitFeatures.pNext = const_cast<void *>(createInfo.pNext);
+                createInfo.pNext = &presentIdFeatures;
+            }
+        }
+        computeHeapCapacities(bindlessEnabled ? &vulkan12Properties : nullptr);
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
+
+        if (config.validation)
+        {
+            createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+            createInfo.ppEnabledLayerNames = validationLayers.data();
+        }
+        else
+        {
+            createInfo.enabledLayerCount = 0;
+        }
+
+        VkDevice createdDevice;
+        if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &createdDevice) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create logical device!");
+        }
+        logicalDevice = UniqueDevice(createdDevice);
+        vkGetDeviceQueue(logicalDevice, indices.graphicsFamily.value(), 0, &graphicsQueue);
+        if (indices.presentFamily.has_value())
+        {
+            vkGetDeviceQueue(logicalDevice, indices.presentFamily.value(), 0, &presentQueue);
+        }
+        vkGetDeviceQueue(logicalDevice, computeQueueFamily(), 0, &computeQueue);
+        vkGetDeviceQueue(logicalDevice, transferQueueFamily(), 0, &transferQueue);
+        if (presentWaitEnabled)
+        {
+            waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(logicalDevice, "vkWaitForPresentKHR"));
+        }
+        if (config.pacing == PacingMode::PresentWait && !presentWaitEnabled)
+        {
+            // before createSwapChain(), so the fallback gets its FIFO swapchain.
+            std::cout << "pacing: device lacks VK_KHR_present_id/VK_KHR_present_wait, falling back to vsync\n";
+            config.pacing = PacingMode::Vsync;
+        }
+        pacer.configure(config.pacing, config.targetFps);
+        std::cout << "queues: graphics family " << indices.graphicsFamily.value()
+                  << ", compute family " << computeQueueFamily() << (indices.computeFamily.has_value() ? " (dedicated)" : " (shared)")
+                  << ", transfer family " << transferQueueFamily() << (indices.transferFamily.has_value() ? " (dedicated)" : " (shared)")
+                  << ", timeline semaphores " << (timelineSemaphoresEnabled ? "on" : "off") << '\n';
+        std::cout << "api: instance " << VK_API_VERSION_MAJOR(instanceApiVersion) << '.' << VK_API_VERSION_MINOR(instanceApiVersion)
+                  << ", device " << VK_API_VERSION_MAJOR(physicalDeviceProperties.apiVersion) << '.' << VK_API_VERSION_MINOR(physicalDeviceProperties.apiVersion)
+                  << "; descriptor heap " << (bindlessEnabled ? "bindless" : "fallback") << ", " << heapTextureCapacity << " textures, " << heapBufferCapacity << " buffers\n";
+
+        deviceAllocator.init(DeviceMemoryBackend::forDevice(logicalDevice), deviceCapabilities.memory, physicalDeviceProperties.limits.bufferImageGranularity);
+    }
+
+    /**
+     * @brief sizes the descriptor heap to what one shader stage may bind: the update-after-bind limits on the bindless path, the plain 1.0 limits on the fallback. The fragment stage sees both arrays plus its color attachment, so they share maxPerStageResources. Without dynamic indexing the shader can only ever read element 0, so the arrays shrink to a single slot.
+     * @param vulkan12Properties null on the fallback path.
+     */
+    void computeHeapCapacities(const VkPhysicalDeviceVulkan12Properties *vulkan12Properties)
+    {
+        const VkPhysicalDeviceLimits &limits = physicalDeviceProperties.limits;
+        uint32_t textures = DESCRIPTOR_HEAP_TEXTURES;
+        uint32_t buffers = DESCRIPTOR_HEAP_BUFFERS;
+        uint32_t resources;
+        if (vulkan12Properties != nullptr)
+        {
+            textures = std::min({textures, vulkan12Properties->maxPerStageDescriptorUpdateAfterBindSamplers, vulkan12Properties->maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                 vulkan12Properties->maxDescriptorSetUpdateAfterBindSamplers, vulkan12Properties->maxDescriptorSetUpdateAfterBindSampledImages});
+            buffers = std::min({buffers, vulkan12Properties->maxPerStageDescriptorUpdateAfterBindStorageBuffers, vulkan12Properties->maxDescriptorSetUpdateAfterBindStorageBuffers});
+            resources = vulkan12Properties->maxPerStageUpdateAfterBindResources;
+        }
+        else
+        {
+            textures = std::min({textures, limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages, limits.maxDescriptorSetSamplers, limits.maxDescriptorSetSampledImages});
+            buffers = std::min({buffers, limits.maxPerStageDescriptorStorageBuffers, limits.maxDescriptorSetStorageBuffers});
+            resources = limits.maxPerStageResources;
+        }
+        if (textures + buffers + 1 > resources)
+        {
+            textures = std::min(textures, (resources - 1) / 2);
+            buffers = std::min(buffers, resources - 1 - textures);
+        }
+        if (!deviceCapabilities.features.shaderSampledImageArrayDynamicIndexing)
+        {
+            textures = 1;
+        }
+        if (!deviceCapabilities.features.shaderStorageBufferArrayDynamicIndexing)
+        {
+            buffers = 1;
+        }
+        heapTextureCapacity = std::max(textures, 1u);
+        heapBufferCapacity = std::max(buffers, 1u);
+    }
+
+    UniqueShaderModule createShaderModule(std::span<const uint32_t> code)
+    {
+        VkShaderModuleCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = code.size_bytes();
+        createInfo.pCode = code.data();
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(logicalDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shader module!");
+        }
+        return UniqueShaderModule(logicalDevice, shaderModule);
+    }
+
+    /**
+     * @brief single subpass, single color attachment render pass. The attachment is the swapchain image when windowed (ends up ready to present) or the slot's offscreen image when headless (ends up ready to be copied out).
+     */
+    void createRenderPass()
+    {
+        VkAttachmentDescription colorAttachment{};
+        colorAttachment.format = config.headless ? offscreenFormat : swapChainImageFormat;
+        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        colorAttachment.finalLayout = config.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        VkAttachmentReference colorAttachmentRef{};
+        colorAttachmentRef.attachment = 0;
+        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorAttachmentRef;
+
+        VkSubpassDependency dependencies[2]{};
+        // the layout transition at the start of the pass must wait for the image to actually be ours, i.e. for the acquire semaphore wait at COLOR_ATTACHMENT_OUTPUT.
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].srcAccessMask = 0;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        // and the headless readback copy must wait for the color writes (and the transition to TRANSFER_SRC) to land.
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 1;
+        renderPassInfo.pAttachments = &colorAttachment;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = 2;
+        renderPassInfo.pDependencies = dependencies;
+
+        VkRenderPass createdRenderPass;
+        if (vkCreateRenderPass(logicalDevice, &renderPassInfo, nullptr, &createdRenderPass) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create render pass!");
+        }
+        renderPass = UniqueRenderPass(logicalDevice, createdRenderPass);
+    }
+
+    static void requirePushConstants(const ShaderReflection &reflection, const char *shaderName, size_t expected)
+    {
+        if (reflection.pushConstantSize != expected)
+        {
+            throw std::runtime_error(std::string(shaderName) + " declares " + std::to_string(reflection.pushConstantSize) + " bytes of push constants but the app pushes " +
+                                     std::to_string(expected) + "!");
+        }
+    }
+
+    /**
+     * @brief the graphics shaders only get set 0, the descriptor heap, whose layout is hand-built for its binding flags; anything else they declare would go unbound.
+     */
+    static void requireHeapBindingsOnly(const ShaderReflection &reflection, const char *shaderName)
+    {
+        for (const auto &binding : reflection.bindings)
+        {
+            if (binding.set != 0)
+            {
+                throw std::runtime_error(std::string(shaderName) + " uses descriptor set " + std::to_string(binding.set) + ", but only the heap (set 0) is bound!");
+            }
+        }
+    }
+
+    /**
+     * @brief reflects the embedded shaders and checks them against the C++ side. Needs no device, so startup runs it while the instance and device are still coming up.
+     */
+    void reflectShaders()
+    {
+        // the push constant range comes from the shaders themselves; the C++ structs that fill it are checked against them rather than trusted.
+        ShaderReflection vertReflection = ShaderReflection::reflect(embeddedShader("triangle.vert"));
+        ShaderReflection fragReflection = ShaderReflection::reflect(embeddedShader("triangle.frag"));
+        requirePushConstants(vertReflection, "triangle.vert", sizeof(DrawPushConstants));
+        requireHeapBindingsOnly(vertReflection, "triangle.vert");
+        requireHeapBindingsOnly(fragReflection, "triangle.frag");
+        pushConstantSize = vertReflection.pushConstantSize;
+        if (config.gpuCull)
+        {
+            cullReflection = ShaderReflection::reflect(embeddedShader("cull.comp"));
+            ShaderReflection indirectReflection = ShaderReflection::reflect(embeddedShader("triangle_indirect.vert"));
+            requirePushConstants(indirectReflection, "triangle_indirect.vert", sizeof(IndirectPushConstants));
+            requireHeapBindingsOnly(indirectReflection, "triangle_indirect.vert");
+            pushConstantSize = std::max(pushConstantSize, indirectReflection.pushConstantSize);
+        }
+        if (config.instances > 0)
+        {
+            ShaderReflection instancedReflection = ShaderReflection::reflect(embeddedShader("triangle_instanced.vert"));
+            requirePushConstants(instancedReflection, "triangle_instanced.vert", sizeof(InstancedPushConstants));
+            requireHeapBindingsOnly(instancedReflection, "triangle_instanced.vert");
+            pushConstantSize = std::max(pushConstantSize, instancedReflection.pushConstantSize);
+        }
+    }
+
+    /**
+     * @brief after reflectShaders().
+     */
+    void createPipelineLayout()
+    {
+        vertShaderModule = createShaderModule(embeddedShader("triangle.vert"));
+        fragShaderModule = createShaderModule(embeddedShader("triangle.frag"));
+        if (config.gpuCull)
+        {
+            cullShaderModule = createShaderModule(embeddedShader("cull.comp"));
+            indirectVertShaderModule = createShaderModule(embeddedShader("triangle_indirect.vert"));
+        }
+        if (config.instances > 0)
+        {
+            instancedVertShaderModule = createShaderModule(embeddedShader("triangle_instanced.vert"));
+        }
+
+        // every vertex shader's block fits in one range; the fragment shader gets its heap indices as flat varyings instead.
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = pushConstantSize;
+
+        VkDescriptorSetLayout heapLayout = descriptorHeap.layout();
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &heapLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        VkPipelineLayout createdLayout;
+        if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &createdLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+        pipelineLayout = UniquePipelineLayout(logicalDevice, createdLayout);
+    }
+
+    /**
+     * @brief builds the triangle pipeline against the given cache. Split out from the init path so the cache benchmark can build the exact same pipeline over and over.
+     * @param cache pipeline cache to consult and populate; VK_NULL_HANDLE is allowed.
+     * @param feedback receives whole-pipeline creation feedback when VK_EXT_pipeline_creation_feedback is enabled; left untouched otherwise.
+     * @param vertexShader triangle.vert for per-draw push constants, triangle_indirect.vert for the GPU-driven path, triangle_instanced.vert for --instances; everything else is identical.
+     * @param perInstanceTransforms add binding 1, a mat4 per instance at locations 2-5, for triangle_instanced.vert.
+     */
+    VkPipeline buildGraphicsPipeline(VkPipelineCache cache, VkPipelineCreationFeedbackEXT *feedback, VkShaderModule vertexShader, bool perInstanceTransforms = false)
+    {
+        VkPipelineShaderStageCreateInfo shaderStages[2]{};
+        shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        shaderStages[0].module = vertexShader;
+        shaderStages[0].pName = "main";
+        shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        shaderStages[1].module = fragShaderModule;
+        shaderStages[1].pName = "main";
+        // the heap's array sizes depend on device limits, so the shaders get them as specialization constants rather than baking in a guess. Constants a stage doesn't declare are ignored.
+        SpecializationConstants heapSizes;
+        heapSizes.set(0, descriptorHeap.textureCapacity()).set(1, descriptorHeap.bufferCapacity());
+        shaderStages[0].pSpecializationInfo = heapSizes.info();
+        shaderStages[1].pSpecializationInfo = shaderStages[0].pSpecializationInfo;
+
+        // binding 0 is the geometry: one Vertex per vertex, position and color.
+        VkVertexInputBindingDescription bindingDescriptions[2]{};
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(Vertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        VkVertexInputAttributeDescription attributeDescriptions[6]{};
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+        attributeDescriptions[0].offset = offsetof(Vertex, position);
+        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[1].offset = offsetof(Vertex, color);
+        uint32_t bindingCount = 1;
+        uint32_t attributeCount = 2;
+        if (perInstanceTransforms)
+        {
+            // a mat4 attribute takes one location per column, each fetched as a vec4.
+            bindingDescriptions[1].binding = 1;
+            bindingDescriptions[1].stride = InstanceTransforms::MATRIX_FLOATS * sizeof(float);
+            bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+            for (uint32_t column = 0; column < 4; column++)
+            {
+                VkVertexInputAttributeDescription &attribute = attributeDescriptions[attributeCount++];
+                attribute.binding = 1;
+                attribute.location = 2 + column;
+                attribute.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+                attribute.offset = column * 4 * sizeof(float);
+            }
+            bindingCount = 2;
+        }
+
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputInfo.vertexBindingDescriptionCount = bindingCount;
+        vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions;
+        vertexInputInfo.vertexAttributeDescriptionCount = attributeCount;
+        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions;
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+        // viewport and scissor are dynamic so a swapchain resize doesn't mean rebuilding (or re-caching) the pipeline.
+        VkPipelineViewportStateCreateInfo viewportState{};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+        std::vector<VkDynamicState> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+        dynamicState.pDynamicStates = dynamicStates.data();
+
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.depthClampEnable = VK_FALSE;
+        rasterizer.rasterizerDiscardEnable = VK_FALSE;
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+        rasterizer.depthBiasEnable = VK_FALSE;
+
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.sampleShadingEnable = VK_FALSE;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachment.blendEnable = VK_FALSE;
+
+        VkPipelineColorBlendStateCreateInfo colorBlending{};
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.logicOpEnable = VK_FALSE;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &colorBlendAttachment;
+
+        // only the render graph's scene pass has a depth attachment.
+        VkPipelineDepthStencilStateCreateInfo depthStencil{};
+        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable = VK_TRUE;
+        depthStencil.depthWriteEnable = VK_TRUE;
+        depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = shaderStages;
+        pipelineInfo.pVertexInputState = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pDepthStencilState = config.renderGraph ? &depthStencil : nullptr;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.renderPass = config.renderGraph ? renderGraph.renderPass("scene") : renderPass;
+        pipelineInfo.subpass = 0;
+
+        VkPipelineCreationFeedbackEXT stageFeedback[2]{};
+        VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+        if (feedback != nullptr && isDeviceExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME))
+        {
+            feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+            feedbackInfo.pPipelineCreationFeedback = feedback;
+            feedbackInfo.pipelineStageCreationFeedbackCount = 2;
+            feedbackInfo.pPipelineStageCreationFeedbacks = stageFeedback;
+            pipelineInfo.pNext = &feedbackInfo;
+        }
+
+        VkPipeline pipeline;
+        if (vkCreateGraphicsPipelines(logicalDevice, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create graphics pipeline!");
+        }
+        return pipeline;
+    }
+
+    void createGraphicsPipeline()
+    {
+        VkPipelineCreationFeedbackEXT feedback{};
+        auto start = std::chrono::steady_clock::now();
+        graphicsPipeline = UniquePipeline(logicalDevice, buildGraphicsPipeline(pipelineCache.handle(), &feedback, vertShaderModule));
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        pipelineCache.recordCreation(isDeviceExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME) ? &feedback : nullptr, ms);
+        std::ostringstream line;
+        line << "startup pipeline creation took " << ms << " ms with a " << (pipelineCache.isWarm() ? "warm" : "cold") << " pipeline cache\n";
+        std::cout << line.str();
+        if (config.gpuCull)
+        {
+            indirectPipeline = UniquePipeline(logicalDevice, buildGraphicsPipeline(pipelineCache.handle(), nullptr, indirectVertShaderModule));
+        }
+        if (config.instances > 0)
+        {
+            instancedPipeline = UniquePipeline(logicalDevice, buildGraphicsPipeline(pipelineCache.handle(), nullptr, instancedVertShaderModule, true));
+        }
+    }
+
+    /**
+     * @brief times pipeline creation against a brand new empty cache (cold) and against our loaded cache (warm). The driver may keep its own shader cache on the side (Mesa does, see MESA_SHADER_CACHE_DISABLE), which makes cold numbers look better than a true first launch.
+     */
+    void benchmarkPipelineCache(uint32_t iterations)
+    {
+        SampleStats cold, warm;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            VkPipelineCacheCreateInfo emptyInfo{};
+            emptyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            VkPipelineCache emptyCache;
+            if (vkCreatePipelineCache(logicalDevice, &emptyInfo, nullptr, &emptyCache) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create pipeline cache!");
+            }
+            auto start = std::chrono::steady_clock::now();
+            VkPipeline pipeline = buildGraphicsPipeline(emptyCache, nullptr, vertShaderModule);
+            cold.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            vkDestroyPipeline(logicalDevice, pipeline, nullptr);
+            vkDestroyPipelineCache(logicalDevice, emptyCache, nullptr);
+
+            VkPipelineCreationFeedbackEXT feedback{};
+            start = std::chrono::steady_clock::now();
+            pipeline = buildGraphicsPipeline(pipelineCache.handle(), &feedback, vertShaderModule);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            warm.add(ms);
+            pipelineCache.recordCreation(isDeviceExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME) ? &feedback : nullptr, ms);
+            vkDestroyPipeline(logicalDevice, pipeline, nullptr);
+        }
+        cold.print(std::cout, "pipeline creation, cold cache");
+        warm.print(std::cout, "pipeline creation, warm cache");
+    }
+
+    /**
+     * @brief one framebuffer per swapchain image; rebuilt whenever the swapchain is.
+     */
+    void createSwapChainFramebuffers()
+    {
+        swapChainFramebuffers.clear();
+        for (const auto &imageView : swapChainImageViews)
+        {
+            VkImageView attachment = imageView;
+            VkFramebufferCreateInfo framebufferInfo{};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.attachmentCount = 1;
+            framebufferInfo.pAttachments = &attachment;
+            framebufferInfo.width = swapChainExtent.width;
+            framebufferInfo.height = swapChainExtent.height;
+            framebufferInfo.layers = 1;
+            VkFramebuffer framebuffer;
+            if (vkCreateFramebuffer(logicalDevice, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create framebuffer!");
+            }
+            swapChainFramebuffers.emplace_back(logicalDevice, framebuffer);
+        }
+    }
+
+    /**
+     * @return the family compute work should be submitted to: the dedicated one if there is one, else graphics.
+     */
+    uint32_t computeQueueFamily() const
+    {
+        return queueFamilies.computeFamily.value_or(queueFamilies.graphicsFamily.value());
+    }
+
+    /**
+     * @return the family streaming uploads should be submitted to: the dedicated one if there is one, else graphics.
+     */
+    uint32_t transferQueueFamily() const
+    {
+        return queueFamilies.transferFamily.value_or(queueFamilies.graphicsFamily.value());
+    }
+
+    bool isDeviceExtensionEnabled(const char *name) const
+    {
+        return enabledDeviceExtensions.count(name) > 0;
+    }
+
+    /**
+     * @brief creates one slot's offscreen render target and the host-visible buffer it gets copied into for dumping. The readback buffer stays mapped for the app's lifetime; mapping per frame would just be overhead.
+     */
+    void createOffscreenTarget(FrameSlot &slot)
+    {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = offscreenFormat;
+        imageInfo.extent = {WINDOW_WIDTH, WINDOW_HEIGHT, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkImage image;
+        if (vkCreateImage(logicalDevice, &imageInfo, nullptr, &image) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create offscreen image!");
+        }
+        slot.offscreenImage = UniqueImage(logicalDevice, image);
+
+        slot.offscreenImageMemory = UniqueAllocation(deviceAllocator, deviceAllocator.allocateForImage(logicalDevice, image, imageInfo.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0));
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = static_cast<VkDeviceSize>(WINDOW_WIDTH) * WINDOW_HEIGHT * 4;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer readbackBuffer;
+        if (vkCreateBuffer(logicalDevice, &bufferInfo, nullptr, &readbackBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create readback buffer!");
+        }
+        slot.readbackBuffer = UniqueBuffer(logicalDevice, readbackBuffer);
+
+        // we read this back on the CPU every frame, so cached memory is worth asking for where the device has it.
+        slot.readbackMemory = UniqueAllocation(deviceAllocator, deviceAllocator.allocateForBuffer(logicalDevice, readbackBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                                                                                VK_MEMORY_PROPERTY_HOST_CACHED_BIT, true));
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = offscreenFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+        VkImageView imageView;
+        if (vkCreateImageView(logicalDevice, &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create offscreen image view!");
+        }
+        slot.offscreenImageView = UniqueImageView(logicalDevice, imageView);
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = &imageView;
+        framebufferInfo.width = WINDOW_WIDTH;
+        framebufferInfo.height = WINDOW_HEIGHT;
+        framebufferInfo.layers = 1;
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(logicalDevice, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create offscreen framebuffer!");
+        }
+        slot.offscreenFramebuffer = UniqueFramebuffer(logicalDevice, framebuffer);
+    }
+
+    /**
+     * @return D32_SFLOAT if it can be a depth attachment here, else D16_UNORM, which every device has to support as one.
+     */
+    VkFormat chooseDepthFormat()
+    {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, VK_FORMAT_D32_SFLOAT, &properties);
+        return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) ? VK_FORMAT_D32_SFLOAT : VK_FORMAT_D16_UNORM;
+    }
+
+    /**
+     * @brief --render-graph sample: the scene with a depth buffer, a crude bloom chain (downsample to 1/2 and 1/4, upsample back to 1/2), then the scene copied into the slot's offscreen image with the bloom blitted over one corner as an inset. The chain is all blits so it can do without new shaders and pipelines; what matters is the shape of the graph: transients with staggered lifetimes, an attachment-only depth buffer, and passes reading what earlier ones wrote.
+     */
+    void createRenderGraph()
+    {
+        VkExtent2D full = {WINDOW_WIDTH, WINDOW_HEIGHT};
+        VkExtent2D half = {full.width / 2, full.height / 2};
+        VkExtent2D quarter = {full.width / 4, full.height / 4};
+        graphSceneColor = renderGraph.createImage("scene color", {offscreenFormat, full});
+        RenderGraph::ResourceId sceneDepth = renderGraph.createImage("scene depth", {chooseDepthFormat(), full, VK_IMAGE_ASPECT_DEPTH_BIT});
+        RenderGraph::ResourceId halfColor = renderGraph.createImage("bloom 1/2", {offscreenFormat, half});
+        RenderGraph::ResourceId quarterColor = renderGraph.createImage("bloom 1/4", {offscreenFormat, quarter});
+        RenderGraph::ResourceId bloom = renderGraph.createImage("bloom", {offscreenFormat, half});
+        // recordReadback() copies out of it right after the graph, and that copy is also the last thing to touch it before the slot comes around again.
+        graphOutput = renderGraph.importImage("output", {offscreenFormat, full}, {VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT});
+        VkClearValue depthClear{};
+        depthClear.depthStencil = {1.0f, 0};
+        renderGraph.setClearValue(sceneDepth, depthClear);
+
+        renderGraph.addPass("scene", {{graphSceneColor, GraphUsage::ColorAttachment, true}, {sceneDepth, GraphUsage::DepthAttachment, true}},
+                            [this](VkCommandBuffer cmd, const RenderGraph::PassContext &context)
+                            { recordDrawRange(cmd, context.extent, context.slotIndex, 0, static_cast<uint32_t>(drawList.size())); });
+        auto addBlitPass = [this](const std::string &name, RenderGraph::ResourceId from, RenderGraph::ResourceId to)
+        {
+            renderGraph.addPass(name, {{from, GraphUsage::TransferSrc}, {to, GraphUsage::TransferDst}},
+                                [this, from, to](VkCommandBuffer cmd, const RenderGraph::PassContext &)
+                                {
+                                    VkExtent2D target = renderGraph.extent(to);
+                                    recordBlit(cmd, from, to, {0, 0, 0}, {static_cast<int32_t>(target.width), static_cast<int32_t>(target.height), 1});
+                                });
+        };
+        addBlitPass("downsample 1/2", graphSceneColor, halfColor);
+        addBlitPass("downsample 1/4", halfColor, quarterColor);
+        addBlitPass("upsample", quarterColor, bloom);
+        renderGraph.addPass("composite", {{graphSceneColor, GraphUsage::TransferSrc}, {graphOutput, GraphUsage::TransferDst}},
+                            [this](VkCommandBuffer cmd, const RenderGraph::PassContext &)
+                            {
+                                VkImageCopy region{};
+                                region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                                region.srcSubresource.layerCount = 1;
+                                region.dstSubresource = region.srcSubresource;
+                                region.extent = {WINDOW_WIDTH, WINDOW_HEIGHT, 1};
+                                vkCmdCopyImage(cmd, renderGraph.image(graphSceneColor), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, renderGraph.image(graphOutput), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+                            });
+        renderGraph.addPass("bloom inset", {{bloom, GraphUsage::TransferSrc}, {graphOutput, GraphUsage::TransferDst}},
+                            [this, bloom](VkCommandBuffer cmd, const RenderGraph::PassContext &)
+                            {
+                                // top right quarter of the frame.
+                                int32_t width = static_cast<int32_t>(WINDOW_WIDTH);
+                                int32_t height = static_cast<int32_t>(WINDOW_HEIGHT);
+                                recordBlit(cmd, bloom, graphOutput, {width - width / 4, 0, 0}, {width, height / 4, 1});
+                            });
+
+        RenderGraph::Settings settings;
+        settings.aliasing = config.graphAliasing;
+        renderGraph.compile(logicalDevice, deviceAllocator, settings);
+        renderGraph.printSummary(std::cout);
+    }
+
+    /**
+     * @brief linear-filtered blit of all of graph image from into the [dstMin, dstMax) box of graph image to; both already in the TRANSFER layouts their pass declared.
+     */
+    void recordBlit(VkCommandBuffer cmd, RenderGraph::ResourceId from, RenderGraph::ResourceId to, VkOffset3D dstMin, VkOffset3D dstMax)
+    {
+        VkExtent2D source = renderGraph.extent(from);
+        VkImageBlit blit{};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.layerCount = 1;
+        blit.srcOffsets[1] = {static_cast<int32_t>(source.width), static_cast<int32_t>(source.height), 1};
+        blit.dstSubresource = blit.srcSubresource;
+        blit.dstOffsets[0] = dstMin;
+        blit.dstOffsets[1] = dstMax;
+        vkCmdBlitImage(cmd, renderGraph.image(from), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, renderGraph.image(to), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+    }
+
+    VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats)
+    {
+        for (const auto &availableFormat : availableFormats)
+        {
+            if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+            {
+                return availableFormat;
+            }
+        }
+        // nobody's going to die over a non-sRGB swapchain, just take whatever the driver lists first.
+        return availableFormats[0];
+    }
+
+    /**
+     * @brief picks a present mode per config.presentPolicy, walking a fallback list until something the surface supports turns up. FIFO is the only mode the spec guarantees, so every list bottoms out there.
+     */
+    VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes)
+    {
+        if (config.pacing == PacingMode::Vsync)
+        {
+            return VK_PRESENT_MODE_FIFO_KHR;
+        }
+        std::vector<VkPresentModeKHR> preferences;
+        switch (config.presentPolicy)
+        {
+        case PresentPolicy::LowLatency:
+            // mailbox: never blocks on vblank, newest frame wins, no tearing. Immediate is lower latency still but tears, so it's only second choice.
+            preferences = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+            break;
+        case PresentPolicy::Benchmark:
+            // immediate: uncapped and unsynchronized, which is exactly what we want when measuring throughput.
+            preferences = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR};
+            break;
+        case PresentPolicy::PowerSaving:
+            break;
+        }
+        preferences.push_back(VK_PRESENT_MODE_FIFO_KHR);
+
+        for (auto preferred : preferences)
+        {
+            if (std::find(availablePresentModes.begin(), availablePresentModes.end(), preferred) != availablePresentModes.end())
+            {
+                return preferred;
+            }
+        }
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+
+    VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities)
+    {
+        // a currentExtent of 0xFFFFFFFF means the window manager lets the swapchain decide, so go with the framebuffer size in pixels (not screen coordinates, which differ on high DPI displays).
+        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+        {
+            return capabilities.currentExtent;
+        }
+
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        VkExtent2D actualExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+        return actualExtent;
+    }
+
+    /**
+     * @brief how many swapchain images to ask for. One above the minimum keeps us from waiting on the driver to release an image; mailbox wants at least three (one on screen, one queued, one being rendered) or it degrades into FIFO-ish blocking. maxImageCount of 0 means no upper limit.
+     */
+    uint32_t chooseSwapImageCount(const VkSurfaceCapabilitiesKHR &capabilities, VkPresentModeKHR presentMode)
+    {
+        uint32_t imageCount = capabilities.minImageCount + 1;
+        if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        {
+            imageCount = std::max(imageCount, 3u);
+        }
+        if (capabilities.maxImageCount > 0)
+        {
+            imageCount = std::min(imageCount, capabilities.maxImageCount);
+        }
+        return imageCount;
+    }
+
+    /**
+     * @brief (re)creates the swapchain. Passing the outgoing swapchain as oldSwapchain lets the driver hand resources over and keep presenting already-queued images while we switch, instead of tearing everything down first.
+     * @param oldSwapchain the swapchain being replaced, or VK_NULL_HANDLE on first creation. The caller stays responsible for destroying it.
+     */
+    void createSwapChain(VkSwapchainKHR oldSwapchain)
+    {
+        SwapChainSupportDetails swapChainSupport = deviceSelector().querySwapChainSupport(physicalDevice);
+
+        VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
+        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
+        uint32_t imageCount = chooseSwapImageCount(swapChainSupport.capabilities, presentMode);
+
+        VkSwapchainCreateInfoKHR createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        createInfo.surface = surface;
+        createInfo.minImageCount = imageCount;
+        createInfo.imageFormat = surfaceFormat.format;
+        createInfo.imageColorSpace = surfaceFormat.colorSpace;
+        createInfo.imageExtent = extent;
+        createInfo.imageArrayLayers = 1;
+        createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+        const QueueFamilyIndices &indices = queueFamilies;
+        uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+        if (indices.graphicsFamily != indices.presentFamily)
+        {
+            // concurrent sharing costs a bit of performance but saves us explicit ownership transfers between the two families.
+            createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = 2;
+            createInfo.pQueueFamilyIndices = queueFamilyIndices;
+        }
+        else
+        {
+            createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        }
+
+        createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
+        createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        createInfo.presentMode = presentMode;
+        createInfo.clipped = VK_TRUE;
+        createInfo.oldSwapchain = oldSwapchain;
+
+        VkSwapchainKHR createdSwapChain;
+        if (vkCreateSwapchainKHR(logicalDevice, &createInfo, nullptr, &createdSwapChain) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create swap chain!");
+        }
+        swapChain = UniqueSwapchain(logicalDevice, createdSwapChain);
+
+        // the driver is allowed to create more images than we asked for, so ask it how many we really got.
+        vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imageCount, nullptr);
+        swapChainImages.resize(imageCount);
+        vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imageCount, swapChainImages.data());
+        swapChainImageFormat = surfaceFormat.format;
+        swapChainExtent = extent;
+
+        swapChainImageViews.clear();
+        swapChainRenderFinishedSemaphores.clear();
+        for (size_t i = 0; i < imageCount; i++)
+        {
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = swapChainImages[i];
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = swapChainImageFormat;
+            viewInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.layerCount = 1;
+            VkImageView imageView;
+            if (vkCreateImageView(logicalDevice, &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create swapchain image view!");
+            }
+            swapChainImageViews.emplace_back(logicalDevice, imageView);
+
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            VkSemaphore semaphore;
+            if (vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create render finished semaphore!");
+            }
+            swapChainRenderFinishedSemaphores.emplace_back(logicalDevice, semaphore);
+        }
+
+        // one insertion, so it stays a whole line while startup has other tasks printing.
+        std::cout << "swapchain: " + std::to_string(imageCount) + " images " + std::to_string(extent.width) + 'x' + std::to_string(extent.height) +
+                         ", present mode " + presentModeName(presentMode) + '\n';
+    }
+
+    static const char *presentModeName(VkPresentModeKHR mode)
+    {
+        switch (mode)
+        {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "IMMEDIATE";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "MAILBOX";
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "FIFO";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "FIFO_RELAXED";
+        default:
+            return "other";
+        }
+    }
+
+    /**
+     * @brief swaps in a new swapchain after a resize or VK_ERROR_OUT_OF_DATE_KHR without stalling the device. The old swapchain and everything made from it go on the deletion queue instead of being destroyed on the spot, since frames still in flight may reference its images; it reaps them once those frames' fences have signaled.
+     * @param frameIndex the next frame to be submitted, i.e. the first one that will only ever see the new swapchain.
+     */
+    void recreateSwapChain(uint32_t frameIndex)
+    {
+        // a minimized window has a 0x0 framebuffer, which we can't make a swapchain for; park here until it comes back.
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        while (width == 0 || height == 0)
+        {
+            glfwWaitEvents();
+            glfwGetFramebufferSize(window, &width, &height);
+        }
+        // the old swapchain's outstanding present IDs can't be waited on once it's retired, and a stall here shouldn't count as a slow frame.
+        latency.forgetInFlight();
+        lastPresentId = 0;
+        pacer.reset();
+
+        // queued before its views so it's destroyed after them; nothing in the queue goes before the next frames retire, so the new swapchain can still be created from it.
+        VkSwapchainKHR oldSwapChain = swapChain;
+        deletionQueue.retire(frameIndex, std::move(swapChain));
+        retireSwapChainResources(frameIndex);
+        createSwapChain(oldSwapChain);
+        createSwapChainFramebuffers();
+        framebufferResized = false;
+        swapChainRecreations++;
+    }
+
+    /**
+     * @brief hands the current swapchain's views, framebuffers and semaphores to the deletion queue.
+     */
+    void retireSwapChainResources(uint32_t frameIndex)
+    {
+        for (auto &imageView : swapChainImageViews)
+        {
+            deletionQueue.retire(frameIndex, std::move(imageView));
+        }
+        for (auto &framebuffer : swapChainFramebuffers)
+        {
+            deletionQueue.retire(frameIndex, std::move(framebuffer));
+        }
+        for (auto &semaphore : swapChainRenderFinishedSemaphores)
+        {
+            deletionQueue.retire(frameIndex, std::move(semaphore));
+        }
+        swapChainImageViews.clear();
+        swapChainFramebuffers.clear();
+        swapChainRenderFinishedSemaphores.clear();
+    }
+
+    static void framebufferResizeCallback(GLFWwindow *window, int width, int height)
+    {
+        auto app = reinterpret_cast<HelloTriangleApplication *>(glfwGetWindowUserPointer(window));
+        app->framebufferResized = true;
+    }
+
+    static void inputCallback(GLFWwindow *window)
+    {
+        reinterpret_cast<HelloTriangleApplication *>(glfwGetWindowUserPointer(window))->latency.inputArrived();
+    }
+
+    static void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
+    {
+        inputCallback(window);
+    }
+
+    static void mouseButtonCallback(GLFWwindow *window, int button, int action, int mods)
+    {
+        inputCallback(window);
+    }
+
+    static void cursorPositionCallback(GLFWwindow *window, double x, double y)
+    {
+        inputCallback(window);
+    }
+
+    static void scrollCallback(GLFWwindow *window, double x, double y)
+    {
+        inputCallback(window);
+    }
+
+    /**
+     * @brief builds config.framesInFlight frame slots. Each slot gets its own command pool rather than sharing one pool with per-buffer resets: resetting a whole pool is the cheap path, and a pool is only ever touched by the frame that owns it, so there's no contention to worry about either.
+     */
+    void createFrameSlots()
+    {
+        const QueueFamilyIndices &queueFamilyIndices = queueFamilies;
+        frameSlots.resize(config.framesInFlight);
+
+        for (auto &slot : frameSlots)
+        {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            // buffers from this pool live exactly one frame before the whole pool gets reset.
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+            VkCommandPool commandPool;
+            if (vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create command pool!");
+            }
+            slot.commandPool = UniqueCommandPool(logicalDevice, commandPool);
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = slot.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &slot.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate command buffers!");
+            }
 
-#ifdef NDEBUG
-const bool enableValidationLayers = false;
-#else
-const bool enableValidationLayers = true;
-#endif
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            // fence starts signaled so the very first wait on each slot falls straight through.
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+            VkSemaphore semaphore;
+            if (vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create frame slot sync objects!");
+            }
+            slot.imageAvailableSemaphore = UniqueSemaphore(logicalDevice, semaphore);
+            VkFence fence;
+            if (vkCreateFence(logicalDevice, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create frame slot sync objects!");
+            }
+            slot.inFlightFence = UniqueFence(logicalDevice, fence);
 
-static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
-    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
-    VkDebugUtilsMessageTypeFlagsEXT messageType,
-    const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData,
-    void *pUserData)
-{
+            slot.workerCommands.resize(maxRecordWorkers());
+            for (auto &worker : slot.workerCommands)
+            {
+                VkCommandPool workerPool;
+                if (vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &workerPool) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create worker command pool!");
+                }
+                worker.commandPool = UniqueCommandPool(logicalDevice, workerPool);
+                VkCommandBufferAllocateInfo secondaryInfo{};
+                secondaryInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                secondaryInfo.commandPool = worker.commandPool;
+                secondaryInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                secondaryInfo.commandBufferCount = 1;
+                if (vkAllocateCommandBuffers(logicalDevice, &secondaryInfo, &worker.commandBuffer) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to allocate secondary command buffers!");
+                }
+            }
 
-    std::cerr << "The validation layer says: " << pCallbackData->pMessage << std::endl;
+            if (config.headless)
+            {
+                createOffscreenTarget(slot);
+            }
+            if (config.instances > 0)
+            {
+                createInstanceBuffer(slot);
+            }
+        }
 
-    return VK_FALSE;
-}
+        if (config.headless && !config.dumpSharedMemory.empty())
+        {
+            sharedMemorySink = std::make_unique<SharedMemoryFrameSink>(config.dumpSharedMemory, WINDOW_WIDTH, WINDOW_HEIGHT);
+        }
+    }
 
-VkResult createDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDebugUtilsMessengerEXT *pDebugMessenger)
-{
-    auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
-    if (func != nullptr)
+    /**
+     * @brief the slot's per-instance matrices: written by the CPU every frame and read once by the GPU, so host-visible memory the GPU reads directly (device-local too where the device has such a heap, e.g. resizable BAR) instead of a staging copy.
+     */
+    void createInstanceBuffer(FrameSlot &slot)
     {
-        return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = static_cast<VkDeviceSize>(config.instances) * InstanceTransforms::MATRIX_FLOATS * sizeof(float);
+        bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer buffer;
+        if (vkCreateBuffer(logicalDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create instance buffer!");
+        }
+        slot.instanceBuffer = UniqueBuffer(logicalDevice, buffer);
+
+        // start on a cache line, so every matrix is exactly one and the update's streaming stores never split one between two workers.
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(logicalDevice, buffer, &requirements);
+        requirements.alignment = std::max<VkDeviceSize>(requirements.alignment, 64);
+        slot.instanceMemory = UniqueAllocation(deviceAllocator, deviceAllocator.allocate(requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                                                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceKind::Linear, true));
+        vkBindBufferMemory(logicalDevice, buffer, slot.instanceMemory->memory, slot.instanceMemory->offset);
     }
-    else
+
+    /**
+     * @brief every slot holds its own handles and allocations, so dropping the slots is the whole teardown.
+     */
+    void destroyFrameSlots()
     {
-        return VK_ERROR_EXTENSION_NOT_PRESENT;
+        frameSlots.clear();
+        sharedMemorySink.reset();
     }
-}
 
-void destroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks *pAllocator)
-{
-    auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
-    if (func != nullptr)
+    /**
+     * @brief creates a device-local buffer for the upload ring to fill.
+     */
+    UniqueBuffer createDeviceLocalBuffer(VkDeviceSize size, VkBufferUsageFlags usage, UniqueAllocation &memory)
     {
-        func(instance, debugMessenger, pAllocator);
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer buffer;
+        if (vkCreateBuffer(logicalDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create buffer!");
+        }
+        UniqueBuffer owned(logicalDevice, buffer);
+        memory = UniqueAllocation(deviceAllocator, deviceAllocator.allocateForBuffer(logicalDevice, buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, false));
+        return owned;
     }
-}
 
-class HelloTriangleApplication
-{
-public:
-    void run()
+    /**
+     * @brief queues the triangle's vertex and index data (and the --stream-test-mb blob) on the upload ring. Nothing blocks here; the first frame's submitFrame() does the actual copies.
+     */
+    void createGeometryBuffers()
     {
-        initWindow();
-        initVulkan();
-        mainLoop();
-        cleanup();
+        VkDeviceSize vertexBytes = sizeof(Vertex) * triangleVertices.size();
+        VkDeviceSize indexBytes = sizeof(uint16_t) * triangleIndices.size();
+        vertexBuffer = createDeviceLocalBuffer(vertexBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBufferMemory);
+        indexBuffer = createDeviceLocalBuffer(indexBytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBufferMemory);
+        uploadRing.uploadBuffer(vertexBuffer, 0, triangleVertices.data(), vertexBytes, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        // uploads finish in order, so the later ticket covers both.
+        geometryTicket = uploadRing.uploadBuffer(indexBuffer, 0, triangleIndices.data(), indexBytes, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+
+        if (config.streamTestMiB > 0)
+        {
+            VkDeviceSize streamBytes = static_cast<VkDeviceSize>(config.streamTestMiB) * 1024 * 1024;
+            streamTestData.resize(streamBytes);
+            for (size_t i = 0; i < streamTestData.size(); i++)
+            {
+                streamTestData[i] = static_cast<uint8_t>(i * 31);
+            }
+            streamTestBuffer = createDeviceLocalBuffer(streamBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, streamTestMemory);
+            streamTestTicket = uploadRing.uploadBuffer(streamTestBuffer, 0, streamTestData.data(), streamBytes, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        }
     }
 
-private:
-    GLFWwindow *window;
-    VkInstance instance;
-    VkDebugUtilsMessengerEXT debugMessenger;
-    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-    VkDevice logicalDevice;
     /**
-     * A queue in Vulkan is a literal queue of commands; we send command buffers to them, and each queue in each queue family is ordered. The queue family we're interested in is just graphics, so the idea is to have command queues per GPU hardware capability e.g. graphics, compute, codec ops etc. See https://registry.khronos.org/vulkan/specs/latest/man/html/VkQueueFlagBits.html for the full list of queue family cap bits.
+     * @brief creates a sampled RGBA8 texture and queues its texels on the upload ring. The texels are parked in materialUploadData since the ring only reads them once it gets to the job.
      */
-    VkQueue graphicsQueue;
+    const MaterialTexture &createMaterialTexture(VkExtent2D extent, std::vector<uint8_t> texels)
+    {
+        MaterialTexture texture;
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        imageInfo.extent = {extent.width, extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImage image;
+        if (vkCreateImage(logicalDevice, &imageInfo, nullptr, &image) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create material texture!");
+        }
+        texture.image = UniqueImage(logicalDevice, image);
+        texture.memory = UniqueAllocation(deviceAllocator, deviceAllocator.allocateForImage(logicalDevice, image, imageInfo.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0));
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = imageInfo.format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+        VkImageView view;
+        if (vkCreateImageView(logicalDevice, &viewInfo, nullptr, &view) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create material texture view!");
+        }
+        texture.view = UniqueImageView(logicalDevice, view);
+
+        materialUploadData.push_back(std::move(texels));
+        materialTicket = uploadRing.uploadImage(image, extent, 4, materialUploadData.back().data(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        materialTextures.push_back(std::move(texture));
+        return materialTextures.back();
+    }
+
     /**
-     * The present Q accepts surface presentation commands. For some reason it must be searched for with a dedicated function vkGetPhysicalDeviceSurfaceSupportKHR() instead of just looking for a Q id bit like we did above. Something something abstracting the Vulkan graphics api so it can serve any purpose for some reason, the api to end all apis, even for non-graphics utility? smdh, Khronos.
+     * @brief a one-vec4 storage buffer holding a tint; matches Palette in shaders/triangle.frag.
      */
-    VkQueue presentQueue;
-    VkSurfaceKHR surface;
+    const MaterialPalette &createMaterialPalette(const std::array<float, 4> &tint)
+    {
+        MaterialPalette palette;
+        palette.buffer = createDeviceLocalBuffer(sizeof(tint), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, palette.memory);
+        std::vector<uint8_t> bytes(sizeof(tint));
+        std::memcpy(bytes.data(), tint.data(), sizeof(tint));
+        materialUploadData.push_back(std::move(bytes));
+        materialTicket = uploadRing.uploadBuffer(palette.buffer, 0, materialUploadData.back().data(), sizeof(tint), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        materialPalettes.push_back(std::move(palette));
+        return materialPalettes.back();
+    }
 
-    struct QueueFamilyIndices
+    /**
+     * @brief fills the descriptor heap: defaults into slot 0 (and every free slot), then the checkerboard and warm tint the draw list alternates between.
+     */
+    void createMaterials()
     {
-        std::optional<uint32_t> graphicsFamily;
-        std::optional<uint32_t> presentFamily;
-        bool isComplete()
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.maxLod = 0.0f;
+        VkSampler sampler;
+        if (vkCreateSampler(logicalDevice, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
         {
-            return graphicsFamily.has_value() && presentFamily.has_value();
+            throw std::runtime_error("failed to create material sampler!");
         }
-    };
+        materialSampler = UniqueSampler(logicalDevice, sampler);
+
+        // the vectors may reallocate on the next push, so take the handles, not references.
+        VkImageView white = createMaterialTexture({1, 1}, std::vector<uint8_t>(4, 255)).view;
+        VkBuffer identity = createMaterialPalette({1.0f, 1.0f, 1.0f, 1.0f}).buffer;
+        descriptorHeap.setDefaults(white, sampler, identity, sizeof(float) * 4);
+
+        const uint32_t checkerSize = 64;
+        std::vector<uint8_t> checker(checkerSize * checkerSize * 4);
+        for (uint32_t y = 0; y < checkerSize; y++)
+        {
+            for (uint32_t x = 0; x < checkerSize; x++)
+            {
+                uint8_t value = ((x / 8) + (y / 8)) % 2 == 0 ? 255 : 96;
+                uint8_t *texel = &checker[(y * checkerSize + x) * 4];
+                texel[0] = texel[1] = texel[2] = value;
+                texel[3] = 255;
+            }
+        }
+        checkerTextureIndex = descriptorHeap.addTexture(createMaterialTexture({checkerSize, checkerSize}, std::move(checker)).view, materialSampler);
+        warmPaletteIndex = descriptorHeap.addBuffer(createMaterialPalette({1.0f, 0.75f, 0.5f, 1.0f}).buffer, 0, sizeof(float) * 4);
+    }
 
-    struct SwapChainSupportDetails
+    void destroyMaterials()
     {
-        VkSurfaceCapabilitiesKHR capabilities;
-        std::vector<VkSurfaceFormatKHR> formats;
-        std::vector<VkPresentModeKHR> presentModes;
-    };
+        materialTextures.clear();
+        materialPalettes.clear();
+        materialUploadData.clear();
+        materialSampler.reset();
+    }
 
-private:
-    void initWindow()
+    void reportStreamTest(uint32_t frameIndex)
     {
-        glfwInit();
-        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Vulkan Triangle", nullptr, nullptr);
+        if (streamTestTicket != 0 && uploadRing.isReady(streamTestTicket))
+        {
+            std::cout << "streamed " << config.streamTestMiB << " MiB test asset in " << frameIndex + 1 << " frame(s)\n";
+            streamTestTicket = 0;
+        }
     }
 
-    void createInstance()
+    /**
+     * @brief lays config.drawCount triangles out on a square grid covering clip space. One draw is the original full-size triangle. With --scene-objects it builds the benchmark scene instead.
+     */
+    void buildDrawList()
     {
-        // I'm having a disagreement with the tutorial on how best to handle the C/C++ interop since Vulkan is a C API but our program is C++... well anyway, it's easier to build up wrappers around pure data than to decompose wrappers into the appropriate data, so let's go with cstring constant and then build a wrapper of wrappers from that why not. Technically we're creating an opportunity for a disconnect between what layers we check for and what we actually request, but I don't wanna use strcmp and friends in the analysis. I don't wanna!
-        std::vector<std::string> validationLayerStrings;
-        for (auto cstring : validationLayers)
+        if (config.sceneObjects > 0)
         {
-            validationLayerStrings.emplace_back(std::string(cstring));
+            buildBenchmarkScene(config.sceneObjects);
+            return;
+        }
+        uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(std::max(config.drawCount, 1u)))));
+        float cell = 2.0f / static_cast<float>(columns);
+        drawList.resize(config.drawCount);
+        for (uint32_t i = 0; i < config.drawCount; i++)
+        {
+            DrawPushConstants &draw = drawList[i];
+            draw.offset[0] = columns == 1 ? 0.0f : -1.0f + cell * (static_cast<float>(i % columns) + 0.5f);
+            draw.offset[1] = columns == 1 ? 0.0f : -1.0f + cell * (static_cast<float>(i / columns) + 0.5f);
+            draw.scale = columns == 1 ? 1.0f : cell * 0.9f;
+            draw.shade = 0.5f + 0.5f * static_cast<float>(i % 7) / 6.0f;
+            draw.textureIndex = i % 2 == 0 ? checkerTextureIndex : 0;
+            draw.paletteIndex = i % 3 == 2 ? warmPaletteIndex : 0;
         }
+    }
 
-        if (enableValidationLayers && !checkValidationLayerSupport(validationLayerStrings))
+    /**
+     * @brief scatters objectCount small triangles over a world several views wide. Fixed seed, so every run (and both culling paths) draws the same scene; recordFrame() pans the camera in a circle so what's visible keeps changing.
+     */
+    void buildBenchmarkScene(uint32_t objectCount)
+    {
+        std::mt19937 random(12345);
+        std::uniform_real_distribution<float> position(-SCENE_WORLD_EXTENT, SCENE_WORLD_EXTENT);
+        std::uniform_real_distribution<float> scale(0.02f, 0.06f);
+        std::uniform_real_distribution<float> shade(0.5f, 1.0f);
+        drawList.resize(objectCount);
+        for (uint32_t i = 0; i < objectCount; i++)
         {
-            throw std::runtime_error("some desired validation layers are not available!");
+            DrawPushConstants &draw = drawList[i];
+            draw.offset[0] = position(random);
+            draw.offset[1] = position(random);
+            draw.scale = scale(random);
+            draw.shade = shade(random);
+            draw.textureIndex = i % 2 == 0 ? checkerTextureIndex : 0;
+            draw.paletteIndex = i % 3 == 2 ? warmPaletteIndex : 0;
         }
+    }
 
-        VkApplicationInfo appInfo{};
-        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-        appInfo.pApplicationName = "Triangular Sandboxing";
-        appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.pEngineName = "No Engine";
-        appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+    /**
+     * @brief --gpu-cull setup: mirrors drawList into a device-local CullObject array (queued on the upload ring), registers it in the descriptor heap for triangle_indirect.vert, and hands it to the culler.
+     */
+    void createCullObjects()
+    {
+        cullObjects.resize(drawList.size());
+        for (size_t i = 0; i < drawList.size(); i++)
+        {
+            const DrawPushConstants &draw = drawList[i];
+            cullObjects[i] = {{draw.offset[0], draw.offset[1]}, draw.scale, draw.shade, draw.textureIndex, draw.paletteIndex, draw.scale * TRIANGLE_BOUNDING_RADIUS, 0.0f};
+        }
+        VkDeviceSize bytes = sizeof(CullObject) * std::max<size_t>(cullObjects.size(), 1);
+        // the whole scene is one storage buffer and, worst case, one indirect call's worth of draws.
+        if (bytes > physicalDeviceProperties.limits.maxStorageBufferRange || cullObjects.size() > physicalDeviceProperties.limits.maxDrawIndirectCount)
+        {
+            throw std::runtime_error("too many scene objects for --gpu-cull on this device!");
+        }
+        objectBuffer = createDeviceLocalBuffer(bytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, objectBufferMemory);
+        objectTicket = uploadRing.uploadBuffer(objectBuffer, 0, cullObjects.data(), sizeof(CullObject) * cullObjects.size(),
+                                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        objectBufferIndex = descriptorHeap.addBuffer(objectBuffer, 0, VK_WHOLE_SIZE);
+        if (objectBufferIndex == 0)
+        {
+            // slot 0 is the identity palette; the heap hands it back when it's full, or when the device can't index storage buffer arrays at all.
+            throw std::runtime_error("no room in the descriptor heap for the cull object buffer!");
+        }
+        const VkPhysicalDeviceLimits &limits = physicalDeviceProperties.limits;
+        if (config.cullWorkgroupSize > limits.maxComputeWorkGroupSize[0] || config.cullWorkgroupSize > limits.maxComputeWorkGroupInvocations)
+        {
+            throw std::runtime_error("--cull-workgroup " + std::to_string(config.cullWorkgroupSize) + " is bigger than this device allows (" +
+                                     std::to_string(std::min(limits.maxComputeWorkGroupSize[0], limits.maxComputeWorkGroupInvocations)) + ")!");
+        }
+        gpuCuller.create(logicalDevice, deviceAllocator, cullShaderModule, cullReflection, pipelineCache.handle(), objectBuffer, static_cast<uint32_t>(cullObjects.size()),
+                         static_cast<uint32_t>(triangleIndices.size()), config.framesInFlight, config.cullWorkgroupSize, config.viewCull);
+    }
 
-        VkInstanceCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-        createInfo.pApplicationInfo = &appInfo;
+    void destroyCullObjects()
+    {
+        if (!gpuCuller.enabled())
+        {
+            return;
+        }
+        gpuCuller.destroy();
+        descriptorHeap.removeBuffer(objectBufferIndex);
+        objectBuffer.reset();
+        objectBufferMemory.reset();
+        indirectPipeline.reset();
+        indirectVertShaderModule.reset();
+        cullShaderModule.reset();
+    }
 
-        // figure out how many and which vk extensions GLFW requires.
-        auto extensions = getRequiredExtensions();
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
-        createInfo.ppEnabledExtensionNames = extensions.data();
+    /**
+     * @brief how many per-worker command pools each frame slot needs: enough for --record-threads and, when benchmarking, for every worker count up to hardware_concurrency.
+     */
+    uint32_t maxRecordWorkers() const
+    {
+        uint32_t workers = config.recordThreads;
+        if (config.recordBenchFrames > 0)
+        {
+            workers = std::max(workers, std::max(std::thread::hardware_concurrency(), 1u));
+        }
+        return workers;
+    }
 
-        // debug message struct fella has to live outside the val condition because it will be referenced by creatinfo and that will be used by the call to vkCreateInstance()
-        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
-        if (enableValidationLayers)
+    void setViewportAndScissor(VkCommandBuffer cmd, VkExtent2D extent)
+    {
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = extent;
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
+    }
+
+    /**
+     * @brief binds the pipeline, the descriptor heap and dynamic state, then draws whatever in drawList[begin, end) is in view. Per draw it's a bounding circle test, push constants and the draw itself. Safe to call from several threads at once as long as each has its own cmd.
+     */
+    void recordDrawRange(VkCommandBuffer cmd, VkExtent2D extent, uint32_t slotIndex, uint32_t begin, uint32_t end)
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+        descriptorHeap.bind(cmd, pipelineLayout, slotIndex);
+        setViewportAndScissor(cmd, extent);
+        if (!uploadRing.isReady(geometryTicket) || !uploadRing.isReady(materialTicket))
         {
-            createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
-            createInfo.ppEnabledLayerNames = validationLayers.data();
-            populateDebugMessengerCreateInfo(debugCreateInfo);
-            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT *)&debugCreateInfo;
+            return;
         }
-        else
+        VkBuffer vertices = vertexBuffer;
+        VkDeviceSize vertexOffset = 0;
+        vkCmdBindVertexBuffers(cmd, 0, 1, &vertices, &vertexOffset);
+        vkCmdBindIndexBuffer(cmd, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+        for (uint32_t i = begin; i < end; i++)
         {
-            createInfo.enabledLayerCount = 0;
-            createInfo.pNext = nullptr;
+            // same test as shaders/cull.comp, so both paths draw exactly the same set.
+            DrawPushConstants draw = drawList[i];
+            draw.offset[0] -= camera[0];
+            draw.offset[1] -= camera[1];
+            float reach = 1.0f + draw.scale * TRIANGLE_BOUNDING_RADIUS;
+            if (std::abs(draw.offset[0]) > reach || std::abs(draw.offset[1]) > reach)
+            {
+                continue;
+            }
+            vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawPushConstants), &draw);
+            vkCmdDrawIndexed(cmd, static_cast<uint32_t>(triangleIndices.size()), 1, 0, 0, 0);
         }
+    }
 
-        if (!checkInstanceExtensions(std::vector<std::string>(extensions.data(), extensions.data() + extensions.size())))
+    /**
+     * @brief --mesh counterpart of recordDrawRange(): one draw per chunk the streamer has resident and in view, each straight from its own buffer. Chunk vertices are already in world space, so the push constants only move the camera.
+     */
+    void recordMeshDraws(VkCommandBuffer cmd, VkExtent2D extent, uint32_t slotIndex)
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+        descriptorHeap.bind(cmd, pipelineLayout, slotIndex);
+        setViewportAndScissor(cmd, extent);
+        if (!uploadRing.isReady(materialTicket))
         {
-            throw std::runtime_error("failed to create triangly vkinstance due to unsupported extensions");
+            return;
         }
-
-        if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+        DrawPushConstants draw{{-camera[0], -camera[1]}, 1.0f, 1.0f, 0, 0};
+        vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawPushConstants), &draw);
+        for (const MeshStreamer::Drawable &chunk : meshStreamer.visibleChunks())
         {
-            throw std::runtime_error("failed to create triangly vkinstance");
+            VkDeviceSize vertexOffset = 0;
+            vkCmdBindVertexBuffers(cmd, 0, 1, &chunk.buffer, &vertexOffset);
+            vkCmdBindIndexBuffer(cmd, chunk.buffer, chunk.indexOffset, VK_INDEX_TYPE_UINT16);
+            vkCmdDrawIndexed(cmd, chunk.indexCount, 1, 0, 0, 0);
         }
     }
 
-    QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device)
+    /**
+     * @brief --instances counterpart of recordDrawRange(): the whole population in one instanced draw, transforms coming from the slot's instance buffer that drawFrame() just filled.
+     */
+    void recordInstancedDraws(VkCommandBuffer cmd, VkExtent2D extent, uint32_t slotIndex)
     {
-        QueueFamilyIndices indices;
-        // Assign index to queue families that could be found
-        // This business of double calls to every query API endpoint because we need to get the result count and perform population separately is an extremely acceptable API design. Good one, Khronos smdh.
-        uint32_t queueFamilyCount = 0;
-        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipeline);
+        descriptorHeap.bind(cmd, pipelineLayout, slotIndex);
+        setViewportAndScissor(cmd, extent);
+        if (!uploadRing.isReady(geometryTicket) || !uploadRing.isReady(materialTicket))
+        {
+            return;
+        }
+        InstancedPushConstants params{{camera[0], camera[1]}};
+        vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(params), &params);
+        // no barrier for the instance data: it's host-coherent and written before submit, which makes it visible to the whole batch.
+        VkBuffer buffers[2] = {vertexBuffer, frameSlots[slotIndex].instanceBuffer};
+        VkDeviceSize offsets[2] = {0, 0};
+        vkCmdBindVertexBuffers(cmd, 0, 2, buffers, offsets);
+        vkCmdBindIndexBuffer(cmd, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+        vkCmdDrawIndexed(cmd, static_cast<uint32_t>(triangleIndices.size()), instanceTransforms.size(), 0, 0, 0);
+    }
 
-        // todo: the index we actually get outta this seems arbitrary, unless the queuefamilies we get above are ordered for some reason, and even if they are why not get the index from the actual populated struct data rather than counting manually ourselves? I don't like the smell.
-        int i = 0;
-        for (const auto &queueFamily : queueFamilies)
+    /**
+     * @brief the GPU-driven counterpart of recordDrawRange(): one indirect draw covering whatever the slot's cull pass let through.
+     */
+    void recordIndirectDraws(VkCommandBuffer cmd, VkExtent2D extent, uint32_t slotIndex)
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, indirectPipeline);
+        descriptorHeap.bind(cmd, pipelineLayout, slotIndex);
+        setViewportAndScissor(cmd, extent);
+        if (!cullReady())
         {
-            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            return;
+        }
+        VkBuffer vertices = vertexBuffer;
+        VkDeviceSize vertexOffset = 0;
+        vkCmdBindVertexBuffers(cmd, 0, 1, &vertices, &vertexOffset);
+        vkCmdBindIndexBuffer(cmd, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+        IndirectPushConstants params{{camera[0], camera[1]}, objectBufferIndex};
+        vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(params), &params);
+        gpuCuller.recordDraw(cmd, slotIndex);
+    }
+
+    /**
+     * @return true once everything the cull pass and indirect draws read has arrived through the upload ring.
+     */
+    bool cullReady() const
+    {
+        return uploadRing.isReady(geometryTicket) && uploadRing.isReady(materialTicket) && uploadRing.isReady(objectTicket);
+    }
+
+    /**
+     * @brief each worker resets its own pool for this slot and records its slice of the draw list into a secondary command buffer that continues the primary's render pass. Secondaries don't inherit any state, hence recordDrawRange() rebinding everything.
+     */
+    void recordDrawsOnWorkers(FrameSlot &slot, VkFramebuffer framebuffer, VkExtent2D extent, WorkerPool &workers)
+    {
+        workers.run([&](uint32_t workerIndex)
+                    {
+            FrameSlot::WorkerCommands &worker = slot.workerCommands[workerIndex];
+            vkResetCommandPool(logicalDevice, worker.commandPool, 0);
+
+            VkCommandBufferInheritanceInfo inheritanceInfo{};
+            inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritanceInfo.renderPass = renderPass;
+            inheritanceInfo.subpass = 0;
+            inheritanceInfo.framebuffer = framebuffer;
+
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            beginInfo.pInheritanceInfo = &inheritanceInfo;
+            if (vkBeginCommandBuffer(worker.commandBuffer, &beginInfo) != VK_SUCCESS)
             {
-                indices.graphicsFamily = i;
+                throw std::runtime_error("failed to begin recording secondary command buffer!");
             }
 
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-            if (presentSupport)
+            auto [begin, end] = workers.slice(static_cast<uint32_t>(drawList.size()), workerIndex);
+            recordDrawRange(worker.commandBuffer, extent, static_cast<uint32_t>(&slot - frameSlots.data()), begin, end);
+
+            if (vkEndCommandBuffer(worker.commandBuffer) != VK_SUCCESS)
             {
-                indices.presentFamily = i;
+                throw std::runtime_error("failed to record secondary command buffer!");
             }
+        });
+    }
 
-            // exit early once we've found all the Q support we need.
-            if indices
-                .isComplete() break;
+    /**
+     * @brief times CPU-side recording of a whole frame, inline and then with 1, 2, 4, ... up to hardware_concurrency workers. Nothing gets submitted; the recordings go into frame slot 0, which is idle this early on.
+     */
+    void benchmarkRecording(uint32_t frames)
+    {
+        FrameSlot &slot = frameSlots[0];
+        VkFramebuffer framebuffer = config.headless ? slot.offscreenFramebuffer : swapChainFramebuffers[0];
+        VkExtent2D extent = config.headless ? VkExtent2D{WINDOW_WIDTH, WINDOW_HEIGHT} : swapChainExtent;
+        uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
 
-            i++;
+        std::vector<uint32_t> workerCounts = {0};
+        for (uint32_t count = 1; count < hardwareThreads; count *= 2)
+        {
+            workerCounts.push_back(count);
         }
+        workerCounts.push_back(hardwareThreads);
 
-        return indices;
+        std::cout << "recording " << drawList.size() << " draws per frame, " << frames << " frames per worker count\n";
+        for (uint32_t count : workerCounts)
+        {
+            std::unique_ptr<WorkerPool> workers = count > 0 ? std::make_unique<WorkerPool>(count) : nullptr;
+            SampleStats recordStats;
+            for (uint32_t i = 0; i < frames; i++)
+            {
+                vkResetCommandPool(logicalDevice, slot.commandPool, 0);
+                auto start = std::chrono::steady_clock::now();
+                recordFrame(slot, framebuffer, extent, i, workers.get());
+                recordStats.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+            recordStats.print(std::cout, count == 0 ? "frame recording, inline" : "frame recording, " + std::to_string(count) + " worker(s)");
+        }
     }
 
     /**
-     * @return the set of extension names we need to support GLFW and optionally debugging in debug builds.
+     * @brief for --scene-objects and --mesh, a slow circle around the world, so objects keep crossing the view edges. Depends only on frameIndex, so calling it again for the same frame is harmless.
      */
-    std::vector<const char *> getRequiredExtensions()
+    void updateCamera(uint32_t frameIndex)
+    {
+        if (config.sceneObjects > 0 || meshStreamer.enabled())
+        {
+            cameraAt(frameIndex, camera);
+        }
+    }
+
+    /**
+     * @brief the panning camera's position on frameIndex, whether or not it's in use yet; openMesh() prefetches around frame 0's.
+     */
+    static void cameraAt(uint32_t frameIndex, float out[2])
+    {
+        float t = static_cast<float>(frameIndex) * 0.01f;
+        out[0] = 0.5f * SCENE_WORLD_EXTENT * std::cos(t);
+        out[1] = 0.5f * SCENE_WORLD_EXTENT * std::sin(t);
+    }
+
+    /**
+     * @brief records a frame into framebuffer: clear to a color that cycles with frameIndex (so consecutive frames are visibly distinct) and draw the draw list on top, either inline or, given workers, as one secondary command buffer per worker. Headless frames then get copied into the slot's readback buffer; windowed ones are left in PRESENT_SRC by the render pass.
+     */
+    void recordFrame(FrameSlot &slot, VkFramebuffer framebuffer, VkExtent2D extent, uint32_t frameIndex, WorkerPool *workers)
     {
-        uint32_t glfwExtensionCount = 0;
-        const char **glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        VkCommandBuffer cmd = slot.commandBuffer;
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording command buffer!");
+        }
+
+        profiler.beginFrame(cmd, static_cast<uint32_t>(&slot - frameSlots.data()), frameIndex);
 
-        std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        // take ownership of whatever the upload ring finished this frame before anything reads it.
+        uploadRing.recordAcquires(cmd);
 
-        if (enableValidationLayers)
+        updateCamera(frameIndex);
+        uint32_t slotIndex = static_cast<uint32_t>(&slot - frameSlots.data());
+        if (gpuCuller.enabled() && cullReady())
         {
-            extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+            uint32_t cullScope = profiler.beginScope(cmd, "cull");
+            gpuCuller.recordCull(cmd, slotIndex, camera);
+            profiler.endScope(cmd, cullScope);
         }
 
-        return extensions;
+        float phase = static_cast<float>(frameIndex % 256) / 255.0f;
+        VkClearValue clearColor = {{{phase * 0.25f, 0.05f, (1.0f - phase) * 0.25f, 1.0f}}};
+
+        if (renderGraph.compiled())
+        {
+            renderGraph.setClearValue(graphSceneColor, clearColor);
+            renderGraph.setImportedImage(graphOutput, slot.offscreenImage, slot.offscreenImageView);
+            renderGraph.execute(cmd, slotIndex, &profiler);
+            recordReadback(cmd, slot, extent);
+            if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to record command buffer!");
+            }
+            return;
+        }
+
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;
+        renderPassInfo.framebuffer = framebuffer;
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = extent;
+        renderPassInfo.clearValueCount = 1;
+        renderPassInfo.pClearValues = &clearColor;
+        uint32_t mainPassScope = profiler.beginScope(cmd, "main pass");
+        if (gpuCuller.enabled())
+        {
+            // a single indirect draw is nothing worth splitting across workers.
+            vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            recordIndirectDraws(cmd, extent, slotIndex);
+        }
+        else if (meshStreamer.enabled())
+        {
+            vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            recordMeshDraws(cmd, extent, slotIndex);
+        }
+        else if (instanceTransforms.size() > 0)
+        {
+            vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            recordInstancedDraws(cmd, extent, slotIndex);
+        }
+        else if (workers == nullptr)
+        {
+            vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            recordDrawRange(cmd, extent, slotIndex, 0, static_cast<uint32_t>(drawList.size()));
+        }
+        else
+        {
+            // the subpass body comes entirely from the workers' secondaries, executed in worker order so draw order matches the draw list.
+            vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            recordDrawsOnWorkers(slot, framebuffer, extent, *workers);
+            std::vector<VkCommandBuffer> secondaries(workers->size());
+            for (uint32_t i = 0; i < workers->size(); i++)
+            {
+                secondaries[i] = slot.workerCommands[i].commandBuffer;
+            }
+            vkCmdExecuteCommands(cmd, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+        }
+
+        vkCmdEndRenderPass(cmd);
+        profiler.endScope(cmd, mainPassScope);
+
+        if (config.headless)
+        {
+            recordReadback(cmd, slot, extent);
+        }
+
+        if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record command buffer!");
+        }
+    }
+
+    /**
+     * @brief copies the headless frame into the slot's readback buffer. Whoever rendered it (the render pass or the render graph) has left the image in TRANSFER_SRC with a dependency covering the copy.
+     */
+    void recordReadback(VkCommandBuffer cmd, FrameSlot &slot, VkExtent2D extent)
+    {
+        uint32_t readbackScope = profiler.beginScope(cmd, "readback copy");
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {extent.width, extent.height, 1};
+        vkCmdCopyImageToBuffer(cmd, slot.offscreenImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.readbackBuffer, 1, &region);
+
+        // make the copy visible to the host once the slot's fence has signaled.
+        VkBufferMemoryBarrier toHost{};
+        toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.buffer = slot.readbackBuffer;
+        toHost.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &toHost, 0, nullptr);
+        profiler.endScope(cmd, readbackScope);
     }
 
     /**
-     * @brief checks if the input validation layers are supported by the driver.
-     * @input reference to a string vector of desired validation layers.
-     * @return true if all desired layers are supported; false otherwise.
+     * @brief consumes whatever the slot rendered last time around; only safe once its in-flight fence has signaled. Headless frames go to whichever sinks were asked for on the command line.
      */
-    bool checkValidationLayerSupport(const std::vector<std::string> &desiredValidationLayers)
+    void retireFrameSlot(FrameSlot &slot)
     {
-        uint32_t layerCount;
-        vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
-
-        std::vector<VkLayerProperties> availableLayers(layerCount);
-        vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
-
-        std::cout << "available val layers:\n";
-        for (const auto &layer : availableLayers)
+        if (!slot.pendingFrame.has_value())
         {
-            std::cout << '\t' << layer.layerName << '\n';
+            return;
         }
-
-        bool allDesiredLayersAreSupported = true;
-        for (const auto &desiredLayer : desiredValidationLayers)
+        uint32_t frameIndex = slot.pendingFrame.value();
+        slot.pendingFrame.reset();
+        if (gpuCuller.enabled())
         {
-            const auto it = std::find_if(availableLayers.begin(), availableLayers.end(), [desiredLayer](VkLayerProperties layerProps)
-                                         { return layerProps.layerName == desiredLayer; });
-            allDesiredLayersAreSupported = allDesiredLayersAreSupported && it != availableLayers.end();
-            if (allDesiredLayersAreSupported)
-            {
-                std::cout << "layer " << desiredLayer << " is supported." << '\n';
-            }
-            else
+            int64_t visible = gpuCuller.takeVisibleCount(static_cast<uint32_t>(&slot - frameSlots.data()));
+            if (visible >= 0)
             {
-                std::cerr << "layer " << desiredLayer << " is NOT supported." << '\n';
+                visibleObjectStats.add(static_cast<double>(visible));
             }
         }
-        return allDesiredLayersAreSupported;
+        if (!config.headless)
+        {
+            return;
+        }
+
+        const auto *pixels = static_cast<const uint8_t *>(slot.readbackMemory->mapped);
+        if (!config.dumpDirectory.empty())
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/frame_%05u.ppm", frameIndex);
+            writeFramePpm(config.dumpDirectory + name, pixels, WINDOW_WIDTH, WINDOW_HEIGHT);
+        }
+        if (sharedMemorySink)
+        {
+            sharedMemorySink->publish(pixels, frameIndex);
+        }
     }
 
     /**
-     * @brief Enumerates the supported vkinstance extensions on stdout and checks them against the input required extension set for the top level driver/vulkan implementation interface; we'll have to check for device specific extensions separately in checkDeviceExtensions().
-     * @param reference to a vector of strings identifying the required extension names.
-     * @return true if all the required extensions are also found in the supported extensions set; false otherwise.
+     * @brief one trip around the frame ring. Outside of the presentation engine throttling us in acquire, the only place the CPU blocks is the wait on this slot's fence, i.e. when we've lapped the GPU by framesInFlight frames; everything after it (recording, submission) overlaps with the GPU chewing on the previous frames.
+     * @return false if the frame was skipped because the swapchain had to be recreated first; the caller should try the same frame again.
      */
-    bool checkInstanceExtensions(const std::vector<std::string> &requiredExtensions)
+    bool drawFrame(uint32_t frameIndex)
     {
-        // check which vk extensions the driver supports against our requirements.
-        uint32_t supportedExtensionCount = 0;
-        // call in once to find out how many vk extensions the driver supports.
-        vkEnumerateInstanceExtensionProperties(nullptr, &supportedExtensionCount, nullptr);
-        // init vector of extension prop structs to the count of supported extensions we just learned.
-        std::vector<VkExtensionProperties> supportedExtensions(supportedExtensionCount);
-        // call in again to populate the supported extensions via vector's C data interface.
-        vkEnumerateInstanceExtensionProperties(nullptr, &supportedExtensionCount, supportedExtensions.data());
+        auto frameStart = std::chrono::steady_clock::now();
+        updateValidationWindow(frameIndex);
+        FrameSlot &slot = frameSlots[currentFrameSlot];
+        profiler.setCpuFrame(frameIndex);
+        auto frameScope = profiler.cpuScope("frame");
 
-        std::cout << "available extensions:\n";
-        for (const auto &extension : supportedExtensions)
         {
-            std::cout << '\t' << extension.extensionName << '\n';
+            auto scope = profiler.cpuScope("wait for frame slot");
+            VkFence fence = slot.inFlightFence;
+            vkWaitForFences(logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX);
         }
+        auto waitEnd = std::chrono::steady_clock::now();
+        fenceWaitStats.add(std::chrono::duration<double, std::milli>(waitEnd - frameStart).count());
 
-        bool allRequiredExtensionsAreSupported = true;
-        for (const auto &requiredExtension : requiredExtensions)
         {
-            const auto it = std::find_if(supportedExtensions.begin(), supportedExtensions.end(), [requiredExtension](VkExtensionProperties props)
-                                         { return props.extensionName == requiredExtension; });
-            allRequiredExtensionsAreSupported = allRequiredExtensionsAreSupported && it != supportedExtensions.end();
-            if (allRequiredExtensionsAreSupported)
+            auto scope = profiler.cpuScope("retire frame slot");
+            retireFrameSlot(slot);
+        }
+        // the slot's fence has signaled, so on the fallback path its copy of the heap is no longer in use and can catch up.
+        descriptorHeap.flush(currentFrameSlot);
+        // and every frame up to frameIndex - framesInFlight with it, so whatever was retired back then can go.
+        deletionQueue.collect(frameIndex);
+
+        VkFramebuffer framebuffer = slot.offscreenFramebuffer;
+        VkExtent2D extent = {WINDOW_WIDTH, WINDOW_HEIGHT};
+        uint32_t imageIndex = 0;
+        if (!config.headless)
+        {
+            VkResult result;
             {
-                std::cout << "extension " << requiredExtension << " is supported." << '\n';
+                auto scope = profiler.cpuScope("acquire");
+                result = vkAcquireNextImageKHR(logicalDevice, swapChain, UINT64_MAX, slot.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
             }
-            else
+            acquireWaitStats.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitEnd).count());
+            if (result == VK_ERROR_OUT_OF_DATE_KHR)
             {
-                std::cerr << "extension " << requiredExtension << " is NOT supported." << '\n';
+                // nothing was acquired and the semaphore wasn't signaled, so the slot is untouched; the fence is still signaled too since we haven't reset it yet.
+                recreateSwapChain(frameIndex);
+                return false;
+            }
+            else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+            {
+                throw std::runtime_error("failed to acquire swap chain image!");
             }
+            framebuffer = swapChainFramebuffers[imageIndex];
+            extent = swapChainExtent;
         }
-        return allRequiredExtensionsAreSupported;
-    }
-
-    bool checkDeviceExtensionSupport(VkPhysicalDevice device)
-    {
-        uint32_t extensionCount;
-        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
-
-        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-        std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
-        for (const auto &extension : availableExtensions)
+        // only reset once we're sure we'll submit work that signals it again, otherwise the next wait on this slot deadlocks.
+        VkFence fence = slot.inFlightFence;
+        vkResetFences(logicalDevice, 1, &fence);
+        vkResetCommandPool(logicalDevice, slot.commandPool, 0);
+        if (meshStreamer.enabled())
         {
-            requiredExtensions.erase(extension.extensionName);
+            // before submitFrame(), so chunks that just came into range start uploading this frame.
+            auto scope = profiler.cpuScope("mesh streaming");
+            updateCamera(frameIndex + outputFrameOffset);
+            meshStreamer.update(frameIndex, camera, MESH_PREFETCH_MARGIN);
         }
-
-        return requiredExtensions.empty();
-    }
-
-    /**
-     * Checks the swapchain properties supported by the input device, e.g. surface capabilities such as min/max number of images, surface formats such as color space, and available presentation modes.
-     * @return a SwapChainSupportDetails struct populated for the given device.
-     */
-    SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device)
-    {
-        SwapChainSupportDetails details;
-
-        // query surface cap
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
-
-        // query surface formats
-        uint32_t formatCount;
-        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
-        if (formatCount != 0)
+        if (instanceTransforms.size() > 0)
         {
-            details.formats.resize(formatCount);
-            vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
+            // the slot's fence was just waited on, so the GPU is done reading last time's matrices. A fixed step keeps runs (and dumped frames) reproducible whatever the frame rate.
+            auto scope = profiler.cpuScope("instance update");
+            auto updateStart = std::chrono::steady_clock::now();
+            instanceTransforms.update(1.0f / 60.0f, static_cast<float *>(slot.instanceMemory->mapped), instanceWorkers.get());
+            instanceUpdateStats.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count());
         }
-
-        // query present modes
-        uint32_t presentModeCount;
-        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
-
-        if (presentModeCount != 0)
         {
-            details.presentModes.resize(presentModeCount);
-            vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
+            auto scope = profiler.cpuScope("upload submit");
+            uploadRing.submitFrame(frameIndex);
         }
-
-        return details;
-    }
-
-    void initVulkan()
-    {
-        createInstance();
-        setupDebugMessenger();
-        createSurface();
-        // Physical device represents the actual hardware capabilities available for Vulkan
-        pickPhysicalDevice();
-        // Logical device is how we interace with the physical device; there can be many logical devices interfacing with one physical device and they maintain independent states
-        createLogicalDevice();
-    }
-
-    void createSurface()
-    {
-        if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
+        reportStreamTest(frameIndex);
         {
-            throw std::runtime_error("failed to create window surface!");
+            auto scope = profiler.cpuScope("record");
+            recordFrame(slot, framebuffer, extent, frameIndex + outputFrameOffset, recordWorkers.get());
         }
-    }
-
-    void createLogicalDevice()
-    {
-        QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
-        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
-        float queuePriority = 1.0f;
-        for (uint32_t queueFamily : uniqueQueueFamilies)
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &slot.commandBuffer;
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<VkPipelineStageFlags> waitStages;
+        std::vector<uint64_t> waitValues;
+        VkSemaphore renderFinished = VK_NULL_HANDLE;
+        if (!config.headless)
         {
-            VkDeviceQueueCreateInfo queueCreateInfo{};
-            queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-            queueCreateInfo.queueFamilyIndex = queueFamily;
-            queueCreateInfo.queueCount = 1;
-            queueCreateInfo.pQueuePriorities = &queuePriority;
-            queueCreateInfos.push_back(queueCreateInfo);
+            waitSemaphores.push_back(slot.imageAvailableSemaphore);
+            waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            waitValues.push_back(0);
+            submitInfo.signalSemaphoreCount = 1;
+            renderFinished = swapChainRenderFinishedSemaphores[imageIndex];
+            submitInfo.pSignalSemaphores = &renderFinished;
         }
-
-        VkPhysicalDeviceFeatures deviceFeatures{}; // todo: revisit when we finally start doing anything
-
-        VkDeviceCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        createInfo.pQueueCreateInfos = queueCreateInfos.data();
-        createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
-        createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
-
-        if (enableValidationLayers)
+        uploadRing.appendWaits(waitSemaphores, waitStages, waitValues);
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        submitInfo.pWaitSemaphores = waitSemaphores.data();
+        submitInfo.pWaitDstStageMask = waitStages.data();
+        // binary semaphores in the same submit just ignore their value.
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+        if (uploadRing.usesTimeline())
         {
-            createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
-            createInfo.ppEnabledLayerNames = validationLayers.data();
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+            timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+            timelineInfo.pWaitSemaphoreValues = waitValues.data();
+            submitInfo.pNext = &timelineInfo;
         }
-        else
+        profiler.markSubmit();
+        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, slot.inFlightFence) != VK_SUCCESS)
         {
-            createInfo.enabledLayerCount = 0;
+            throw std::runtime_error("failed to submit frame!");
         }
+        // the frame's place in the batch, which is what output gets named after; frameIndex itself stays local and sequential for the upload ring.
+        slot.pendingFrame = frameIndex + outputFrameOffset;
+        uint64_t presentId = presentWaitEnabled ? nextPresentId++ : 0;
+        latency.submitted(presentId);
 
-        if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &logicalDevice) != VK_SUCCESS)
+        if (!config.headless)
         {
-            throw std::runtime_error("failed to create logical device!");
+            VkPresentInfoKHR presentInfo{};
+            presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+            presentInfo.waitSemaphoreCount = 1;
+            VkSwapchainKHR presentSwapChain = swapChain;
+            presentInfo.pWaitSemaphores = &renderFinished;
+            presentInfo.swapchainCount = 1;
+            presentInfo.pSwapchains = &presentSwapChain;
+            presentInfo.pImageIndices = &imageIndex;
+            VkPresentIdKHR presentIdInfo{};
+            if (presentId != 0)
+            {
+                presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+                presentIdInfo.swapchainCount = 1;
+                presentIdInfo.pPresentIds = &presentId;
+                presentInfo.pNext = &presentIdInfo;
+                lastPresentId = presentId;
+            }
+
+            VkResult result;
+            {
+                auto scope = profiler.cpuScope("present");
+                result = vkQueuePresentKHR(presentQueue, &presentInfo);
+            }
+            if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
+            {
+                // the frame went out (or was dropped by the driver), so the next frame is the first on the new swapchain.
+                recreateSwapChain(frameIndex + 1);
+            }
+            else if (result != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to present swap chain image!");
+            }
+        }
+
+        currentFrameSlot = (currentFrameSlot + 1) % static_cast<uint32_t>(frameSlots.size());
+        cpuFrameStats.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+        return true;
+    }
+
+    /**
+     * @brief waits out every slot still in flight and consumes its output, so the tail end of a run doesn't get dropped.
+     */
+    void drainFrameSlots()
+    {
+        for (uint32_t i = 0; i < frameSlots.size(); i++)
+        {
+            // walk the ring oldest-first so dumped frames come out in order.
+            FrameSlot &slot = frameSlots[(currentFrameSlot + i) % frameSlots.size()];
+            VkFence fence = slot.inFlightFence;
+            vkWaitForFences(logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+            retireFrameSlot(slot);
         }
-        vkGetDeviceQueue(logicalDevice, indices.graphicsFamily.value(), 0, &graphicsQueue);
-        vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
     }
 
     void pickPhysicalDevice()
@@ -421,15 +3432,31 @@ private:
         {
             throw std::runtime_error("failed to find GPUs with Vulkan support!");
         }
-        std::vector<VkPhysicalDevice> devices(deviceCount);
-        vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+        std::vector<VkPhysicalDevice> physicalDevices(deviceCount);
+        vkEnumeratePhysicalDevices(instance, &deviceCount, physicalDevices.data());
+
+        // snapshot every candidate once up front; scoring and everything after selection read from these. The cache and scoring policy were read by loadStartupCaches().
+        auto snapshotStart = std::chrono::steady_clock::now();
+        std::vector<DeviceCapabilities> devices;
+        for (VkPhysicalDevice device : physicalDevices)
+        {
+            devices.push_back(deviceCapabilityCache.lookup(device));
+        }
+        if (scoringPolicy.benchmark)
+        {
+            benchmarkDevices(devices);
+        }
+        deviceCapabilityCache.save();
+        double snapshotMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - snapshotStart).count();
+        std::cout << "device capabilities: " << devices.size() << " device(s) in " << snapshotMs << " ms ("
+                  << deviceCapabilityCache.hitCount() << " cached, " << deviceCapabilityCache.missCount() << " queried)\n";
 
         /* first come algo
         for (const auto &device : devices)
         {
             if (isDeviceSuitable(device))
             {
-                physicalDevice = device;
+                physicalDevice = device.device;
                 break;
             }
         }
@@ -440,139 +3467,483 @@ private:
         }
         */
 
-        // Use an ordered map to automatically sort candidates by increasing score
-        std::multimap<int, VkPhysicalDevice> candidates;
+        reportDeviceGroups();
 
-        for (const auto &device : devices)
+        // keep every suitable device, best first, so --device and --multi-gpu can reach past the winner.
+        std::vector<const DeviceCapabilities *> suitable = deviceSelector().rank(devices, &std::cout);
+        suitableDevices = static_cast<uint32_t>(suitable.size());
+        if (suitable.empty())
         {
-            int score = rateDeviceSuitability(device);
-            candidates.insert(std::make_pair(score, device));
+            throw std::runtime_error("failed to find a suitable GPU!");
+        }
+        if (config.deviceRank >= suitable.size())
+        {
+            throw std::runtime_error("asked for device " + std::to_string(config.deviceRank) + " but only " + std::to_string(suitable.size()) + " device(s) are suitable!");
         }
+        deviceCapabilities = *suitable[config.deviceRank];
+        physicalDevice = deviceCapabilities.device;
+        physicalDeviceProperties = deviceCapabilities.properties;
+        std::cout << "Selecting GPU device " << physicalDeviceProperties.deviceName << " (" << config.deviceRank + 1 << " of " << suitable.size() << " suitable)\n";
+    }
 
-        // Check if the best candidate is suitable at all
-        if (candidates.rbegin()->first > 0)
+    /**
+     * @brief runs DeviceBenchmark on every device that doesn't have results yet and records them in the capability cache, so this only costs anything on the first launch per device + driver. A device that fails to benchmark is just ranked without measurements.
+     *
+     * Each benchmark brings up its own logical device, so they all run at once, one thread per device (unless --startup-threads 0), and the whole thing takes as long as the slowest device rather than the sum. Results are reported and cached afterwards, in device order.
+     */
+    void benchmarkDevices(std::vector<DeviceCapabilities> &devices)
+    {
+        std::span<const uint32_t> computeSpirv = embeddedShader("bench.comp");
+        // empty for devices that already had results.
+        std::vector<std::optional<double>> ms(devices.size());
+        std::vector<std::string> errors(devices.size());
+        auto benchmark = [&](size_t i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            try
+            {
+                devices[i].benchmark = DeviceBenchmark::run(devices[i], computeSpirv);
+            }
+            catch (const std::exception &e)
+            {
+                errors[i] = e.what();
+            }
+            ms[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < devices.size(); i++)
         {
-            physicalDevice = candidates.rbegin()->second;
-            VkPhysicalDeviceProperties deviceProperties;
-            vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
-            std::cout << "Selecting GPU device " << deviceProperties.deviceName << '\n';
+            if (devices[i].benchmark.measured)
+            {
+                continue;
+            }
+            if (config.startupThreads == 0)
+            {
+                benchmark(i);
+            }
+            else
+            {
+                threads.emplace_back(benchmark, i);
+            }
         }
-        else
+        for (auto &thread : threads)
         {
-            throw std::runtime_error("failed to find a suitable GPU!");
+            thread.join();
         }
-    }
 
-    bool isDeviceSuitable(VkPhysicalDevice device)
-    {
-        VkPhysicalDeviceProperties deviceProperties;
-        vkGetPhysicalDeviceProperties(device, &deviceProperties);
-        VkPhysicalDeviceFeatures deviceFeatures;
-        vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
-        return deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU &&
-               deviceFeatures.geometryShader;
+        for (size_t i = 0; i < devices.size(); i++)
+        {
+            const DeviceCapabilities &device = devices[i];
+            if (!errors[i].empty())
+            {
+                std::cerr << "benchmark failed on " << device.properties.deviceName << ": " << errors[i] << '\n';
+                continue;
+            }
+            if (!ms[i])
+            {
+                continue;
+            }
+            deviceCapabilityCache.update(device);
+            std::cout << "benchmarked " << device.properties.deviceName << " in " << *ms[i] << " ms: fill " << device.benchmark.fillGpixelsPerSec << " Gpix/s, compute "
+                      << device.benchmark.computeGflops << " GFLOP/s, copy " << device.benchmark.copyGBPerSec << " GB/s\n";
+        }
     }
 
-    int rateDeviceSuitability(VkPhysicalDevice device)
+    /**
+     * @brief logs how the loader groups physical devices. Linked GPUs (SLI/CrossFire-style groups with more than one member) could share one logical device with split- or alternate-frame rendering through device masks; --multi-gpu doesn't go there and drives every device, grouped or not, as an independent logical device, which works for any mix of vendors and for software ICDs.
+     */
+    void reportDeviceGroups()
     {
-        int score = 0;
-
-        VkPhysicalDeviceProperties deviceProperties;
-        vkGetPhysicalDeviceProperties(device, &deviceProperties);
-        VkPhysicalDeviceFeatures deviceFeatures;
-        vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
-
-        std::cout << "Considering gpu device " << deviceProperties.deviceName << '\n';
-
-        // Discrete GPUs have a significant performance advantage
-        if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+        if (instanceApiVersion < VK_API_VERSION_1_1)
         {
-            score += 1000;
+            return;
         }
-
-        // Maximum possible size of textures affects graphics quality
-        score += deviceProperties.limits.maxImageDimension2D;
-
-        // Application can't function without geometry shaders or required Q family(ies)
-        QueueFamilyIndices indices = findQueueFamilies(device);
-        if (!deviceFeatures.geometryShader || !indices.isComplete() || !checkDeviceExtensionSupport(device))
+        auto enumerateGroups = reinterpret_cast<PFN_vkEnumeratePhysicalDeviceGroups>(vkGetInstanceProcAddr(instance, "vkEnumeratePhysicalDeviceGroups"));
+        if (enumerateGroups == nullptr)
         {
-            return 0;
+            return;
         }
-        else
+        uint32_t groupCount = 0;
+        enumerateGroups(instance, &groupCount, nullptr);
+        std::vector<VkPhysicalDeviceGroupProperties> groups(groupCount);
+        for (auto &group : groups)
         {
-            // now that we know we support the required extensions, including swapchain, we can query the swapchain capabilities to see if those meet our minimum requirements.
-            bool swapChainAdequate = false;
-            SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
-            swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
-            if (!swapCainAdequate)
-            {
-                return 0;
-            }
-
-            // finally, last minute adjustments for optimal nice-to-haves now that we've passed our minimum viability checks and gathered all the details.
-            if (indices.graphicsFamily == indices.presentFamily)
+            group.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GROUP_PROPERTIES;
+        }
+        enumerateGroups(instance, &groupCount, groups.data());
+        uint32_t linked = 0;
+        for (const auto &group : groups)
+        {
+            if (group.physicalDeviceCount > 1)
             {
-                // slight bump for a device whose gfx and present Q are the same guy, for efficiency.
-                score += 100;
+                linked++;
             }
         }
+        std::cout << "device groups: " << groupCount << " group(s), " << linked << " with linked devices\n";
+    }
 
-        return score;
+    bool isDeviceSuitable(const DeviceCapabilities &device)
+    {
+        return device.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU &&
+               device.features.geometryShader;
     }
 
     void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo)
     {
         createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-        createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-        createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+        // filtering here rather than in the callback means the layer doesn't even format the messages we'd throw away.
+        createInfo.messageSeverity = config.debugLog.severities;
+        createInfo.messageType = config.debugLog.types;
         createInfo.pfnUserCallback = debugCallback;
+        createInfo.pUserData = &debugLog;
     }
 
     void setupDebugMessenger()
     {
-        if (!enableValidationLayers)
+        if (!config.validation)
             return;
 
         VkDebugUtilsMessengerCreateInfoEXT createInfo{};
         populateDebugMessengerCreateInfo(createInfo);
 
-        if (createDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS)
+        VkDebugUtilsMessengerEXT messenger;
+        if (createDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &messenger) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to set up debug messenger!");
         }
+        debugMessenger = UniqueDebugMessenger(instance, messenger);
+    }
+
+    /**
+     * @brief applies --validation-frames: destroys the messenger once the window runs out and recreates it when SIGUSR1 asks for another one.
+     *
+     * This only takes the callback off the table, and with it the message formatting and our logging; the layer itself stays loaded (it can't be unloaded without a new instance) and keeps validating every call.
+     */
+    void updateValidationWindow(uint32_t frameIndex)
+    {
+        if (!config.validation || config.validationFrames == 0)
+        {
+            return;
+        }
+        uint32_t requests = validationRequests.load(std::memory_order_relaxed);
+        if (requests != seenValidationRequests)
+        {
+            seenValidationRequests = requests;
+            validationUntilFrame = frameIndex + config.validationFrames;
+            if (debugMessenger == VK_NULL_HANDLE)
+            {
+                setupDebugMessenger();
+                std::cout << "debug messenger back on for frames " << frameIndex << " to " << validationUntilFrame - 1 << '\n';
+            }
+        }
+        if (debugMessenger != VK_NULL_HANDLE && frameIndex >= validationUntilFrame)
+        {
+            debugMessenger.reset();
+            std::cout << "debug messenger muted after frame " << frameIndex - 1 << " (SIGUSR1 turns it back on)\n";
+        }
+    }
+
+    /**
+     * @brief minimized, or with --pause-unfocused, not in focus.
+     */
+    bool windowIdle()
+    {
+        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED))
+        {
+            return true;
+        }
+        return config.pauseUnfocused && !glfwGetWindowAttrib(window, GLFW_FOCUSED);
+    }
+
+    /**
+     * @brief with present IDs, records when earlier frames reached the screen. Under --pacing present-wait this is also the pacing: it blocks until the previous frame is on screen, so there's never more than the frame being rendered queued behind the display. Otherwise it only polls, so completion times land up to a frame late.
+     */
+    void waitForPresents()
+    {
+        if (!presentWaitEnabled)
+        {
+            return;
+        }
+        if (config.pacing == PacingMode::PresentWait && lastPresentId != 0)
+        {
+            // bounded, since a present to an occluded window may never complete; a timeout just means this frame goes unpaced.
+            VkResult result = waitForPresent(logicalDevice, swapChain, lastPresentId, PRESENT_WAIT_TIMEOUT_NS);
+            if (result == VK_SUCCESS)
+            {
+                latency.presented(lastPresentId, std::chrono::steady_clock::now());
+            }
+        }
+        while (auto id = latency.oldestInFlight())
+        {
+            if (waitForPresent(logicalDevice, swapChain, *id, 0) != VK_SUCCESS)
+            {
+                break;
+            }
+            latency.presented(*id, std::chrono::steady_clock::now());
+        }
     }
 
     void mainLoop()
     {
-        while (!glfwWindowShouldClose(window))
+        auto start = std::chrono::steady_clock::now();
+        uint32_t frame = 0;
+        while (config.frameCount == 0 || frame < config.frameCount)
         {
-            glfwPollEvents();
+            if (!config.headless)
+            {
+                if (glfwWindowShouldClose(window))
+                {
+                    break;
+                }
+                if (config.idleWait && windowIdle())
+                {
+                    // nothing to show anyone, so sleep until the window manager or the user says otherwise instead of spinning out frames.
+                    glfwWaitEvents();
+                    pacer.reset();
+                    continue;
+                }
+                waitForPresents();
+            }
+            pacer.waitForNextFrame();
+            if (!config.headless)
+            {
+                // after pacing, so the frame picks up input as late as it can.
+                glfwPollEvents();
+            }
+            if (drawFrame(frame))
+            {
+                if (frame == 0)
+                {
+                    // submitted rather than on screen, but that's the part startup controls.
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - launchTime).count();
+                    std::cout << "time to first frame: " << ms << " ms\n";
+                }
+                frame++;
+            }
+        }
+        drainFrameSlots();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        reportRun(std::cout, frame, seconds);
+    }
+
+    /**
+     * @brief mainLoop() for a --multi-gpu worker: frames come from the shared scheduler in chunks, and each chunk's wall time goes back to it as this device's throughput. Frame numbers stay local and sequential as far as the frame ring and upload ring are concerned; outputFrameOffset maps them onto the batch.
+     */
+    void shardLoop(FrameScheduler &scheduler, uint32_t worker)
+    {
+        auto start = std::chrono::steady_clock::now();
+        uint32_t frame = 0;
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        while (scheduler.next(worker, begin, end))
+        {
+            auto chunkStart = std::chrono::steady_clock::now();
+            // unsigned wraparound is fine here, it comes back out when added to frame.
+            outputFrameOffset = begin - frame;
+            for (uint32_t i = begin; i < end; i++)
+            {
+                // headless frames never get skipped, so no retry loop like mainLoop()'s.
+                drawFrame(frame);
+                frame++;
+            }
+            scheduler.report(worker, end - begin, std::chrono::duration<double>(std::chrono::steady_clock::now() - chunkStart).count());
+        }
+        drainFrameSlots();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // every worker reports at once, so build the whole block before it goes near std::cout.
+        std::ostringstream report;
+        report << "worker " << worker << " on " << physicalDeviceProperties.deviceName << ":\n";
+        reportRun(report, frame, seconds);
+        std::cout << report.str();
+    }
+
+    void reportRun(std::ostream &out, uint32_t frames, double seconds)
+    {
+        out << "rendered " << frames << " frames in " << seconds << "s (" << frames / seconds << " fps) with "
+            << config.framesInFlight << " frame(s) in flight\n";
+        fenceWaitStats.print(out, "cpu wait on in-flight fence");
+        if (!config.headless)
+        {
+            acquireWaitStats.print(out, "cpu wait in acquire");
+            out << "swapchain recreated " << swapChainRecreations << " time(s)\n";
+        }
+        cpuFrameStats.print(out, "cpu frame time");
+        if (pacer.mode() != PacingMode::Uncapped)
+        {
+            pacer.printStats(out);
+        }
+        latency.printStats(out);
+        if (meshStreamer.enabled())
+        {
+            meshStreamer.printStats(out);
+        }
+        if (gpuCuller.enabled())
+        {
+            visibleObjectStats.print(out, "gpu cull survivors", "objects of " + std::to_string(cullObjects.size()));
+        }
+        if (instanceTransforms.size() > 0)
+        {
+            instanceUpdateStats.print(out, "instance transform update (" + std::to_string(instanceTransforms.size()) + " instances, " +
+                                               std::to_string(instanceWorkers ? instanceWorkers->size() : 0) + " worker(s))");
+        }
+
+        if (profiler.enabled())
+        {
+            profiler.collectAll();
+            profiler.printStats(out);
+            if (!config.tracePath.empty())
+            {
+                profiler.writeChromeTrace(config.tracePath);
+            }
         }
     }
 
     void cleanup()
     {
-        vkDestroyDevice(logicalDevice, nullptr);
-        if (enableValidationLayers)
+        // shutting down, not resizing: this is the one place a full device idle is fine.
+        vkDeviceWaitIdle(logicalDevice);
+        pipelineCache.printStats(std::cout);
+        pipelineCache.save();
+        uploadRing.printStats(std::cout);
+        descriptorHeap.printStats(std::cout);
+        deviceAllocator.printStats(std::cout);
+        deletionQueue.printStats(std::cout);
+        deletionQueue.flush();
+        destroyFrameSlots();
+        uploadRing.destroy();
+        profiler.destroy();
+        destroyCullObjects();
+        destroyMaterials();
+        if (meshStreamer.enabled())
+        {
+            meshStreamer.destroy();
+            meshAsset.close();
+        }
+        vertexBuffer.reset();
+        vertexBufferMemory.reset();
+        indexBuffer.reset();
+        indexBufferMemory.reset();
+        streamTestBuffer.reset();
+        streamTestMemory.reset();
+        swapChainRenderFinishedSemaphores.clear();
+        swapChainFramebuffers.clear();
+        swapChainImageViews.clear();
+        swapChain.reset();
+        graphicsPipeline.reset();
+        instancedPipeline.reset();
+        instancedVertShaderModule.reset();
+        renderGraph.destroy();
+        pipelineLayout.reset();
+        descriptorHeap.destroy();
+        fragShaderModule.reset();
+        vertShaderModule.reset();
+        renderPass.reset();
+        pipelineCache.destroy();
+        deviceAllocator.destroy();
+        logicalDevice.reset();
+        debugMessenger.reset();
+        surface.reset();
+        instance.reset();
+        // the instance (and with it the last chance of a message) is gone, so flush and print the per-ID summary.
+        debugLog.stop();
+        if (window != nullptr)
         {
-            destroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+            glfwDestroyWindow(window);
+            glfwTerminate();
         }
-        vkDestroySurfaceKHR(instance, surface, nullptr);
-        vkDestroyInstance(instance, nullptr);
-        glfwDestroyWindow(window);
-        glfwTerminate();
     }
 };
 
-int main()
+/**
+ * @return path with ".N" appended for worker N > 0, so --multi-gpu workers don't all save over the same file; empty (disabled) paths stay empty.
+ */
+std::string workerPath(const std::string &path, uint32_t worker)
+{
+    if (path.empty() || worker == 0)
+    {
+        return path;
+    }
+    return path + "." + std::to_string(worker);
+}
+
+/**
+ * @brief --multi-gpu: one HelloTriangleApplication (instance, logical device and all) per suitable device and replica, each on its own thread, pulling chunks of the batch from a shared FrameScheduler.
+ *
+ * Worker 0 initializes alone first. That's how we find out how many devices there are, and it means worker 0 is the one that fills the device capability cache, so everyone after it only reads. A worker that fails to start just never asks for frames; the rest cover for it and the error is rethrown once they're done.
+ */
+void runMultiGpu(const AppConfig &config)
 {
-    HelloTriangleApplication app;
+    std::vector<std::unique_ptr<HelloTriangleApplication>> workers;
+    workers.push_back(std::make_unique<HelloTriangleApplication>(config));
+    workers[0]->init();
+    uint32_t workerCount = workers[0]->suitableDeviceCount() * config.deviceReplicas;
+    std::cout << "multi-gpu: " << workers[0]->suitableDeviceCount() << " suitable device(s) x " << config.deviceReplicas << " replica(s) = " << workerCount << " worker(s)\n";
+    for (uint32_t worker = 1; worker < workerCount; worker++)
+    {
+        AppConfig workerConfig = config;
+        workerConfig.deviceRank = worker / config.deviceReplicas;
+        workerConfig.pipelineCachePath = workerPath(config.pipelineCachePath, worker);
+        workerConfig.tracePath = workerPath(config.tracePath, worker);
+        workers.push_back(std::make_unique<HelloTriangleApplication>(workerConfig));
+    }
+
+    FrameScheduler scheduler(config.frameCount, workerCount);
+    std::vector<std::exception_ptr> errors(workerCount);
+    std::vector<std::thread> threads;
+    for (uint32_t worker = 0; worker < workerCount; worker++)
+    {
+        threads.emplace_back([&, worker]()
+                             {
+            try
+            {
+                if (worker > 0)
+                {
+                    workers[worker]->init();
+                }
+                workers[worker]->renderShard(scheduler, worker);
+            }
+            catch (...)
+            {
+                errors[worker] = std::current_exception();
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    scheduler.printStats(std::cout);
+    for (auto &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
 
+int main(int argc, char **argv)
+{
     try
     {
-        app.run();
+        AppConfig config = parseArguments(argc, argv);
+#ifdef SIGUSR1
+        if (config.validation && config.validationFrames > 0)
+        {
+            // a lock-free atomic increment is about all that's safe to do in a signal handler; drawFrame() picks it up.
+            std::signal(SIGUSR1, [](int)
+                        { validationRequests.fetch_add(1, std::memory_order_relaxed); });
+        }
+#endif
+        if (config.multiGpu)
+        {
+            runMultiGpu(config);
+        }
+        else
+        {
+            HelloTriangleApplication app(config);
+            app.run();
+        }
     }
     catch (const std::exception &e)
     {
@@ -0,0 +1,479 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "DeviceAllocator.hpp"
+#include "QueueSync.hpp"
+#include "Stats.hpp"
+
+/**
+ * @brief streaming uploads through one persistently mapped staging buffer, split into one region per frame in flight.
+ *
+ * Callers queue copies into device-local buffers and images with uploadBuffer()/uploadImage() whenever they like; once per frame submitFrame() packs as much of the queue as fits into the current region, records all of it into a single command buffer and submits that to the transfer queue. Anything that doesn't fit (including assets bigger than a whole region) just carries over to the next frame, so a big asset streams in over several frames instead of stalling one.
+ *
+ * Destinations are treated as freshly created: nothing else may touch them until their ticket is ready. When the job's last chunk goes out, the transfer queue releases the destination and the graphics queue acquires it in the same frame (see recordAcquires()), so from that frame on it's owned by graphics and usable.
+ */
+class UploadRing
+{
+public:
+    /**
+     * @param graphicsFamily the family that ends up owning uploaded resources.
+     * @param useTimeline signal a TimelineSemaphore per submission instead of a binary semaphore per region.
+     * @param coreTimeline timelines come from core 1.2 rather than VK_KHR_timeline_semaphore; see TimelineSemaphore::create().
+     * @param copyOffsetAlignment the device's optimalBufferCopyOffsetAlignment; every staged chunk starts on a multiple of it (and of 16).
+     */
+    void create(VkDevice device, DeviceAllocator &allocator, uint32_t transferFamily, VkQueue transferQueue, uint32_t graphicsFamily,
+                VkDeviceSize ringSize, uint32_t regionCount, bool useTimeline, bool coreTimeline, VkDeviceSize copyOffsetAlignment)
+    {
+        this->device = device;
+        this->allocator = &allocator;
+        this->transferFamily = transferFamily;
+        this->transferQueue = transferQueue;
+        this->graphicsFamily = graphicsFamily;
+        this->useTimeline = useTimeline;
+        chunkAlignment = std::max<VkDeviceSize>(16, copyOffsetAlignment);
+        // regions start on an aligned offset too, otherwise every chunk staged past region 0 inherits the remainder.
+        regionSize = ringSize / regionCount / chunkAlignment * chunkAlignment;
+        if (regionSize == 0)
+        {
+            throw std::runtime_error("upload ring too small for its region count!");
+        }
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = regionSize * regionCount;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &ringBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload ring buffer!");
+        }
+        ringMemory = allocator.allocateForBuffer(device, ringBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, true);
+
+        if (useTimeline)
+        {
+            timeline.create(device, coreTimeline);
+        }
+
+        regions.resize(regionCount);
+        for (auto &region : regions)
+        {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = transferFamily;
+            if (vkCreateCommandPool(device, &poolInfo, nullptr, &region.commandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create upload command pool!");
+            }
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = region.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(device, &allocInfo, &region.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            if (vkCreateFence(device, &fenceInfo, nullptr, &region.fence) != VK_SUCCESS ||
+                (!useTimeline && vkCreateSemaphore(device, &semaphoreInfo, nullptr, &region.semaphore) != VK_SUCCESS))
+            {
+                throw std::runtime_error("failed to create upload sync objects!");
+            }
+        }
+    }
+
+    UploadRing() = default;
+    UploadRing(const UploadRing &) = delete;
+    UploadRing &operator=(const UploadRing &) = delete;
+
+    ~UploadRing()
+    {
+        destroy();
+    }
+
+    /**
+     * @brief only call once the transfer queue is idle. Safe to call again, or on a ring that was never created.
+     */
+    void destroy()
+    {
+        if (device == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        for (auto &region : regions)
+        {
+            vkDestroyFence(device, region.fence, nullptr);
+            if (region.semaphore != VK_NULL_HANDLE)
+            {
+                vkDestroySemaphore(device, region.semaphore, nullptr);
+            }
+            vkDestroyCommandPool(device, region.commandPool, nullptr);
+        }
+        regions.clear();
+        timeline.destroy();
+        vkDestroyBuffer(device, ringBuffer, nullptr);
+        ringBuffer = VK_NULL_HANDLE;
+        allocator->free(ringMemory);
+        device = VK_NULL_HANDLE;
+    }
+
+    /**
+     * @brief queues size bytes from data into dst at dstOffset. data must stay valid until isReady(ticket).
+     * @param dstStage/dstAccess how the graphics queue will first use the buffer.
+     * @return ticket to poll with isReady().
+     */
+    uint64_t uploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void *data, VkDeviceSize size, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+    {
+        Job job{};
+        job.ticket = ++lastTicket;
+        job.source = static_cast<const uint8_t *>(data);
+        job.size = size;
+        job.buffer = dst;
+        job.bufferOffset = dstOffset;
+        job.dstStage = dstStage;
+        job.dstAccess = dstAccess;
+        queue.push_back(job);
+        return job.ticket;
+    }
+
+    /**
+     * @brief queues a tightly packed single-mip 2D image upload; streamed a band of whole rows at a time. The image ends up in finalLayout.
+     * @return ticket to poll with isReady().
+     */
+    uint64_t uploadImage(VkImage dst, VkExtent2D extent, uint32_t texelSize, const void *data, VkImageLayout finalLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+    {
+        if (static_cast<VkDeviceSize>(extent.width) * texelSize > regionSize)
+        {
+            throw std::runtime_error("image row doesn't fit in an upload ring region!");
+        }
+        Job job{};
+        job.ticket = ++lastTicket;
+        job.source = static_cast<const uint8_t *>(data);
+        job.size = static_cast<VkDeviceSize>(extent.width) * extent.height * texelSize;
+        job.image = dst;
+        job.imageExtent = extent;
+        job.texelSize = texelSize;
+        job.finalLayout = finalLayout;
+        job.dstStage = dstStage;
+        job.dstAccess = dstAccess;
+        queue.push_back(job);
+        return job.ticket;
+    }
+
+    /**
+     * @brief waits for this frame's region to come back from the GPU, then stages, records and submits as much queued work as fits. Call once per frame before recording the graphics command buffer.
+     */
+    void submitFrame(uint32_t frameIndex)
+    {
+        Region &region = regions[frameIndex % regions.size()];
+        VkDeviceSize regionBase = (frameIndex % regions.size()) * regionSize;
+        if (vkGetFenceStatus(device, region.fence) == VK_NOT_READY)
+        {
+            // the GPU hasn't finished copying out of this region yet, i.e. the ring is too small for how fast we're feeding it.
+            stats.stalls++;
+            vkWaitForFences(device, 1, &region.fence, VK_TRUE, UINT64_MAX);
+        }
+        completedTicket = std::max(completedTicket, region.lastTicket);
+        pendingAcquires.clear();
+        waitThisFrame = false;
+
+        if (queue.empty())
+        {
+            stats.bytesPerFrame.add(0.0);
+            return;
+        }
+
+        vkResetCommandPool(device, region.commandPool, 0);
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(region.commandBuffer, &beginInfo);
+
+        VkDeviceSize head = 0;
+        VkDeviceSize frameBytes = 0;
+        auto *ring = static_cast<uint8_t *>(ringMemory.mapped) + regionBase;
+        while (!queue.empty())
+        {
+            Job &job = queue.front();
+            // vkCmdCopyBufferToImage wants a multiple of 4 and of the texel size; chunkAlignment is a multiple of 16, so only texel sizes that don't divide it need more.
+            VkDeviceSize alignment = job.image != VK_NULL_HANDLE && chunkAlignment % job.texelSize != 0 ? chunkAlignment * job.texelSize : chunkAlignment;
+            // align the offset into the buffer, which is what the copy sees, not the offset into the region.
+            head = (regionBase + head + alignment - 1) / alignment * alignment - regionBase;
+            if (head >= regionSize)
+            {
+                break;
+            }
+            VkDeviceSize chunk = std::min(job.size - job.uploaded, regionSize - head);
+            if (job.image != VK_NULL_HANDLE)
+            {
+                // whole rows only.
+                VkDeviceSize rowBytes = static_cast<VkDeviceSize>(job.imageExtent.width) * job.texelSize;
+                chunk = chunk / rowBytes * rowBytes;
+            }
+            if (chunk == 0)
+            {
+                break;
+            }
+
+            std::memcpy(ring + head, job.source + job.uploaded, chunk);
+            recordChunk(region.commandBuffer, job, regionBase + head, chunk);
+            job.uploaded += chunk;
+            head += chunk;
+            frameBytes += chunk;
+
+            if (job.uploaded < job.size)
+            {
+                // region is full; the rest of this job goes out next frame.
+                stats.chunkedFrames++;
+                break;
+            }
+            finishJob(region.commandBuffer, job);
+            region.lastTicket = job.ticket;
+            readyTicket = job.ticket;
+            queue.pop_front();
+        }
+        if (!queue.empty())
+        {
+            stats.deferredFrames++;
+        }
+
+        vkEndCommandBuffer(region.commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &region.commandBuffer;
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+        VkSemaphore signal = region.semaphore;
+        if (useTimeline)
+        {
+            waitValue = timeline.next();
+            signal = timeline.handle();
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &waitValue;
+            submitInfo.pNext = &timelineInfo;
+        }
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &signal;
+        vkResetFences(device, 1, &region.fence);
+        if (vkQueueSubmit(transferQueue, 1, &submitInfo, region.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit uploads!");
+        }
+        waitSemaphore = signal;
+        waitThisFrame = true;
+
+        stats.totalBytes += frameBytes;
+        stats.bytesPerFrame.add(static_cast<double>(frameBytes) / 1024.0);
+    }
+
+    /**
+     * @brief records the acquire half of every ownership transfer released by this frame's submitFrame(). Goes in the graphics command buffer, before anything that uses the uploads.
+     */
+    void recordAcquires(VkCommandBuffer graphicsCmd) const
+    {
+        for (const auto &acquire : pendingAcquires)
+        {
+            if (acquire.image != VK_NULL_HANDLE)
+            {
+                recordImageAcquire(graphicsCmd, acquire.handoff, acquire.image, colorRange(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, acquire.finalLayout);
+            }
+            else
+            {
+                recordBufferAcquire(graphicsCmd, acquire.handoff, acquire.buffer);
+            }
+        }
+    }
+
+    /**
+     * @brief adds what the graphics submission has to wait on this frame, if anything. values is only meaningful (and only needs to be passed along in a VkTimelineSemaphoreSubmitInfo) when timelines are in use; binary entries get 0.
+     */
+    void appendWaits(std::vector<VkSemaphore> &semaphores, std::vector<VkPipelineStageFlags> &stages, std::vector<uint64_t> &values) const
+    {
+        if (!waitThisFrame)
+        {
+            return;
+        }
+        semaphores.push_back(waitSemaphore);
+        // the acquire barriers and the first uses can be anywhere in the frame, so don't let anything start early.
+        stages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        values.push_back(useTimeline ? waitValue : 0);
+    }
+
+    /**
+     * @return true once the graphics queue owns the upload's destination, i.e. draws recorded from now on may use it.
+     */
+    bool isReady(uint64_t ticket) const
+    {
+        return ticket <= readyTicket;
+    }
+
+    /**
+     * @return true once the GPU has finished the copy and the source data may be freed.
+     */
+    bool isComplete(uint64_t ticket) const
+    {
+        return ticket <= completedTicket;
+    }
+
+    bool usesTimeline() const
+    {
+        return useTimeline;
+    }
+
+    void printStats(std::ostream &out)
+    {
+        out << "upload ring: " << regions.size() << " x " << regionSize / 1024 << " KiB regions, " << stats.totalBytes / 1024 << " KiB uploaded, "
+            << stats.stalls << " ring stall(s), " << stats.deferredFrames << " frame(s) with uploads deferred for lack of space, "
+            << stats.chunkedFrames << " frame(s) splitting a job\n";
+        stats.bytesPerFrame.print(out, "uploaded per frame", "KiB");
+    }
+
+private:
+    struct Job
+    {
+        uint64_t ticket;
+        const uint8_t *source;
+        VkDeviceSize size;
+        VkDeviceSize uploaded;
+        VkBuffer buffer;
+        VkDeviceSize bufferOffset;
+        VkImage image;
+        VkExtent2D imageExtent;
+        uint32_t texelSize;
+        VkImageLayout finalLayout;
+        VkPipelineStageFlags dstStage;
+        VkAccessFlags dstAccess;
+    };
+
+    struct PendingAcquire
+    {
+        QueueHandoff handoff;
+        VkBuffer buffer;
+        VkImage image;
+        VkImageLayout finalLayout;
+    };
+
+    struct Region
+    {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        // binary path only.
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        // newest job finished by this region's last submission.
+        uint64_t lastTicket = 0;
+    };
+
+    static VkImageSubresourceRange colorRange()
+    {
+        VkImageSubresourceRange range{};
+        range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        range.levelCount = 1;
+        range.layerCount = 1;
+        return range;
+    }
+
+    void recordChunk(VkCommandBuffer cmd, const Job &job, VkDeviceSize ringOffset, VkDeviceSize chunk)
+    {
+        if (job.image == VK_NULL_HANDLE)
+        {
+            VkBufferCopy copy{};
+            copy.srcOffset = ringOffset;
+            copy.dstOffset = job.bufferOffset + job.uploaded;
+            copy.size = chunk;
+            vkCmdCopyBuffer(cmd, ringBuffer, job.buffer, 1, &copy);
+            return;
+        }
+
+        if (job.uploaded == 0)
+        {
+            // contents are about to be overwritten anyway, so UNDEFINED is fine and lets the driver skip preserving them.
+            VkImageMemoryBarrier toTransfer{};
+            toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            toTransfer.srcAccessMask = 0;
+            toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            toTransfer.image = job.image;
+            toTransfer.subresourceRange = colorRange();
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+        }
+
+        VkDeviceSize rowBytes = static_cast<VkDeviceSize>(job.imageExtent.width) * job.texelSize;
+        VkBufferImageCopy region{};
+        region.bufferOffset = ringOffset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, static_cast<int32_t>(job.uploaded / rowBytes), 0};
+        region.imageExtent = {job.imageExtent.width, static_cast<uint32_t>(chunk / rowBytes), 1};
+        vkCmdCopyBufferToImage(cmd, ringBuffer, job.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    /**
+     * @brief last chunk is in: release the destination to the graphics family and remember to acquire it there.
+     */
+    void finishJob(VkCommandBuffer cmd, const Job &job)
+    {
+        QueueHandoff handoff{transferFamily, graphicsFamily, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, job.dstStage, job.dstAccess};
+        if (job.image != VK_NULL_HANDLE)
+        {
+            recordImageRelease(cmd, handoff, job.image, colorRange(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, job.finalLayout);
+        }
+        else
+        {
+            recordBufferRelease(cmd, handoff, job.buffer);
+        }
+        pendingAcquires.push_back({handoff, job.buffer, job.image, job.finalLayout});
+    }
+
+    struct Stats
+    {
+        uint64_t totalBytes = 0;
+        uint32_t stalls = 0;
+        uint32_t deferredFrames = 0;
+        uint32_t chunkedFrames = 0;
+        SampleStats bytesPerFrame;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceAllocator *allocator = nullptr;
+    uint32_t transferFamily = 0;
+    uint32_t graphicsFamily = 0;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    VkBuffer ringBuffer = VK_NULL_HANDLE;
+    DeviceAllocation ringMemory;
+    VkDeviceSize regionSize = 0;
+    VkDeviceSize chunkAlignment = 16;
+    std::vector<Region> regions;
+    bool useTimeline = false;
+    TimelineSemaphore timeline;
+
+    std::deque<Job> queue;
+    std::vector<PendingAcquire> pendingAcquires;
+    uint64_t lastTicket = 0;
+    uint64_t readyTicket = 0;
+    uint64_t completedTicket = 0;
+    bool waitThisFrame = false;
+    VkSemaphore waitSemaphore = VK_NULL_HANDLE;
+    uint64_t waitValue = 0;
+    Stats stats;
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief stands in for the parent of a handle that doesn't have one (instances, devices), so UniqueHandle has a single shape; takes no space.
+ */
+struct NoOwner
+{
+};
+
+/**
+ * @brief move-only owner of one Vulkan handle, destroyed with its parent when it goes out of scope, so a throw halfway through init unwinds whatever was created before it instead of leaking it.
+ *
+ * Traits says what the handle is, what owns it and how to destroy it; destroy() is a static function, so no deleter is stored and a UniqueHandle is exactly the parent and the handle side by side (just the handle for root objects), with destroy calls the compiler can inline. It converts to the raw handle implicitly, since every Vulkan call wants the raw handle and wrapping them all would only add noise; create into a raw handle and hand it over with the (owner, handle) constructor.
+ *
+ * Destruction order between handles is still the owner's problem: in a class, declare parents before children, since members are destroyed in reverse.
+ */
+template <typename Traits>
+class UniqueHandle
+{
+public:
+    using Handle = typename Traits::Handle;
+    using Owner = typename Traits::Owner;
+
+    UniqueHandle() = default;
+
+    UniqueHandle(Owner owner, Handle handle) : parent(owner), handle(handle) {}
+
+    explicit UniqueHandle(Handle handle)
+        requires std::is_same_v<Owner, NoOwner>
+        : handle(handle)
+    {
+    }
+
+    ~UniqueHandle()
+    {
+        reset();
+    }
+
+    UniqueHandle(const UniqueHandle &) = delete;
+    UniqueHandle &operator=(const UniqueHandle &) = delete;
+
+    UniqueHandle(UniqueHandle &&other) noexcept : parent(other.parent), handle(other.release()) {}
+
+    UniqueHandle &operator=(UniqueHandle &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            parent = other.parent;
+            handle = other.release();
+        }
+        return *this;
+    }
+
+    /**
+     * @brief destroys the handle now, if there is one.
+     */
+    void reset()
+    {
+        if (handle != VK_NULL_HANDLE)
+        {
+            Traits::destroy(parent, handle);
+            handle = VK_NULL_HANDLE;
+        }
+    }
+
+    /**
+     * @return the handle, which the caller now has to destroy.
+     */
+    Handle release()
+    {
+        Handle released = handle;
+        handle = VK_NULL_HANDLE;
+        return released;
+    }
+
+    Handle get() const
+    {
+        return handle;
+    }
+
+    Owner owner() const
+    {
+        return parent;
+    }
+
+    operator Handle() const
+    {
+        return handle;
+    }
+
+private:
+    [[no_unique_address]] Owner parent{};
+    Handle handle = VK_NULL_HANDLE;
+};
+
+/**
+ * @brief traits for handles destroyed by vkDestroyX(handle, allocator).
+ */
+template <typename H, void(VKAPI_PTR *Destroy)(H, const VkAllocationCallbacks *)>
+struct RootHandleTraits
+{
+    using Owner = NoOwner;
+    using Handle = H;
+
+    static void destroy(NoOwner, H handle)
+    {
+        Destroy(handle, nullptr);
+    }
+};
+
+/**
+ * @brief traits for handles destroyed by vkDestroyX(parent, handle, allocator).
+ */
+template <typename O, typename H, void(VKAPI_PTR *Destroy)(O, H, const VkAllocationCallbacks *)>
+struct ChildHandleTraits
+{
+    using Owner = O;
+    using Handle = H;
+
+    static void destroy(O owner, H handle)
+    {
+        Destroy(owner, handle, nullptr);
+    }
+};
+
+/**
+ * @brief a device waits for idle before it goes, since destroying one with work still queued is undefined; after an orderly shutdown that wait returns immediately.
+ */
+struct DeviceHandleTraits
+{
+    using Owner = NoOwner;
+    using Handle = VkDevice;
+
+    static void destroy(NoOwner, VkDevice device)
+    {
+        vkDeviceWaitIdle(device);
+        vkDestroyDevice(device, nullptr);
+    }
+};
+
+/**
+ * @brief the debug messenger's destroy function comes from an extension, so it has to be looked up through the instance.
+ */
+struct DebugMessengerHandleTraits
+{
+    using Owner = VkInstance;
+    using Handle = VkDebugUtilsMessengerEXT;
+
+    static void destroy(VkInstance instance, VkDebugUtilsMessengerEXT messenger)
+    {
+        auto destroyMessenger = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT"));
+        if (destroyMessenger != nullptr)
+        {
+            destroyMessenger(instance, messenger, nullptr);
+        }
+    }
+};
+
+using UniqueInstance = UniqueHandle<RootHandleTraits<VkInstance, vkDestroyInstance>>;
+using UniqueDevice = UniqueHandle<DeviceHandleTraits>;
+using UniqueDebugMessenger = UniqueHandle<DebugMessengerHandleTraits>;
+using UniqueSurface = UniqueHandle<ChildHandleTraits<VkInstance, VkSurfaceKHR, vkDestroySurfaceKHR>>;
+using UniqueSwapchain = UniqueHandle<ChildHandleTraits<VkDevice, VkSwapchainKHR, vkDestroySwapchainKHR>>;
+using UniqueImageView = UniqueHandle<ChildHandleTraits<VkDevice, VkImageView, vkDestroyImageView>>;
+using UniqueFramebuffer = UniqueHandle<ChildHandleTraits<VkDevice, VkFramebuffer, vkDestroyFramebuffer>>;
+using UniqueSemaphore = UniqueHandle<ChildHandleTraits<VkDevice, VkSemaphore, vkDestroySemaphore>>;
+using UniqueRenderPass = UniqueHandle<ChildHandleTraits<VkDevice, VkRenderPass, vkDestroyRenderPass>>;
+using UniqueShaderModule = UniqueHandle<ChildHandleTraits<VkDevice, VkShaderModule, vkDestroyShaderModule>>;
+using UniquePipelineLayout = UniqueHandle<ChildHandleTraits<VkDevice, VkPipelineLayout, vkDestroyPipelineLayout>>;
+using UniquePipeline = UniqueHandle<ChildHandleTraits<VkDevice, VkPipeline, vkDestroyPipeline>>;
+using UniqueCommandPool = UniqueHandle<ChildHandleTraits<VkDevice, VkCommandPool, vkDestroyCommandPool>>;
+using UniqueFence = UniqueHandle<ChildHandleTraits<VkDevice, VkFence, vkDestroyFence>>;
+using UniqueBuffer = UniqueHandle<ChildHandleTraits<VkDevice, VkBuffer, vkDestroyBuffer>>;
+using UniqueImage = UniqueHandle<ChildHandleTraits<VkDevice, VkImage, vkDestroyImage>>;
+using UniqueSampler = UniqueHandle<ChildHandleTraits<VkDevice, VkSampler, vkDestroySampler>>;
+
+// the zero overhead part: nothing but the handle and its parent.
+static_assert(sizeof(UniqueInstance) == sizeof(VkInstance));
+static_assert(sizeof(UniqueDevice) == sizeof(VkDevice));
+static_assert(sizeof(UniqueImageView) == sizeof(std::pair<VkDevice, VkImageView>));
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief fixed set of worker threads that all run the same job, fork-join style: run() hands job(workerIndex) to every worker and blocks until they've all returned.
+ *
+ * This is deliberately not a general task queue. Command recording wants each worker to own per-thread state (its command pools), and a stable workerIndex is what lets a worker find that state without any locking. Workers sleep on a condition variable between jobs, so an idle pool costs nothing but the threads themselves.
+ */
+class WorkerPool
+{
+public:
+    explicit WorkerPool(uint32_t workerCount)
+    {
+        workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back([this, i]()
+                                 { workerLoop(i); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    uint32_t size() const
+    {
+        return static_cast<uint32_t>(workers.size());
+    }
+
+    /**
+     * @brief runs job on every worker and waits for all of them; if any worker throws, the first exception is rethrown here once the others are done.
+     */
+    void run(const std::function<void(uint32_t workerIndex)> &job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentJob = &job;
+            pending = size();
+            failure = nullptr;
+            generation++;
+        }
+        wake.notify_all();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]()
+                  { return pending == 0; });
+        currentJob = nullptr;
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    /**
+     * @brief splits [0, count) into size() contiguous slices as evenly as possible.
+     * @return the [begin, end) slice belonging to workerIndex.
+     */
+    std::pair<uint32_t, uint32_t> slice(uint32_t count, uint32_t workerIndex) const
+    {
+        uint32_t base = count / size();
+        uint32_t extra = count % size();
+        uint32_t begin = workerIndex * base + std::min(workerIndex, extra);
+        return {begin, begin + base + (workerIndex < extra ? 1 : 0)};
+    }
+
+private:
+    void workerLoop(uint32_t workerIndex)
+    {
+        uint64_t seenGeneration = 0;
+        while (true)
+        {
+            const std::function<void(uint32_t)> *job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]()
+                          { return stopping || generation != seenGeneration; });
+                if (stopping)
+                {
+                    return;
+                }
+                seenGeneration = generation;
+                job = currentJob;
+            }
+
+            std::exception_ptr error;
+            try
+            {
+                (*job)(workerIndex);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (error && !failure)
+            {
+                failure = error;
+            }
+            if (--pending == 0)
+            {
+                done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(uint32_t)> *currentJob = nullptr;
+    uint32_t pending = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+    std::exception_ptr failure;
+};
@@ -0,0 +1,26 @@
+#version 450
+
+// descriptor heap array sizes, specialized at pipeline creation to DescriptorHeap's device-clamped capacities.
+layout(constant_id = 0) const int TEXTURE_CAPACITY = 1;
+layout(constant_id = 1) const int BUFFER_CAPACITY = 1;
+
+// the global descriptor heap; bindings must match DescriptorHeap.hpp.
+layout(set = 0, binding = 0) uniform sampler2D textures[TEXTURE_CAPACITY];
+layout(std430, set = 0, binding = 1) readonly buffer Palette {
+    vec4 tint;
+} palettes[BUFFER_CAPACITY];
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUV;
+// heap indices, from push constants (triangle.vert) or the object buffer (triangle_indirect.vert). Constant across a draw either way, which keeps them dynamically uniform.
+layout(location = 2) flat in uint fragTextureIndex;
+layout(location = 3) flat in uint fragPaletteIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // clamping keeps a bad index inside the heap.
+    int textureIndex = min(int(fragTextureIndex), TEXTURE_CAPACITY - 1);
+    int paletteIndex = min(int(fragPaletteIndex), BUFFER_CAPACITY - 1);
+    outColor = vec4(fragColor, 1.0) * texture(textures[textureIndex], fragUV) * palettes[paletteIndex].tint;
+}
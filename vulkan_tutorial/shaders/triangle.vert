@@ -0,0 +1,28 @@
+#version 450
+
+// per-draw placement so one pipeline can draw a whole grid of triangles; must match DrawPushConstants in TriangleMain.cpp.
+layout(push_constant) uniform DrawParams {
+    vec2 offset;
+    float scale;
+    float shade;
+    uint textureIndex;
+    uint paletteIndex;
+} draw;
+
+// must match Vertex in TriangleMain.cpp.
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragTextureIndex;
+layout(location = 3) flat out uint fragPaletteIndex;
+
+void main() {
+    gl_Position = vec4(inPosition * draw.scale + draw.offset, 0.0, 1.0);
+    fragColor = inColor * draw.shade;
+    // the triangle spans [-0.5, 0.5], so this maps it onto the unit square.
+    fragUV = inPosition + 0.5;
+    fragTextureIndex = draw.textureIndex;
+    fragPaletteIndex = draw.paletteIndex;
+}
@@ -0,0 +1,45 @@
+#version 450
+
+// GPU-driven variant of triangle.vert: placement comes from the object buffer instead of push constants, indexed by the firstInstance cull.comp wrote into each draw.
+
+layout(constant_id = 1) const int BUFFER_CAPACITY = 1;
+
+// must match CullObject in GpuCulling.hpp.
+struct ObjectData {
+    vec2 offset;
+    float scale;
+    float shade;
+    uint textureIndex;
+    uint paletteIndex;
+    float radius;
+    float pad;
+};
+
+// the descriptor heap's storage buffer array, read as object data; bindings must match DescriptorHeap.hpp.
+layout(std430, set = 0, binding = 1) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffers[BUFFER_CAPACITY];
+
+// must match IndirectPushConstants in TriangleMain.cpp.
+layout(push_constant) uniform IndirectParams {
+    vec2 camera;
+    uint objectBufferIndex;
+} params;
+
+// must match Vertex in TriangleMain.cpp.
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragTextureIndex;
+layout(location = 3) flat out uint fragPaletteIndex;
+
+void main() {
+    ObjectData object = objectBuffers[min(int(params.objectBufferIndex), BUFFER_CAPACITY - 1)].objects[gl_InstanceIndex];
+    gl_Position = vec4(inPosition * object.scale + object.offset - params.camera, 0.0, 1.0);
+    fragColor = inColor * object.shade;
+    fragUV = inPosition + 0.5;
+    fragTextureIndex = object.textureIndex;
+    fragPaletteIndex = object.paletteIndex;
+}
@@ -0,0 +1,29 @@
+#version 450
+
+// --instances variant of triangle.vert: every instance brings its own transform through a per-instance vertex binding, written each frame by InstanceTransforms.
+
+// must match InstancedPushConstants in TriangleMain.cpp.
+layout(push_constant) uniform InstancedParams {
+    vec2 camera;
+} params;
+
+// must match Vertex in TriangleMain.cpp.
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+// column-major, one column per location (2..5); must match InstanceTransforms::MATRIX_FLOATS.
+layout(location = 2) in mat4 inModel;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragTextureIndex;
+layout(location = 3) flat out uint fragPaletteIndex;
+
+void main() {
+    vec4 world = inModel * vec4(inPosition, 0.0, 1.0);
+    gl_Position = vec4(world.xy - params.camera, 0.0, 1.0);
+    fragColor = inColor;
+    fragUV = inPosition + 0.5;
+    // first texture and palette in the heap: instances differ by transform only.
+    fragTextureIndex = 0;
+    fragPaletteIndex = 0;
+}